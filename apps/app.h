@@ -47,6 +47,7 @@ public:
 	virtual void send(int nbytes);
 	virtual void recv(int nbytes);
 	virtual void resume();
+	Agent* agent() const { return agent_; }
 
 protected:
 	virtual int command(int argc, const char*const* argv);
@@ -0,0 +1,356 @@
+/* -*-	Mode:C++; c-basic-offset:8; tab-width:8; indent-tabs-mode:t -*- */
+/*
+ * Copyright (c) 1994 Regents of the University of California.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor of the Laboratory may be used
+ *    to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "queue.h"
+#include "delay.h"
+#include "fluid.h"
+
+static class FluidModelClass : public TclClass {
+public:
+	FluidModelClass() : TclClass("FluidModel") {}
+	TclObject* create(int, const char*const*) {
+		return (new FluidModel);
+	}
+} class_fluid_model;
+
+void FluidTimer::expire(Event*)
+{
+	model_->step();
+	resched(model_->step_);
+}
+
+FluidModel::FluidModel() : links_(0), nlinks_(0), maxlinks_(0),
+	classes_(0), nclasses_(0), maxclasses_(0), cur_(0), steps_(0),
+	last_(0), timer_(this)
+{
+	bind_time("step_", &step_);
+}
+
+FluidModel::~FluidModel()
+{
+	timer_.force_cancel();
+	for (int i = 0; i < nclasses_; ++i) {
+		delete [] classes_[i].hops_;
+		delete [] classes_[i].hist_;
+	}
+	delete [] classes_;
+	delete [] links_;
+}
+
+int FluidModel::find(Queue* q)
+{
+	for (int i = 0; i < nlinks_; ++i)
+		if (links_[i].queue_ == q)
+			return (i);
+	return (-1);
+}
+
+/* the link of queue q, added if new */
+int FluidModel::link(Queue* q, LinkDelay* l)
+{
+	int i = find(q);
+	if (i >= 0)
+		return (i);
+	if (nlinks_ == maxlinks_) {
+		maxlinks_ = maxlinks_ ? 2 * maxlinks_ : 8;
+		FluidLink* links = new FluidLink[maxlinks_];
+		memcpy(links, links_, nlinks_ * sizeof(FluidLink));
+		delete [] links_;
+		links_ = links;
+	}
+	FluidLink& k = links_[nlinks_];
+	memset(&k, 0, sizeof(k));
+	k.queue_ = q;
+	k.link_ = l;
+	k.bw_ = l->bandwidth() / 8;
+	return (nlinks_++);
+}
+
+/* a class of nflows flows along the route of argv's {queue link} pairs */
+int FluidModel::flow(int nflows, double size, double wmax, int argc,
+		     const char*const* argv)
+{
+	if (nclasses_ == maxclasses_) {
+		maxclasses_ = maxclasses_ ? 2 * maxclasses_ : 8;
+		FluidClass* classes = new FluidClass[maxclasses_];
+		memcpy(classes, classes_, nclasses_ * sizeof(FluidClass));
+		delete [] classes_;
+		classes_ = classes;
+	}
+	FluidClass& c = classes_[nclasses_];
+	memset(&c, 0, sizeof(c));
+	c.hops_ = new int[argc / 2];
+	for (int i = 0; i + 1 < argc; i += 2) {
+		Queue* q = (Queue*)TclObject::lookup(argv[i]);
+		LinkDelay* l = (LinkDelay*)TclObject::lookup(argv[i + 1]);
+		if (q == 0 || l == 0) {
+			delete [] c.hops_;
+			return (-1);
+		}
+		c.hops_[c.nhops_++] = link(q, l);
+		c.base_ += 2 * l->delay();
+	}
+	c.nflows_ = nflows;
+	c.size_ = size;
+	c.wmax_ = wmax;
+	c.w_ = 1;
+	c.rtt_ = c.base_;
+	c.hist_ = new double[FLUID_HISTORY];
+	memset(c.hist_, 0, FLUID_HISTORY * sizeof(double));
+	return (nclasses_++);
+}
+
+void FluidModel::start()
+{
+	double* nflows = new double[nlinks_];
+	int i, j;
+
+	// the mean packet size of each link, over its flows
+	for (i = 0; i < nlinks_; ++i) {
+		links_[i].pktsize_ = 0;
+		nflows[i] = 0;
+	}
+	for (i = 0; i < nclasses_; ++i)
+		for (j = 0; j < classes_[i].nhops_; ++j) {
+			int h = classes_[i].hops_[j];
+			links_[h].pktsize_ +=
+				classes_[i].nflows_ * classes_[i].size_;
+			nflows[h] += classes_[i].nflows_;
+		}
+	for (i = 0; i < nlinks_; ++i) {
+		FluidLink& k = links_[i];
+		k.pktsize_ = nflows[i] > 0 ? k.pktsize_ / nflows[i] : 1000;
+		k.limit_ = k.queue_->limit() * k.pktsize_;
+		k.queue_->fluid(0, 0);
+		k.queue_->fluid_arrivals();
+	}
+	delete [] nflows;
+	last_ = Scheduler::instance().clock();
+	timer_.resched(step_);
+}
+
+static double red_prob(const FluidLink& k)
+{
+	if (k.avg_ < k.minth_)
+		return (0);
+	if (k.avg_ < k.maxth_)
+		return (k.maxp_ * (k.avg_ - k.minth_) / (k.maxth_ - k.minth_));
+	if (k.gentle_ && k.avg_ < 2 * k.maxth_)
+		return (k.maxp_ + (1 - k.maxp_) * (k.avg_ - k.maxth_) / k.maxth_);
+	return (1);
+}
+
+void FluidModel::step()
+{
+	double now = Scheduler::instance().clock();
+	double dt = now - last_;
+	double rate, a, bg, pass, fb;
+	int i, j, lag;
+
+	if (dt <= 0)
+		return;
+	last_ = now;
+
+	// rates into the links, thinned by the loss upstream
+	for (i = 0; i < nlinks_; ++i) {
+		links_[i].in_ = 0;
+		links_[i].fg_ = links_[i].queue_->fluid_arrivals() / dt;
+	}
+	for (i = 0; i < nclasses_; ++i) {
+		FluidClass& c = classes_[i];
+		rate = c.nflows_ * c.w_ * c.size_ / c.rtt_;
+		for (j = 0; j < c.nhops_; ++j) {
+			links_[c.hops_[j]].in_ += rate;
+			rate *= 1 - links_[c.hops_[j]].p_;
+		}
+	}
+
+	// backlogs and loss, handed to the packets
+	for (i = 0; i < nlinks_; ++i) {
+		FluidLink& k = links_[i];
+		a = k.in_ + k.fg_;
+		pass = 1;
+		if (k.red_) {
+			// as if RED's estimator ran for each packet arriving;
+			// what RED drops never reaches the queue
+			double qp = k.q_ / k.pktsize_;
+			k.avg_ = qp + (k.avg_ - qp) *
+				pow(1 - k.wq_, dt * a / k.pktsize_);
+			pass = 1 - red_prob(k);
+			a *= pass;
+		}
+		k.q_ += dt * (a - k.bw_);
+		if (k.q_ < 0)
+			k.q_ = 0;
+		if (k.q_ >= k.limit_) {
+			k.q_ = k.limit_;
+			if (a > k.bw_)
+				pass *= k.bw_ / a;
+		}
+		k.p_ = 1 - pass;
+		bg = k.q_ - k.queue_->byteLength();
+		if (bg < 0)
+			bg = 0;
+		k.queue_->fluid(int(bg / k.pktsize_ + 0.5), int(bg));
+		k.link_->fluid_delay(bg / k.bw_);
+	}
+
+	// windows, with the loss feedback of one round trip ago
+	for (i = 0; i < nclasses_; ++i) {
+		FluidClass& c = classes_[i];
+		c.rtt_ = c.base_;
+		pass = 1;
+		for (j = 0; j < c.nhops_; ++j) {
+			FluidLink& k = links_[c.hops_[j]];
+			c.rtt_ += k.q_ / k.bw_;
+			pass *= 1 - k.p_;
+		}
+		if (c.rtt_ < 1e-6)
+			c.rtt_ = 1e-6;
+		c.p_ = 1 - pass;
+		c.hist_[cur_] = c.w_ / c.rtt_ * c.p_;
+		lag = int(c.rtt_ / dt + 0.5);
+		if (lag > FLUID_HISTORY - 1)
+			lag = FLUID_HISTORY - 1;
+		fb = c.hist_[(cur_ - lag + FLUID_HISTORY) % FLUID_HISTORY];
+		c.w_ += dt * (1 / c.rtt_ - c.w_ / 2 * fb);
+		if (c.w_ < 1)
+			c.w_ = 1;
+		else if (c.w_ > c.wmax_)
+			c.w_ = c.wmax_;
+	}
+	cur_ = (cur_ + 1) % FLUID_HISTORY;
+	++steps_;
+}
+
+int FluidModel::command(int argc, const char*const* argv)
+{
+	Tcl& tcl = Tcl::instance();
+	if (argc == 2) {
+		if (strcmp(argv[1], "start") == 0) {
+			start();
+			return (TCL_OK);
+		}
+		if (strcmp(argv[1], "stop") == 0) {
+			timer_.force_cancel();
+			return (TCL_OK);
+		}
+		if (strcmp(argv[1], "stats") == 0) {
+			long n = 0;
+			for (int i = 0; i < nclasses_; ++i)
+				n += classes_[i].nflows_;
+			tcl.resultf("steps %ld classes %d flows %ld links %d",
+				    steps_, nclasses_, n, nlinks_);
+			return (TCL_OK);
+		}
+	} else if (argc == 3) {
+		int i = atoi(argv[2]);
+		if (strcmp(argv[1], "link-stats") == 0) {
+			Queue* q = (Queue*)TclObject::lookup(argv[2]);
+			if (q == 0 || (i = find(q)) < 0) {
+				tcl.resultf("%s: no fluid link %s", name(), argv[2]);
+				return (TCL_ERROR);
+			}
+			FluidLink& k = links_[i];
+			tcl.resultf("backlog %g loss %g background %g "
+				    "foreground %g", k.q_, k.p_, k.in_, k.fg_);
+			return (TCL_OK);
+		}
+		if (i < 0 || i >= nclasses_) {
+			tcl.resultf("%s: no class %s", name(), argv[2]);
+			return (TCL_ERROR);
+		}
+		FluidClass& c = classes_[i];
+		if (strcmp(argv[1], "rate") == 0) {
+			// delivered bytes/s of the whole class
+			tcl.resultf("%g", c.nflows_ * c.w_ * c.size_ / c.rtt_ *
+				    (1 - c.p_));
+			return (TCL_OK);
+		}
+		if (strcmp(argv[1], "window") == 0) {
+			tcl.resultf("%g", c.w_);
+			return (TCL_OK);
+		}
+		if (strcmp(argv[1], "rtt") == 0) {
+			tcl.resultf("%g", c.rtt_);
+			return (TCL_OK);
+		}
+	} else if (argc == 4) {
+		if (strcmp(argv[1], "link") == 0) {
+			Queue* q = (Queue*)TclObject::lookup(argv[2]);
+			LinkDelay* l = (LinkDelay*)TclObject::lookup(argv[3]);
+			if (q == 0 || l == 0) {
+				tcl.resultf("%s: bad link %s %s", name(),
+					    argv[2], argv[3]);
+				return (TCL_ERROR);
+			}
+			tcl.resultf("%d", link(q, l));
+			return (TCL_OK);
+		}
+	} else if (argc == 8) {
+		// red <queue> <minth> <maxth> <maxp> <gentle> <q_weight>
+		if (strcmp(argv[1], "red") == 0) {
+			Queue* q = (Queue*)TclObject::lookup(argv[2]);
+			int i;
+			if (q == 0 || (i = find(q)) < 0) {
+				tcl.resultf("%s: no fluid link %s", name(), argv[2]);
+				return (TCL_ERROR);
+			}
+			FluidLink& k = links_[i];
+			k.red_ = 1;
+			k.minth_ = atof(argv[3]);
+			k.maxth_ = atof(argv[4]);
+			k.maxp_ = atof(argv[5]);
+			k.gentle_ = atoi(argv[6]);
+			k.wq_ = atof(argv[7]);
+			if (k.maxth_ <= k.minth_)
+				k.maxth_ = k.minth_ + 1;
+			return (TCL_OK);
+		}
+	}
+	if (argc >= 7 && (argc & 1) && strcmp(argv[1], "flow") == 0) {
+		// flow <nflows> <pktsize> <wmax> <queue> <link> ...
+		int i = flow(atoi(argv[2]), atof(argv[3]), atof(argv[4]),
+			     argc - 5, argv + 5);
+		if (i < 0) {
+			tcl.resultf("%s: bad route", name());
+			return (TCL_ERROR);
+		}
+		tcl.resultf("%d", i);
+		return (TCL_OK);
+	}
+	return (TclObject::command(argc, argv));
+}
@@ -0,0 +1,143 @@
+/* -*-	Mode:C++; c-basic-offset:8; tab-width:8; indent-tabs-mode:t -*- */
+/*
+ * Copyright (c) 1994 Regents of the University of California.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor of the Laboratory may be used
+ *    to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+
+/*
+ * FluidModel: long-lived background TCP flows as fluid, for hybrid
+ * packet/fluid simulation.
+ *
+ * Where thousands of bulk TCP flows are there only to load the links
+ * that a few packet-level (foreground) flows are studied on, their
+ * packets cost most of the events.  A FluidModel replaces each class
+ * of background flows (N flows along one route) with the fluid model
+ * of Misra, Gong and Towsley (SIGCOMM 2000), solved in steps of step_
+ * seconds:
+ *
+ *	dW/dt = 1/R(t) - W(t)/2 * W(t-R)/R(t-R) * p(t-R)
+ *	dq/dt = A(t) + F(t) - C		(0 <= q <= buffer)
+ *
+ * for the window W and round trip R of each class and the backlog q
+ * of each link it crosses; A is the background rate into the link, F
+ * the foreground (packet) rate measured over the last step, and p the
+ * loss probability along the route.  A link loses the overflow of a
+ * full buffer and (RED) drops what arrives with the RED probability
+ * of a fluid average queue.  At the fixed point W is the square root
+ * law of tcp/formula.h, which asim (asim.cc) solves for statically;
+ * the fluid model adds the dynamics the packets need to see.
+ *
+ * Each step the background part of the backlog is handed to the
+ * packet queue (Queue::fluid()), where it counts against the limit
+ * and in RED's average, and its drain time to the link
+ * (LinkDelay::fluid_delay()), where it delays every packet, so the
+ * foreground flows see the queueing and loss the background makes.
+ * Windows are capped at wmax and timeouts are not modelled; the round
+ * trip of a class is twice the propagation delay of its route plus
+ * the queueing along it.  Keep step_ below the smallest round trip.
+ *
+ * "$ns background-tcp" (tcl/lib/ns-fluid.tcl) sets this up.
+ */
+
+#ifndef ns_fluid_h
+#define ns_fluid_h
+
+#include "timer-handler.h"
+
+class Queue;
+class LinkDelay;
+class FluidModel;
+
+#define FLUID_HISTORY	1024	/* steps of loss feedback kept per class */
+
+struct FluidLink {
+	Queue* queue_;
+	LinkDelay* link_;
+	double bw_;		// bytes/s
+	double limit_;		// buffer, bytes
+	double pktsize_;	// mean background packet size, bytes
+	int red_;		// RED parameters, in packets
+	double minth_, maxth_, maxp_, wq_;
+	int gentle_;
+
+	double q_;		// backlog, bytes (background and foreground)
+	double avg_;		// RED average queue, packets
+	double in_;		// background rate in, bytes/s
+	double fg_;		// foreground rate in, bytes/s
+	double p_;		// loss (or mark) probability
+};
+
+struct FluidClass {
+	int nflows_;
+	double size_;		// packet size, bytes
+	double wmax_;		// largest window, packets
+	double base_;		// round-trip propagation delay
+	int nhops_;
+	int* hops_;		// the links of the route, in FluidModel::links_
+
+	double w_;		// window of each flow, packets
+	double rtt_;
+	double p_;		// loss along the route
+	double* hist_;		// W/R * p of each step, a ring
+};
+
+class FluidTimer : public TimerHandler {
+public:
+	FluidTimer(FluidModel* m) : model_(m) {}
+protected:
+	void expire(Event*);
+	FluidModel* model_;
+};
+
+class FluidModel : public TclObject {
+public:
+	FluidModel();
+	~FluidModel();
+	void step();
+protected:
+	friend class FluidTimer;
+	int command(int argc, const char*const* argv);
+	int link(Queue* q, LinkDelay* l);
+	int find(Queue* q);
+	int flow(int nflows, double size, double wmax, int argc,
+		 const char*const* argv);
+	void start();
+
+	double step_;		// bound: seconds per step
+	FluidLink* links_;
+	int nlinks_, maxlinks_;
+	FluidClass* classes_;
+	int nclasses_, maxclasses_;
+	int cur_;		// slot of this step in the hist_ rings
+	long steps_;
+	double last_;		// time of the last step
+	FluidTimer timer_;
+};
+
+#endif
@@ -125,12 +125,8 @@ int HashClassifier::command(int argc, const char*const* argv)
 			nsaddr_t dst = atoi(argv[3]);
 			int fid = atoi(argv[4]);
 			
-			Tcl_HashEntry *ep= Tcl_FindHashEntry(&ht_, 
-							     hashkey(src, dst,
-								     fid)); 
-			if (ep) {
-				long slot = (long)Tcl_GetHashValue(ep);
-				Tcl_DeleteHashEntry(ep);
+			long slot;
+			if (ht_.remove(hashkey(src, dst, fid), &slot)) {
 				tcl.resultf("%lu", slot);
 				return (TCL_OK);
 			}
@@ -180,7 +176,13 @@ int DestHashClassifier::classify(Packet *p)
 	int slot= lookup(p);
 	if (slot >= 0 && slot <=maxslot_)
 		return (slot);
-	else if (default_ >= 0)
+	if (lazy_node_ >= 0 &&
+	    lazy_route(mshift(hdr_ip::access(p)->daddr()))) {
+		slot = lookup(p);
+		if (slot >= 0 && slot <= maxslot_)
+			return (slot);
+	}
+	if (default_ >= 0)
 		return (default_);
 	return -1;
 } // HashClassifier::classify
@@ -36,20 +36,31 @@
 
 #include "classifier.h"
 #include "ip.h"
+#include "flow-table.h"
 
 class Flow;
+class HashClassifier;
+
+/*
+ * Called by a hash classifier for a packet of a flow it has no entry
+ * for, in place of the Tcl "unknown-flow" instproc.  It returns the
+ * slot for the flow (or -1), and normally also installs it with
+ * do_set_hash() so the next packet of the flow hits the table.
+ */
+class UnknownFlowHandler {
+public:
+	virtual ~UnknownFlowHandler() {}
+	virtual long unknown_flow(HashClassifier* cl, nsaddr_t src,
+				  nsaddr_t dst, int fid) = 0;
+};
 
 /* class defs for HashClassifier (base), SrcDest, SrcDestFid HashClassifiers */
 class HashClassifier : public Classifier {
 public:
-	HashClassifier(int keylen) : default_(-1), keylen_(keylen) {
+	HashClassifier() : default_(-1), unknown_handler_(0) {
 		// shift + mask picked up from underlying Classifier object
 		bind("default_", &default_);
-		Tcl_InitHashTable(&ht_, keylen);
 	}		
-	~HashClassifier() {
-		Tcl_DeleteHashTable(&ht_);
-	};
 	virtual int classify(Packet *p);
 	virtual long lookup(Packet* p) {
 		hdr_ip* h = hdr_ip::access(p);
@@ -58,126 +69,97 @@ public:
 	}
 	virtual long unknown(Packet* p) {
 		hdr_ip* h = hdr_ip::access(p);
+		if (unknown_handler_ != 0)
+			return (unknown_handler_->unknown_flow(this,
+				h->saddr(), h->daddr(), h->flowid()));
 		Tcl::instance().evalf("%s unknown-flow %u %u %u",
 				      name(), h->saddr(), h->daddr(),
 				      h->flowid()); 
 		return lookup(p);
 	};
 	void set_default(int slot) { default_ = slot; } 
+	void set_unknown_handler(UnknownFlowHandler* h) {
+		unknown_handler_ = h;
+	}
 	int do_set_hash(nsaddr_t src, nsaddr_t dst, int fid, int slot) {
 		return (set_hash(src,dst,fid,slot));
 	}
 	void set_table_size(int nn);
 protected:
-	union hkey {
-		struct {
-			int fid;
-		} Fid;
-		struct {
-			nsaddr_t dst;
-		} Dst;
-		struct {
-			nsaddr_t src, dst;
-		} SrcDst;
-		struct {
-			nsaddr_t src, dst;
-			int fid;
-		} SrcDstFid;
-	};
-		
 	long lookup(nsaddr_t src, nsaddr_t dst, int fid) {
 		return get_hash(src, dst, fid);
 	}
 	int newflow(Packet* pkt) {
-		hdr_ip* h = hdr_ip::access(pkt);
-		Tcl::instance().evalf("%s unknown-flow %u %u %u",
-				      name(), h->saddr(), h->daddr(),
-				      h->flowid()); 
-		return lookup(pkt);
+		return (unknown(pkt));
 	};
 	void reset() {
-		Tcl_DeleteHashTable(&ht_);
-		Tcl_InitHashTable(&ht_, keylen_);
+		ht_.clear();
 	}
 
-	virtual const char* hashkey(nsaddr_t, nsaddr_t, int)=0; 
+	/* the table key of a flow; each classifier keeps only its fields */
+	virtual FlowKey hashkey(nsaddr_t, nsaddr_t, int)=0; 
 
 	int set_hash(nsaddr_t src, nsaddr_t dst, int fid, long slot) {
-		int newEntry;
-		Tcl_HashEntry *ep= Tcl_CreateHashEntry(&ht_,
-						       hashkey(src, dst, fid),
-						       &newEntry); 
-		if (ep) {
-			Tcl_SetHashValue(ep, slot);
-			return slot;
-		}
-		return -1;
+		ht_.insert(hashkey(src, dst, fid), slot);
+		return slot;
 	}
 	long get_hash(nsaddr_t src, nsaddr_t dst, int fid) {
-		Tcl_HashEntry *ep= Tcl_FindHashEntry(&ht_, 
-						     hashkey(src, dst, fid)); 
-		if (ep)
-			return (long)Tcl_GetHashValue(ep);
-		return -1;
+		return (ht_.find(hashkey(src, dst, fid)));
 	}
 	
 	virtual int command(int argc, const char*const* argv);
 
 
 	int default_;
-	Tcl_HashTable ht_;
-	hkey buf_;
-	int keylen_;
+	FlowTable ht_;
+	UnknownFlowHandler* unknown_handler_;
 };
 
 class SrcDestFidHashClassifier : public HashClassifier {
 public:
-	SrcDestFidHashClassifier() : HashClassifier(3) {
+	SrcDestFidHashClassifier() {
 	}
 protected:
-	const char* hashkey(nsaddr_t src, nsaddr_t dst, int fid) {
-		buf_.SrcDstFid.src= mshift(src);
-		buf_.SrcDstFid.dst= mshift(dst);
-		buf_.SrcDstFid.fid= fid;
-		return (const char*) &buf_;
+	FlowKey hashkey(nsaddr_t src, nsaddr_t dst, int fid) {
+		FlowKey k = { mshift(src), mshift(dst), fid };
+		return k;
 	}
 };
 
 class SrcDestHashClassifier : public HashClassifier {
 public:
-	SrcDestHashClassifier() : HashClassifier(2) {
+	SrcDestHashClassifier() {
 	int command(int argc, const char*const* argv);
 	int classify(Packet *p);
 	}
 protected:
-	const char*  hashkey(nsaddr_t src, nsaddr_t dst, int) {
-		buf_.SrcDst.src= mshift(src);
-		buf_.SrcDst.dst= mshift(dst);
-		return (const char*) &buf_;
+	FlowKey hashkey(nsaddr_t src, nsaddr_t dst, int) {
+		FlowKey k = { mshift(src), mshift(dst), 0 };
+		return k;
 	}
 };
 
 class FidHashClassifier : public HashClassifier {
 public:
-	FidHashClassifier() : HashClassifier(TCL_ONE_WORD_KEYS) {
+	FidHashClassifier() {
 	}
 protected:
-	const char* hashkey(nsaddr_t, nsaddr_t, int fid) {
-		long key = fid;
-		return (const char*) key;
+	FlowKey hashkey(nsaddr_t, nsaddr_t, int fid) {
+		FlowKey k = { 0, 0, fid };
+		return k;
 	}
 };
 
 class DestHashClassifier : public HashClassifier {
 public:
-	DestHashClassifier() : HashClassifier(TCL_ONE_WORD_KEYS) {}
+	DestHashClassifier() {}
 	virtual int command(int argc, const char*const* argv);
 	int classify(Packet *p);
 	virtual void do_install(char *dst, NsObject *target);
 protected:
-	const char* hashkey(nsaddr_t, nsaddr_t dst, int) {
-		long key = mshift(dst);
-		return (const char*) key;
+	FlowKey hashkey(nsaddr_t, nsaddr_t dst, int) {
+		FlowKey k = { 0, mshift(dst), 0 };
+		return k;
 	}
 };
 
@@ -37,6 +37,7 @@ static const char rcsid[] =
 #include "config.h"
 #include "classifier.h"
 #include "packet.h"
+#include "simulator.h"
 
 static class ClassifierClass : public TclClass {
 public:
@@ -48,7 +49,8 @@ public:
 
 
 Classifier::Classifier() : 
-	slot_(0), nslot_(0), maxslot_(-1), shift_(0), mask_(0xffffffff), nsize_(0)
+	slot_(0), nslot_(0), maxslot_(-1), shift_(0), mask_(0xffffffff), nsize_(0),
+	lazy_node_(-1)
 {
 	default_target_ = 0;
 
@@ -159,6 +161,9 @@ NsObject* Classifier::find(Packet* p)
 	NsObject* node = NULL;
 	int cl = classify(p);
 	if (cl < 0 || cl >= nslot_ || (node = slot_[cl]) == 0) { 
+		if (cl >= 0 && lazy_route(cl) &&
+		    cl < nslot_ && (node = slot_[cl]) != 0)
+			return (node);
 		if (default_target_) 
 			return default_target_;
 		/*
@@ -178,6 +183,16 @@ NsObject* Classifier::find(Packet* p)
 	return (node);
 }
 
+/*
+ * With lazy routing, the route from lazy_node_ to dst is only computed
+ * and installed when the first packet for dst misses.
+ */
+int Classifier::lazy_route(int dst)
+{
+	return (lazy_node_ >= 0 &&
+		Simulator::instance().lazy_route(lazy_node_, dst));
+}
+
 int Classifier::install_next(NsObject *node) {
 	int slot = maxslot_ + 1;
 	install(slot, node);
@@ -271,6 +286,14 @@ int Classifier::command(int argc, const char*const* argv)
 				return TCL_ERROR;
 			return TCL_OK;
 		}
+		/*
+		 * $classifier lazy-node $id
+		 * resolve the routes of node $id on misses
+		 */
+		if (strcmp(argv[1], "lazy-node") == 0) {
+			lazy_node_ = atoi(argv[2]);
+			return (TCL_OK);
+		}
 	} else if (argc == 4) {
 		/*
 		 * $classifier install $slot $node
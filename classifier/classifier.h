@@ -83,6 +83,8 @@ protected:
 	int mask_;
 	NsObject *default_target_;
 	int nsize_;       //what size of nslot_ should be
+	int lazy_route(int dst);
+	int lazy_node_;		// node whose routes are resolved on a miss
 };
 
 #endif
@@ -0,0 +1,151 @@
+/* -*-	Mode:C++; c-basic-offset:8; tab-width:8; indent-tabs-mode:t -*- */
+/*
+ * Copyright (c) 1997 The Regents of the University of California.
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. All advertising materials mentioning features or use of this software
+ *    must display the following acknowledgement:
+ * 	This product includes software developed by the Network Research
+ * 	Group at Lawrence Berkeley National Laboratory.
+ * 4. Neither the name of the University nor of the Laboratory may be used
+ *    to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "flow-table.h"
+
+FlowTable::FlowTable() : ctrl_(0), entries_(0), capacity_(0), mask_(0),
+	size_(0), deleted_(0)
+{
+	resize(GROUP);
+}
+
+FlowTable::~FlowTable()
+{
+	delete [] ctrl_;
+	delete [] entries_;
+}
+
+void FlowTable::clear()
+{
+	memset(ctrl_, EMPTY, capacity_ + GROUP);
+	size_ = 0;
+	deleted_ = 0;
+}
+
+/*
+ * Re-insert every live entry into a table of the given capacity,
+ * which also drops the tombstones.
+ */
+void FlowTable::resize(int capacity)
+{
+	u_int8_t* octrl = ctrl_;
+	Entry* oentries = entries_;
+	int ocapacity = capacity_;
+
+	ctrl_ = new u_int8_t[capacity + GROUP];
+	entries_ = new Entry[capacity];
+	capacity_ = capacity;
+	mask_ = capacity - 1;
+	clear();
+	for (int i = 0; i < ocapacity; i++) {
+		if (octrl[i] & 0x80)
+			continue;
+		u_int32_t h = hash(oentries[i].key_);
+		int pos = (h >> 7) & mask_;
+		int m;
+		while ((m = match(pos, EMPTY)) == 0)
+			pos = (pos + GROUP) & mask_;
+		int j = (pos + first_bit(m) - 1) & mask_;
+		set_ctrl(j, h & 0x7f);
+		entries_[j] = oentries[i];
+		size_++;
+	}
+	delete [] octrl;
+	delete [] oentries;
+}
+
+void FlowTable::insert(const FlowKey& k, long value)
+{
+	u_int32_t h = hash(k);
+	u_int8_t tag = h & 0x7f;
+	int pos = (h >> 7) & mask_;
+	int slot = -1;		// first empty or deleted entry on the way
+	for (;;) {
+		int m = match(pos, tag);
+		while (m != 0) {
+			int i = (pos + first_bit(m) - 1) & mask_;
+			if (same(entries_[i].key_, k)) {
+				entries_[i].value_ = value;
+				return;
+			}
+			m &= m - 1;
+		}
+		if (slot < 0) {
+			m = match(pos, DELETED) | match(pos, EMPTY);
+			if (m != 0)
+				slot = (pos + first_bit(m) - 1) & mask_;
+		}
+		if (match(pos, EMPTY) != 0)
+			break;
+		pos = (pos + GROUP) & mask_;
+	}
+	if (ctrl_[slot] == DELETED)
+		deleted_--;
+	else if ((size_ + deleted_ + 1) * 8 > capacity_ * 7) {
+		/* full up to 7/8: grow, or just sweep if mostly tombstones */
+		resize(size_ * 2 >= capacity_ ? capacity_ * 2 : capacity_);
+		insert(k, value);
+		return;
+	}
+	set_ctrl(slot, tag);
+	entries_[slot].key_ = k;
+	entries_[slot].value_ = value;
+	size_++;
+}
+
+int FlowTable::remove(const FlowKey& k, long* value)
+{
+	u_int32_t h = hash(k);
+	u_int8_t tag = h & 0x7f;
+	int pos = (h >> 7) & mask_;
+	for (;;) {
+		int m = match(pos, tag);
+		while (m != 0) {
+			int i = (pos + first_bit(m) - 1) & mask_;
+			if (same(entries_[i].key_, k)) {
+				*value = entries_[i].value_;
+				set_ctrl(i, DELETED);
+				size_--;
+				deleted_++;
+				return (1);
+			}
+			m &= m - 1;
+		}
+		if (match(pos, EMPTY) != 0)
+			return (0);
+		pos = (pos + GROUP) & mask_;
+	}
+}
@@ -0,0 +1,144 @@
+/* -*-	Mode:C++; c-basic-offset:8; tab-width:8; indent-tabs-mode:t -*- */
+/*
+ * Copyright (c) 1997 The Regents of the University of California.
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. All advertising materials mentioning features or use of this software
+ *    must display the following acknowledgement:
+ * 	This product includes software developed by the Network Research
+ * 	Group at Lawrence Berkeley National Laboratory.
+ * 4. Neither the name of the University nor of the Laboratory may be used
+ *    to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * flow-table.h
+ *
+ * The (src, dst, fid) -> slot table of the hash classifiers: open
+ * addressing with a byte of metadata per entry (empty, deleted, or 7
+ * bits of the hash), probed sixteen bytes at a time, so that a lookup
+ * usually touches one cache line of metadata and one entry.
+ */
+
+#ifndef ns_flow_table_h
+#define ns_flow_table_h
+
+#include "config.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+struct FlowKey {
+	int32_t src;
+	int32_t dst;
+	int32_t fid;
+};
+
+class FlowTable {
+public:
+	FlowTable();
+	~FlowTable();
+
+	/* the value for k, or -1 */
+	inline long find(const FlowKey& k) const {
+		if (size_ == 0)
+			return (-1);
+		u_int32_t h = hash(k);
+		u_int8_t tag = h & 0x7f;
+		int pos = (h >> 7) & mask_;
+		for (;;) {
+			int m = match(pos, tag);
+			while (m != 0) {
+				int i = (pos + first_bit(m) - 1) & mask_;
+				if (same(entries_[i].key_, k))
+					return (entries_[i].value_);
+				m &= m - 1;
+			}
+			if (match(pos, EMPTY) != 0)
+				return (-1);
+			pos = (pos + GROUP) & mask_;
+		}
+	}
+	void insert(const FlowKey& k, long value);	// or replace
+	int remove(const FlowKey& k, long* value);	// 0 if absent
+	void clear();
+	inline int size() const { return size_; }
+
+protected:
+	enum { GROUP = 16, EMPTY = 0x80, DELETED = 0xfe };
+	struct Entry {
+		FlowKey key_;
+		long value_;
+	};
+
+	static inline u_int32_t hash(const FlowKey& k) {
+		u_int64_t x = (u_int64_t)(u_int32_t)k.src * 0x9e3779b97f4a7c15ULL;
+		x ^= (u_int64_t)(u_int32_t)k.dst * 0xc2b2ae3d27d4eb4fULL;
+		x ^= (u_int64_t)(u_int32_t)k.fid * 0x165667b19e3779f9ULL;
+		x ^= x >> 29;
+		x *= 0xbf58476d1ce4e5b9ULL;
+		return (u_int32_t)(x >> 32);
+	}
+	static inline int same(const FlowKey& a, const FlowKey& b) {
+		return (a.src == b.src && a.dst == b.dst && a.fid == b.fid);
+	}
+	static inline int first_bit(int m) {
+		int i = 1;
+		while ((m & 1) == 0) {
+			m >>= 1;
+			i++;
+		}
+		return (i);
+	}
+	/* bit i set if ctrl_[pos + i] == b, for the GROUP bytes at pos */
+	inline int match(int pos, u_int8_t b) const {
+#ifdef __SSE2__
+		__m128i g = _mm_loadu_si128((const __m128i*)(ctrl_ + pos));
+		return (_mm_movemask_epi8(_mm_cmpeq_epi8(g,
+				_mm_set1_epi8((char)b))));
+#else
+		int m = 0;
+		for (int i = 0; i < GROUP; i++)
+			if (ctrl_[pos + i] == b)
+				m |= 1 << i;
+		return (m);
+#endif
+	}
+	inline void set_ctrl(int i, u_int8_t b) {
+		ctrl_[i] = b;
+		if (i < GROUP)
+			ctrl_[capacity_ + i] = b;	// the copy for wrapped loads
+	}
+	void resize(int capacity);
+
+	u_int8_t* ctrl_;	// capacity_ + GROUP bytes
+	Entry* entries_;
+	int capacity_;		// a power of 2, at least GROUP
+	int mask_;
+	int size_;
+	int deleted_;
+};
+
+#endif /* ns_flow_table_h */
@@ -0,0 +1,122 @@
+/* -*-	Mode:C++; c-basic-offset:8; tab-width:8; indent-tabs-mode:t -*- */
+/*
+ * Copyright (c) 1994 Regents of the University of California.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor of the Laboratory may be used
+ *    to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+/*
+ * Agent pools.
+ *
+ * Traffic generators that open a connection per flow (Tmix,
+ * PackMimeHTTP) keep the agents of finished connections for reuse.  An
+ * AgentPool hands them out oldest first, whatever node they were on;
+ * the generator attaches a reused agent again (which gives it a new
+ * port, as for a new agent) but need not set it up in OTcl again:
+ * reusing it takes resetting a few variables from C++, where a new
+ * agent costs an OTcl object, its bindings and several OTcl calls.
+ */
+
+#ifndef ns_agent_pool_h
+#define ns_agent_pool_h
+
+#include <stdlib.h>
+#include <deque>
+#include <tclcl.h>
+
+template <class T>
+class AgentPool {
+public:
+	AgentPool() : peak_(0), created_(0), reused_(0) {}
+
+	/*
+	 * The agent idle longest, or 0 if there is none or (with
+	 * min_idle) it has not been idle for more than min_idle seconds.
+	 */
+	T* get(double now, double min_idle = 0) {
+		if (idle_.empty())
+			return (0);
+		Entry& e = idle_.front();
+		if (min_idle > 0 && now - e.since_ <= min_idle)
+			return (0);
+		T* a = e.agent_;
+		idle_.pop_front();
+		reused_++;
+		return (a);
+	}
+	/* a (reset) agent is free as of now */
+	void put(T* a, double now) {
+		Entry e;
+		e.agent_ = a;
+		e.since_ = now;
+		idle_.push_back(e);
+		if (idle() > peak_)
+			peak_ = idle();
+	}
+	/* removes and returns any idle agent, 0 once the pool is empty */
+	T* drain() {
+		if (idle_.empty())
+			return (0);
+		T* a = idle_.front().agent_;
+		idle_.pop_front();
+		return (a);
+	}
+	/* counts an agent the generator had to create */
+	void created() { created_++; }
+
+	int idle() const { return ((int)idle_.size()); }
+	/* sets the Tcl result to the pool statistics */
+	void stats(Tcl& tcl) const {
+		tcl.resultf("created %ld reused %ld idle %d peak %d",
+			    created_, reused_, idle(), peak_);
+	}
+
+protected:
+	struct Entry {
+		T* agent_;
+		double since_;		// time the agent became idle
+	};
+
+	std::deque<Entry> idle_;	// idle agents, oldest first
+	int peak_;		// most agents ever in the pool
+	long created_;		// agents created by the generator
+	long reused_;		// agents taken from the pool
+};
+
+/*
+ * Whether two reused agents may be connected from C++.  "$ns connect"
+ * also records the connection for asim when useasim_ is set, so then
+ * it has to be called.
+ */
+inline int pool_fast_connect()
+{
+	Tcl& tcl = Tcl::instance();
+	tcl.evalf("[Simulator instance] set useasim_");
+	return (atoi(tcl.result()) == 0);
+}
+
+#endif
@@ -42,6 +42,7 @@ static const char rcsid[] =
 #include "flags.h"
 #include "address.h"
 #include "app.h"
+#include "cmd-table.h"
 #ifdef HAVE_STL
 #include "nix/hdr_nv.h"
 #include "nix/nixnode.h"
@@ -61,7 +62,7 @@ public:
 	}
 } class_agent;
 
-int Agent::uidcnt_;		/* running unique id */
+NS_THREAD_LOCAL int Agent::uidcnt_;		/* running unique id */
 
 Agent::Agent(packet_t pkttype) : 
 	size_(0), type_(pkttype), 
@@ -113,34 +114,69 @@ Agent::~Agent()
 	}
 }
 
+/* the subcommands of Agent::command() */
+enum {
+	CMD_DELETE_AGENT_TRACE,
+	CMD_SHOW_MONITOR,
+	CMD_CLOSE,
+	CMD_LISTEN,
+	CMD_DUMP_NAMTRACEDVARS,
+	CMD_ATTACH,
+	CMD_ADD_AGENT_TRACE,
+	CMD_CONNECT,
+	CMD_SEND,
+	CMD_SET_PKTTYPE,
+	CMD_SENDMSG,
+	CMD_SENDTO,
+	CMD_TRACEVAR
+};
+static const CommandTable::Entry agent_cmds[] = {
+	{ "delete-agent-trace", CMD_DELETE_AGENT_TRACE },
+	{ "show-monitor", CMD_SHOW_MONITOR },
+	{ "close", CMD_CLOSE },
+	{ "listen", CMD_LISTEN },
+	{ "dump-namtracedvars", CMD_DUMP_NAMTRACEDVARS },
+	{ "attach", CMD_ATTACH },
+	{ "add-agent-trace", CMD_ADD_AGENT_TRACE },
+	{ "connect", CMD_CONNECT },
+	{ "send", CMD_SEND },
+	{ "set_pkttype", CMD_SET_PKTTYPE },
+	{ "sendmsg", CMD_SENDMSG },
+	{ "sendto", CMD_SENDTO },
+	{ "tracevar", CMD_TRACEVAR },
+	{ 0, 0 }
+};
+static CommandTable agent_table(agent_cmds);
+
 int Agent::command(int argc, const char*const* argv)
 {
 	Tcl& tcl = Tcl::instance();
+	int cmd = agent_table.find(argv[1]);
 	if (argc == 2) {
-		if (strcmp(argv[1], "delete-agent-trace") == 0) {
+		if (cmd == CMD_DELETE_AGENT_TRACE) {
 			if ((traceName_ == 0) || (channel_ == 0))
 				return (TCL_OK);
 			deleteAgentTrace();
 			return (TCL_OK);
-		} else if (strcmp(argv[1], "show-monitor") == 0) {
+		} else if (cmd == CMD_SHOW_MONITOR) {
 			if ((traceName_ == 0) || (channel_ == 0))
 				return (TCL_OK);
 			monitorAgentTrace();
 			return (TCL_OK);
-		} else if (strcmp(argv[1], "close") == 0) {
+		} else if (cmd == CMD_CLOSE) {
 			close();
 			return (TCL_OK);
-		} else if (strcmp(argv[1], "listen") == 0) {
+		} else if (cmd == CMD_LISTEN) {
                         listen();
                         return (TCL_OK);
-                } else if (strcmp(argv[1], "dump-namtracedvars") == 0) {
+                } else if (cmd == CMD_DUMP_NAMTRACEDVARS) {
 			enum_tracedVars();
 			return (TCL_OK);
 		}
 		
 	}
 	else if (argc == 3) {
-		if (strcmp(argv[1], "attach") == 0) {
+		if (cmd == CMD_ATTACH) {
 			int mode;
 			const char* id = argv[2];
 			channel_ = Tcl_GetChannel(tcl.interp(), (char*)id, &mode);
@@ -149,7 +185,7 @@ int Agent::command(int argc, const char*const* argv)
 				return (TCL_ERROR);
 			}
 			return (TCL_OK);
-		} else if (strcmp(argv[1], "add-agent-trace") == 0) {
+		} else if (cmd == CMD_ADD_AGENT_TRACE) {
 			// we need to write nam traces and set agent trace name
 			if (channel_ == 0) {
 				tcl.resultf("agent %s: no trace file attached", name_);
@@ -157,30 +193,30 @@ int Agent::command(int argc, const char*const* argv)
 			}
 			addAgentTrace(argv[2]);
 			return (TCL_OK);
-		} else if (strcmp(argv[1], "connect") == 0) {
+		} else if (cmd == CMD_CONNECT) {
 			connect((nsaddr_t)atoi(argv[2]));
 			return (TCL_OK);
-		} else if (strcmp(argv[1], "send") == 0) {
+		} else if (cmd == CMD_SEND) {
 			sendmsg(atoi(argv[2]));
 			return (TCL_OK);
-		} else if (strcmp(argv[1], "set_pkttype") == 0) {
+		} else if (cmd == CMD_SET_PKTTYPE) {
 			set_pkttype(packet_t(atoi(argv[2])));
 			return (TCL_OK);
 		}
 	}
 	else if (argc == 4) {	
-		if (strcmp(argv[1], "sendmsg") == 0) {
+		if (cmd == CMD_SENDMSG) {
 			sendmsg(atoi(argv[2]), argv[3]);
 			return (TCL_OK);
 		}
 	}
 	else if (argc == 5) {
-		if (strcmp(argv[1], "sendto") == 0) {
+		if (cmd == CMD_SENDTO) {
 			sendto(atoi(argv[2]), argv[3], (nsaddr_t)atoi(argv[4]));
 			return (TCL_OK);
 		}
 	}
-	if (strcmp(argv[1], "tracevar") == 0) {
+	if (cmd == CMD_TRACEVAR) {
 		// wrapper of TclObject's trace command, because some tcl
 		// agents (e.g. srm) uses it.
 		const char* args[4];
@@ -100,6 +100,7 @@ class Agent : public Connector {
 	inline nsaddr_t& port() { return here_.port_; }
 	inline nsaddr_t& daddr() { return dst_.addr_; }
 	inline nsaddr_t& dport() { return dst_.port_; }
+	inline int& flowid() { return fid_; }
 	void set_pkttype(packet_t pkttype) { type_ = pkttype; }
 	inline packet_t get_pkttype() { return type_; }
 
@@ -128,7 +129,8 @@ class Agent : public Connector {
 	int class_;		/* class to place in packet header */
 #endif
 
-	static int uidcnt_;
+	friend class ParallelScheduler;	// keeps a uidcnt_ per LP
+	static NS_THREAD_LOCAL int uidcnt_;
 
 	Tcl_Channel channel_;
 	char *traceName_;		// name used in agent traces
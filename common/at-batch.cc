@@ -0,0 +1,288 @@
+/* -*-	Mode:C++; c-basic-offset:8; tab-width:8; indent-tabs-mode:t -*- */
+/*
+ * Copyright (c) 1994 Regents of the University of California.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor of the Laboratory may be used
+ *    to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "config.h"
+#include "at-batch.h"
+
+/*
+ * Time and position of a call, sorted so that calls of equal time
+ * keep the order in which they were given, as separate "at"s would.
+ */
+struct AtOrder {
+	double time_;
+	int index_;
+};
+
+static int at_order_cmp(const void* a, const void* b)
+{
+	const AtOrder* x = (const AtOrder*)a;
+	const AtOrder* y = (const AtOrder*)b;
+	if (x->time_ != y->time_)
+		return (x->time_ < y->time_ ? -1 : 1);
+	return (x->index_ - y->index_);
+}
+
+AtBatch::AtBatch() :
+	calls_(0), ncalls_(0), maxcalls_(0),
+	strings_(0), nstrings_(0), maxstrings_(0), live_(0)
+{
+}
+
+AtBatch::~AtBatch()
+{
+	delete [] calls_;
+	delete [] strings_;
+}
+
+/*
+ * Schedule the calls of a Tcl list of {time object method arg...}
+ * lists, or of a file holding one such list per line (blank lines and
+ * lines starting with # are skipped).  The object is either a TclObject
+ * name or the name of a global variable holding one, e.g. "ftp(12)".
+ * Nothing is scheduled unless every call is valid; the result is the
+ * number of calls scheduled.
+ */
+int AtBatch::load(Scheduler& s, const char* arg, int isfile)
+{
+	Tcl& tcl = Tcl::instance();
+	AtBatch* b = new AtBatch;
+	Tcl_HashTable tails;
+	Tcl_InitHashTable(&tails, TCL_STRING_KEYS);
+	int ok = 1;
+
+	if (isfile) {
+		FILE* f = fopen(arg, "r");
+		if (f == 0) {
+			tcl.resultf("at-file: cannot open %s", arg);
+			ok = 0;
+		} else {
+			char line[4096];
+			int n = 0;
+			while (ok && fgets(line, sizeof(line), f) != 0) {
+				n++;
+				const char* p = line;
+				while (*p == ' ' || *p == '\t')
+					p++;
+				if (*p == '#' || *p == '\n' || *p == 0)
+					continue;
+				ok = b->add(s, p, n, &tails);
+			}
+			fclose(f);
+		}
+	} else {
+		int n;
+		const char** tuples;
+		if (Tcl_SplitList(tcl.interp(), arg, &n, &tuples) != TCL_OK)
+			ok = 0;
+		else {
+			for (int i = 0; ok && i < n; i++)
+				ok = b->add(s, tuples[i], i + 1, &tails);
+			Tcl_Free((char*)tuples);
+		}
+	}
+	Tcl_DeleteHashTable(&tails);
+	if (!ok || b->ncalls_ == 0) {
+		delete b;
+		if (ok)
+			tcl.result("0");
+		return (ok ? TCL_OK : TCL_ERROR);
+	}
+
+	if (b->maxcalls_ > b->ncalls_) {
+		// the calls stay for the whole run: drop the slack
+		AtCall* nc = new AtCall[b->ncalls_];
+		for (int i = 0; i < b->ncalls_; i++)
+			nc[i] = b->calls_[i];
+		delete [] b->calls_;
+		b->calls_ = nc;
+		b->maxcalls_ = b->ncalls_;
+	}
+	AtOrder* order = new AtOrder[b->ncalls_];
+	for (int i = 0; i < b->ncalls_; i++) {
+		order[i].time_ = b->calls_[i].time_;
+		order[i].index_ = i;
+	}
+	qsort(order, b->ncalls_, sizeof(*order), at_order_cmp);
+	b->live_ = b->ncalls_;
+	for (int i = 0; i < b->ncalls_; i++) {
+		AtCall* c = &b->calls_[order[i].index_];
+		double t = c->time_;
+		c->time_ = 0;
+		s.schedule_call(c->target_, b, c, t);
+	}
+	delete [] order;
+	tcl.resultf("%d", b->ncalls_);
+	return (TCL_OK);
+}
+
+int AtBatch::add(Scheduler& s, const char* tuple, int line,
+		 Tcl_HashTable* tails)
+{
+	Tcl& tcl = Tcl::instance();
+	int argc;
+	const char** argv;
+
+	if (Tcl_SplitList(tcl.interp(), tuple, &argc, &argv) != TCL_OK)
+		return (0);
+	if (argc < 3 || argc > AT_MAXARGS + 3) {
+		tcl.resultf("at-batch: call %d: want <time> <object> "
+		    "<method> ?arg ...?", line);
+		Tcl_Free((char*)argv);
+		return (0);
+	}
+	char* end;
+	double t = strtod(argv[0], &end);
+	if (*end != 0 || end == argv[0] || t < s.clock()) {
+		tcl.resultf("at-batch: call %d: bad time %s (now %g)",
+		    line, argv[0], s.clock());
+		Tcl_Free((char*)argv);
+		return (0);
+	}
+	const char* name = argv[1];
+	if (strncmp(name, "_o", 2) != 0) {
+		name = Tcl_GetVar(tcl.interp(), argv[1], TCL_GLOBAL_ONLY);
+		if (name == 0)
+			name = argv[1];
+	}
+	TclObject* o = TclObject::lookup(name);
+	if (o == 0) {
+		tcl.resultf("at-batch: call %d: no object %s", line, argv[1]);
+		Tcl_Free((char*)argv);
+		return (0);
+	}
+	if (tcl.evalf("%s at-native %s %s", s.name(), o->name(),
+		      argv[2]) != TCL_OK) {
+		Tcl_Free((char*)argv);
+		return (0);
+	}
+	int native = atoi(tcl.result());
+
+	// calls often share their method and arguments ("start")
+	char* key = Tcl_Merge(argc - 2, argv + 2);
+	int isnew;
+	Tcl_HashEntry* he = Tcl_CreateHashEntry(tails, key, &isnew);
+	Tcl_Free(key);
+	if (isnew) {
+		int len = 0;
+		for (int i = 2; i < argc; i++)
+			len += strlen(argv[i]) + 1;
+		if (nstrings_ + len > maxstrings_) {
+			maxstrings_ = 2 * maxstrings_ + len + 256;
+			char* ns = new char[maxstrings_];
+			if (nstrings_ > 0)
+				memcpy(ns, strings_, nstrings_);
+			delete [] strings_;
+			strings_ = ns;
+		}
+		Tcl_SetHashValue(he, (ClientData)(long)nstrings_);
+		for (int i = 2; i < argc; i++) {
+			strcpy(strings_ + nstrings_, argv[i]);
+			nstrings_ += strlen(argv[i]) + 1;
+		}
+	}
+
+	if (ncalls_ == maxcalls_) {
+		maxcalls_ = maxcalls_ ? 2 * maxcalls_ : 64;
+		AtCall* nc = new AtCall[maxcalls_];
+		for (int i = 0; i < ncalls_; i++)
+			nc[i] = calls_[i];
+		delete [] calls_;
+		calls_ = nc;
+	}
+	AtCall* c = &calls_[ncalls_++];
+	c->time_ = t;
+	c->target_ = o;
+	c->str_ = (int)(long)Tcl_GetHashValue(he);
+	c->nargs_ = argc - 3;
+	c->native_ = native;
+	Tcl_Free((char*)argv);
+	return (1);
+}
+
+void AtBatch::handle(Event* e)
+{
+	AtCall* c = (AtCall*)e;
+	Tcl& tcl = Tcl::instance();
+	const char* argv[AT_MAXARGS + 2];
+	int argc = c->nargs_ + 2;
+	const char* p = strings_ + c->str_;
+
+	argv[0] = "cmd";
+	for (int i = 1; i < argc; i++) {
+		argv[i] = p;
+		p += strlen(p) + 1;
+	}
+	int st;
+	if (c->native_) {
+		Tcl_ResetResult(tcl.interp());
+		st = c->target_->command(argc, argv);
+	} else {
+		Tcl_Obj* objv[AT_MAXARGS + 2];
+		objv[0] = Tcl_NewStringObj(c->target_->name(), -1);
+		for (int i = 1; i < argc; i++)
+			objv[i] = Tcl_NewStringObj(argv[i], -1);
+		for (int i = 0; i < argc; i++)
+			Tcl_IncrRefCount(objv[i]);
+		st = Tcl_EvalObjv(tcl.interp(), argc, objv, TCL_EVAL_GLOBAL);
+		for (int i = 0; i < argc; i++)
+			Tcl_DecrRefCount(objv[i]);
+	}
+	if (st != TCL_OK) {
+		char buf[256];
+		snprintf(buf, sizeof(buf), "%s %s", c->target_->name(), argv[1]);
+		tcl.error(buf);
+	}
+	release();
+}
+
+/*
+ * Remove e, if it is a call of a batch, from the scheduler and free
+ * it; return 0 for any other event.
+ */
+int AtBatch::cancel(Scheduler& s, Event* e)
+{
+	AtBatch* b = dynamic_cast<AtBatch*>(e->handler_);
+	if (b == 0)
+		return (0);
+	s.cancel(e);
+	b->release();
+	return (1);
+}
+
+/* the last call of a batch frees it */
+void AtBatch::release()
+{
+	if (--live_ == 0)
+		delete this;
+}
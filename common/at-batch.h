@@ -0,0 +1,84 @@
+/* -*-	Mode:C++; c-basic-offset:8; tab-width:8; indent-tabs-mode:t -*- */
+/*
+ * Copyright (c) 1994 Regents of the University of California.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor of the Laboratory may be used
+ *    to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+/*
+ * Batches of "at" events.
+ *
+ * "$ns at-batch <list>" and "$ns at-file <file>" schedule many calls
+ * of the form <time> <object> <method> <arg>... at once.  Rather than
+ * one AtEvent and one copy of the script per call, a batch keeps its
+ * calls in one array and their methods and arguments in one string
+ * pool, and schedules them in order of time (which the heap takes in
+ * O(1) each).  A call runs without its script being parsed again: if
+ * <method> is not defined in OTcl for the object, the object's
+ * command() is called directly, as if through "cmd", and otherwise
+ * the words are passed to Tcl_EvalObjv().  The objects must outlive
+ * their calls, as for any C++ event.
+ */
+
+#ifndef ns_at_batch_h
+#define ns_at_batch_h
+
+#include "scheduler.h"
+
+#define AT_MAXARGS	32	/* arguments of a call, besides the method */
+
+struct AtCall : public Event {
+	TclObject* target_;
+	int str_;		/* method and args, NUL separated, at
+				 * this offset in the batch's strings_ */
+	short nargs_;		/* args besides the method */
+	short native_;		/* call target_->command() directly */
+};
+
+class AtBatch : public Handler {
+public:
+	static int load(Scheduler& s, const char* list, int isfile);
+	static int cancel(Scheduler& s, Event* e);
+	void handle(Event* e);
+
+protected:
+	AtBatch();
+	~AtBatch();
+	int add(Scheduler& s, const char* tuple, int line,
+		Tcl_HashTable* tails);
+	void release();
+
+	AtCall* calls_;
+	int ncalls_;
+	int maxcalls_;
+	char* strings_;
+	int nstrings_;
+	int maxstrings_;
+	int live_;		/* calls scheduled and not yet run */
+};
+
+#endif
@@ -0,0 +1,86 @@
+/* -*-	Mode:C++; c-basic-offset:8; tab-width:8; indent-tabs-mode:t -*- */
+/*
+ * Copyright (c) 1994 Regents of the University of California.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor of the Laboratory may be used
+ *    to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "cmd-table.h"
+
+/*
+ * Find a seed under which the names of the table fall into distinct
+ * slots of a table of at least twice their number, doubling the table
+ * whenever a few hundred seeds fail.  The tables are a few dozen
+ * names at most, so this takes microseconds, once per table.
+ */
+CommandTable::CommandTable(const Entry* entries) :
+	entries_(entries), n_(0), slots_(0), mask_(0), seed_(0)
+{
+	while (entries_[n_].name_ != 0)
+		n_++;
+	for (int i = 0; i < n_; i++)
+		for (int j = 0; j < i; j++)
+			if (strcmp(entries_[i].name_, entries_[j].name_) == 0) {
+				fprintf(stderr, "CommandTable: \"%s\" is listed twice\n",
+					entries_[i].name_);
+				abort();
+			}
+	int nslots = 4;
+	while (nslots < 2 * n_)
+		nslots <<= 1;
+	for (;;) {
+		for (unsigned int seed = 0; seed < 256; seed++)
+			if (place(nslots, seed))
+				return;
+		nslots <<= 1;
+	}
+}
+
+CommandTable::~CommandTable()
+{
+	delete [] slots_;
+}
+
+int CommandTable::place(int nslots, unsigned int seed)
+{
+	if (slots_ == 0 || (int)mask_ + 1 != nslots) {
+		delete [] slots_;
+		slots_ = new const Entry*[nslots];
+		mask_ = nslots - 1;
+	}
+	memset(slots_, 0, nslots * sizeof(*slots_));
+	for (int i = 0; i < n_; i++) {
+		const Entry*& s = slots_[hash(entries_[i].name_, seed) & mask_];
+		if (s != 0)
+			return (0);
+		s = &entries_[i];
+	}
+	seed_ = seed;
+	return (1);
+}
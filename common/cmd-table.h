@@ -0,0 +1,99 @@
+/* -*-	Mode:C++; c-basic-offset:8; tab-width:8; indent-tabs-mode:t -*- */
+/*
+ * Copyright (c) 1994 Regents of the University of California.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor of the Laboratory may be used
+ *    to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+/*
+ * Command tables.
+ *
+ * command() is usually a chain of strcmp()s on argv[1], which costs
+ * every Tcl call to a late entry (or to a base class, which runs the
+ * chains of all the derived classes first) a dozen or more string
+ * compares.  A CommandTable maps the subcommand names a command()
+ * understands to small integers with a perfect hash built once, at
+ * static initialisation: one hash of argv[1], one probe and a single
+ * strcmp to confirm.  Classes opt in one at a time:
+ *
+ *	enum { CMD_AT, CMD_NOW };
+ *	static const CommandTable::Entry sched_cmds[] = {
+ *		{ "at", CMD_AT }, { "now", CMD_NOW }, { 0, 0 }
+ *	};
+ *	static CommandTable sched_table(sched_cmds);
+ *	...
+ *	int cmd = sched_table.find(argv[1]);
+ *	if (argc == 2 && cmd == CMD_NOW) ...
+ *
+ * find() returns -1 for names not in the table, which command() then
+ * hands to its base class as before.  The argc checks stay where they
+ * were, so a table can replace the strcmp()s of an existing chain
+ * without touching its structure.
+ */
+
+#ifndef ns_cmd_table_h
+#define ns_cmd_table_h
+
+#include <string.h>
+
+class CommandTable {
+public:
+	struct Entry {
+		const char* name_;
+		int id_;
+	};
+	/* entries ends with a { 0, 0 } entry; it must outlive the table */
+	CommandTable(const Entry* entries);
+	~CommandTable();
+	inline int find(const char* name) const {
+		const Entry* e = slots_[hash(name, seed_) & mask_];
+		if (e != 0 && strcmp(e->name_, name) == 0)
+			return (e->id_);
+		return (-1);
+	}
+	int size() const { return (n_); }
+
+protected:
+	/* FNV-1a, perturbed by seed */
+	static inline unsigned int hash(const char* s, unsigned int seed) {
+		unsigned int h = 2166136261U ^ seed;
+		while (*s != 0) {
+			h ^= (unsigned char)*s++;
+			h *= 16777619U;
+		}
+		return (h ^ (h >> 15));
+	}
+	int place(int nslots, unsigned int seed);
+
+	const Entry* entries_;
+	int n_;
+	const Entry** slots_;
+	unsigned int mask_;
+	unsigned int seed_;
+};
+
+#endif
@@ -67,6 +67,15 @@ int Connector::command(int argc, const char*const* argv)
 		if (strcmp(argv[1], "isDynamic") == 0) {
 			return TCL_OK;
 		}
+		/*
+		 * Connectors that know their usual successor (Queue,
+		 * LinkDelay) may call it directly, see Queue::transmit;
+		 * the others have no shortcut to set up.
+		 */
+		if (strcmp(argv[1], "fast-path") == 0) {
+			tcl.result("0");
+			return (TCL_OK);
+		}
 	}
 
 	else if (argc == 3) {
@@ -0,0 +1,407 @@
+/* -*-	Mode:C++; c-basic-offset:8; tab-width:8; indent-tabs-mode:t -*- */
+/*
+ * Copyright (c) 1994 Regents of the University of California.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor of the Laboratory may be used
+ *    to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+/*
+ * Ladder queue scheduler.
+ *
+ * W.T. Tang, R.S.M. Goh and I.L.-J. Thng, "Ladder Queue: An O(1)
+ * Priority Queue Structure for Large-Scale Discrete Event Simulation",
+ * ACM TOMACS 15(3):175-204, July 2005.
+ *
+ * The event set is split into three tiers:
+ *
+ *  - top: an unsorted list of far-future events, appended in O(1);
+ *  - rungs: up to LADDER_MAX_RUNGS calendars of buckets, each rung
+ *    subdividing one bucket of the rung above it;
+ *  - bottom: a short sorted list from which events are dispatched.
+ *
+ * Nothing is sorted until it reaches bottom.  When bottom runs dry the
+ * next non-empty bucket of the lowest rung is either sorted into bottom
+ * (if it holds at most bucket_threshold_ events) or spread over a new,
+ * finer rung; when the rungs run dry the whole of top is spread over a
+ * new rung sized from its actual time span.  Unlike the calendar queue
+ * the bucket width is therefore derived from each batch of events
+ * rather than re-estimated globally, so bursts of timers with very
+ * different horizons do not cause resizing storms.
+ *
+ * Events on every list keep their insertion order and bottom is sorted
+ * with a stable merge sort, so simultaneous events are dispatched FIFO,
+ * exactly as the heap scheduler does.  Bucket indices are computed with
+ * the same (monotone) arithmetic on insertion and on transfer, and an
+ * event is only placed in a rung whose remaining buckets cover its
+ * timestamp, so no event can ever overtake an earlier one.
+ */
+
+#include <float.h>
+#include <assert.h>
+
+#include "scheduler.h"
+
+static class LadderSchedulerClass : public TclClass {
+public:
+	LadderSchedulerClass() : TclClass("Scheduler/Ladder") {}
+	TclObject* create(int /* argc */, const char*const* /* argv */) {
+		return (new LadderScheduler);
+	}
+} class_ladder_sched;
+
+static inline void
+ladder_init(Event* s)
+{
+	s->next_ = s->prev_ = s;
+}
+
+static inline void
+ladder_append(Event* s, Event* e)
+{
+	e->next_ = s;
+	e->prev_ = s->prev_;
+	s->prev_->next_ = e;
+	s->prev_ = e;
+}
+
+static inline void
+ladder_unlink(Event* e)
+{
+	e->prev_->next_ = e->next_;
+	e->next_->prev_ = e->prev_;
+	e->next_ = e->prev_ = NULL;
+}
+
+/* Cancel every event on list s, leaving s empty. */
+static void
+ladder_clear(Event* s)
+{
+	while (s->next_ != s) {
+		Event* e = s->next_;
+		ladder_unlink(e);
+		if (e->uid_ > 0)
+			e->uid_ = -e->uid_;
+	}
+}
+
+/*
+ * Unhook all events on list s and return them as a NULL-terminated
+ * chain through next_, leaving s empty.  On the way we count them and
+ * note their time span and whether they are already in time order.
+ */
+static Event*
+ladder_detach(Event* s, int& n, double& tmin, double& tmax, int& sorted)
+{
+	Event* h = s->next_;
+	n = 0;
+	sorted = 1;
+	if (h == s)
+		return NULL;
+	tmin = tmax = h->time_;
+	for (Event* p = h; p != s; p = p->next_) {
+		++n;
+		if (p->time_ < tmax) {
+			sorted = 0;
+			if (p->time_ < tmin)
+				tmin = p->time_;
+		} else
+			tmax = p->time_;
+	}
+	s->prev_->next_ = NULL;
+	ladder_init(s);
+	return h;
+}
+
+/* Stable merge sort of a NULL-terminated chain of n events. */
+static Event*
+ladder_sort(Event* h, int n)
+{
+	if (n < 2)
+		return h;
+	int half = n / 2;
+	Event* p = h;
+	for (int i = 1; i < half; ++i)
+		p = p->next_;
+	Event* b = p->next_;
+	p->next_ = NULL;
+	Event* a = ladder_sort(h, half);
+	b = ladder_sort(b, n - half);
+
+	Event* out;
+	Event** tail = &out;
+	while (a != NULL && b != NULL) {
+		// take from the left on ties to keep FIFO order
+		if (b->time_ < a->time_) {
+			*tail = b;
+			tail = &b->next_;
+			b = b->next_;
+		} else {
+			*tail = a;
+			tail = &a->next_;
+			a = a->next_;
+		}
+	}
+	*tail = (a != NULL) ? a : b;
+	return out;
+}
+
+LadderScheduler::LadderScheduler() : top_start_(-DBL_MAX), nrungs_(0), qsize_(0)
+{
+	bind("bucket_threshold_", &threshold_);
+	ladder_init(&top_);
+	ladder_init(&bottom_);
+	for (int i = 0; i < LADDER_MAX_RUNGS; ++i) {
+		rungs_[i].buckets_ = NULL;
+		rungs_[i].nbuckets_ = rungs_[i].maxbuckets_ = 0;
+		rungs_[i].cur_ = 0;
+		rungs_[i].start_ = rungs_[i].width_ = 0;
+	}
+}
+
+/*
+ * The events still queued belong to their handlers (timers, packets),
+ * so they are cancelled, not freed: unhooked from the lists, which go
+ * away with the rungs, and marked as no longer pending.
+ */
+LadderScheduler::~LadderScheduler()
+{
+	ladder_clear(&top_);
+	ladder_clear(&bottom_);
+	for (int i = 0; i < LADDER_MAX_RUNGS; ++i) {
+		for (int j = 0; j < rungs_[i].nbuckets_; ++j)
+			ladder_clear(&rungs_[i].buckets_[j]);
+		delete [] rungs_[i].buckets_;
+	}
+	qsize_ = 0;
+}
+
+/*
+ * Bucket of rung r that covers time t, or -1 if t falls before the
+ * start of the rung.  Times past the end of the rung are clamped into
+ * its last bucket; callers only ever offer such times to a rung whose
+ * parent guarantees they precede everything after it.
+ */
+inline int
+LadderScheduler::bucket(const Rung& r, double t) const
+{
+	double d = (t - r.start_) / r.width_;
+	if (d < 0)
+		return -1;
+	if (d >= r.nbuckets_ - 1)
+		return r.nbuckets_ - 1;
+	return (int)d;
+}
+
+/*
+ * Spread a chain of n events with timestamps in [tmin, tmax] over a new
+ * lowest rung.  Returns 0 (leaving the chain untouched) if the ladder
+ * is already at full depth or the span cannot be subdivided.
+ */
+int
+LadderScheduler::spawn(Event* chain, int n, double tmin, double tmax)
+{
+	if (nrungs_ == LADDER_MAX_RUNGS)
+		return 0;
+	int nb = (n < LADDER_MAX_BUCKETS) ? n : LADDER_MAX_BUCKETS;
+	double width = (tmax - tmin) / nb;
+	if (!(width > 0))
+		return 0;
+
+	Rung& r = rungs_[nrungs_++];
+	if (nb > r.maxbuckets_) {
+		delete [] r.buckets_;
+		r.buckets_ = new Event[nb];
+		r.maxbuckets_ = nb;
+	}
+	for (int i = 0; i < nb; ++i)
+		ladder_init(&r.buckets_[i]);
+	r.nbuckets_ = nb;
+	r.cur_ = 0;
+	r.start_ = tmin;
+	r.width_ = width;
+
+	while (chain != NULL) {
+		Event* e = chain;
+		chain = e->next_;
+		ladder_append(&r.buckets_[bucket(r, e->time_)], e);
+	}
+	return 1;
+}
+
+/* Move a chain of n events onto the (empty) bottom list in time order. */
+void
+LadderScheduler::sort_to_bottom(Event* chain, int n, int sorted)
+{
+	if (!sorted)
+		chain = ladder_sort(chain, n);
+	while (chain != NULL) {
+		Event* e = chain;
+		chain = e->next_;
+		ladder_append(&bottom_, e);
+	}
+}
+
+/*
+ * Refill the empty bottom list from the lowest non-empty rung, or from
+ * top when all rungs are exhausted.  Returns 0 if the queue is empty.
+ */
+int
+LadderScheduler::refill()
+{
+	int n, sorted;
+	double tmin, tmax;
+	Event* chain;
+
+	for (;;) {
+		if (nrungs_ == 0) {
+			chain = ladder_detach(&top_, n, tmin, tmax, sorted);
+			if (chain == NULL)
+				return 0;
+			top_start_ = tmax;
+			if (n > threshold_ && spawn(chain, n, tmin, tmax))
+				continue;
+			sort_to_bottom(chain, n, sorted);
+			return 1;
+		}
+
+		Rung& r = rungs_[nrungs_ - 1];
+		while (r.cur_ < r.nbuckets_ &&
+		       r.buckets_[r.cur_].next_ == &r.buckets_[r.cur_])
+			++r.cur_;
+		if (r.cur_ == r.nbuckets_) {
+			--nrungs_;
+			continue;
+		}
+		chain = ladder_detach(&r.buckets_[r.cur_++], n, tmin, tmax, sorted);
+		if (n > threshold_ && spawn(chain, n, tmin, tmax))
+			continue;
+		sort_to_bottom(chain, n, sorted);
+		return 1;
+	}
+}
+
+void
+LadderScheduler::insert(Event* e)
+{
+	double t = e->time_;
+
+	if (qsize_++ == 0) {
+		// everything is empty: start over with a fresh ladder
+		top_start_ = -DBL_MAX;
+		nrungs_ = 0;
+	}
+
+	if (t >= top_start_) {
+		ladder_append(&top_, e);
+		return;
+	}
+	for (int i = 0; i < nrungs_; ++i) {
+		Rung& r = rungs_[i];
+		int b = bucket(r, t);
+		if (b >= r.cur_) {
+			ladder_append(&r.buckets_[b], e);
+			return;
+		}
+	}
+
+	// earlier than anything left on the rungs: sorted insert into
+	// bottom, searching from the tail and after any simultaneous events
+	Event* p = bottom_.prev_;
+	int steps = 0;
+	for (; p != &bottom_ && t < p->time_; p = p->prev_)
+		++steps;
+	e->prev_ = p;
+	e->next_ = p->next_;
+	p->next_->prev_ = e;
+	p->next_ = e;
+
+	if (steps > threshold_) {
+		// bottom has grown too long to search: turn it into a rung
+		int n, sorted;
+		double tmin, tmax;
+		Event* chain = ladder_detach(&bottom_, n, tmin, tmax, sorted);
+		if (!spawn(chain, n, tmin, tmax))
+			sort_to_bottom(chain, n, 1);
+	}
+}
+
+/*
+ * Cancel an event.  It is an error to call this routine
+ * when the event is not actually in the queue.  The caller
+ * must free the event if necessary; this routine only removes
+ * it from the scheduler queue.
+ */
+void
+LadderScheduler::cancel(Event* e)
+{
+	if (e->uid_ <= 0)	// event not in queue
+		return;
+	ladder_unlink(e);
+	e->uid_ = -e->uid_;
+	--qsize_;
+}
+
+const Event*
+LadderScheduler::head()
+{
+	if (bottom_.next_ == &bottom_ && !refill())
+		return NULL;
+	return bottom_.next_;
+}
+
+Event*
+LadderScheduler::deque()
+{
+	if (bottom_.next_ == &bottom_ && !refill())
+		return NULL;
+	Event* e = bottom_.next_;
+	ladder_unlink(e);
+	--qsize_;
+	return e;
+}
+
+Event*
+LadderScheduler::lookup(scheduler_uid_t uid)
+{
+	Event* p;
+	for (p = bottom_.next_; p != &bottom_; p = p->next_)
+		if (p->uid_ == uid)
+			return p;
+	for (int i = nrungs_ - 1; i >= 0; --i) {
+		Rung& r = rungs_[i];
+		for (int b = r.cur_; b < r.nbuckets_; ++b) {
+			Event* s = &r.buckets_[b];
+			for (p = s->next_; p != s; p = p->next_)
+				if (p->uid_ == uid)
+					return p;
+		}
+	}
+	for (p = top_.next_; p != &top_; p = p->next_)
+		if (p->uid_ == uid)
+			return p;
+	return NULL;
+}
@@ -59,6 +59,7 @@
 #include "phy.h"
 #include "wired-phy.h"
 #include "god.h"
+#include "cmd-table.h"
 
 // XXX Must supply the first parameter in the macro otherwise msvc
 // is unhappy. 
@@ -126,6 +127,9 @@ MobileNode::MobileNode(void) :
 	next_ = 0;
 	radius_ = 0;
 
+	gridCell_ = gridIndex_ = -1;
+	gridDeadline_ = -1;
+
 	position_update_interval_ = MN_POSITION_UPDATE_INTERVAL;
 	position_update_time_ = 0.0;
 	
@@ -139,15 +143,70 @@ MobileNode::MobileNode(void) :
 	
 }
 
+/* the subcommands of MobileNode::command() */
+enum {
+	CMD_START,
+	CMD_LOG_MOVEMENT,
+	CMD_LOG_ENERGY,
+	CMD_POWERSAVING,
+	CMD_ADAPTIVEFIDELITY,
+	CMD_ENERGY,
+	CMD_ADJUSTENERGY,
+	CMD_ON,
+	CMD_OFF,
+	CMD_SHUTDOWN,
+	CMD_STARTUP,
+	CMD_ADDIF,
+	CMD_SETSLEEPTIME,
+	CMD_SETENERGY,
+	CMD_SETTALIVE,
+	CMD_MAXTTL,
+	CMD_RADIUS,
+	CMD_RANDOM_MOTION,
+	CMD_TOPOGRAPHY,
+	CMD_LOG_TARGET,
+	CMD_BASE_STATION,
+	CMD_IDLEENERGY,
+	CMD_SETDEST
+};
+static const CommandTable::Entry mobile_cmds[] = {
+	{ "start", CMD_START },
+	{ "log-movement", CMD_LOG_MOVEMENT },
+	{ "log-energy", CMD_LOG_ENERGY },
+	{ "powersaving", CMD_POWERSAVING },
+	{ "adaptivefidelity", CMD_ADAPTIVEFIDELITY },
+	{ "energy", CMD_ENERGY },
+	{ "adjustenergy", CMD_ADJUSTENERGY },
+	{ "on", CMD_ON },
+	{ "off", CMD_OFF },
+	{ "shutdown", CMD_SHUTDOWN },
+	{ "startup", CMD_STARTUP },
+	{ "addif", CMD_ADDIF },
+	{ "setsleeptime", CMD_SETSLEEPTIME },
+	{ "setenergy", CMD_SETENERGY },
+	{ "settalive", CMD_SETTALIVE },
+	{ "maxttl", CMD_MAXTTL },
+	{ "radius", CMD_RADIUS },
+	{ "random-motion", CMD_RANDOM_MOTION },
+	{ "topography", CMD_TOPOGRAPHY },
+	{ "log-target", CMD_LOG_TARGET },
+	{ "base-station", CMD_BASE_STATION },
+	{ "idleenergy", CMD_IDLEENERGY },
+	{ "setdest", CMD_SETDEST },
+	{ 0, 0 }
+};
+static CommandTable mobile_table(mobile_cmds);
+
 int
 MobileNode::command(int argc, const char*const* argv)
 {
 	Tcl& tcl = Tcl::instance();
+	int cmd = mobile_table.find(argv[1]);
 	if(argc == 2) {
-		if(strcmp(argv[1], "start") == 0) {
+		if(cmd == CMD_START) {
 		        start();
 			return TCL_OK;
-		} else if(strcmp(argv[1], "log-movement") == 0) {
+		} else if(cmd == CMD_LOG_MOVEMENT) {
 #ifdef DEBUG
                         fprintf(stderr,
                                 "%d - %s: calling update_position()\n",
@@ -156,23 +215,23 @@ MobileNode::command(int argc, const char*const* argv)
 		        update_position();
 		        log_movement();
 			return TCL_OK;
-		} else if(strcmp(argv[1], "log-energy") == 0) {
+		} else if(cmd == CMD_LOG_ENERGY) {
 			log_energy(1);
 			return TCL_OK;
-		} else if(strcmp(argv[1], "powersaving") == 0) {
+		} else if(cmd == CMD_POWERSAVING) {
 			energy_model()->powersavingflag() = 1;
 			energy_model()->start_powersaving();
 			return TCL_OK;
-		} else if(strcmp(argv[1], "adaptivefidelity") == 0) {
+		} else if(cmd == CMD_ADAPTIVEFIDELITY) {
 			energy_model()->adaptivefidelity() = 1;
 			energy_model()->powersavingflag() = 1;
 			energy_model()->start_powersaving();
 			return TCL_OK;
-		} else if (strcmp(argv[1], "energy") == 0) {
+		} else if (cmd == CMD_ENERGY) {
 			Tcl& tcl = Tcl::instance();
 			tcl.resultf("%f", energy_model()->energy());
 			return TCL_OK;
-		} else if (strcmp(argv[1], "adjustenergy") == 0) {
+		} else if (cmd == CMD_ADJUSTENERGY) {
 			// assume every 10 sec schedule and 1.15 W 
 			// idle energy consumption. needs to be
 			// parameterized.
@@ -181,14 +240,14 @@ MobileNode::command(int argc, const char*const* argv)
 			energy_model()->total_rcvtime() = 0;
 			energy_model()->total_sleeptime() = 0;
 			return TCL_OK;
-		} else if (strcmp(argv[1], "on") == 0) {
+		} else if (cmd == CMD_ON) {
 			energy_model()->node_on() = true;
 			tcl.evalf("%s set netif_(0)", name_);
 			const char *str = tcl.result();
 			tcl.evalf("%s NodeOn", str);
 			God::instance()->ComputeRoute();
 			return TCL_OK;
-		} else if (strcmp(argv[1], "off") == 0) {
+		} else if (cmd == CMD_OFF) {
 			energy_model()->node_on() = false;
 			tcl.evalf("%s set netif_(0)", name_);
 			const char *str = tcl.result();
@@ -198,7 +257,7 @@ MobileNode::command(int argc, const char*const* argv)
 			tcl.evalf("%s reset-state", str);
 			God::instance()->ComputeRoute();
 		     	return TCL_OK;
-		} else if (strcmp(argv[1], "shutdown") == 0) {
+		} else if (cmd == CMD_SHUTDOWN) {
 			// set node state
 			//Phy *p;
 			energy_model()->node_on() = false;
@@ -206,39 +265,39 @@ MobileNode::command(int argc, const char*const* argv)
 			//p = ifhead().lh_first;
 			//if (p) ((WirelessPhy *)p)->node_off();
 			return TCL_OK;
-		} else if (strcmp(argv[1], "startup") == 0) {
+		} else if (cmd == CMD_STARTUP) {
 			energy_model()->node_on() = true;
 			return TCL_OK;
 		}
 	
 	} else if(argc == 3) {
-		if(strcmp(argv[1], "addif") == 0) {
+		if(cmd == CMD_ADDIF) {
 			WiredPhy* phyp = (WiredPhy*)TclObject::lookup(argv[2]);
 			if(phyp == 0)
 				return TCL_ERROR;
 			phyp->insertnode(&ifhead_);
 			phyp->setnode(this);
 			return TCL_OK;
-		} else if (strcmp(argv[1], "setsleeptime") == 0) {
+		} else if (cmd == CMD_SETSLEEPTIME) {
 			energy_model()->afe()->set_sleeptime(atof(argv[2]));
 			energy_model()->afe()->set_sleepseed(atof(argv[2]));
 			return TCL_OK;
-		} else if (strcmp(argv[1], "setenergy") == 0) {
+		} else if (cmd == CMD_SETENERGY) {
 			energy_model()->setenergy(atof(argv[2]));
 			return TCL_OK;
-		} else if (strcmp(argv[1], "settalive") == 0) {
+		} else if (cmd == CMD_SETTALIVE) {
 			energy_model()->max_inroute_time() = atof(argv[2]);
 			return TCL_OK;
-		} else if (strcmp(argv[1], "maxttl") == 0) {
+		} else if (cmd == CMD_MAXTTL) {
 			energy_model()->maxttl() = atoi(argv[2]);
 			return TCL_OK;
-		} else if(strcmp(argv[1], "radius") == 0) {
+		} else if(cmd == CMD_RADIUS) {
                         radius_ = strtod(argv[2],NULL);
                         return TCL_OK;
-                } else if(strcmp(argv[1], "random-motion") == 0) {
+                } else if(cmd == CMD_RANDOM_MOTION) {
 			random_motion_ = atoi(argv[2]);
 			return TCL_OK;
-		} else if(strcmp(argv[1], "addif") == 0) {
+		} else if(cmd == CMD_ADDIF) {
 			WirelessPhy *n = (WirelessPhy*)
 				TclObject::lookup(argv[2]);
 			if(n == 0)
@@ -246,29 +305,29 @@ MobileNode::command(int argc, const char*const* argv)
 			n->insertnode(&ifhead_);
 			n->setnode(this);
 			return TCL_OK;
-		} else if(strcmp(argv[1], "topography") == 0) {
+		} else if(cmd == CMD_TOPOGRAPHY) {
 			T_ = (Topography*) TclObject::lookup(argv[2]);
 			if (T_ == 0)
 				return TCL_ERROR;
 			return TCL_OK;
-		} else if(strcmp(argv[1], "log-target") == 0) {
+		} else if(cmd == CMD_LOG_TARGET) {
 			log_target_ = (Trace*) TclObject::lookup(argv[2]);
 			if (log_target_ == 0)
 				return TCL_ERROR;
 			return TCL_OK;
-		} else if (strcmp(argv[1],"base-station") == 0) {
+		} else if (cmd == CMD_BASE_STATION) {
 			base_stn_ = atoi(argv[2]);
 			if(base_stn_ == -1)
 				return TCL_ERROR;
 			return TCL_OK;
 		} 
 	} else if (argc == 4) {
-		if (strcmp(argv[1], "idleenergy") == 0) {
+		if (cmd == CMD_IDLEENERGY) {
 			idle_energy_patch(atof(argv[2]),atof(argv[3]));
 			return TCL_OK;
 		}
 	} else if (argc == 5) {
-		if (strcmp(argv[1], "setdest") == 0) { 
+		if (cmd == CMD_SETDEST) { 
 			/* <mobilenode> setdest <X> <Y> <speed> */
 #ifdef DEBUG
 			fprintf(stderr, "%d - %s: calling set_destination()\n",
@@ -436,6 +495,9 @@ MobileNode::set_destination(double x, double y, double s)
 #endif
 	log_movement();
 
+	/* the neighbor grid bounds how far a node can drift by its speed */
+	T_->updateNodesList(this, X_);
+
 	/* update gridkeeper */
 	if (GridKeeper::instance()){
 		GridKeeper* gp =  GridKeeper::instance();
@@ -460,13 +522,30 @@ MobileNode::set_destination(double x, double y, double s)
 
 
 
+/*
+ * Apply the position refreshes the channel's neighbor grid has put off
+ * (see mac/channel.cc).  A no-op with the channel's X-sorted list.
+ */
+void
+MobileNode::catchUp()
+{
+	if (T_ != 0)
+		T_->catchUp(this);
+}
+
 void 
 MobileNode::update_position()
 {
-	double now = Scheduler::instance().clock();
+	catchUp();
+	update_position(Scheduler::instance().clock());
+}
+
+void 
+MobileNode::update_position(double now)
+{
 	double interval = now - position_update_time_;
 	double oldX = X_;
-	//double oldY = Y_;
+	double oldY = Y_;
 
 	if ((interval == 0.0)&&(position_update_time_!=0))
 		return;         // ^^^ for list-based imprvmnt 
@@ -481,9 +560,6 @@ MobileNode::update_position()
 	if ((dY_ > 0 && Y_ > destY_) || (dY_ < 0 && Y_ < destY_))
 	  Y_ = destY_;		// correct overshoot (slow? XXX)
 	
-	/* list based improvement */
-	if(oldX != X_)// || oldY != Y_)
-		T_->updateNodesList(this, oldX);//, oldY);
 	// COMMENTED BY -VAL- // bound_position();
 
 	// COMMENTED BY -VAL- // Z_ = T_->height(X_, Y_);
@@ -493,6 +569,10 @@ MobileNode::update_position()
 		address_, X_, Y_, Z_, now);
 #endif
 	position_update_time_ = now;
+
+	/* list based improvement */
+	if(oldX != X_ || oldY != Y_)
+		T_->updateNodesList(this, oldX);
 }
 
 
@@ -519,6 +599,7 @@ MobileNode::random_destination()
 		exit(1);
 	}
 
+	catchUp();		// at the old speed
 	random_speed();
 #ifdef DEBUG
         fprintf(stderr, "%d - %s: calling set_destination()\n",
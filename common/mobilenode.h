@@ -117,6 +117,7 @@ private:
 class MobileNode : public Node 
 {
 	friend class PositionHandler;
+	friend class MobilityScenario;
 public:
 	MobileNode();
 	virtual int command(int argc, const char*const* argv);
@@ -151,6 +152,8 @@ public:
 	//inline double last_routingtime() { return last_rt_time_;}
 
 	void update_position();
+	void update_position(double now);
+	void catchUp();
 	void log_energy(int);
 	//void logrttime(double);
 	virtual void idle_energy_patch(float, float);
@@ -158,6 +161,11 @@ public:
 	/* For list-keeper */
 	MobileNode* nextX_;
 	MobileNode* prevX_;
+
+	/* For the channel's neighbor grid */
+	int gridCell_;		// cell the node is filed under
+	int gridIndex_;		// position in that cell
+	double gridDeadline_;	// when its position must be refreshed
 	
 protected:
 	/*
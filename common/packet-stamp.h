@@ -22,7 +22,7 @@ class MobileNode;
 class PacketStamp {
 public:
 
-  PacketStamp() : ant(0), node(0), Pr(-1), lambda(-1) { }
+  PacketStamp() : batchPr(-1), ant(0), node(0), Pr(-1), lambda(-1) { }
 
   void init(const PacketStamp *s) {
 	  Antenna* ant;
@@ -40,6 +40,7 @@ public:
     node = n;
     Pr = xmitPr;
     lambda = lam;
+    batchPr = -1;
   }
 
   inline Antenna * getAntenna() {return ant;}
@@ -55,6 +56,11 @@ public:
   double RxPr;			// power with which pkt is received
   double CPThresh;		// capture threshold for recving interface
 
+  /* Power with which the receiving interface gets the packet, already
+     worked out by the channel when it was sent (batch_pr_ in
+     WirelessChannel), or -1 if the interface has to work it out. */
+  double batchPr;
+
 protected:
   Antenna       *ant;
   MobileNode	*node;
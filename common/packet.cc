@@ -33,6 +33,7 @@ static const char rcsid[] =
     "@(#) $Header: /home/smtatapudi/Thesis/nsnam/nsnam/ns-2/common/packet.cc,v 1.20 2012/05/07 02:30:36 tom_henderson Exp $ (LBL)";
 #endif
 
+#include <new>
 #include "packet.h"
 #include "flags.h"
 
@@ -54,7 +55,9 @@ int p_info::addPacket(char *name)
 }
 
 int Packet::hdrlen_ = 0;		// size of a packet's header
-Packet* Packet::free_;			// free list
+int Packet::hdrguard_ = 0;		// offset of pruned headers, if any
+NS_THREAD_LOCAL Packet* Packet::free_;			// free list
+NS_THREAD_LOCAL PacketPoolStats Packet::stats_;		// pool counters
 int hdr_cmn::offset_;			// static offset of common header
 int hdr_flags::offset_;			// static offset of flags header
 
@@ -140,14 +143,135 @@ public:
 } class_flagshdr;
 
 
+/*
+ * Free lists of packets whose headers were carved for some other
+ * hdrlen_ than the current one.  Scripts normally fix the header set
+ * once, before the first packet is allocated, so this list holds at
+ * most a couple of entries; packets parked here are reused if hdrlen_
+ * ever returns to their size.  Per thread, like free_.
+ */
+struct PacketSlabPool {
+	int hdrlen_;
+	Packet* free_;
+	PacketSlabPool* next_;
+};
+static NS_THREAD_LOCAL PacketSlabPool* slab_pools;
+
+static Packet*& slab_pool(int hdrlen)
+{
+	PacketSlabPool* sp;
+	for (sp = slab_pools; sp != 0; sp = sp->next_)
+		if (sp->hdrlen_ == hdrlen)
+			return (sp->free_);
+	sp = new PacketSlabPool;
+	sp->hdrlen_ = hdrlen;
+	sp->free_ = 0;
+	sp->next_ = slab_pools;
+	slab_pools = sp;
+	return (sp->free_);
+}
+
+void Packet::park(Packet* p)
+{
+	Packet*& fl = slab_pool(p->bitslen_);
+	p->next_ = fl;
+	fl = p;
+}
+
+/* round up to a multiple of 8 so that every header block is aligned */
+#define SLAB_ROUND(n)	(((n) + 7) & ~7)
+
+Packet* Packet::slab_alloc()
+{
+	// hdrlen_ changed since these were freed: put them aside
+	while (free_ != 0 && free_->bitslen_ != hdrlen_) {
+		Packet* p = free_;
+		free_ = p->next_;
+		park(p);
+	}
+	if (free_ == 0) {
+		Packet*& fl = slab_pool(hdrlen_);
+		free_ = fl;
+		fl = 0;
+	}
+	if (free_ == 0) {
+		// Lay packets out back to back, each followed by its
+		// headers, and thread them so they are handed out in
+		// address order.
+		int psize = SLAB_ROUND(sizeof(Packet));
+		int size = psize + SLAB_ROUND(hdrlen_);
+		int n = PACKET_SLAB_BYTES / size;
+		if (n < 1)
+			n = 1;
+		char* slab = new char[n * size];
+		if (slab == 0)
+			abort();
+		for (int i = n - 1; i >= 0; --i) {
+			char* m = slab + i * size;
+			Packet* p = new (m) Packet;
+			p->bits_ = (unsigned char*)(m + psize);
+			p->bitslen_ = hdrlen_;
+			p->next_ = free_;
+			free_ = p;
+		}
+		++stats_.slabs_;
+		stats_.packets_ += n;
+	}
+	Packet* p = free_;
+	free_ = p->next_;
+	return (p);
+}
+
+/*
+ * When the packet format is pruned (see auto-packet-headers in
+ * ns-packet.tcl) every header left out of the format is mapped onto
+ * one block at the end of the packet, from hdrguard_ to hdrlen_.  The
+ * block is cleared when the packet is allocated, so code that reads a
+ * pruned header sees zeros, and code that writes one is caught here.
+ */
+void Packet::check_pruned(const Packet* p)
+{
+	for (int i = hdrguard_; i < hdrlen_; ++i) {
+		if (p->bits_[i] != 0) {
+			fprintf(stderr, "packet %d (%s) wrote into a packet "
+				"header that was pruned from the packet format; "
+				"add it with add-packet-header\n",
+				HDR_CMN(p)->uid(),
+				packet_info.name(HDR_CMN(p)->ptype()));
+			abort();
+		}
+	}
+}
+
+
 /* manages active packet header types */
 class PacketHeaderManager : public TclObject {
 public:
 	PacketHeaderManager() {
 		bind("hdrlen_", &Packet::hdrlen_);
+		bind("hdrguard_", &Packet::hdrguard_);
 	}
+	int command(int argc, const char*const* argv);
 };
 
+int PacketHeaderManager::command(int argc, const char*const* argv)
+{
+	Tcl& tcl = Tcl::instance();
+	if (argc == 2) {
+		if (strcmp(argv[1], "pool-stats") == 0) {
+			// one malloc per slab, where a packet and its
+			// headers used to cost two each
+			const PacketPoolStats& s = Packet::pool_stats();
+			tcl.resultf("hdrlen %d allocs %lu live %ld peak %ld "
+				    "slabs %lu packets %lu", Packet::hdrlen_,
+				    s.allocs_, s.live_, s.peak_, s.slabs_,
+				    s.packets_);
+			return (TCL_OK);
+		}
+	}
+	return (TclObject::command(argc, argv));
+}
+
 static class PacketHeaderManagerClass : public TclClass {
 public:
 	PacketHeaderManagerClass() : TclClass("PacketHeaderManager") {}
@@ -480,22 +480,49 @@ private:
 //Monarch ext
 typedef void (*FailureCallback)(Packet *,void *);
 
+/*
+ * Packets are never returned to the heap.  They are carved out of
+ * slabs of about PACKET_SLAB_BYTES, each packet immediately followed
+ * by its header block, and recycled through a free list per header
+ * size, so allocating a packet costs no malloc in the steady state and
+ * a packet's headers share cache lines and pages with the packet itself.
+ */
+#define PACKET_SLAB_BYTES	(1 << 18)
+
+struct PacketPoolStats {
+	unsigned long allocs_;	// Packet::alloc() and copy() calls
+	long live_;		// packets currently allocated
+	long peak_;		// high water mark of live_
+	unsigned long slabs_;	// slabs allocated
+	unsigned long packets_;	// packets carved out of the slabs
+};
+
 class Packet : public Event {
 private:
 	unsigned char* bits_;	// header bits
+	int bitslen_;		// size of bits_ (hdrlen_ when carved)
 //	unsigned char* data_;	// variable size buffer for 'data'
 //  	unsigned int datalen_;	// length of variable size buffer
 	AppData* data_;		// variable size buffer for 'data'
 	static void init(Packet*);     // initialize pkt hdr 
+	static inline Packet* get();	// take a packet off the pool
+	static Packet* slab_alloc();	// get() slow path
+	static void park(Packet*);	// free() of a stale header size
+	static void check_pruned(const Packet*);
 	bool fflag_;
 protected:
-	static Packet* free_;	// packet free list
+	// per thread under the parallel scheduler, as are the counters
+	static NS_THREAD_LOCAL Packet* free_;	// free list of packets with hdrlen_ hdrs
+	static NS_THREAD_LOCAL PacketPoolStats stats_;
 	int	ref_count_;	// free the pkt until count to 0
 public:
 	Packet* next_;		// for queues and the free list
 	static int hdrlen_;
+	static int hdrguard_;	// start of the block shared by pruned hdrs
 
-	Packet() : bits_(0), data_(0), ref_count_(0), next_(0) { }
+	Packet() : bits_(0), bitslen_(0), data_(0), fflag_(FALSE),
+		   ref_count_(0), next_(0) { }
+	static const PacketPoolStats& pool_stats() { return (stats_); }
 	inline unsigned char* bits() { return (bits_); }
 	inline Packet* copy() const;
 	inline Packet* refcopy() { ++ref_count_; return this; }
@@ -688,29 +715,38 @@ inline void Packet::init(Packet* p)
 	bzero(p->bits_, hdrlen_);
 }
 
-inline Packet* Packet::alloc()
+/*
+ * Take a packet off the free list (or a new slab) and mark it in use.
+ * Its header bits are left as they are.
+ */
+inline Packet* Packet::get()
 {
 	Packet* p = free_;
-	if (p != 0) {
-		assert(p->fflag_ == FALSE);
+	if (p != 0 && p->bitslen_ == hdrlen_)
 		free_ = p->next_;
-		assert(p->data_ == 0);
-		p->uid_ = 0;
-		p->time_ = 0;
-	} else {
-		p = new Packet;
-		p->bits_ = new unsigned char[hdrlen_];
-		if (p == 0 || p->bits_ == 0)
-			abort();
-	}
+	else
+		p = slab_alloc();
+	assert(p->fflag_ == FALSE);
+	assert(p->data_ == 0);
+	p->uid_ = 0;
+	p->time_ = 0;
+	p->next_ = 0;
+	p->fflag_ = TRUE;
+	++stats_.allocs_;
+	if (++stats_.live_ > stats_.peak_)
+		stats_.peak_ = stats_.live_;
+	return (p);
+}
+
+inline Packet* Packet::alloc()
+{
+	Packet* p = get();
 	init(p); // Initialize bits_[]
 	(HDR_CMN(p))->next_hop_ = -2; // -1 reserved for IP_BROADCAST
 	(HDR_CMN(p))->last_hop_ = -2; // -1 reserved for IP_BROADCAST
-	p->fflag_ = TRUE;
 	(HDR_CMN(p))->direction() = hdr_cmn::DOWN;
 	/* setting all direction of pkts to be downward as default; 
 	   until channel changes it to +1 (upward) */
-	p->next_ = 0;
 	return (p);
 }
 
@@ -774,10 +810,18 @@ inline void Packet::free(Packet* p)
 				delete p->data_;
 				p->data_ = 0;
 			}
-			init(p);
-			p->next_ = free_;
-			free_ = p;
+			// bits_ are cleared by the next alloc()
 			p->fflag_ = FALSE;
+			--stats_.live_;
+			if (p->bitslen_ == hdrlen_) {
+#ifndef NDEBUG
+				if (hdrguard_ > 0)
+					check_pruned(p);
+#endif
+				p->next_ = free_;
+				free_ = p;
+			} else
+				park(p);
 		} else {
 			--p->ref_count_;
 		}
@@ -787,7 +831,8 @@ inline void Packet::free(Packet* p)
 inline Packet* Packet::copy() const
 {
         hdr_dccp *dccph, *dccph_p;
-	Packet* p = alloc();
+	// no need to clear the headers we are about to overwrite
+	Packet* p = get();
 	memcpy(p->bits(), bits_, hdrlen_);
  
         //copy DCCP options_, since it is a pointer
@@ -0,0 +1,747 @@
+/* -*-	Mode:C++; c-basic-offset:8; tab-width:8; indent-tabs-mode:t -*- */
+/*
+ * Copyright (c) 1994 Regents of the University of California.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor of the Laboratory may be used
+ *    to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+/*
+ * Conservative parallel execution.
+ *
+ * The nodes of a wired topology are partitioned into logical processes
+ * (LPs) with "$ns partition $node $lp".  Every LP is a heap scheduler of
+ * its own, and the LPs advance together in windows: if T is the time of
+ * the earliest pending event and L (the lookahead) the least delay of
+ * any cut link - a link whose ends are in different LPs - nothing an LP
+ * does before T + L can reach another LP before T + L either, so the
+ * LPs can each run their events before T + L independently, in threads_
+ * threads.  A packet that enters a cut link is not scheduled but posted
+ * to a buffer of the sending LP, one per receiving LP, which only the
+ * sending LP writes during the window and only the master reads, once
+ * every LP is done with it; the hand-off thus needs no lock.
+ *
+ * An event scheduled from outside the LPs (the setup before "run", a
+ * Tcl "at" event) goes to the LP that owns its handler ("assign") or
+ * else to a global queue, whose events run one at a time between
+ * windows, with every LP stopped.  Whatever an "at" event whose script
+ * starts with an object of some LP ("$ftp start") schedules goes to
+ * that LP.
+ *
+ * The statics that the packet path updates (Scheduler::instance_ and
+ * the event uid, the packet uid counter and the default RNG) are per
+ * thread and are switched along with the LP, so the outcome of a run
+ * does not depend on threads_: LP k draws its
+ * default random numbers 2^40 k values into the default stream and
+ * numbers packets and events from a k-th share of the uid space.  LP 0
+ * continues the default stream and counters, so a run with one LP does
+ * exactly what the heap scheduler does.  The packet free lists and
+ * their counters are per thread but not switched: a packet goes back
+ * to the free list of the thread that frees it, whichever LP it came
+ * from, and "pool-stats" only counts the calling thread.
+ *
+ * With threads_ > 1 no event of an LP may call into Tcl (traces, Tcl
+ * callbacks of agents, ...) and the LPs must not share any object but
+ * cut links.
+ */
+
+#include <float.h>
+#include <limits.h>
+#include <ctype.h>
+
+#include "scheduler.h"
+#include "agent.h"
+#include "app.h"
+#include "rng.h"
+#include "delay.h"
+#ifdef NS_THREADS
+#include <pthread.h>
+#endif
+
+static class ParallelSchedulerClass : public TclClass {
+public:
+	ParallelSchedulerClass() : TclClass("Scheduler/Parallel") {}
+	TclObject* create(int /* argc */, const char*const* /* argv */) {
+		return (new ParallelScheduler);
+	}
+} class_parallel_sched;
+
+/* Events posted by one LP to another during a window. */
+struct LPChannel {
+	struct Post {
+		double time_;
+		Handler* handler_;
+		Event* event_;
+	};
+	LPChannel() : posts_(0), n_(0), max_(0) {}
+	~LPChannel() { delete [] posts_; }
+	void add(Handler* h, Event* e, double t) {
+		if (n_ == max_) {
+			max_ = max_ ? 2 * max_ : 64;
+			Post* np = new Post[max_];
+			for (int i = 0; i < n_; i++)
+				np[i] = posts_[i];
+			delete [] posts_;
+			posts_ = np;
+		}
+		posts_[n_].time_ = t;
+		posts_[n_].handler_ = h;
+		posts_[n_].event_ = e;
+		n_++;
+	}
+	Post* posts_;
+	int n_;
+	int max_;
+};
+
+class LPScheduler : public HeapScheduler {
+public:
+	LPScheduler(int id, int nlps) : id_(id), rng_(0), uidcnt_(0),
+		evuid_(1), out_(nlps ? new LPChannel[nlps] : 0),
+		cancels_(0), ncancels_(0), maxcancels_(0) {}
+	~LPScheduler() {
+		delete [] out_;
+		delete [] cancels_;
+	}
+	void cancel(Event* e);
+	int remove(Event* e) { return (hp_->heap_delete((void*)e)); }
+	void run_window(double end, scheduler_uid_t enduid, const int* halted);
+protected:
+	friend class ParallelScheduler;
+	int id_;
+	RNG* rng_;		// RNG::default_ of the LP
+	int uidcnt_;		// Agent::uidcnt_ of the LP
+	scheduler_uid_t evuid_;	// Scheduler::uid_ of the LP
+	LPChannel* out_;	// out_[k]: posts to LP k
+	Event** cancels_;	// events of other queues the LP cancelled
+	int ncancels_;
+	int maxcancels_;
+};
+
+void LPScheduler::cancel(Event* e)
+{
+	if (e->uid_ <= 0)
+		return;
+	e->uid_ = - e->uid_;
+	if (remove(e))
+		return;
+	/*
+	 * An event of the global queue (e.g. a timer set up before "run"):
+	 * the master takes it out after the window, before it can run.
+	 */
+	if (ncancels_ == maxcancels_) {
+		maxcancels_ = maxcancels_ ? 2 * maxcancels_ : 16;
+		Event** nc = new Event*[maxcancels_];
+		for (int i = 0; i < ncancels_; i++)
+			nc[i] = cancels_[i];
+		delete [] cancels_;
+		cancels_ = nc;
+	}
+	cancels_[ncancels_++] = e;
+}
+
+/* Dispatch the events before (end, enduid), in (time, uid) order. */
+void LPScheduler::run_window(double end, scheduler_uid_t enduid,
+			     const int* halted)
+{
+	Event* e;
+	while (!*halted && (e = (Event*)hp_->heap_min()) != 0 &&
+	       (e->time_ < end || (e->time_ == end && e->uid_ < enduid))) {
+		hp_->heap_extract_min();
+		dispatch(e, e->time_);
+	}
+}
+
+#ifdef NS_THREADS
+struct LPWorker {
+	ParallelScheduler* ps_;
+	int id_;
+	pthread_t tid_;
+};
+
+struct LPWorkers {
+	pthread_mutex_t mutex_;
+	pthread_cond_t go_;		// gen_ or quit_ changed
+	pthread_cond_t done_;		// busy_ dropped to 0
+	unsigned gen_;			// windows started
+	int busy_;			// workers not done with the window
+	int quit_;
+	LPWorker* workers_;
+};
+#endif
+
+NS_THREAD_LOCAL int ParallelScheduler::lp_ = -1;
+ParallelScheduler* ParallelScheduler::running_;
+
+ParallelScheduler::ParallelScheduler()
+	: nlps_(0), lps_(0), lookahead_(DBL_MAX), end_(0), enduid_(0),
+	  ctx_(-1), athint_(-2), started_(0), nworkers_(0), pool_(0)
+{
+	bind("threads_", &threads_);
+	global_ = new LPScheduler(-1, 0);
+	Tcl_InitHashTable(&owners_, TCL_ONE_WORD_KEYS);
+	Tcl_InitHashTable(&hints_, TCL_ONE_WORD_KEYS);
+}
+
+ParallelScheduler::~ParallelScheduler()
+{
+#ifdef NS_THREADS
+	stop_workers();
+#endif
+	for (int k = 0; k < nlps_; k++)
+		delete lps_[k];
+	delete [] lps_;
+	delete global_;
+	Tcl_DeleteHashTable(&owners_);
+	Tcl_DeleteHashTable(&hints_);
+	if (running_ == this)
+		running_ = 0;
+}
+
+int ParallelScheduler::configure(int nlps)
+{
+	if (lps_ != 0)
+		return (nlps == nlps_ ? TCL_OK : TCL_ERROR);
+	nlps_ = nlps;
+	lps_ = new LPScheduler*[nlps];
+	for (int k = 0; k < nlps; k++)
+		lps_[k] = new LPScheduler(k, nlps);
+	running_ = this;
+	return (TCL_OK);
+}
+
+int ParallelScheduler::owner(const void* obj)
+{
+	Tcl_HashEntry* he = Tcl_FindHashEntry(&owners_, (const char*)obj);
+	return (he ? (int)(long)Tcl_GetHashValue(he) : -1);
+}
+
+/*
+ * The LP of the object that an "at" script starts with, if any, or of
+ * the agent of that object, if it is an application.
+ */
+int ParallelScheduler::hint(const char* script)
+{
+	char name[SMALL_LEN];
+	int n = 0;
+
+	while (isspace(*script))
+		script++;
+	while (script[n] != 0 && !isspace(script[n]) && n < SMALL_LEN - 1) {
+		name[n] = script[n];
+		n++;
+	}
+	name[n] = 0;
+	if (strncmp(name, "_o", 2) != 0)
+		return (-1);
+	return (hint(TclObject::lookup(name)));
+}
+
+int ParallelScheduler::hint(TclObject* o)
+{
+	if (o == 0)
+		return (-1);
+	int lp = owner(o);
+	if (lp < 0) {
+		Application* app = dynamic_cast<Application*>(o);
+		if (app != 0 && app->agent() != 0)
+			lp = owner(static_cast<TclObject*>(app->agent()));
+	}
+	return (lp);
+}
+
+/*
+ * Called on the first "run", after the script had its chance to seed
+ * the default RNG: split the random stream and the uid spaces among
+ * the LPs, and move the events scheduled so far to their LPs.
+ */
+void ParallelScheduler::setup()
+{
+	RNG* rng = RNG::defaultrng();
+	scheduler_uid_t uspan = ((scheduler_uid_t)1 <<
+	    (sizeof(scheduler_uid_t) * 8 - 2)) / nlps_;
+	int pspan = (INT_MAX - Agent::uidcnt_) / nlps_;
+
+	for (int k = 0; k < nlps_; k++) {
+		LPScheduler* lp = lps_[k];
+		if (k > 0 && rng != 0)
+#ifdef OLD_RNG
+			rng = new RNG(RNG::RAW_SEED_SOURCE, rng->seed() + 1);
+#else
+			rng = RNG::substream(*rng, 40);
+#endif
+		lp->rng_ = rng;
+		lp->evuid_ = uid_ + k * uspan;
+		lp->uidcnt_ = Agent::uidcnt_ + k * pspan;
+	}
+
+	LPScheduler* held = global_;
+	global_ = new LPScheduler(-1, 0);
+	Event* e;
+	while ((e = held->deque()) != 0) {
+		int lp = owner(e->handler_);
+		if (lp >= 0 && lp < nlps_)
+			lps_[lp]->insert(e);
+		else
+			global_->insert(e);
+	}
+	delete held;
+
+	if (threads_ > nlps_)
+		threads_ = nlps_;
+#ifdef NS_THREADS
+	if (threads_ > 1)
+		start_workers();
+#else
+	if (threads_ > 1)
+		fprintf(stderr, "Scheduler/Parallel: built without thread "
+			"support, running the LPs in one thread\n");
+#endif
+	started_ = 1;
+}
+
+void ParallelScheduler::enter(LPScheduler* lp)
+{
+	lp_ = lp->id_;
+	instance_ = lp;
+	uid_ = lp->evuid_;
+	Agent::uidcnt_ = lp->uidcnt_;
+	RNG::default_ = lp->rng_;
+}
+
+void ParallelScheduler::leave(LPScheduler* lp)
+{
+	lp->evuid_ = uid_;
+	lp->uidcnt_ = Agent::uidcnt_;
+	lp_ = -1;
+}
+
+void ParallelScheduler::run_lps(int first)
+{
+	for (int k = first; k < nlps_; k += nworkers_ + 1) {
+		LPScheduler* lp = lps_[k];
+		enter(lp);
+		lp->run_window(end_, enduid_, &halted_);
+		leave(lp);
+	}
+}
+
+/*
+ * Run every LP up to (end_, enduid_), then hand over what went over
+ * cut links.  The master context runs with the state of LP 0.
+ */
+void ParallelScheduler::window()
+{
+	lps_[0]->evuid_ = uid_;
+	lps_[0]->uidcnt_ = Agent::uidcnt_;
+#ifdef NS_THREADS
+	if (nworkers_ > 0) {
+		LPWorkers* pool = (LPWorkers*)pool_;
+		pthread_mutex_lock(&pool->mutex_);
+		pool->busy_ = nworkers_;
+		pool->gen_++;
+		pthread_cond_broadcast(&pool->go_);
+		pthread_mutex_unlock(&pool->mutex_);
+		run_lps(0);
+		pthread_mutex_lock(&pool->mutex_);
+		while (pool->busy_ > 0)
+			pthread_cond_wait(&pool->done_, &pool->mutex_);
+		pthread_mutex_unlock(&pool->mutex_);
+	} else
+#endif
+		run_lps(0);
+	instance_ = this;
+	uid_ = lps_[0]->evuid_;
+	Agent::uidcnt_ = lps_[0]->uidcnt_;
+	RNG::default_ = lps_[0]->rng_;
+	exchange();
+}
+
+/*
+ * Apply the cancels of other queues' events and schedule the posted
+ * events, LP by LP, so that the order (and the uids) never depend on
+ * which LP finished first.
+ */
+void ParallelScheduler::exchange()
+{
+	for (int src = 0; src < nlps_; src++) {
+		LPScheduler* lp = lps_[src];
+		for (int i = 0; i < lp->ncancels_; i++) {
+			Event* e = lp->cancels_[i];
+			if (global_->remove(e)) {
+				Tcl_HashEntry* he =
+				    Tcl_FindHashEntry(&hints_, (char*)e);
+				if (he != 0)
+					Tcl_DeleteHashEntry(he);
+				continue;
+			}
+			for (int k = 0; k < nlps_; k++)
+				if (k != src && lps_[k]->remove(e))
+					break;
+		}
+		lp->ncancels_ = 0;
+	}
+	for (int src = 0; src < nlps_; src++) {
+		LPChannel* out = lps_[src]->out_;
+		for (int dst = 0; dst < nlps_; dst++) {
+			LPChannel& c = out[dst];
+			for (int i = 0; i < c.n_; i++)
+				lps_[dst]->schedule_at(c.posts_[i].handler_,
+				    c.posts_[i].event_, c.posts_[i].time_);
+			c.n_ = 0;
+		}
+	}
+}
+
+void ParallelScheduler::post(int lp, Handler* h, Event* e, double t)
+{
+	ParallelScheduler* ps = running_;
+	if (ps == 0 || lp >= ps->nlps_) {
+		Scheduler::instance().schedule_at(h, e, t);
+		return;
+	}
+	if (lp_ < 0) {
+		// from the master context: the LPs are stopped
+		ps->lps_[lp]->schedule_at(h, e, t);
+		return;
+	}
+	if (t < ps->end_) {
+		fprintf(stderr, "Scheduler/Parallel: LP %d posted an event "
+			"for %f to LP %d within the window ending at %f "
+			"(delay of a cut link lowered?)\n",
+			lp_, t, lp, ps->end_);
+		abort();
+	}
+	ps->lps_[lp_]->out_[lp].add(h, e, t);
+}
+
+void ParallelScheduler::run()
+{
+	instance_ = this;
+	if (lps_ == 0)
+		configure(1);
+	if (!started_)
+		setup();
+
+	while (!halted_) {
+		Event* g = (Event*)global_->head();
+		double gt = g ? g->time_ : DBL_MAX;
+		scheduler_uid_t gu = g ? g->uid_ : 0;
+		double t = DBL_MAX;
+		int before = 0;
+		for (int k = 0; k < nlps_; k++) {
+			const Event* e = lps_[k]->head();
+			if (e == 0)
+				continue;
+			if (e->time_ < t)
+				t = e->time_;
+			if (g == 0 || e->time_ < gt ||
+			    (e->time_ == gt && e->uid_ < gu))
+				before = 1;
+		}
+		if (before) {
+			end_ = t + lookahead_;
+			enduid_ = 0;
+			if (g != 0 && gt <= end_) {
+				end_ = gt;
+				enduid_ = gu;
+			}
+			window();
+			continue;
+		}
+		if (g == 0)
+			break;
+		/* a global event, with every LP stopped */
+		global_->deque();
+		Tcl_HashEntry* he = Tcl_FindHashEntry(&hints_, (char*)g);
+		if (he != 0) {
+			ctx_ = (int)(long)Tcl_GetHashValue(he);
+			Tcl_DeleteHashEntry(he);
+		}
+		dispatch(g, gt);
+		ctx_ = -1;
+	}
+	for (int k = 0; k < nlps_; k++)
+		if (lps_[k]->clock() > clock_)
+			clock_ = lps_[k]->clock();
+}
+
+/* a call of an at-batch: goes where "at" would put "$target ..." */
+void ParallelScheduler::schedule_call(TclObject* target, Handler* h,
+				      Event* e, double t)
+{
+	athint_ = hint(target);
+	schedule_at(h, e, t);
+	athint_ = -2;
+}
+
+void ParallelScheduler::insert(Event* e)
+{
+	if (lp_ >= 0) {
+		// from an event of an LP (a timer, "$ns at" in a callback)
+		lps_[lp_]->insert(e);
+		return;
+	}
+	if (athint_ != -2) {
+		// an "at" event runs between windows
+		global_->insert(e);
+		if (athint_ >= 0) {
+			int isnew;
+			Tcl_HashEntry* he = Tcl_CreateHashEntry(&hints_,
+			    (char*)e, &isnew);
+			Tcl_SetHashValue(he, (ClientData)(long)athint_);
+		}
+		return;
+	}
+	int lp = ctx_ >= 0 ? ctx_ : owner(e->handler_);
+	if (lp >= 0 && lp < nlps_)
+		lps_[lp]->insert(e);
+	else
+		global_->insert(e);
+}
+
+void ParallelScheduler::cancel(Event* e)
+{
+	if (lp_ >= 0) {
+		lps_[lp_]->cancel(e);
+		return;
+	}
+	if (e->uid_ <= 0)
+		return;
+	e->uid_ = - e->uid_;
+	if (global_->remove(e)) {
+		Tcl_HashEntry* he = Tcl_FindHashEntry(&hints_, (char*)e);
+		if (he != 0)
+			Tcl_DeleteHashEntry(he);
+		return;
+	}
+	for (int k = 0; k < nlps_; k++)
+		if (lps_[k]->remove(e))
+			return;
+}
+
+Event* ParallelScheduler::lookup(scheduler_uid_t uid)
+{
+	Event* e = global_->lookup(uid);
+	for (int k = 0; e == 0 && k < nlps_; k++)
+		e = lps_[k]->lookup(uid);
+	return (e);
+}
+
+/* The queue with the earliest event, for deque() and head(). */
+LPScheduler* ParallelScheduler::earliest()
+{
+	LPScheduler* q = global_->head() ? global_ : 0;
+	for (int k = 0; k < nlps_; k++) {
+		const Event* e = lps_[k]->head();
+		if (e != 0 && (q == 0 || e->time_ < q->head()->time_))
+			q = lps_[k];
+	}
+	return (q);
+}
+
+Event* ParallelScheduler::deque()
+{
+	LPScheduler* q = earliest();
+	if (q == 0)
+		return (0);
+	Event* e = q->deque();
+	if (q == global_) {
+		Tcl_HashEntry* he = Tcl_FindHashEntry(&hints_, (char*)e);
+		if (he != 0)
+			Tcl_DeleteHashEntry(he);
+	}
+	return (e);
+}
+
+const Event* ParallelScheduler::head()
+{
+	LPScheduler* q = earliest();
+	return (q ? q->head() : 0);
+}
+
+void ParallelScheduler::reset()
+{
+	Scheduler::reset();
+	for (int k = 0; k < nlps_; k++)
+		lps_[k]->reset();
+}
+
+#ifdef NS_THREADS
+void* ParallelScheduler::worker(void* arg)
+{
+	LPWorker* w = (LPWorker*)arg;
+	LPWorkers* pool = (LPWorkers*)w->ps_->pool_;
+	unsigned seen = 0;
+
+	for (;;) {
+		pthread_mutex_lock(&pool->mutex_);
+		while (pool->gen_ == seen && !pool->quit_)
+			pthread_cond_wait(&pool->go_, &pool->mutex_);
+		if (pool->quit_) {
+			pthread_mutex_unlock(&pool->mutex_);
+			break;
+		}
+		seen = pool->gen_;
+		pthread_mutex_unlock(&pool->mutex_);
+
+		w->ps_->run_lps(w->id_);
+
+		pthread_mutex_lock(&pool->mutex_);
+		if (--pool->busy_ == 0)
+			pthread_cond_signal(&pool->done_);
+		pthread_mutex_unlock(&pool->mutex_);
+	}
+	return (0);
+}
+
+/* threads_ - 1 workers; the thread that calls run() is the first. */
+void ParallelScheduler::start_workers()
+{
+	LPWorkers* pool = new LPWorkers;
+	pthread_mutex_init(&pool->mutex_, 0);
+	pthread_cond_init(&pool->go_, 0);
+	pthread_cond_init(&pool->done_, 0);
+	pool->gen_ = 0;
+	pool->busy_ = 0;
+	pool->quit_ = 0;
+	pool->workers_ = new LPWorker[threads_ - 1];
+	pool_ = pool;
+	for (int i = 0; i < threads_ - 1; i++) {
+		LPWorker* w = &pool->workers_[i];
+		w->ps_ = this;
+		w->id_ = i + 1;
+		if (pthread_create(&w->tid_, 0, worker, w) != 0) {
+			fprintf(stderr, "Scheduler/Parallel: cannot start "
+				"thread %d, running with %d\n", i + 1, i + 1);
+			break;
+		}
+		nworkers_ = i + 1;
+	}
+}
+
+void ParallelScheduler::stop_workers()
+{
+	LPWorkers* pool = (LPWorkers*)pool_;
+	if (pool == 0)
+		return;
+	pthread_mutex_lock(&pool->mutex_);
+	pool->quit_ = 1;
+	pthread_cond_broadcast(&pool->go_);
+	pthread_mutex_unlock(&pool->mutex_);
+	for (int i = 0; i < nworkers_; i++)
+		pthread_join(pool->workers_[i].tid_, 0);
+	pthread_mutex_destroy(&pool->mutex_);
+	pthread_cond_destroy(&pool->go_);
+	pthread_cond_destroy(&pool->done_);
+	delete [] pool->workers_;
+	delete pool;
+	pool_ = 0;
+	nworkers_ = 0;
+}
+#endif
+
+int ParallelScheduler::command(int argc, const char*const* argv)
+{
+	Tcl& tcl = Tcl::instance();
+
+	if (lp_ >= 0 && argc >= 2 && (strcmp(argv[1], "now") == 0 ||
+	    strcmp(argv[1], "at") == 0 || strcmp(argv[1], "at-now") == 0)) {
+		// from an event of an LP: its clock, not the master's
+		double clock = clock_;
+		clock_ = instance_->clock();
+		int res = Scheduler::command(argc, argv);
+		clock_ = clock;
+		return (res);
+	}
+	if (argc == 3) {
+		if (strcmp(argv[1], "lps") == 0) {
+			int n = atoi(argv[2]);
+			if (n < 1 || configure(n) != TCL_OK) {
+				tcl.resultf("cannot set up %s LPs "
+				    "(already %d)", argv[2], nlps_);
+				return (TCL_ERROR);
+			}
+			return (TCL_OK);
+		}
+		if (strcmp(argv[1], "at-now") == 0) {
+			athint_ = hint(argv[2]);
+			int res = Scheduler::command(argc, argv);
+			athint_ = -2;
+			return (res);
+		}
+	} else if (argc == 4) {
+		/*
+		 * $sched assign <lp> <object>
+		 * Events of <object> belong to LP <lp>.
+		 */
+		if (strcmp(argv[1], "assign") == 0) {
+			int lp = atoi(argv[2]);
+			TclObject* o = TclObject::lookup(argv[3]);
+			if (o == 0 || lp < 0 || lp >= nlps_) {
+				tcl.resultf("cannot assign %s to LP %s",
+				    argv[3], argv[2]);
+				return (TCL_ERROR);
+			}
+			int isnew;
+			Tcl_HashEntry* he = Tcl_CreateHashEntry(&owners_,
+			    (char*)o, &isnew);
+			Tcl_SetHashValue(he, (ClientData)(long)lp);
+			Handler* h = dynamic_cast<Handler*>(o);
+			if (h != 0 && (void*)h != (void*)o) {
+				he = Tcl_CreateHashEntry(&owners_, (char*)h,
+				    &isnew);
+				Tcl_SetHashValue(he, (ClientData)(long)lp);
+			}
+			return (TCL_OK);
+		}
+		/*
+		 * $sched cut <delaylink> <lp>
+		 * Packets over <delaylink> go to LP <lp>.
+		 */
+		if (strcmp(argv[1], "cut") == 0) {
+			LinkDelay* ld = dynamic_cast<LinkDelay*>(
+			    TclObject::lookup(argv[2]));
+			int lp = atoi(argv[3]);
+			if (ld == 0 || lp < 0 || lp >= nlps_ ||
+			    ld->cut(lp) < 0) {
+				tcl.resultf("cannot cut %s (not a static "
+				    "DelayLink with a delay?)", argv[2]);
+				return (TCL_ERROR);
+			}
+			if (ld->delay() < lookahead_)
+				lookahead_ = ld->delay();
+			return (TCL_OK);
+		}
+		if (strcmp(argv[1], "at") == 0) {
+			athint_ = hint(argv[3]);
+			int res = Scheduler::command(argc, argv);
+			athint_ = -2;
+			return (res);
+		}
+	}
+	return (Scheduler::command(argc, argv));
+}
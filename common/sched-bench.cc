@@ -0,0 +1,345 @@
+/* -*-	Mode:C++; c-basic-offset:8; tab-width:8; indent-tabs-mode:t -*- */
+/*
+ * Copyright (c) 1994 Regents of the University of California.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor of the Laboratory may be used
+ *    to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+/*
+ * SchedulerBench: compare scheduler implementations on the same event
+ * stream.
+ *
+ *	$bench generate <model> <file> <n> <ops> ?seed?
+ *		write a synthetic SchedulerLog for the hold model <model>
+ *		(exp, bimodal or tcp) with <n> pending events and <ops>
+ *		dequeues
+ *	$bench replay <scheduler> <file>
+ *		replay a SchedulerLog (recorded with Scheduler/Record or
+ *		generated above) against <scheduler>, returning a list of
+ *		{name value} statistics
+ *
+ * The log is decoded into memory before the clock starts, so the timed
+ * loop makes nothing but scheduler calls.  Every dequeue is checked
+ * against the recorded order, which makes a replay a conformance test
+ * as well.  tcl/ex/sched-bench.tcl drives this for all schedulers.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <map>
+#include <vector>
+
+#include "config.h"
+#ifndef WIN32
+#include <sys/time.h>
+#endif
+#ifdef HAVE_GETRUSAGE
+#include <sys/resource.h>
+#endif
+#include <time.h>
+
+#include "sched-log.h"
+#include "rng.h"
+
+#define HOLD_EXP	0	/* exponential increments, mean 1 */
+#define HOLD_BIMODAL	1	/* 90% short (mean 0.01), 10% long (mean 10) */
+#define HOLD_TCP	2	/* per-packet events plus cancelled RTO timers */
+
+class SchedulerBench : public TclObject {
+public:
+	SchedulerBench() {}
+	int command(int argc, const char*const* argv);
+protected:
+	int generate(int model, const char* file, int n, int nops, long seed);
+	int load(const char* file);
+	void replay(Scheduler* s);
+
+	// the decoded log: one entry per record ...
+	vector<char> op_;
+	vector<int> slot_;		// event the record refers to (or -1)
+	// ... and one entry per inserted event
+	vector<double> time_;
+	vector<scheduler_uid_t> uid_;
+};
+
+static class SchedulerBenchClass : public TclClass {
+public:
+	SchedulerBenchClass() : TclClass("SchedulerBench") {}
+	TclObject* create(int /* argc */, const char*const* /* argv */) {
+		return (new SchedulerBench);
+	}
+} class_scheduler_bench;
+
+static double
+bench_now()
+{
+#ifdef CLOCK_MONOTONIC
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (ts.tv_sec + 1e-9 * ts.tv_nsec);
+#else
+	timeval tv;
+	gettimeofday(&tv, 0);
+	return (tv.tv_sec + 1e-6 * tv.tv_usec);
+#endif
+}
+
+/* peak resident set size in KB, or 0 if we cannot tell */
+static long
+bench_maxrss()
+{
+#ifdef HAVE_GETRUSAGE
+	struct rusage ru;
+	getrusage(RUSAGE_SELF, &ru);
+	return (ru.ru_maxrss);
+#else
+	return (0);
+#endif
+}
+
+static double
+hold_delay(RNG& rng, int model)
+{
+	switch (model) {
+	case HOLD_EXP:
+		return (rng.exponential(1.0));
+	case HOLD_BIMODAL:
+		return (rng.uniform_double() < 0.9 ?
+			rng.exponential(0.01) : rng.exponential(10.0));
+	default:	// HOLD_TCP: link/queue delay of the next packet
+		return (rng.exponential(0.01));
+	}
+}
+
+/*
+ * Generate a hold-model log.  A reference queue ordered on (time, uid)
+ * stands in for the scheduler, which gives the FIFO order all ns
+ * schedulers must follow.  In the tcp model every one of the <n> flows
+ * has one packet event and one RTO timer pending; each packet event
+ * cancels and restarts its flow's timer and schedules the next packet,
+ * so the stream is dominated by cancellations.
+ */
+int
+SchedulerBench::generate(int model, const char* file, int n, int nops, long seed)
+{
+	typedef map<pair<double, scheduler_uid_t>, int> Pending;
+	Pending q;
+	vector<Pending::iterator> rto(n);
+	SchedulerLog log;
+	RNG rng(seed);
+	scheduler_uid_t uid = 1;
+	double now = 0, t;
+	int i;
+
+	if (log.open(file, 1) < 0)
+		return (-1);
+
+#define HOLD_SCHEDULE(T, V)						\
+	(log.put(SCHEDLOG_INSERT, uid, (T)),				\
+	 q.insert(Pending::value_type(make_pair((T), uid++), (V))).first)
+
+	for (i = 0; i < n; ++i) {
+		t = now + hold_delay(rng, model);
+		HOLD_SCHEDULE(t, i << 1);
+		if (model == HOLD_TCP) {
+			t = now + rng.uniform(0.2, 1.0);
+			rto[i] = HOLD_SCHEDULE(t, (i << 1) | 1);
+		}
+	}
+	for (int op = 0; op < nops && !q.empty(); ++op) {
+		Pending::iterator p = q.begin();
+		int flow = p->second >> 1;
+		int timer = p->second & 1;
+		now = p->first.first;
+		log.put(SCHEDLOG_DEQUE, p->first.second);
+		q.erase(p);
+
+		if (model != HOLD_TCP) {
+			t = now + hold_delay(rng, model);
+			HOLD_SCHEDULE(t, flow << 1);
+			continue;
+		}
+		if (!timer) {
+			// an ack: restart the RTO and send the next packet
+			log.put(SCHEDLOG_CANCEL, rto[flow]->first.second);
+			q.erase(rto[flow]);
+			t = now + hold_delay(rng, model);
+			HOLD_SCHEDULE(t, flow << 1);
+		}
+		t = now + rng.uniform(0.2, 1.0);
+		rto[flow] = HOLD_SCHEDULE(t, (flow << 1) | 1);
+	}
+#undef HOLD_SCHEDULE
+	log.close();
+	return (0);
+}
+
+int
+SchedulerBench::load(const char* file)
+{
+	map<scheduler_uid_t, int> live;
+	map<scheduler_uid_t, int>::iterator p;
+	SchedulerLog log;
+	scheduler_uid_t uid;
+	double t;
+	int op, r, slot;
+
+	op_.clear();
+	slot_.clear();
+	time_.clear();
+	uid_.clear();
+	if (log.open(file, 0) < 0)
+		return (-1);
+	while ((r = log.get(op, uid, t)) == 1) {
+		if (op == SCHEDLOG_INSERT) {
+			slot = time_.size();
+			time_.push_back(t);
+			uid_.push_back(uid);
+			live[uid] = slot;
+		} else if ((p = live.find(uid)) != live.end()) {
+			slot = p->second;
+			live.erase(p);
+		} else if (op == SCHEDLOG_DEQUE) {
+			slot = -1;	// counts as a mismatch on replay
+		} else
+			continue;	// cancel of something never inserted
+		op_.push_back((char)op);
+		slot_.push_back(slot);
+	}
+	log.close();
+	return (r);
+}
+
+void
+SchedulerBench::replay(Scheduler* s)
+{
+	Tcl& tcl = Tcl::instance();
+	int nevents = time_.size(), nrecords = op_.size();
+	int ncancel = 0, ndeque = 0, mismatch = 0;
+	double cancel = 0, t0, t1, c0;
+	Event* ev = new Event[nevents];
+	Event* e;
+	int i;
+
+	for (i = 0; i < nevents; ++i) {
+		ev[i].time_ = time_[i];
+		ev[i].uid_ = uid_[i];
+		ev[i].handler_ = 0;
+	}
+
+	// cost of the clock reads bracketing each cancel
+	t0 = bench_now();
+	for (i = 0; i < 1000; ++i)
+		bench_now();
+	double tick = (bench_now() - t0) / 1000;
+
+	long rss = bench_maxrss();
+	t0 = bench_now();
+	for (i = 0; i < nrecords; ++i) {
+		switch (op_[i]) {
+		case SCHEDLOG_INSERT:
+			s->insert(&ev[slot_[i]]);
+			break;
+		case SCHEDLOG_CANCEL:
+			c0 = bench_now();
+			s->cancel(&ev[slot_[i]]);
+			cancel += bench_now() - c0;
+			++ncancel;
+			break;
+		case SCHEDLOG_DEQUE:
+			e = s->deque();
+			if (e == 0 || slot_[i] < 0 || e != &ev[slot_[i]])
+				++mismatch;
+			if (e != 0)
+				e->uid_ = -e->uid_;	// as if dispatched
+			++ndeque;
+			break;
+		}
+	}
+	t1 = bench_now();
+	rss = bench_maxrss() - rss;
+
+	while ((e = s->deque()) != 0)
+		e->uid_ = -e->uid_;
+	delete [] ev;
+
+	cancel -= ncancel * 2 * tick;
+	if (cancel < 0)
+		cancel = 0;
+	double elapsed = t1 - t0 - ncancel * 2 * tick;
+	if (elapsed <= 0)
+		elapsed = 1e-9;
+	tcl.resultf("events %d cancels %d deques %d seconds %.6f "
+		    "rate %.0f cancel-ns %.1f peak-kb %ld mismatches %d",
+		    nevents, ncancel, ndeque, elapsed, nrecords / elapsed,
+		    ncancel ? 1e9 * cancel / ncancel : 0.0, rss, mismatch);
+}
+
+int
+SchedulerBench::command(int argc, const char*const* argv)
+{
+	Tcl& tcl = Tcl::instance();
+	if (argc == 4) {
+		if (strcmp(argv[1], "replay") == 0) {
+			Scheduler* s = (Scheduler*)TclObject::lookup(argv[2]);
+			if (s == 0) {
+				tcl.resultf("%s: no scheduler %s", name(), argv[2]);
+				return (TCL_ERROR);
+			}
+			if (load(argv[3]) != 0) {
+				tcl.resultf("%s: cannot read scheduler log %s",
+					    name(), argv[3]);
+				return (TCL_ERROR);
+			}
+			replay(s);
+			return (TCL_OK);
+		}
+	} else if (argc == 6 || argc == 7) {
+		if (strcmp(argv[1], "generate") == 0) {
+			int model;
+			if (strcmp(argv[2], "exp") == 0)
+				model = HOLD_EXP;
+			else if (strcmp(argv[2], "bimodal") == 0)
+				model = HOLD_BIMODAL;
+			else if (strcmp(argv[2], "tcp") == 0)
+				model = HOLD_TCP;
+			else {
+				tcl.resultf("%s: unknown hold model %s",
+					    name(), argv[2]);
+				return (TCL_ERROR);
+			}
+			long seed = (argc == 7) ? atol(argv[6]) : 1;
+			if (generate(model, argv[3], atoi(argv[4]),
+				     atoi(argv[5]), seed) < 0) {
+				tcl.resultf("%s: cannot write %s", name(), argv[3]);
+				return (TCL_ERROR);
+			}
+			return (TCL_OK);
+		}
+	}
+	return (TclObject::command(argc, argv));
+}
@@ -0,0 +1,199 @@
+/* -*-	Mode:C++; c-basic-offset:8; tab-width:8; indent-tabs-mode:t -*- */
+/*
+ * Copyright (c) 1994 Regents of the University of California.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor of the Laboratory may be used
+ *    to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "config.h"
+#include "sched-log.h"
+
+int
+SchedulerLog::open(const char* file, int writing)
+{
+	char magic[sizeof(SCHEDLOG_MAGIC)];
+
+	close();
+	fp_ = fopen(file, writing ? "wb" : "rb");
+	if (fp_ == 0)
+		return (-1);
+	last_ = 0;
+	if (writing) {
+		fwrite(SCHEDLOG_MAGIC, 1, sizeof(SCHEDLOG_MAGIC) - 1, fp_);
+		return (0);
+	}
+	if (fread(magic, 1, sizeof(SCHEDLOG_MAGIC) - 1, fp_) !=
+	    sizeof(SCHEDLOG_MAGIC) - 1 ||
+	    memcmp(magic, SCHEDLOG_MAGIC, sizeof(SCHEDLOG_MAGIC) - 1) != 0) {
+		close();
+		return (-1);
+	}
+	return (0);
+}
+
+void
+SchedulerLog::close()
+{
+	if (fp_ != 0) {
+		fclose(fp_);
+		fp_ = 0;
+	}
+}
+
+void
+SchedulerLog::put(int op, scheduler_uid_t uid, double t)
+{
+	unsigned char buf[1 + 10 + sizeof(double)];
+	int n = 0;
+
+	// zigzag-encode the uid delta so small negative steps stay small
+	int64_t d = (int64_t)uid - (int64_t)last_;
+	u_int64_t z = ((u_int64_t)d << 1) ^ (u_int64_t)(d >> 63);
+	last_ = uid;
+
+	buf[n++] = (unsigned char)op;
+	while (z >= 0x80) {
+		buf[n++] = (unsigned char)(z | 0x80);
+		z >>= 7;
+	}
+	buf[n++] = (unsigned char)z;
+	if (op == SCHEDLOG_INSERT) {
+		memcpy(buf + n, &t, sizeof(double));
+		n += sizeof(double);
+	}
+	fwrite(buf, 1, n, fp_);
+}
+
+/*
+ * Read the next record.  Returns 1 on success, 0 at end of file and
+ * -1 if the log is corrupt.
+ */
+int
+SchedulerLog::get(int& op, scheduler_uid_t& uid, double& t)
+{
+	int c = getc(fp_);
+	if (c == EOF)
+		return (0);
+	if (c != SCHEDLOG_INSERT && c != SCHEDLOG_CANCEL && c != SCHEDLOG_DEQUE)
+		return (-1);
+	op = c;
+
+	u_int64_t z = 0;
+	int shift = 0;
+	do {
+		if ((c = getc(fp_)) == EOF || shift > 63)
+			return (-1);
+		z |= (u_int64_t)(c & 0x7f) << shift;
+		shift += 7;
+	} while (c & 0x80);
+	int64_t d = (int64_t)(z >> 1) ^ -(int64_t)(z & 1);
+	uid = last_ = (scheduler_uid_t)(last_ + d);
+
+	if (op == SCHEDLOG_INSERT) {
+		if (fread(&t, sizeof(double), 1, fp_) != 1)
+			return (-1);
+	} else
+		t = 0;
+	return (1);
+}
+
+
+/*
+ * Scheduler/Record passes every operation through to the scheduler
+ * given with "target" and logs it.  It is normally installed with
+ * "$ns record-scheduler <file> [type]" before anything is scheduled.
+ */
+static class RecordSchedulerClass : public TclClass {
+public:
+	RecordSchedulerClass() : TclClass("Scheduler/Record") {}
+	TclObject* create(int /* argc */, const char*const* /* argv */) {
+		return (new RecordScheduler);
+	}
+} class_record_sched;
+
+void
+RecordScheduler::insert(Event* e)
+{
+	if (log_.is_open())
+		log_.put(SCHEDLOG_INSERT, e->uid_, e->time_);
+	target_->insert(e);
+}
+
+void
+RecordScheduler::cancel(Event* e)
+{
+	if (e->uid_ <= 0)	// event not in queue
+		return;
+	if (log_.is_open())
+		log_.put(SCHEDLOG_CANCEL, e->uid_);
+	target_->cancel(e);
+}
+
+Event*
+RecordScheduler::deque()
+{
+	Event* e = target_->deque();
+	if (e != 0 && log_.is_open())
+		log_.put(SCHEDLOG_DEQUE, e->uid_);
+	return (e);
+}
+
+int
+RecordScheduler::command(int argc, const char*const* argv)
+{
+	Tcl& tcl = Tcl::instance();
+	if (argc == 2) {
+		if (strcmp(argv[1], "close") == 0) {
+			log_.close();
+			return (TCL_OK);
+		}
+	} else if (argc == 3) {
+		if (strcmp(argv[1], "target") == 0) {
+			Scheduler* s = (Scheduler*)TclObject::lookup(argv[2]);
+			if (s == 0 || s == this) {
+				tcl.resultf("%s: bad target scheduler %s",
+					    name(), argv[2]);
+				return (TCL_ERROR);
+			}
+			target_ = s;
+			// C++ code must schedule through us, not the target
+			instance_ = this;
+			return (TCL_OK);
+		}
+		if (strcmp(argv[1], "open") == 0) {
+			if (log_.open(argv[2], 1) < 0) {
+				tcl.resultf("%s: cannot open %s", name(), argv[2]);
+				return (TCL_ERROR);
+			}
+			return (TCL_OK);
+		}
+	}
+	return (Scheduler::command(argc, argv));
+}
@@ -0,0 +1,91 @@
+/* -*-	Mode:C++; c-basic-offset:8; tab-width:8; indent-tabs-mode:t -*- */
+/*
+ * Copyright (c) 1994 Regents of the University of California.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor of the Laboratory may be used
+ *    to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+/*
+ * Scheduler event logs.
+ *
+ * A SchedulerLog is a compact binary record of the insert / cancel /
+ * deque stream seen by a scheduler.  Scheduler/Record sits in front of
+ * any other scheduler and writes such a log while a simulation runs;
+ * SchedulerBench (sched-bench.cc) replays logs, or synthetic ones of
+ * its own making, against each scheduler implementation.
+ *
+ * File layout: the 8-byte magic SCHEDLOG_MAGIC followed by records of
+ *
+ *	'i' <zigzag varint uid delta> <8-byte double time>
+ *	'c' <zigzag varint uid delta>
+ *	'd' <zigzag varint uid delta>
+ *
+ * where the uid delta is taken against the uid of the preceding
+ * record, so the usual stream of increasing uids costs 1-2 bytes each.
+ * Times are stored in host byte order.
+ */
+
+#ifndef ns_sched_log_h
+#define ns_sched_log_h
+
+#include <stdio.h>
+#include "scheduler.h"
+
+#define SCHEDLOG_MAGIC	"NSSCHED1"
+#define SCHEDLOG_INSERT	'i'
+#define SCHEDLOG_CANCEL	'c'
+#define SCHEDLOG_DEQUE	'd'
+
+class SchedulerLog {
+public:
+	SchedulerLog() : fp_(0), last_(0) {}
+	~SchedulerLog() { close(); }
+	int open(const char* file, int writing);
+	void close();
+	int is_open() const { return (fp_ != 0); }
+	void put(int op, scheduler_uid_t uid, double t = 0);
+	int get(int& op, scheduler_uid_t& uid, double& t);
+protected:
+	FILE* fp_;
+	scheduler_uid_t last_;		// uid of the previous record
+};
+
+class RecordScheduler : public Scheduler {
+public:
+	RecordScheduler() : target_(0) {}
+	void cancel(Event*);
+	void insert(Event*);
+	Event* lookup(scheduler_uid_t uid) { return target_->lookup(uid); }
+	Event* deque();
+	const Event* head() { return target_->head(); }
+protected:
+	int command(int argc, const char*const* argv);
+	Scheduler* target_;		// the scheduler doing the real work
+	SchedulerLog log_;
+};
+
+#endif
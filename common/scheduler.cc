@@ -42,14 +42,16 @@ static const char rcsid[] =
 #include "config.h"
 #include "scheduler.h"
 #include "packet.h"
+#include "cmd-table.h"
+#include "at-batch.h"
 
 
 #ifdef MEMDEBUG_SIMULATIONS
 #include "mem-trace.h"
 #endif
 
-Scheduler* Scheduler::instance_;
-scheduler_uid_t Scheduler::uid_ = 1;
+NS_THREAD_LOCAL Scheduler* Scheduler::instance_;
+NS_THREAD_LOCAL scheduler_uid_t Scheduler::uid_ = 1;
 
 // class AtEvent : public Event {
 // public:
@@ -77,6 +79,24 @@ Scheduler::~Scheduler(){
  */
 void 
 Scheduler::schedule(Handler* h, Event* e, double delay)
+{
+	if (delay < 0) {
+		// You probably don't want to do this
+		// (it probably represents a bug in your simulation).
+		fprintf(stderr, 
+			"warning: ns Scheduler::schedule: scheduling event\n\t"
+			"with negative delay (%f) at time %f.\n", delay, clock_);
+	}
+	schedule_at(h, e, clock_ + delay);
+}
+
+/*
+ * Schedule at an absolute time, for callers that computed the time
+ * of an event when it was first known and want exactly that time,
+ * not clock_ + (time - clock_).
+ */
+void
+Scheduler::schedule_at(Handler* h, Event* e, double t)
 {
 	// handler should ALWAYS be set... if it's not, it's a bug in the caller
 	if (!h) {
@@ -91,22 +111,12 @@ Scheduler::schedule(Handler* h, Event* e, double delay)
 		abort();
 	}
 	
-	if (delay < 0) {
-		// You probably don't want to do this
-		// (it probably represents a bug in your simulation).
-		fprintf(stderr, 
-			"warning: ns Scheduler::schedule: scheduling event\n\t"
-			"with negative delay (%f) at time %f.\n", delay, clock_);
-	}
-
 	if (uid_ < 0) {
 		fprintf(stderr, "Scheduler: UID space exhausted!\n");
 		abort();
 	}
 	e->uid_ = uid_++;
 	e->handler_ = h;
-	double t = clock_ + delay;
-
 	e->time_ = t;
 	insert(e);
 }
@@ -181,41 +191,74 @@ Scheduler::reset()
 	clock_ = SCHED_START;
 }
 
+/* the subcommands of Scheduler::command() */
+enum {
+	CMD_RUN,
+	CMD_NOW,
+	CMD_RESUME,
+	CMD_HALT,
+	CMD_CLEARMEMTRACE,
+	CMD_IS_RUNNING,
+	CMD_DUMPQ,
+	CMD_AT,
+	CMD_CANCEL,
+	CMD_AT_NOW,
+	CMD_AT_BATCH,
+	CMD_AT_FILE
+};
+static const CommandTable::Entry sched_cmds[] = {
+	{ "run", CMD_RUN },
+	{ "now", CMD_NOW },
+	{ "resume", CMD_RESUME },
+	{ "halt", CMD_HALT },
+	{ "clearMemTrace", CMD_CLEARMEMTRACE },
+	{ "is-running", CMD_IS_RUNNING },
+	{ "dumpq", CMD_DUMPQ },
+	{ "at", CMD_AT },
+	{ "cancel", CMD_CANCEL },
+	{ "at-now", CMD_AT_NOW },
+	{ "at-batch", CMD_AT_BATCH },
+	{ "at-file", CMD_AT_FILE },
+	{ 0, 0 }
+};
+static CommandTable sched_table(sched_cmds);
+
 int 
 Scheduler::command(int argc, const char*const* argv)
 {
 	Tcl& tcl = Tcl::instance();
+	int cmd = sched_table.find(argv[1]);
 	if (instance_ == 0)
 		instance_ = this;
 	if (argc == 2) {
-		if (strcmp(argv[1], "run") == 0) {
+		if (cmd == CMD_RUN) {
 			/* set global to 0 before calling object reset methods */
 			reset();	// sets clock to zero
 			run();
 			return (TCL_OK);
-		} else if (strcmp(argv[1], "now") == 0) {
+		} else if (cmd == CMD_NOW) {
 			sprintf(tcl.buffer(), "%.17g", clock());
 			tcl.result(tcl.buffer());
 			return (TCL_OK);
-		} else if (strcmp(argv[1], "resume") == 0) {
+		} else if (cmd == CMD_RESUME) {
 			halted_ = 0;
 			run();
 			return (TCL_OK);
-		} else if (strcmp(argv[1], "halt") == 0) {
+		} else if (cmd == CMD_HALT) {
 			halted_ = 1;
 			return (TCL_OK);
 
-		} else if (strcmp(argv[1], "clearMemTrace") == 0) {
+		} else if (cmd == CMD_CLEARMEMTRACE) {
 #ifdef MEMDEBUG_SIMULATIONS
 			extern MemTrace *globalMemTrace;
 			if (globalMemTrace)
 				globalMemTrace->diff("Sim.");
 #endif
 			return (TCL_OK);
-		} else if (strcmp(argv[1], "is-running") == 0) {
+		} else if (cmd == CMD_IS_RUNNING) {
 			sprintf(tcl.buffer(), "%d", !halted_);
 			return (TCL_OK);
-		} else if (strcmp(argv[1], "dumpq") == 0) {
+		} else if (cmd == CMD_DUMPQ) {
 			if (!halted_) {
 				fprintf(stderr, "Scheduler: dumpq only allowed while halted\n");
 				tcl.result("0");
@@ -225,16 +268,19 @@ Scheduler::command(int argc, const char*const* argv)
 			return (TCL_OK);
 		}
 	} else if (argc == 3) {
-		if (strcmp(argv[1], "at") == 0 ||
-		    strcmp(argv[1], "cancel") == 0) {
+		if (cmd == CMD_AT ||
+		    cmd == CMD_CANCEL) {
 			Event* p = lookup(STRTOUID(argv[2]));
-			if (p != 0) {
+			if (p != 0 && !AtBatch::cancel(*this, p)) {
 				/*XXX make sure it really is an atevent*/
 				cancel(p);
 				AtEvent* ae = (AtEvent*)p;
 				delete ae;
 			}
-		} else if (strcmp(argv[1], "at-now") == 0) {
+		} else if (cmd == CMD_AT_BATCH || cmd == CMD_AT_FILE) {
+			return (AtBatch::load(*this, argv[2],
+			    cmd == CMD_AT_FILE));
+		} else if (cmd == CMD_AT_NOW) {
 			const char* proc = argv[2];
 
 			// "at [$ns now]" may not work because of tcl's 
@@ -249,7 +295,7 @@ Scheduler::command(int argc, const char*const* argv)
 		}
 		return (TCL_OK);
 	} else if (argc == 4) {
-		if (strcmp(argv[1], "at") == 0) {
+		if (cmd == CMD_AT) {
 			/* t < 0 means relative time: delay = -t */
 			double delay, t = atof(argv[2]);
 			const char* proc = argv[3];
@@ -78,6 +78,11 @@ public:
 		return (*instance_);		// general access to scheduler
 	}
 	void schedule(Handler*, Event*, double delay);	// sched later event
+	void schedule_at(Handler*, Event*, double time); // at absolute time
+	// an "at" call of target, from a batch (see at-batch.h)
+	virtual void schedule_call(TclObject*, Handler* h, Event* e, double t) {
+		schedule_at(h, e, t);
+	}
 	virtual void run();			// execute the simulator
 	virtual void cancel(Event*) = 0;	// cancel event
 	virtual void insert(Event*) = 0;	// schedule event
@@ -101,8 +106,9 @@ protected:
 	int command(int argc, const char*const* argv);
 	double clock_;
 	int halted_;
-	static Scheduler* instance_;
-	static scheduler_uid_t uid_;
+	// per thread, so that each LP of a ParallelScheduler has its own
+	static NS_THREAD_LOCAL Scheduler* instance_;
+	static NS_THREAD_LOCAL scheduler_uid_t uid_;
 };
 
 class ListScheduler : public Scheduler {
@@ -213,5 +219,114 @@ private:
 	int validate(Event *);
 };
 
+#define LADDER_MAX_RUNGS	8	/* depth of the ladder */
+#define LADDER_MAX_BUCKETS	65536	/* buckets per rung */
+
+class LadderScheduler : public Scheduler {
+public:
+	LadderScheduler();
+	~LadderScheduler();
+	void cancel(Event*);
+	void insert(Event*);
+	Event* lookup(scheduler_uid_t uid);
+	Event* deque();
+	const Event* head();
+
+protected:
+	/*
+	 * Every list (top, each bucket of each rung, bottom) is a
+	 * circular doubly linked list through Event::next_/prev_ anchored
+	 * at a sentinel Event, so cancel() can unlink in O(1) without
+	 * knowing which list the event lives on.
+	 */
+	struct Rung {
+		Event*	buckets_;	// sentinels, one per bucket
+		int	nbuckets_;	// buckets in use
+		int	maxbuckets_;	// buckets allocated
+		int	cur_;		// first bucket not yet consumed
+		double	start_;		// timestamp of the start of bucket 0
+		double	width_;		// bucket width
+	};
+
+	int bucket(const Rung& r, double t) const;
+	int spawn(Event* chain, int n, double tmin, double tmax);
+	void sort_to_bottom(Event* chain, int n, int sorted);
+	int refill();
+
+	int threshold_;			// max events a bucket may hand to bottom
+
+	Event top_;			// unsorted far-future events
+	double top_start_;		// events at or after this go to top_
+	Rung rungs_[LADDER_MAX_RUNGS];
+	int nrungs_;
+	Event bottom_;			// sorted events about to be dispatched
+	int qsize_;
+};
+
+/*
+ * Conservative parallel execution (see parallel-scheduler.cc).  Nodes
+ * are partitioned into logical processes (LPs), each with its own
+ * event heap, run in lookahead windows by threads_ threads; packets
+ * cross between LPs only over cut DelayLinks, through post().
+ */
+class LPScheduler;
+
+class ParallelScheduler : public Scheduler {
+public:
+	ParallelScheduler();
+	~ParallelScheduler();
+	void run();
+	void cancel(Event*);
+	void insert(Event*);
+	Event* lookup(scheduler_uid_t uid);
+	Event* deque();
+	const Event* head();
+	void reset();
+	void schedule_call(TclObject* target, Handler* h, Event* e, double t);
+
+	/* the LP the calling thread is running, or -1 */
+	static int current() { return (lp_); }
+	/* schedule e for h at time t in LP lp, from a cut link */
+	static void post(int lp, Handler* h, Event* e, double t);
+
+protected:
+	friend class LPScheduler;
+	int command(int argc, const char*const* argv);
+	int configure(int nlps);
+	void setup();
+	int owner(const void* obj);
+	int hint(const char* script);
+	int hint(TclObject* o);
+	LPScheduler* earliest();
+	void enter(LPScheduler* lp);
+	void leave(LPScheduler* lp);
+	void window();
+	void run_lps(int first);
+	void exchange();
+#ifdef NS_THREADS
+	static void* worker(void* arg);
+	void start_workers();
+	void stop_workers();
+#endif
+
+	int threads_;			// bound; threads running the LPs
+	int nlps_;
+	LPScheduler** lps_;
+	LPScheduler* global_;		// events that belong to no LP
+	double lookahead_;		// least delay of a cut link
+	double end_;			// the window runs events before
+	scheduler_uid_t enduid_;	//   (end_, enduid_)
+	int ctx_;			// LP of the global event running, or -1
+	int athint_;			// LP for the "at" event being scheduled
+	Tcl_HashTable owners_;		// object -> LP
+	Tcl_HashTable hints_;		// global "at" event -> LP
+	int started_;			// setup() done
+	int nworkers_;
+	void* pool_;			// the worker threads, if any
+
+	static NS_THREAD_LOCAL int lp_;
+	static ParallelScheduler* running_;
+};
+
 
 #endif
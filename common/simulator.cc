@@ -48,6 +48,7 @@
 #include "node.h"
 #include "address.h"
 #include "object.h"
+#include "cmd-table.h"
 
 //class ParentNode;
 
@@ -61,22 +62,54 @@ public:
 
 Simulator* Simulator::instance_;
 
+/* the subcommands of Simulator::command() */
+enum {
+	CMD_POPULATE_FLAT_CLASSIFIERS,
+	CMD_LAZY_FLAT_CLASSIFIERS,
+	CMD_POPULATE_HIER_CLASSIFIERS,
+	CMD_GET_ROUTELOGIC,
+	CMD_MAC_TYPE,
+	CMD_ADD_NODE,
+	CMD_ADD_LANNODE,
+	CMD_ADD_ABSLAN_NODE,
+	CMD_ADD_BROADCAST_NODE
+};
+static const CommandTable::Entry sim_cmds[] = {
+	{ "populate-flat-classifiers", CMD_POPULATE_FLAT_CLASSIFIERS },
+	{ "lazy-flat-classifiers", CMD_LAZY_FLAT_CLASSIFIERS },
+	{ "populate-hier-classifiers", CMD_POPULATE_HIER_CLASSIFIERS },
+	{ "get-routelogic", CMD_GET_ROUTELOGIC },
+	{ "mac-type", CMD_MAC_TYPE },
+	{ "add-node", CMD_ADD_NODE },
+	{ "add-lannode", CMD_ADD_LANNODE },
+	{ "add-abslan-node", CMD_ADD_ABSLAN_NODE },
+	{ "add-broadcast-node", CMD_ADD_BROADCAST_NODE },
+	{ 0, 0 }
+};
+static CommandTable sim_table(sim_cmds);
+
 int Simulator::command(int argc, const char*const* argv) {
 	Tcl& tcl = Tcl::instance();
+	int cmd = sim_table.find(argv[1]);
 	if ((instance_ == 0) || (instance_ != this))
 		instance_ = this;
 	if (argc == 3) {
-		if (strcmp(argv[1], "populate-flat-classifiers") == 0) {
+		if (cmd == CMD_POPULATE_FLAT_CLASSIFIERS) {
 			nn_ = atoi(argv[2]);
 			populate_flat_classifiers();
 			return TCL_OK;
 		}
-		if (strcmp(argv[1], "populate-hier-classifiers") == 0) {
+		if (cmd == CMD_LAZY_FLAT_CLASSIFIERS) {
+			nn_ = atoi(argv[2]);
+			lazy_flat_classifiers();
+			return TCL_OK;
+		}
+		if (cmd == CMD_POPULATE_HIER_CLASSIFIERS) {
 			nn_ = atoi(argv[2]);
 			populate_hier_classifiers();
 			return TCL_OK;
 		}
-		if (strcmp(argv[1], "get-routelogic") == 0) {
+		if (cmd == CMD_GET_ROUTELOGIC) {
 			rtobject_ = (RouteLogic *)(TclObject::lookup(argv[2]));
 			if (rtobject_ == NULL) {
 				tcl.add_errorf("Wrong rtobject name %s", argv[2]);
@@ -84,7 +117,7 @@ int Simulator::command(int argc, const char*const* argv) {
 			}
 			return TCL_OK;
 		}
-		if (strcmp(argv[1], "mac-type") == 0) {
+		if (cmd == CMD_MAC_TYPE) {
 			if (strlen(argv[2]) >= SMALL_LEN) {
 				tcl.add_errorf("Length of mac-type name must be < %d", SMALL_LEN);
 				return TCL_ERROR;
@@ -94,7 +127,7 @@ int Simulator::command(int argc, const char*const* argv) {
 		}
 	}
 	if (argc == 4) {
-		if (strcmp(argv[1], "add-node") == 0) {
+		if (cmd == CMD_ADD_NODE) {
 			Node *node = (Node *)(TclObject::lookup(argv[2]));
 			if (node == NULL) {
 				tcl.add_errorf("Wrong object name %s",argv[2]);
@@ -103,7 +136,7 @@ int Simulator::command(int argc, const char*const* argv) {
 			int id = atoi(argv[3]);
 			add_node(node, id);
 			return TCL_OK;
-		} else if (strcmp(argv[1], "add-lannode") == 0) {
+		} else if (cmd == CMD_ADD_LANNODE) {
 			LanNode *node = (LanNode *)(TclObject::lookup(argv[2]));
 			if (node == NULL) {
 				tcl.add_errorf("Wrong object name %s",argv[2]);
@@ -112,7 +145,7 @@ int Simulator::command(int argc, const char*const* argv) {
 			int id = atoi(argv[3]);
 			add_node(node, id);
 			return TCL_OK;
-		} else if (strcmp(argv[1], "add-abslan-node") == 0) {
+		} else if (cmd == CMD_ADD_ABSLAN_NODE) {
 			AbsLanNode *node = (AbsLanNode *)(TclObject::lookup(argv[2]));
 			if (node == NULL) {
 				tcl.add_errorf("Wrong object name %s",argv[2]);
@@ -121,7 +154,7 @@ int Simulator::command(int argc, const char*const* argv) {
 			int id = atoi(argv[3]);
 			add_node(node, id);
 			return TCL_OK;
-		} else if (strcmp(argv[1], "add-broadcast-node") == 0) {
+		} else if (cmd == CMD_ADD_BROADCAST_NODE) {
 			BroadcastNode *node = (BroadcastNode *)(TclObject::lookup(argv[2]));
 			if (node == NULL) {
 				tcl.add_errorf("Wrong object name %s",argv[2]);
@@ -198,6 +231,88 @@ void Simulator::populate_flat_classifiers() {
 }
 
 
+/*
+ * Instead of installing all nn_ x nn_ routes, let the classifiers ask
+ * for each one on its first miss (see Classifier::lazy_route()).  When
+ * the routes are recomputed, the ones already installed are redone
+ * here, as populate_flat_classifiers() would.  A pair that has become
+ * unreachable keeps its old route, as it does there, so it stays on
+ * the list to be redone once it is reachable again.
+ */
+void Simulator::lazy_flat_classifiers() {
+	lazy_ = 1;
+	check(nn_);
+	clear_lazy_misses();
+	int n = nlazy_;
+	nlazy_ = 0;
+	for (int i = 0; i < n; i++) {
+		int src = lazy_pairs_[2 * i], dst = lazy_pairs_[2 * i + 1];
+		if (!lazy_route(src, dst))
+			lazy_record(src, dst);
+	}
+}
+
+int Simulator::lazy_route(int src, int dst) {
+	char tmp[SMALL_LEN];
+	if (!lazy_ || rtobject_ == NULL || src == dst || src < 0 ||
+	    src >= size_ || nodelist_[src] == NULL || dst < 0 || dst >= nn_)
+		return 0;
+	if (nmiss_ != nn_)
+		clear_lazy_misses();
+	unsigned int *miss = lazy_miss_ ? lazy_miss_[src] : NULL;
+	if (miss != NULL && (miss[dst >> 5] & (1U << (dst & 31))))
+		return 0;
+
+	int nh = rtobject_->lookup_flat(src, dst);
+	if (nh < 0) {
+		// unreachable until the routes change
+		if (lazy_miss_ == NULL) {
+			nmiss_ = nn_;
+			lazy_miss_ = new unsigned int*[nmiss_];
+			for (int i = 0; i < nmiss_; i++)
+				lazy_miss_[i] = NULL;
+		}
+		if (lazy_miss_[src] == NULL) {
+			int w = (nmiss_ + 31) >> 5;
+			lazy_miss_[src] = new unsigned int[w];
+			for (int i = 0; i < w; i++)
+				lazy_miss_[src][i] = 0;
+		}
+		lazy_miss_[src][dst >> 5] |= 1U << (dst & 31);
+		return 0;
+	}
+	NsObject *l_head = get_link_head(nodelist_[src], nh);
+	sprintf(tmp, "%d", dst);
+	nodelist_[src]->add_route(tmp, l_head);
+	lazy_record(src, dst);
+	return 1;
+}
+
+/* note that the route from src to dst is installed */
+void Simulator::lazy_record(int src, int dst) {
+	if (nlazy_ == maxlazy_) {
+		int* old = lazy_pairs_;
+		maxlazy_ = maxlazy_ ? 2 * maxlazy_ : SMALL_LEN;
+		lazy_pairs_ = new int[2 * maxlazy_];
+		for (int i = 0; i < 2 * nlazy_; i++)
+			lazy_pairs_[i] = old[i];
+		delete [] old;
+	}
+	lazy_pairs_[2 * nlazy_] = src;
+	lazy_pairs_[2 * nlazy_ + 1] = dst;
+	nlazy_++;
+}
+
+void Simulator::clear_lazy_misses() {
+	if (lazy_miss_ != NULL) {
+		for (int i = 0; i < nmiss_; i++)
+			delete [] lazy_miss_[i];
+		delete [] lazy_miss_;
+		lazy_miss_ = NULL;
+	}
+	nmiss_ = nn_;
+}
+
 void Simulator::populate_hier_classifiers() {
 	// Set up each classifer (aka node) to act as a router.
 	// Point each classifer table to the link object that
@@ -61,14 +61,21 @@ class Simulator : public TclObject {
 public:
 	static Simulator& instance() { return (*instance_); }
       Simulator() : nodelist_(NULL), rtobject_(NULL), nn_(0), \
-	size_(0) {}
+	size_(0), lazy_(0), lazy_pairs_(NULL), nlazy_(0), maxlazy_(0),
+	lazy_miss_(NULL), nmiss_(0) {}
       ~Simulator() {
 	    delete []nodelist_; 
+	    delete []lazy_pairs_;
+	    clear_lazy_misses();
       }
 	char* macType() { return macType_; }
 	int command(int argc, const char*const* argv);
 	void populate_flat_classifiers();
 	void populate_hier_classifiers();
+	void lazy_flat_classifiers();
+	int lazy_route(int src, int dst);
+	void lazy_record(int src, int dst);
+	void clear_lazy_misses();
 	void add_node(ParentNode *node, int id);
 	NsObject* get_link_head(ParentNode *node, int nh);
 	int node_id_by_addr(int address);
@@ -81,6 +88,12 @@ private:
 	RouteLogic *rtobject_;
 	int nn_;
 	int size_;
+	int lazy_;		// flat routes installed on first use
+	int *lazy_pairs_;	// (src, dst) of the routes installed so
+	int nlazy_;		// far, to redo when the routes change
+	int maxlazy_;
+	unsigned int **lazy_miss_; // per src, a bitmap of the dsts with no
+	int nmiss_;		// route, for nmiss_ (nn_ then) nodes
 	char macType_[SMALL_LEN];
 	static Simulator* instance_;
 };
@@ -33,53 +33,7 @@ static const char rcsid[] =
     "@(#) $Header: /home/smtatapudi/Thesis/nsnam/nsnam/ns-2/common/ttl.cc,v 1.12 2012/05/07 02:30:36 tom_henderson Exp $";
 #endif
 
-#include "packet.h"
-#include "ip.h"
-#include "connector.h"
-
-class TTLChecker : public Connector {
-public:
-	TTLChecker() : noWarn_(1), tick_(1) {}
-	int command(int argc, const char*const* argv) {
-		if (argc == 3) {
-			if (strcmp(argv[1], "warning") == 0) {
-				noWarn_ = ! atoi(argv[2]);
-				return TCL_OK;
-			}
-			if (strcmp(argv[1], "tick") == 0) {
-				int tick = atoi(argv[2]);
-				if (tick > 0) {
-					tick_ = tick;
-					return TCL_OK;
-				} else {
-					Tcl& tcl = Tcl::instance();
-					tcl.resultf("%s: TTL must be positive (specified = %d)\n",
-						    name(), tick);
-					return TCL_ERROR;
-				}
-			}
-		}
-		return Connector::command(argc, argv);
-	}
-	void recv(Packet* p, Handler* h) {
-		hdr_ip* iph = hdr_ip::access(p);
-		int ttl = iph->ttl() - tick_;
-		if (ttl <= 0) {
-			/* XXX should send to a drop object.*/
-			// Yes, and now it does...
-			// Packet::free(p);
-			if (! noWarn_)
-				printf("ttl exceeded\n");
-			drop(p);
-			return;
-		}
-		iph->ttl() = ttl;
-		send(p, h);
-	}
-protected:
-	int noWarn_;
-	int tick_;
-};
+#include "ttl.h"
 
 static class TTLCheckerClass : public TclClass {
 public:
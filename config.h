@@ -50,6 +50,17 @@
 #include "autoconf.h"
 #endif
 
+/*
+ * Thread-local storage for the little global state that the threads of
+ * the parallel scheduler (Scheduler/Parallel) must not share.
+ */
+#if defined(HAVE_LIBPTHREAD) && defined(__GNUC__)
+#define NS_THREADS
+#define NS_THREAD_LOCAL	__thread
+#else
+#define NS_THREAD_LOCAL
+#endif
+
 /* after autoconf (and HAVE_INT64) we can pick up tclcl.h */
 #ifndef stand_alone
 #ifdef __cplusplus
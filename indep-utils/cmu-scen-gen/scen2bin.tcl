@@ -0,0 +1,16 @@
+#
+# scen2bin.tcl -- convert a node-movement scenario written by setdest
+# into the binary form "$ns_ load-mobility" reads without parsing
+# (see mobile/mobility-scen.h).
+#
+# Usage:
+#   ns scen2bin.tcl <scenario-file> <binary-file>
+#
+
+if { $argc != 2 } {
+	puts stderr "usage: ns $argv0 <scenario-file> <binary-file>"
+	exit 1
+}
+set scen [new MobilityScenario]
+$scen convert [lindex $argv 0] [lindex $argv 1]
+exit 0
@@ -34,25 +34,37 @@ static const char rcsid[] =
 #endif
 
 #include "delay.h"
+#include "ttl.h"
 #include "mcast_ctrl.h"
 #include "ctrMcast.h"
+#include <typeinfo>
 
 static class LinkDelayClass : public TclClass {
 public:
 	LinkDelayClass() : TclClass("DelayLink") {}
 	TclObject* create(int /* argc */, const char*const* /* argv */) {
-		return (new LinkDelay);
+		return (new LinkDelay(1));
 	}
 } class_delay_link;
 
-LinkDelay::LinkDelay() 
-	: dynamic_(0), 
+/*
+ * Only a DelayLink proper (ring) binds inflightRing_; the LL and
+ * ARPTable built on LinkDelay never keep packets in transit.
+ */
+LinkDelay::LinkDelay(int ring) 
+	: fluid_delay_(0),
+	  dynamic_(0), 
 	  latest_time_(0),
-	  itq_(0)
+	  itq_(0),
+	  inflightRing_(0),
+	  lp_(-1),
+	  fastttl_(0)
 {
 	bind_bw("bandwidth_", &bandwidth_);
 	bind_time("delay_", &delay_);
 	bind_bool("avoidReordering_", &avoidReordering_);
+	if (ring)
+		bind_bool("inflightRing_", &inflightRing_);
 }
 
 int LinkDelay::command(int argc, const char*const* argv)
@@ -60,7 +72,16 @@ int LinkDelay::command(int argc, const char*const* argv)
 	if (argc == 2) {
 		if (strcmp(argv[1], "isDynamic") == 0) {
 			dynamic_ = 1;
-			itq_ = new PacketQueue();
+			if (itq_ == 0)
+				itq_ = new PacketQueue();
+			return TCL_OK;
+		}
+		/* see Queue::transmit */
+		if (strcmp(argv[1], "fast-path") == 0) {
+			fastttl_ = 0;
+			if (target_ != 0 && typeid(*target_) == typeid(TTLChecker))
+				fastttl_ = (TTLChecker*)target_;
+			Tcl::instance().resultf("%d", fastttl_ != 0);
 			return TCL_OK;
 		}
 	} else if (argc == 6) {
@@ -81,44 +102,110 @@ int LinkDelay::command(int argc, const char*const* argv)
 void LinkDelay::recv(Packet* p, Handler* h)
 {
 	double txt = txtime(p);
+	double delay = delay_ + fluid_delay_;
 	Scheduler& s = Scheduler::instance();
 	if (dynamic_) {
-		Event* e = (Event*)p;
-		e->time_= txt + delay_;
-		itq_->enque(p); // for convinience, use a queue to store packets in transit
-		s.schedule(this, p, txt + delay_);
+		if (inflightRing_) {
+			deliver(p, txt + delay);
+		} else {
+			Event* e = (Event*)p;
+			e->time_= txt + delay;
+			itq_->enque(p); // for convinience, use a queue to store packets in transit
+			s.schedule(this, p, txt + delay);
+		}
 	} else if (avoidReordering_) {
 		// code from Andrei Gurtov, to prevent reordering on
 		//   bandwidth or delay changes
  		double now_ = Scheduler::instance().clock();
- 		if (txt + delay_ < latest_time_ - now_ && latest_time_ > 0) {
+ 		if (txt + delay < latest_time_ - now_ && latest_time_ > 0) {
  			latest_time_+=txt;
- 			s.schedule(target_, p, latest_time_ - now_ );
+ 			deliver(p, latest_time_ - now_ );
  		} else {
- 			latest_time_ = now_ + txt + delay_;
- 			s.schedule(target_, p, txt + delay_);
+ 			latest_time_ = now_ + txt + delay;
+ 			deliver(p, txt + delay);
  		}
 
 	} else {
-		s.schedule(target_, p, txt + delay_);
+		deliver(p, txt + delay);
 	}
 	s.schedule(h, &intr_, txt);
 }
 
+/*
+ * Hand p to target_ after delay.  With inflightRing_, packets in
+ * transit wait in itq_ in order of arrival, each stamped with its
+ * delivery time, and only the head of itq_ is in the scheduler: while
+ * bandwidth_ and delay_ stay put delivery times only increase, so a
+ * link with thousands of packets in flight costs the scheduler one
+ * event.  A packet that would overtake the tail (delay_ or bandwidth_
+ * was raised, and avoidReordering_ is off) is scheduled on its own as
+ * before, except on a dynamic link, which must be able to drop every
+ * packet in transit and so holds it back behind the tail instead.
+ * On a link cut by a ParallelScheduler the packet is posted to the LP
+ * of the receiving end.
+ */
+void LinkDelay::deliver(Packet* p, double delay)
+{
+	Scheduler& s = Scheduler::instance();
+	if (lp_ >= 0) {
+		ParallelScheduler::post(lp_, target_, p, s.clock() + delay);
+		return;
+	}
+	if (!inflightRing_) {
+		s.schedule(target_, p, delay);
+		return;
+	}
+	if (itq_ == 0)
+		itq_ = new PacketQueue();
+	double t = s.clock() + delay;
+	Packet* tail = itq_->tail();
+	if (tail != 0 && t < tail->time_) {
+		if (!dynamic_) {
+			s.schedule(target_, p, delay);
+			return;
+		}
+		t = tail->time_;
+	}
+	p->time_ = t;
+	itq_->enque(p);
+	if (tail == 0)
+		s.schedule_at(this, p, t);
+}
+
+/*
+ * Make this link the boundary between two LPs of a ParallelScheduler:
+ * packets are posted to LP lp rather than scheduled.  A dynamic link
+ * cannot be cut, as the sending LP could not reach the packets in
+ * transit to drop them.
+ */
+int LinkDelay::cut(int lp)
+{
+	if (dynamic_ || delay_ <= 0)
+		return (-1);
+	lp_ = lp;
+	return (0);
+}
+
 void LinkDelay::send(Packet* p, Handler*)
 {
-	target_->recv(p, (Handler*) NULL);
+	if (target_ == fastttl_)
+		fastttl_->TTLChecker::recv(p, (Handler*) NULL);
+	else
+		target_->recv(p, (Handler*) NULL);
 }
 
 void LinkDelay::reset()
 {
 	Scheduler& s= Scheduler::instance();
 
-	if (itq_ && itq_->length()) {
+	if (dynamic_ && itq_ && itq_->length()) {
 		Packet *np;
 		// walk through packets currently in transit and kill 'em
+		if (inflightRing_)
+			s.cancel(itq_->head());	// the only one scheduled
 		while ((np = itq_->deque()) != 0) {
-			s.cancel(np);
+			if (!inflightRing_)
+				s.cancel(np);
 			drop(np);
 		}
 	}
@@ -128,6 +215,11 @@ void LinkDelay::handle(Event* e)
 {
 	Packet *p = itq_->deque();
 	assert(p->time_ == e->time_);
+	if (inflightRing_) {
+		Packet* np = itq_->head();
+		if (np != 0)
+			Scheduler::instance().schedule_at(this, np, np->time_);
+	}
 	send(p, (Handler*) NULL);
 }
 
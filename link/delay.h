@@ -40,9 +40,11 @@
 #include "ip.h"
 #include "connector.h"
 
+class TTLChecker;
+
 class LinkDelay : public Connector {
  public:
-	LinkDelay();
+	LinkDelay(int ring = 0);
 	void recv(Packet* p, Handler*);
 	void send(Packet* p, Handler*);
 	void handle(Event* e);
@@ -51,12 +53,17 @@ class LinkDelay : public Connector {
 		return (8. * hdr_cmn::access(p)->size() / bandwidth_);
 	}
 	double bandwidth() const { return bandwidth_; }
+	/* wait behind the backlog of a FluidModel (asim/fluid.h) */
+	void fluid_delay(double d) { fluid_delay_ = d; }
 	void pktintran(int src, int group);
+	int cut(int lp);
  protected:
 	int command(int argc, const char*const* argv);
 	void reset();
+	void deliver(Packet* p, double delay);
 	double bandwidth_;	/* bandwidth of underlying link (bits/sec) */
 	double delay_;		/* line latency */
+	double fluid_delay_;	/* added to delay_, see fluid_delay() */
 	Event intr_;
 	int dynamic_;		/* indicates whether or not link is ~ */
 	double latest_time_;	/* latest scheduled packet time, for use
@@ -66,6 +73,12 @@ class LinkDelay : public Connector {
 	int avoidReordering_;	/* indicates whether or not to avoid
 				 *  reordering when link bandwidth or delay 
 				 *  changes */
+	int inflightRing_;	/* keep packets in transit in itq_ and
+				 *  schedule only the one at its head */
+	int lp_;		/* LP of the receiving end if the link
+				 *  is cut by a ParallelScheduler, or -1 */
+	TTLChecker* fastttl_;	/* target_, if "fast-path" found it to
+				 *  be a plain TTLChecker */
 };
 
 #endif
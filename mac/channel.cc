@@ -43,6 +43,10 @@ static const char rcsid[] =
 
 //#include "template.h"
 #include <float.h>
+#include <math.h>
+#include <vector>
+#include <queue>
+#include <functional>
 
 #include "trace.h"
 #include "delay.h"
@@ -279,11 +283,326 @@ public:
 // Wireless extensions
 class MobileNode;
 
+/*
+ * NeighborGrid: a uniform grid of square cells over the nodes of a
+ * WirelessChannel, used instead of the X-sorted list when the channel's
+ * neighbor_grid_ is set.  A transmission then only looks at the few
+ * cells around the sender, and a position update only re-files the
+ * node when it leaves its cell.
+ *
+ * The list version refreshes, on every transmission, the position of
+ * every moving node last updated more than XLIST_POSITION_UPDATE_INTERVAL
+ * ago, and that is what makes it O(N).  The grid keeps the times of the
+ * transmissions instead, and replays the refreshes a node missed the
+ * next time its position is needed (catchUp()), so that nodes end up
+ * with exactly the positions, and transmissions with exactly the
+ * receivers, they would have with the list.  To make sure that no node
+ * outside the cells searched could have moved into range, the search
+ * reaches slack_ beyond the radius, and a moving node is caught up
+ * before it may have drifted slack_ from where it is filed (deadlines_).
+ */
+class NeighborGrid {
+public:
+	NeighborGrid(MobileNode *nodes, double radius);
+	~NeighborGrid();
+	void add(MobileNode *mn);
+	void remove(MobileNode *mn);
+	void moved(MobileNode *mn);
+	void catchUp(MobileNode *mn);
+	MobileNode **getAffectedNodes(MobileNode *mn, double radius,
+				      int *numAffectedNodes);
+private:
+	int column(double x) const;
+	int row(double y) const;
+	void file(MobileNode *mn, int c);
+	void unfile(MobileNode *mn);
+	void watch(MobileNode *mn);
+	void expire(double now);
+	void trim();
+
+	double x0_, y0_;	// lower left corner of cell 0
+	double width_;		// cell width and height
+	int nx_, ny_;		// columns and rows
+	double slack_;		// how far a node may be from its cell
+	std::vector<MobileNode*> *cells_;
+	int numNodes_;
+
+	typedef std::pair<double, MobileNode*> Deadline;
+	std::priority_queue<Deadline, std::vector<Deadline>,
+			    std::greater<Deadline> > deadlines_;
+	std::vector<double> sends_;	// times of the transmissions
+	unsigned int trimmed_;		// sends_.size() after the last trim()
+	std::vector<MobileNode*> found_;	// getAffectedNodes() result
+	std::vector<MobileNode*> due_;		// scratch for expire()
+};
+
+#define NEIGHBOR_GRID_MAX_CELLS (1 << 20)
+
+NeighborGrid::NeighborGrid(MobileNode *nodes, double radius) :
+	numNodes_(0), trimmed_(0)
+{
+	MobileNode *tmp;
+	double x1, y1;
+
+	// cover the nodes as they are now; nodes that stray out of the
+	// area are filed under the border cells
+	x0_ = y0_ = DBL_MAX;
+	x1 = y1 = -DBL_MAX;
+	for (tmp = nodes; tmp != NULL; tmp = tmp->nextX_) {
+		x0_ = min(x0_, tmp->X());
+		y0_ = min(y0_, tmp->Y());
+		x1 = max(x1, tmp->X());
+		y1 = max(y1, tmp->Y());
+	}
+	if (nodes == NULL)
+		x0_ = y0_ = x1 = y1 = 0;
+	width_ = radius;
+	for (;;) {
+		nx_ = (int)((x1 - x0_) / width_) + 1;
+		ny_ = (int)((y1 - y0_) / width_) + 1;
+		if ((double)nx_ * ny_ <= NEIGHBOR_GRID_MAX_CELLS)
+			break;
+		width_ *= 2;
+	}
+	slack_ = radius / 4;
+	cells_ = new std::vector<MobileNode*>[nx_ * ny_];
+	for (tmp = nodes; tmp != NULL; tmp = tmp->nextX_)
+		add(tmp);
+}
+
+NeighborGrid::~NeighborGrid()
+{
+	for (int c = 0; c < nx_ * ny_; c++)
+		for (unsigned int i = 0; i < cells_[c].size(); i++) {
+			cells_[c][i]->gridCell_ = -1;
+			cells_[c][i]->gridDeadline_ = -1;
+		}
+	delete [] cells_;
+}
+
+inline int
+NeighborGrid::column(double x) const
+{
+	double i = floor((x - x0_) / width_);
+	return (i < 0 ? 0 : (i >= nx_ ? nx_ - 1 : (int)i));
+}
+
+inline int
+NeighborGrid::row(double y) const
+{
+	double i = floor((y - y0_) / width_);
+	return (i < 0 ? 0 : (i >= ny_ ? ny_ - 1 : (int)i));
+}
+
+void
+NeighborGrid::file(MobileNode *mn, int c)
+{
+	mn->gridCell_ = c;
+	mn->gridIndex_ = cells_[c].size();
+	cells_[c].push_back(mn);
+}
+
+void
+NeighborGrid::unfile(MobileNode *mn)
+{
+	std::vector<MobileNode*>& cell = cells_[mn->gridCell_];
+	MobileNode *last = cell.back();
+
+	cell[mn->gridIndex_] = last;
+	last->gridIndex_ = mn->gridIndex_;
+	cell.pop_back();
+	mn->gridCell_ = -1;
+}
+
+/*
+ * Replay the refreshes the list version would have done to mn at the
+ * transmissions since its last update.
+ */
+void
+NeighborGrid::catchUp(MobileNode *mn)
+{
+	if (mn->gridCell_ < 0)
+		return;
+	while (mn->speed() != 0.0) {
+		double t = mn->getUpdateTime();
+		// first transmission more than the interval after t
+		unsigned int lo = 0, hi = sends_.size();
+		while (lo < hi) {
+			unsigned int mid = (lo + hi) / 2;
+			if (sends_[mid] - t > XLIST_POSITION_UPDATE_INTERVAL)
+				hi = mid;
+			else
+				lo = mid + 1;
+		}
+		if (lo == sends_.size())
+			break;
+		mn->update_position(sends_[lo]);
+	}
+}
+
+/*
+ * Make sure a moving node is caught up before it may have drifted
+ * slack_ from where it is filed.  Between refreshes its position does
+ * not change at all, so the deadline is never earlier than the first
+ * time it can be refreshed again.
+ */
+void
+NeighborGrid::watch(MobileNode *mn)
+{
+	if (mn->speed() == 0.0 || mn->gridCell_ < 0)
+		return;
+	double t = mn->getUpdateTime() + max(slack_ / mn->speed(),
+					     XLIST_POSITION_UPDATE_INTERVAL);
+	if (mn->gridDeadline_ < 0 || t < mn->gridDeadline_) {
+		// an earlier entry for mn, if any, is now stale
+		mn->gridDeadline_ = t;
+		deadlines_.push(Deadline(t, mn));
+	}
+}
+
+void
+NeighborGrid::expire(double now)
+{
+	unsigned int i;
+
+	due_.clear();
+	while (!deadlines_.empty() && deadlines_.top().first < now) {
+		Deadline d = deadlines_.top();
+
+		deadlines_.pop();
+		if (d.second->gridDeadline_ != d.first)
+			continue;
+		d.second->gridDeadline_ = -1;
+		due_.push_back(d.second);
+	}
+	// a node may not have been refreshed, so watch it only after the
+	// loop, lest it keeps coming due
+	for (i = 0; i < due_.size(); i++) {
+		catchUp(due_[i]);
+		watch(due_[i]);
+	}
+}
+
+/* forget the transmissions no node needs to catch up on */
+void
+NeighborGrid::trim()
+{
+	double oldest = DBL_MAX;
+	unsigned int n;
+
+	for (int c = 0; c < nx_ * ny_; c++)
+		for (unsigned int i = 0; i < cells_[c].size(); i++)
+			if (cells_[c][i]->speed() != 0.0)
+				oldest = min(oldest,
+					     cells_[c][i]->getUpdateTime());
+	for (n = 0; n < sends_.size() && sends_[n] < oldest; n++)
+		;
+	sends_.erase(sends_.begin(), sends_.begin() + n);
+	trimmed_ = sends_.size();
+}
+
+void
+NeighborGrid::add(MobileNode *mn)
+{
+	file(mn, column(mn->X()) + row(mn->Y()) * nx_);
+	numNodes_++;
+	watch(mn);
+}
+
+void
+NeighborGrid::remove(MobileNode *mn)
+{
+	if (mn->gridCell_ < 0)
+		return;
+	unfile(mn);
+	numNodes_--;
+	mn->gridDeadline_ = -1;
+}
+
+/* mn's position or speed has changed */
+void
+NeighborGrid::moved(MobileNode *mn)
+{
+	if (mn->gridCell_ < 0)
+		return;
+	int c = column(mn->X()) + row(mn->Y()) * nx_;
+	if (c != mn->gridCell_) {
+		unfile(mn);
+		file(mn, c);
+	}
+	watch(mn);
+}
+
+MobileNode **
+NeighborGrid::getAffectedNodes(MobileNode *mn, double radius,
+			       int *numAffectedNodes)
+{
+	double now = Scheduler::instance().clock();
+	double xmin, xmax, ymin, ymax;
+	int i, j, k;
+
+	// the list version takes the sender's position before this
+	// transmission refreshes anything
+	catchUp(mn);
+	xmin = mn->X() - radius;
+	xmax = mn->X() + radius;
+	ymin = mn->Y() - radius;
+	ymax = mn->Y() + radius;
+
+	if (sends_.empty() || sends_.back() < now) {
+		sends_.push_back(now);
+		if (sends_.size() > 2 * trimmed_ + numNodes_)
+			trim();
+	}
+	expire(now);
+
+	found_.clear();
+	for (j = row(ymin - slack_); j <= row(ymax + slack_); j++)
+		for (i = column(xmin - slack_); i <= column(xmax + slack_); i++) {
+			std::vector<MobileNode*>& cell = cells_[i + j * nx_];
+			found_.insert(found_.end(), cell.begin(), cell.end());
+		}
+	for (k = 0; k < (int)found_.size(); k++)
+		catchUp(found_[k]);
+
+	j = 0;
+	for (k = 0; k < (int)found_.size(); k++) {
+		MobileNode *tmp = found_[k];
+		if (tmp->X() >= xmin && tmp->X() <= xmax &&
+		    tmp->Y() >= ymin && tmp->Y() <= ymax)
+			found_[j++] = tmp;
+	}
+	found_.resize(j);
+
+	*numAffectedNodes = j;
+	return (j > 0 ? &found_[0] : NULL);
+}
+
+
 double WirelessChannel::highestAntennaZ_ = -1; // i.e., uninitialized
 double WirelessChannel::distCST_ = -1;
 
+/* Scratch space of sendUpBatch() */
+class ChannelBatch {
+public:
+	std::vector<Phy*> rx_;		// interfaces to copy the packet to
+	std::vector<double> pr_;	// and their receive power
+	PrBatch prop_;
+};
+
 WirelessChannel::WirelessChannel(void) : Channel(), numNodes_(0), 
-					 xListHead_(NULL), sorted_(0) {}
+					 xListHead_(NULL), sorted_(0), grid_(0),
+					 batch_(0)
+{
+	bind("neighbor_grid_", &neighbor_grid_);
+	bind("batch_pr_", &batch_pr_);
+}
+
+WirelessChannel::~WirelessChannel()
+{
+	delete grid_;
+	delete batch_;
+}
 
 int WirelessChannel::command(int argc, const char*const* argv)
 {
@@ -359,12 +678,30 @@ WirelessChannel::sendUp(Packet* p, Phy *tifp)
 		 MobileNode *mtnode = (MobileNode *) tnode;
 		 MobileNode **affectedNodes;// **aN;
 		 int numAffectedNodes = -1, i;
+		 double radius = distCST_ + /* safety */ 5;
 		 
-		 if(!sorted_){
-			 sortLists();
+		 if (!neighbor_grid_ && grid_ != 0) {
+			 // switched back: the list has not been kept sorted
+			 delete grid_;
+			 grid_ = 0;
+			 sorted_ = false;
+		 }
+		 if (neighbor_grid_ && grid_ == 0 && radius < DBL_MAX)
+			 grid_ = new NeighborGrid(xListHead_, radius);
+
+		 if (grid_ != 0) {
+			 affectedNodes = grid_->getAffectedNodes(mtnode,
+					 radius, &numAffectedNodes);
+		 } else {
+			 if(!sorted_){
+				 sortLists();
+			 }
+			 affectedNodes = getAffectedNodes(mtnode, radius, &numAffectedNodes);
+		 }
+		 if (batch_pr_) {
+			 sendUpBatch(p, tnode, affectedNodes, numAffectedNodes);
+			 numAffectedNodes = 0;
 		 }
-		 
-		 affectedNodes = getAffectedNodes(mtnode, distCST_ + /* safety */ 5, &numAffectedNodes);
 		 for (i=0; i < numAffectedNodes; i++) {
 			 rnode = affectedNodes[i];
 			 
@@ -380,12 +717,84 @@ WirelessChannel::sendUp(Packet* p, Phy *tifp)
 				 s.schedule(rifp, newp, propdelay);
 			 }
 		 }
-		 delete [] affectedNodes;
+		 if (grid_ == 0)
+			 delete [] affectedNodes;
 	 }
 	 Packet::free(p);
 }
 
 
+/*
+ * Work out, for all the candidates at once, the power with which their
+ * interfaces on this channel receive p, and only copy p to those that
+ * can sense it.  The copies are scheduled in the order of the
+ * candidates and carry the power along (PacketStamp::batchPr), so the
+ * receiving WirelessPhy does not evaluate the propagation model again.
+ * Interfaces that share a propagation model hand all their receivers
+ * to it in one call (Propagation::Pr(PacketStamp*, PrBatch&)); the
+ * others, and those that do not fit in, are asked one by one.
+ *
+ * The power is taken at the time of sending rather than when the first
+ * bit arrives, which is at most a few microseconds later.  With a
+ * random propagation model, use its per-receiver streams
+ * ("$prop rx-streams") so that what a receiver draws does not depend
+ * on the order of evaluation.
+ */
+void
+WirelessChannel::sendUpBatch(Packet *p, Node *tnode, MobileNode **nodes, int n)
+{
+	Scheduler &s = Scheduler::instance();
+	Phy *rifp;
+	Packet *newp;
+	double Pr;
+	int i, j, k;
+
+	if (batch_ == 0)
+		batch_ = new ChannelBatch;
+	std::vector<Phy*> &rx = batch_->rx_;
+	std::vector<double> &rxPr = batch_->pr_;
+	PrBatch &b = batch_->prop_;
+
+	rx.clear();
+	rxPr.clear();
+	b.clear();
+	for (i = 0; i < n; i++) {
+		if (nodes[i] == tnode)
+			continue;
+		rifp = (nodes[i]->ifhead()).lh_first;
+		for (; rifp; rifp = rifp->nextnode()) {
+			if (rifp->channel() != this)
+				continue;
+			if (rifp->prescreen(&b)) {
+				rx.push_back(rifp);
+				rxPr.push_back(-2);	// from the batch
+			} else if (rifp->prescreen(p, &Pr)) {
+				rx.push_back(rifp);
+				rxPr.push_back(Pr);
+			}
+		}
+	}
+	if (b.size() > 0)
+		b.prop_->Pr(&p->txinfo_, b);
+
+	for (i = j = k = 0; i < (int)rx.size(); i++) {
+		if (rxPr[i] == -2) {
+			Pr = b.pr_[k++];
+			if (Pr < ((WirelessPhy*)rx[i])->getCSThresh())
+				continue;
+			rxPr[i] = Pr;
+		}
+		rx[j] = rx[i];
+		rxPr[j++] = rxPr[i];
+	}
+	for (i = 0; i < j; i++) {
+		newp = p->copy();
+		newp->txinfo_.batchPr = rxPr[i];
+		s.schedule(rx[i], newp, get_pdelay(tnode, rx[i]->node()));
+	}
+}
+
+
 void
 WirelessChannel::addNodeToList(MobileNode *mn)
 {
@@ -404,12 +813,17 @@ WirelessChannel::addNodeToList(MobileNode *mn)
 		mn->nextX_ = NULL;
 	}
 	numNodes_++;
+	if (grid_ != 0)
+		grid_->add(mn);
 }
 
 void
 WirelessChannel::removeNodeFromList(MobileNode *mn) {
 	
 	MobileNode *tmp;
+
+	if (grid_ != 0)
+		grid_->remove(mn);
 	// Find node in list
 	for (tmp = xListHead_; tmp->nextX_ != NULL; tmp=tmp->nextX_) {
 		if (tmp == mn) {
@@ -471,6 +885,13 @@ WirelessChannel::sortLists(void) {
 	fprintf(stderr, "DONE!\n");
 }
 
+void
+WirelessChannel::catchUp(class MobileNode *mn)
+{
+	if (grid_ != 0)
+		grid_->catchUp(mn);
+}
+
 void
 WirelessChannel::updateNodesList(class MobileNode *mn, double oldX) {
 	
@@ -478,6 +899,12 @@ WirelessChannel::updateNodesList(class MobileNode *mn, double oldX) {
 	double X = mn->X();
 	bool skipX=false;
 	
+	if (grid_ != 0) {
+		grid_->moved(mn);
+		return;
+	}
+	if (X == oldX)
+		return;		// only Y or the speed changed
 	if(!sorted_) {
 		sortLists();
 		return;
@@ -43,6 +43,8 @@
 
 class Trace;
 class Node;
+class NeighborGrid;
+class ChannelBatch;
 /*=================================================================
 Channel:  a shared medium that supports contention and collision
         This class is used to represent the physical media to which
@@ -101,6 +103,7 @@ class WirelessChannel : public Channel{
 	friend class Topography;
 public:
 	WirelessChannel(void);
+	~WirelessChannel();
 	virtual int command(int argc, const char*const* argv);
         inline double gethighestAntennaZ() { return highestAntennaZ_; }
 
@@ -117,7 +120,18 @@ private:
 	void removeNodeFromList(MobileNode *mn);
 	void sortLists(void);
 	void updateNodesList(class MobileNode *mn, double oldX);
+	void catchUp(class MobileNode *mn);
 	MobileNode **getAffectedNodes(MobileNode *mn, double radius, int *numAffectedNodes);
+
+	/* Or, with neighbor_grid_ set, a uniform grid over the nodes */
+	int neighbor_grid_;
+	NeighborGrid *grid_;
+
+	/* With batch_pr_ set, the receive power at every candidate is
+	   worked out before any copy of the packet is made */
+	void sendUpBatch(Packet *p, Node *tnode, MobileNode **nodes, int n);
+	int batch_pr_;
+	ChannelBatch *batch_;
 	
 protected:
 	static double distCST_;        
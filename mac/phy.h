@@ -59,6 +59,7 @@ LIST_HEAD(if_head, Phy);
 
 class Node;
 class LinkHead;
+class PrBatch;
 /*--------------------------------------------------------------
   Phy : Base class for all network interfaces used to control
   channel access
@@ -74,6 +75,14 @@ class Phy : public BiConnector {
 	
 	virtual int sendUp(Packet *p)=0;
 
+	// Work out the power with which this interface would receive p
+	// and whether it can sense it at all, before p is copied to it.
+	// Pr is -1 if the interface leaves that to sendUp().
+	virtual int prescreen(Packet *, double *Pr) { *Pr = -1; return 1; }
+	// Or leave that to the propagation model, for all receivers in b
+	// at once.  Returns 0 if the interface cannot join b.
+	virtual int prescreen(PrBatch *) { return 0; }
+
 	inline double  txtime(Packet *p) {
 		return (hdr_cmn::access(p)->size() * 8.0) / bandwidth_; }
 	inline double txtime(int bytes) {
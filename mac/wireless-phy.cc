@@ -337,8 +337,13 @@ WirelessPhy::sendUp(Packet *p)
 	}
 
 	if(propagation_) {
-		s.stamp((MobileNode*)node(), ant_, 0, lambda_);
-		Pr = propagation_->Pr(&p->txinfo_, &s, this);
+		if (p->txinfo_.batchPr >= 0) {
+			// the channel got it when p was sent
+			Pr = p->txinfo_.batchPr;
+		} else {
+			s.stamp((MobileNode*)node(), ant_, 0, lambda_);
+			Pr = propagation_->Pr(&p->txinfo_, &s, this);
+		}
 		if (Pr < CSThresh_) {
 			pkt_recvd = 0;
 			goto DONE;
@@ -432,6 +437,27 @@ DONE:
 	return pkt_recvd;
 }
 
+int
+WirelessPhy::prescreen(Packet *p, double *Pr)
+{
+	PacketStamp s;
+
+	*Pr = -1;
+	if (propagation_ == 0)
+		return 1;
+	s.stamp((MobileNode*)node(), ant_, 0, lambda_);
+	*Pr = propagation_->Pr(&p->txinfo_, &s, this);
+	return (*Pr >= CSThresh_);
+}
+
+int
+WirelessPhy::prescreen(PrBatch *b)
+{
+	if (propagation_ == 0)
+		return 0;
+	return b->add(this);
+}
+
 void
 WirelessPhy::node_on()
 {
@@ -64,6 +64,8 @@ public:
 	
 	void sendDown(Packet *p);
 	int sendUp(Packet *p);
+	int prescreen(Packet *p, double *Pr);
+	int prescreen(PrBatch *b);
 	
 	inline double getL() const {return L_;}
 	inline double getLambda() const {return lambda_;}
@@ -82,6 +84,8 @@ public:
 
         /* -NEW- */
         inline double getAntennaZ() { return ant_->getZ(); }
+        inline Antenna *getAntenna() { return ant_; }
+        inline Propagation *getPropagation() { return propagation_; }
         inline double getPt() { return Pt_; }
         inline double getRXThresh() { return RXThresh_; }
         inline double getCSThresh() { return CSThresh_; }
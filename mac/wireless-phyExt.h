@@ -168,6 +168,9 @@ public:
 	//ns2 calls
 	void sendDown(Packet *p);
 	int sendUp(Packet *p);
+	// the power monitor has to see every packet, sensed or not
+	int prescreen(Packet *, double *Pr) { *Pr = -1; return 1; }
+	int prescreen(PrBatch *) { return 0; }
 
 	int discard(Packet *p, double power, char* reason);
 	double getDist(double Pr, double Pt, double Gt, double Gr,
@@ -83,6 +83,11 @@ God::God()
 	num_send = 0;
 	active = false;
 	allowTostop = false;
+	link_ = 0;
+	nbr_ = 0;
+	deg_ = cap_ = bfs_ = rows_ = changed_ = 0;
+	max_changed_ = 0;
+	bind("incremental_", &incremental_);
 }
 
 
@@ -105,6 +110,8 @@ int God::NextHop(int from, int to)
     return -1;
   }
 
+  if (link_ != 0)
+    return NextHopOf(from, to);
   return NEXT_HOP(from,to);
 }
 
@@ -247,7 +254,7 @@ void God::Dump()
    fprintf(stdout, "Dump next_hop\n");
    for (i = 0; i < num_nodes; i++) {
      for (j = 0; j < num_nodes; j++) {
-       fprintf(stdout,"NextHop(%d,%d):%d\n",i,j,NEXT_HOP(i,j));
+       fprintf(stdout,"NextHop(%d,%d):%d\n",i,j,NextHop(i,j));
      }
    }
 
@@ -469,6 +476,8 @@ bool God::IsNeighbor(int i, int j)
     return false;
   }
 
+  mb_node[i]->catchUp();
+  mb_node[j]->catchUp();
   vector a(mb_node[i]->X(), mb_node[i]->Y(), mb_node[i]->Z());
   vector b(mb_node[j]->X(), mb_node[j]->Y(), mb_node[j]->Z());
   vector d = a - b;
@@ -570,8 +579,13 @@ void God::ComputeRoute()
     return;
   }
 
-  floyd_warshall();
-  ComputeNextHop();
+  if (incremental_) {
+    UpdateHops();
+  } else {
+    DropLinks();
+    floyd_warshall();
+    ComputeNextHop();
+  }
   Rewrite_OIF_Map();
   CountConnect();
   CountAliveNode();
@@ -658,6 +672,210 @@ void God::floyd_warshall()
 
 }
 
+
+// Incremental shortest paths.  The links are unweighted and
+// symmetric, so a new link (u,v) can only shorten the paths of a
+// source s through it, by min_hops(s,u) + 1 + min_hops(v,t), and a
+// lost link only lengthens the paths of the sources it was on, i.e.
+// those s with |min_hops(s,u) - min_hops(s,v)| == 1, whose rows are
+// then redone by a breadth first search.
+
+void God::UpdateHops()
+{
+  int i, j, n = num_nodes, nchanged = 0;
+
+  if (link_ == 0) {
+    link_ = new char[n * n];
+    nbr_ = new int*[n];
+    deg_ = new int[n];
+    cap_ = new int[n];
+    bfs_ = new int[n];
+    rows_ = new int[2 * n];
+    bzero(link_, sizeof(char) * n * n);
+    for (i = 0; i < n; i++) {
+      nbr_[i] = 0;
+      deg_[i] = cap_[i] = 0;
+    }
+    // no links yet
+    for (i = 0; i < n; i++)
+      for (j = 0; j < n; j++)
+	MIN_HOPS(i,j) = (i == j) ? 0 : INFINITY;
+  }
+
+  for (i = 0; i < n; i++) {
+    for (j = i+1; j < n; j++) {
+      int up = IsNeighbor(i,j) ? 1 : 0;
+      if (up == link_[i*n + j])
+	continue;
+      if (3 * nchanged + 3 > max_changed_) {
+	int *c = new int[2 * max_changed_ + 3 * n];
+	if (changed_ != 0) {
+	  memcpy(c, changed_, sizeof(int) * 3 * nchanged);
+	  delete [] changed_;
+	}
+	changed_ = c;
+	max_changed_ = 2 * max_changed_ + 3 * n;
+      }
+      changed_[3*nchanged] = i;
+      changed_[3*nchanged + 1] = j;
+      changed_[3*nchanged + 2] = up;
+      nchanged++;
+    }
+  }
+
+  if (nchanged > n) {
+    // too many to repair one by one
+    for (i = 0; i < nchanged; i++)
+      SetLink(changed_[3*i], changed_[3*i + 1], changed_[3*i + 2]);
+    for (i = 0; i < n; i++)
+      BFSHops(i);
+    return;
+  }
+  // take down the lost links first, so that every BFS sees the links
+  // of the last call minus those lost so far
+  for (i = 0; i < nchanged; i++)
+    if (changed_[3*i + 2] == 0)
+      LinkDown(changed_[3*i], changed_[3*i + 1]);
+  for (i = 0; i < nchanged; i++)
+    if (changed_[3*i + 2] == 1)
+      LinkUp(changed_[3*i], changed_[3*i + 1]);
+
+#ifdef SANITY_CHECKS
+  for(i = 0; i < n; i++)
+     for(j = 0; j < n; j++)
+	assert(MIN_HOPS(i,j) == MIN_HOPS(j,i));
+#endif
+}
+
+void God::SetLink(int i, int j, int up)
+{
+  int k, a, b;
+
+  link_[i*num_nodes + j] = link_[j*num_nodes + i] = up;
+  for (k = 0; k < 2; k++) {
+    a = k ? j : i;
+    b = k ? i : j;
+    int *l = nbr_[a];
+    int pos = 0;
+    while (pos < deg_[a] && l[pos] < b)
+      pos++;
+    if (up) {
+      if (deg_[a] == cap_[a]) {
+	cap_[a] = cap_[a] ? 2 * cap_[a] : 8;
+	l = new int[cap_[a]];
+	if (nbr_[a] != 0) {
+	  memcpy(l, nbr_[a], sizeof(int) * deg_[a]);
+	  delete [] nbr_[a];
+	}
+	nbr_[a] = l;
+      }
+      memmove(l + pos + 1, l + pos, sizeof(int) * (deg_[a] - pos));
+      l[pos] = b;
+      deg_[a]++;
+    } else {
+      assert(pos < deg_[a] && l[pos] == b);
+      memmove(l + pos, l + pos + 1, sizeof(int) * (deg_[a] - pos - 1));
+      deg_[a]--;
+    }
+  }
+}
+
+void God::LinkUp(int u, int v)
+{
+  int s, t, d;
+  int *ru = rows_, *rv = rows_ + num_nodes;
+
+  // the rows are changed as we go, so work from the old ones of u, v
+  memcpy(ru, &MIN_HOPS(u,0), sizeof(int) * num_nodes);
+  memcpy(rv, &MIN_HOPS(v,0), sizeof(int) * num_nodes);
+  SetLink(u, v, 1);
+  for (s = 0; s < num_nodes; s++) {
+    if (ru[s] + 1 < rv[s]) {
+      // s now reaches the side of v faster, through u
+      for (t = 0; t < num_nodes; t++) {
+	d = ru[s] + 1 + rv[t];
+	if (d < MIN_HOPS(s,t))
+	  MIN_HOPS(s,t) = MIN_HOPS(t,s) = d;
+      }
+    } else if (rv[s] + 1 < ru[s]) {
+      for (t = 0; t < num_nodes; t++) {
+	d = rv[s] + 1 + ru[t];
+	if (d < MIN_HOPS(s,t))
+	  MIN_HOPS(s,t) = MIN_HOPS(t,s) = d;
+      }
+    }
+  }
+}
+
+void God::LinkDown(int u, int v)
+{
+  int s, n = 0;
+  int *affected = new int[num_nodes];
+
+  for (s = 0; s < num_nodes; s++) {
+    int diff = MIN_HOPS(s,u) - MIN_HOPS(s,v);
+    if (diff == 1 || diff == -1)
+      affected[n++] = s;
+  }
+  SetLink(u, v, 0);
+  for (s = 0; s < n; s++)
+    BFSHops(affected[s]);
+  delete [] affected;
+}
+
+// redo row (and column) s of min_hops
+void God::BFSHops(int s)
+{
+  int head = 0, tail = 0, i, k;
+
+  for (i = 0; i < num_nodes; i++)
+    MIN_HOPS(s,i) = MIN_HOPS(i,s) = INFINITY;
+  MIN_HOPS(s,s) = 0;
+  bfs_[tail++] = s;
+  while (head < tail) {
+    i = bfs_[head++];
+    for (k = 0; k < deg_[i]; k++) {
+      int j = nbr_[i][k];
+      if (MIN_HOPS(s,j) != INFINITY)
+	continue;
+      MIN_HOPS(s,j) = MIN_HOPS(j,s) = MIN_HOPS(s,i) + 1;
+      bfs_[tail++] = j;
+    }
+  }
+}
+
+// Same answer as ComputeNextHop(): the lowest numbered neighbor on a
+// shortest path.
+int God::NextHopOf(int from, int to)
+{
+  if (from == to)
+    return from;
+  for (int k = 0; k < deg_[from]; k++) {
+    int n = nbr_[from][k];
+    if (MIN_HOPS(from,to) == MIN_HOPS(n,to) + 1)
+      return n;
+  }
+  return UNREACHABLE;
+}
+
+// Forget the links, e.g. when min_hops is set some other way.
+void God::DropLinks()
+{
+  if (link_ == 0)
+    return;
+  for (int i = 0; i < num_nodes; i++)
+    delete [] nbr_[i];
+  delete [] nbr_;
+  delete [] link_;
+  delete [] deg_;
+  delete [] cap_;
+  delete [] bfs_;
+  delete [] rows_;
+  link_ = 0;
+  nbr_ = 0;
+  deg_ = cap_ = bfs_ = rows_ = 0;
+}
+
 // --------------------------
 
 
@@ -798,6 +1016,33 @@ God::getMyBottomGrid(double x, double y)
 	return(yloc*gridX+xloc);
 }
 
+/*
+ * What "$god_ set-dist" does; also called by MobilityScenario.
+ */
+void
+God::SetDist(int i, int j, int d)
+{
+        assert(i >= 0 && i < num_nodes);
+        assert(j >= 0 && j < num_nodes);
+
+	if (active == true) {
+	  if (NOW > prev_time) {
+	    ComputeRoute();
+	  }
+	}
+	else {
+	  DropLinks();
+	  min_hops[i*num_nodes+j] = d;
+	  min_hops[j*num_nodes+i] = d;
+	}
+
+	// The scenario file should set the node positions
+	// before calling set-dist !!
+
+	assert(min_hops[i * num_nodes + j] == d);
+        assert(min_hops[j * num_nodes + i] == d);
+}
+
 int 
 God::command(int argc, const char* const* argv)
 {
@@ -1025,28 +1270,7 @@ God::command(int argc, const char* const* argv)
 		}
 
                 if (strcasecmp(argv[1], "set-dist") == 0) {
-                        int i = atoi(argv[2]);
-                        int j = atoi(argv[3]);
-                        int d = atoi(argv[4]);
-
-                        assert(i >= 0 && i < num_nodes);
-                        assert(j >= 0 && j < num_nodes);
-
-			if (active == true) {
-			  if (NOW > prev_time) {
-			    ComputeRoute();
-			  }
-			}
-			else {
-			  min_hops[i*num_nodes+j] = d;
-			  min_hops[j*num_nodes+i] = d;
-			}
-
-			// The scenario file should set the node positions
-			// before calling set-dist !!
-
-			assert(min_hops[i * num_nodes + j] == d);
-                        assert(min_hops[j * num_nodes + i] == d);
+                        SetDist(atoi(argv[2]), atoi(argv[3]), atoi(argv[4]));
                         return TCL_OK;
                 }
 
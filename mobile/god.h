@@ -169,6 +169,8 @@ public:
         bool IsNeighbor(int i, int j);   // Is node i a neighbor of node j ?
         void ComputeW();           // Initialize the connectivity metrix
         void floyd_warshall();     // Calculate the shortest path
+        void UpdateHops();         // Or repair min_hops link by link
+        void SetDist(int i, int j, int d);  // "set-dist"
 
         void AddSink(int dt, int skid);
         void AddSource(int dt, int srcid);
@@ -224,6 +226,28 @@ private:
         int gridX;
         int gridY;
 
+        // With incremental_ set, ComputeRoute() finds the links that
+        // came up or went down since its last call and repairs only
+        // the rows of min_hops they affect, instead of running
+        // floyd_warshall() and ComputeNextHop().  NextHop() is then
+        // looked up in the neighbor lists.
+        int incremental_;
+        char *link_;          // link_[i * num_nodes + j] is 1 if i and j
+                              // are neighbors, or 0 if not known yet
+        int **nbr_;           // nbr_[i] neighbors of i, in increasing
+        int *deg_;            //   order, deg_[i] of them
+        int *cap_;
+        int *bfs_;            // BFS queue
+        int *rows_;           // scratch for LinkUp()
+        int *changed_;        // links that changed, as (i, j, up)
+        int max_changed_;
+
+        void SetLink(int i, int j, int up);
+        void LinkUp(int u, int v);
+        void LinkDown(int u, int v);
+        void BFSHops(int s);
+        int NextHopOf(int from, int to);
+        void DropLinks();
 };
 
 #endif
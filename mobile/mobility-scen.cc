@@ -0,0 +1,463 @@
+/* -*-	Mode:C++; c-basic-offset:8; tab-width:8; indent-tabs-mode:t -*- */
+/*
+ * Copyright (c) 1997 Regents of the University of California.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor of the Laboratory may be used
+ *    to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+#include "mobility-scen.h"
+#include "mobilenode.h"
+#include "god.h"
+
+static class MobilityScenarioClass : public TclClass {
+public:
+	MobilityScenarioClass() : TclClass("MobilityScenario") {}
+	TclObject* create(int, const char*const*) {
+		return (new MobilityScenario);
+	}
+} class_mobility_scenario;
+
+MobilityScenario::MobilityScenario() :
+	buf_(0), len_(0), hdr_(0), nodes_(0), way_(0), dist_(0),
+	mn_(0), nmn_(0), ev_(0)
+{
+}
+
+MobilityScenario::~MobilityScenario()
+{
+	if (ev_) {
+		for (int i = 0; i <= hdr_->nnodes_; i++)
+			if (ev_[i].uid_ > 0)
+				Scheduler::instance().cancel(&ev_[i]);
+		delete [] ev_;
+	}
+	delete [] buf_;
+	delete [] mn_;
+}
+
+int
+MobilityScenario::command(int argc, const char*const* argv)
+{
+	Tcl& tcl = Tcl::instance();
+
+	if (argc == 3) {
+		if (strcmp(argv[1], "load") == 0)
+			return (load(argv[2]));
+	} else if (argc == 4) {
+		if (strcmp(argv[1], "node") == 0) {
+			int i = atoi(argv[2]);
+			MobileNode* mn = (MobileNode*)TclObject::lookup(argv[3]);
+			if (i < 0 || mn == 0) {
+				tcl.resultf("%s: bad node %s %s", name(),
+					    argv[2], argv[3]);
+				return (TCL_ERROR);
+			}
+			if (i >= nmn_) {
+				int n = nmn_ ? nmn_ : 16;
+				while (n <= i)
+					n *= 2;
+				MobileNode** grown = new MobileNode*[n];
+				memset(grown, 0, n * sizeof(MobileNode*));
+				if (nmn_)
+					memcpy(grown, mn_,
+					       nmn_ * sizeof(MobileNode*));
+				delete [] mn_;
+				mn_ = grown;
+				nmn_ = n;
+			}
+			mn_[i] = mn;
+			return (TCL_OK);
+		}
+		if (strcmp(argv[1], "convert") == 0) {
+			if (buf_ != 0) {
+				tcl.resultf("%s: already holds a scenario",
+					    name());
+				return (TCL_ERROR);
+			}
+			if (parse(argv[2]) != TCL_OK)
+				return (TCL_ERROR);
+			return (write(argv[3]));
+		}
+	}
+	return (TclObject::command(argc, argv));
+}
+
+/*
+ * Allocate an empty image for the given number of records.
+ */
+void
+MobilityScenario::alloc(int nnodes, int nwaypoints, int ndist, int ndist0)
+{
+	len_ = sizeof(ScenHeader) + nnodes * sizeof(ScenNode) +
+		nwaypoints * sizeof(ScenWaypoint) + ndist * sizeof(ScenDist);
+	buf_ = new char[len_];
+	memset(buf_, 0, len_);
+	hdr_ = (ScenHeader*)buf_;
+	nodes_ = (ScenNode*)(hdr_ + 1);
+	way_ = (ScenWaypoint*)(nodes_ + nnodes);
+	dist_ = (ScenDist*)(way_ + nwaypoints);
+
+	memcpy(hdr_->magic_, SCEN_MAGIC, sizeof(hdr_->magic_));
+	hdr_->order_ = SCEN_ORDER;
+	hdr_->version_ = SCEN_VERSION;
+	hdr_->nnodes_ = nnodes;
+	hdr_->nwaypoints_ = nwaypoints;
+	hdr_->ndist_ = ndist;
+	hdr_->ndist0_ = ndist0;
+}
+
+struct ScenWaypointOf {
+	int		node_;
+	ScenWaypoint	w_;
+};
+
+static bool
+waypoint_before(const ScenWaypointOf& a, const ScenWaypointOf& b)
+{
+	if (a.node_ != b.node_)
+		return (a.node_ < b.node_);
+	return (a.w_.t_ < b.w_.t_);
+}
+
+static bool
+dist_before(const ScenDist& a, const ScenDist& b)
+{
+	return (a.t_ < b.t_);
+}
+
+/*
+ * Read a text scenario.  Only the lines setdest writes are understood:
+ *
+ *	$node_(i) set X_ x			(likewise Y_ and Z_)
+ *	$god_ set-dist i j d
+ *	$ns_ at t "$node_(i) setdest x y speed"
+ *	$ns_ at t "$god_ set-dist i j d"
+ *
+ * plus comments and "set god_ ...".  Records scheduled for the same
+ * time keep their order in the file.
+ */
+int
+MobilityScenario::parse(const char* file)
+{
+	Tcl& tcl = Tcl::instance();
+	FILE* fp = fopen(file, "r");
+	if (fp == 0) {
+		tcl.resultf("%s: can't open %s", name(), file);
+		return (TCL_ERROR);
+	}
+
+	std::vector<ScenNode> nodes;
+	std::vector<ScenWaypointOf> way;
+	std::vector<ScenDist> dist0, dist;
+	char line[1024];
+	int lineno = 0;
+
+	while (fgets(line, sizeof(line), fp) != 0) {
+		lineno++;
+		if (strchr(line, '\n') == 0 && !feof(fp)) {
+			tcl.resultf("%s: %s:%d: line too long", name(),
+				    file, lineno);
+			fclose(fp);
+			return (TCL_ERROR);
+		}
+		char* p = line + strspn(line, " \t\r\n");
+		if (*p == 0 || *p == '#' || strncmp(p, "set god_ ", 9) == 0)
+			continue;
+
+		ScenWaypointOf w;
+		ScenDist d;
+		char c;
+		double v;
+		int i, n = 0;
+		memset(&d, 0, sizeof(d));
+		if (sscanf(p, "$node_(%d) set %c_ %lf %n", &i, &c, &v, &n) == 3
+		    && p[n] == 0 && i >= 0 && (c == 'X' || c == 'Y' || c == 'Z')) {
+			if (i >= (int)nodes.size()) {
+				ScenNode z;
+				memset(&z, 0, sizeof(z));
+				nodes.resize(i + 1, z);
+			}
+			if (c == 'X') {
+				nodes[i].x_ = v;
+				nodes[i].set_ |= SCEN_X;
+			} else if (c == 'Y') {
+				nodes[i].y_ = v;
+				nodes[i].set_ |= SCEN_Y;
+			} else {
+				nodes[i].z_ = v;
+				nodes[i].set_ |= SCEN_Z;
+			}
+			continue;
+		}
+		n = 0;
+		if (sscanf(p, "$god_ set-dist %d %d %d %n",
+			   &d.i_, &d.j_, &d.d_, &n) == 3 && p[n] == 0 &&
+		    d.i_ >= 0 && d.j_ >= 0) {
+			d.t_ = -1;
+			dist0.push_back(d);
+			continue;
+		}
+		n = 0;
+		if (sscanf(p, "$ns_ at %lf \"$node_(%d) setdest %lf %lf %lf\" %n",
+			   &w.w_.t_, &w.node_, &w.w_.x_, &w.w_.y_,
+			   &w.w_.speed_, &n) == 5 && p[n] == 0 &&
+		    w.node_ >= 0 && w.w_.t_ >= 0) {
+			way.push_back(w);
+			continue;
+		}
+		n = 0;
+		if (sscanf(p, "$ns_ at %lf \"$god_ set-dist %d %d %d\" %n",
+			   &d.t_, &d.i_, &d.j_, &d.d_, &n) == 4 && p[n] == 0 &&
+		    d.i_ >= 0 && d.j_ >= 0 && d.t_ >= 0) {
+			dist.push_back(d);
+			continue;
+		}
+		tcl.resultf("%s: %s:%d: not a node-movement command", name(),
+			    file, lineno);
+		fclose(fp);
+		return (TCL_ERROR);
+	}
+	fclose(fp);
+
+	std::stable_sort(way.begin(), way.end(), waypoint_before);
+	std::stable_sort(dist.begin(), dist.end(), dist_before);
+
+	int nnodes = nodes.size();
+	if (!way.empty() && way.back().node_ >= nnodes)
+		nnodes = way.back().node_ + 1;
+	alloc(nnodes, way.size(), dist0.size() + dist.size(), dist0.size());
+	for (int i = 0; i < (int)nodes.size(); i++)
+		nodes_[i] = nodes[i];
+	for (int k = 0; k < (int)way.size(); k++) {
+		way_[k] = way[k].w_;
+		nodes_[way[k].node_].nwaypoints_++;
+	}
+	for (int k = 0; k < (int)dist0.size(); k++)
+		dist_[k] = dist0[k];
+	for (int k = 0; k < (int)dist.size(); k++)
+		dist_[dist0.size() + k] = dist[k];
+	return (TCL_OK);
+}
+
+/*
+ * Read a binary scenario.
+ */
+int
+MobilityScenario::read(const char* file)
+{
+	Tcl& tcl = Tcl::instance();
+	FILE* fp = fopen(file, "rb");
+	if (fp == 0) {
+		tcl.resultf("%s: can't open %s", name(), file);
+		return (TCL_ERROR);
+	}
+	ScenHeader h;
+	if (fread(&h, sizeof(h), 1, fp) != 1 ||
+	    memcmp(h.magic_, SCEN_MAGIC, sizeof(h.magic_)) != 0) {
+		tcl.resultf("%s: %s is not a binary scenario", name(), file);
+		fclose(fp);
+		return (TCL_ERROR);
+	}
+	if (h.order_ != SCEN_ORDER || h.version_ != SCEN_VERSION ||
+	    h.nnodes_ < 0 || h.nwaypoints_ < 0 ||
+	    h.ndist0_ < 0 || h.ndist_ < h.ndist0_) {
+		tcl.resultf("%s: %s was written by another version or on "
+			    "another kind of host; convert the text "
+			    "scenario again", name(), file);
+		fclose(fp);
+		return (TCL_ERROR);
+	}
+	alloc(h.nnodes_, h.nwaypoints_, h.ndist_, h.ndist0_);
+	long n = len_ - sizeof(h);
+	int nway = 0;
+	if ((long)fread(hdr_ + 1, 1, n, fp) == n && getc(fp) == EOF)
+		for (int i = 0; i < h.nnodes_; i++)
+			nway += nodes_[i].nwaypoints_;
+	fclose(fp);
+	if (nway != h.nwaypoints_) {
+		tcl.resultf("%s: %s is truncated or corrupt", name(), file);
+		delete [] buf_;
+		buf_ = 0;
+		return (TCL_ERROR);
+	}
+	return (TCL_OK);
+}
+
+int
+MobilityScenario::write(const char* file)
+{
+	Tcl& tcl = Tcl::instance();
+	FILE* fp = fopen(file, "wb");
+	if (fp == 0) {
+		tcl.resultf("%s: can't create %s", name(), file);
+		return (TCL_ERROR);
+	}
+	if ((long)fwrite(buf_, 1, len_, fp) != len_ || fclose(fp) != 0) {
+		tcl.resultf("%s: error writing %s", name(), file);
+		return (TCL_ERROR);
+	}
+	return (TCL_OK);
+}
+
+/*
+ * Do what sourcing the scenario would: set the initial positions and
+ * distances now, and schedule the rest.
+ */
+int
+MobilityScenario::load(const char* file)
+{
+	Tcl& tcl = Tcl::instance();
+	if (buf_ != 0) {
+		tcl.resultf("%s: already holds a scenario", name());
+		return (TCL_ERROR);
+	}
+
+	char magic[sizeof(hdr_->magic_)];
+	FILE* fp = fopen(file, "rb");
+	if (fp == 0) {
+		tcl.resultf("%s: can't open %s", name(), file);
+		return (TCL_ERROR);
+	}
+	int binary = fread(magic, sizeof(magic), 1, fp) == 1 &&
+		memcmp(magic, SCEN_MAGIC, sizeof(magic)) == 0;
+	fclose(fp);
+	if ((binary ? read(file) : parse(file)) != TCL_OK)
+		return (TCL_ERROR);
+
+	int nnodes = hdr_->nnodes_;
+	double now = Scheduler::instance().clock();
+	int first = 0;
+	for (int i = 0; i < nnodes; i++) {
+		ScenNode* sn = &nodes_[i];
+		if ((sn->set_ || sn->nwaypoints_) &&
+		    (i >= nmn_ || mn_[i] == 0)) {
+			tcl.resultf("%s: %s moves node_(%d), which is not "
+				    "registered", name(), file, i);
+			return (TCL_ERROR);
+		}
+		if (sn->nwaypoints_ && way_[first].t_ < now) {
+			tcl.resultf("%s: %s moves node_(%d) in the past",
+				    name(), file, i);
+			return (TCL_ERROR);
+		}
+		first += sn->nwaypoints_;
+	}
+	God* god = 0;
+	if (hdr_->ndist_ > 0) {
+		god = God::instance();
+		for (int k = 0; k < hdr_->ndist_; k++) {
+			ScenDist* d = &dist_[k];
+			if (d->i_ >= god->nodes() || d->j_ >= god->nodes()) {
+				tcl.resultf("%s: %s: set-dist %d %d for a God "
+					    "of %d nodes", name(), file,
+					    d->i_, d->j_, god->nodes());
+				return (TCL_ERROR);
+			}
+		}
+		if (hdr_->ndist_ > hdr_->ndist0_ &&
+		    dist_[hdr_->ndist0_].t_ < now) {
+			tcl.resultf("%s: %s sets distances in the past",
+				    name(), file);
+			return (TCL_ERROR);
+		}
+	}
+
+	for (int i = 0; i < nnodes; i++) {
+		ScenNode* sn = &nodes_[i];
+		if (sn->set_ & SCEN_X)
+			mn_[i]->X_ = sn->x_;
+		if (sn->set_ & SCEN_Y)
+			mn_[i]->Y_ = sn->y_;
+		if (sn->set_ & SCEN_Z)
+			mn_[i]->Z_ = sn->z_;
+	}
+	for (int k = 0; k < hdr_->ndist0_; k++)
+		god->SetDist(dist_[k].i_, dist_[k].j_, dist_[k].d_);
+
+	ev_ = new ScenEvent[nnodes + 1];
+	first = 0;
+	for (int i = 0; i < nnodes; i++) {
+		ev_[i].node_ = i;
+		ev_[i].next_ = first;
+		first += nodes_[i].nwaypoints_;
+		ev_[i].end_ = first;
+		if (ev_[i].next_ < ev_[i].end_)
+			schedule(&ev_[i], way_[ev_[i].next_].t_);
+	}
+	ev_[nnodes].node_ = -1;
+	ev_[nnodes].next_ = hdr_->ndist0_;
+	ev_[nnodes].end_ = hdr_->ndist_;
+	if (ev_[nnodes].next_ < ev_[nnodes].end_)
+		schedule(&ev_[nnodes], dist_[ev_[nnodes].next_].t_);
+	return (TCL_OK);
+}
+
+/*
+ * Schedule e for time t.  The "at" of a sourced scenario fires at
+ * exactly t, but now + (t - now) can be an ulp off, so nudge the
+ * delay until it lands on t.
+ */
+void
+MobilityScenario::schedule(ScenEvent* e, double t)
+{
+	Scheduler& s = Scheduler::instance();
+	double now = s.clock();
+	double delay = t - now;
+	for (int k = 0; k < 4 && now + delay != t; k++)
+		delay += t - (now + delay);
+	s.schedule(this, e, delay);
+}
+
+void
+MobilityScenario::handle(Event* e)
+{
+	ScenEvent* se = (ScenEvent*)e;
+
+	if (se->node_ >= 0) {
+		ScenWaypoint* w = &way_[se->next_++];
+		if (mn_[se->node_]->set_destination(w->x_, w->y_,
+						     w->speed_) < 0) {
+			fprintf(stderr, "%s: node_(%d) setdest %f %f %f at "
+				"%f is off the topography\n", name(),
+				se->node_, w->x_, w->y_, w->speed_, w->t_);
+			exit(1);
+		}
+		if (se->next_ < se->end_)
+			schedule(se, way_[se->next_].t_);
+	} else {
+		ScenDist* d = &dist_[se->next_++];
+		God::instance()->SetDist(d->i_, d->j_, d->d_);
+		if (se->next_ < se->end_)
+			schedule(se, dist_[se->next_].t_);
+	}
+}
@@ -0,0 +1,136 @@
+/* -*-	Mode:C++; c-basic-offset:8; tab-width:8; indent-tabs-mode:t -*- */
+/*
+ * Copyright (c) 1997 Regents of the University of California.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor of the Laboratory may be used
+ *    to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+
+/*
+ * mobility-scen.h
+ *
+ * Native loader for node-movement scenarios (the output of setdest and
+ * friends).  Sourcing such a scenario turns every waypoint and every
+ * "$god_ set-dist" into its own Tcl "at" event, all of them created up
+ * front.  A MobilityScenario instead keeps the records in one compact
+ * array and feeds them to MobileNode::set_destination() and
+ * God::SetDist() from C++, with a single pending event per node (and
+ * one for God).
+ *
+ * It reads either the text scenario or a binary conversion of it.  The
+ * binary file is just the in-memory image below, in host byte order:
+ *
+ *	ScenHeader
+ *	ScenNode	x nnodes_	initial positions
+ *	ScenWaypoint	x nwaypoints_	node 0's by time, then node 1's, ...
+ *	ScenDist	x ndist_	the ndist0_ applied at load time
+ *					first, then the rest by time
+ *
+ * From Tcl:
+ *	$scen node <i> <mobilenode>	the node called $node_(<i>)
+ *	$scen load <file>		apply and schedule a scenario
+ *	$scen convert <text> <binary>
+ * or just "$ns load-mobility <file>", which registers all of $node_().
+ */
+
+#ifndef ns_mobility_scen_h
+#define ns_mobility_scen_h
+
+#include "config.h"
+#include "scheduler.h"
+
+class MobileNode;
+
+#define SCEN_MAGIC	"NSMOBIL"
+#define SCEN_ORDER	0x01020304
+#define SCEN_VERSION	1
+
+struct ScenHeader {
+	char	magic_[8];
+	int32_t	order_;		// SCEN_ORDER as written by the host
+	int32_t	version_;
+	int32_t	nnodes_;
+	int32_t	nwaypoints_;
+	int32_t	ndist_;
+	int32_t	ndist0_;
+};
+
+#define SCEN_X	1
+#define SCEN_Y	2
+#define SCEN_Z	4
+
+struct ScenNode {
+	double	x_, y_, z_;
+	int32_t	set_;		// which of x_, y_, z_ the scenario sets
+	int32_t	nwaypoints_;
+};
+
+struct ScenWaypoint {
+	double	t_;
+	double	x_, y_, speed_;	// "setdest x_ y_ speed_"
+};
+
+struct ScenDist {
+	double	t_;
+	int32_t	i_, j_, d_;	// "set-dist i_ j_ d_"
+	int32_t	pad_;
+};
+
+/* the pending record of one node (node_ >= 0) or of God (node_ < 0) */
+class ScenEvent : public Event {
+public:
+	int	node_;
+	int	next_;
+	int	end_;
+};
+
+class MobilityScenario : public TclObject, public Handler {
+public:
+	MobilityScenario();
+	~MobilityScenario();
+	void handle(Event*);
+protected:
+	int command(int argc, const char*const* argv);
+	void alloc(int nnodes, int nwaypoints, int ndist, int ndist0);
+	int parse(const char* file);
+	int read(const char* file);
+	int write(const char* file);
+	int load(const char* file);
+	void schedule(ScenEvent*, double t);
+
+	char*		buf_;		// the image, laid out as above
+	long		len_;
+	ScenHeader*	hdr_;
+	ScenNode*	nodes_;
+	ScenWaypoint*	way_;
+	ScenDist*	dist_;
+
+	MobileNode**	mn_;		// the registered nodes, by index
+	int		nmn_;
+	ScenEvent*	ev_;		// nnodes_ + 1 of them, God's last
+};
+
+#endif /* ns_mobility_scen_h */
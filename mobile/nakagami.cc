@@ -179,7 +179,16 @@ double Nakagami::Pr(PacketStamp *t, PacketStamp *r, WirelessPhy *ifp)
  		
  		double resultPower;
  		
-        if (int_m == m) {
+		if (streams_.enabled()) {
+			int i = r->getNode()->nodeid();
+			if (int_m == m) {
+				RNG *rng = streams_.rng(i);
+				resultPower = 0;
+				for (unsigned int k = 0; k < int_m; k++)
+					resultPower += rng->exponential(Pr/m);
+			} else
+				resultPower = streams_.gamma(i, m, Pr/m);
+		} else if (int_m == m) {
  			resultPower = ErlangRandomVariable(Pr/m, int_m).value();
  		} else {
  			resultPower = GammaRandomVariable(m, Pr/m).value();
@@ -188,8 +197,10 @@ double Nakagami::Pr(PacketStamp *t, PacketStamp *r, WirelessPhy *ifp)
 	}
 }	
 
-int Nakagami::command(int , const char* const* )
+int Nakagami::command(int argc, const char* const* argv)
 {
+	if (argc >= 2 && strcasecmp(argv[1], "rx-streams") == 0)
+		return Propagation::command(argc, argv);
 	return 0;
 }
 
@@ -0,0 +1,81 @@
+/* -*-	Mode:C++; c-basic-offset:8; tab-width:8; indent-tabs-mode:t -*- */
+/*
+ * Copyright (c) 1997 Regents of the University of California.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor of the Laboratory may be used
+ *    to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * propagation-simd.h
+ *
+ * A few packed-double operations for the batch Pr() kernels of the
+ * propagation models: four lanes with AVX, two with SSE2, and none
+ * (PR_SIMD undefined) otherwise, in which case the kernels only run
+ * their scalar loop.  The kernels do the same IEEE operations in the
+ * same order as the scalar Pr(), so both give identical results.
+ */
+
+#ifndef ns_propagation_simd_h
+#define ns_propagation_simd_h
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define PR_SIMD
+#define PR_LANES	4
+typedef __m256d pr_vec;
+#define pr_load(p)	_mm256_loadu_pd(p)
+#define pr_store(p, v)	_mm256_storeu_pd((p), (v))
+#define pr_set1(x)	_mm256_set1_pd(x)
+#define pr_add(a, b)	_mm256_add_pd((a), (b))
+#define pr_sub(a, b)	_mm256_sub_pd((a), (b))
+#define pr_mul(a, b)	_mm256_mul_pd((a), (b))
+#define pr_div(a, b)	_mm256_div_pd((a), (b))
+#define pr_sqrt(a)	_mm256_sqrt_pd(a)
+#define pr_le(a, b)	_mm256_cmp_pd((a), (b), _CMP_LE_OQ)
+#define pr_eq(a, b)	_mm256_cmp_pd((a), (b), _CMP_EQ_OQ)
+/* lanes of b where m is set, of a elsewhere */
+#define pr_select(m, b, a)	_mm256_blendv_pd((a), (b), (m))
+
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define PR_SIMD
+#define PR_LANES	2
+typedef __m128d pr_vec;
+#define pr_load(p)	_mm_loadu_pd(p)
+#define pr_store(p, v)	_mm_storeu_pd((p), (v))
+#define pr_set1(x)	_mm_set1_pd(x)
+#define pr_add(a, b)	_mm_add_pd((a), (b))
+#define pr_sub(a, b)	_mm_sub_pd((a), (b))
+#define pr_mul(a, b)	_mm_mul_pd((a), (b))
+#define pr_div(a, b)	_mm_div_pd((a), (b))
+#define pr_sqrt(a)	_mm_sqrt_pd(a)
+#define pr_le(a, b)	_mm_cmple_pd((a), (b))
+#define pr_eq(a, b)	_mm_cmpeq_pd((a), (b))
+#define pr_select(m, b, a)	\
+	_mm_or_pd(_mm_and_pd((m), (b)), _mm_andnot_pd((m), (a)))
+#endif
+
+#endif /* ns_propagation_simd_h */
@@ -32,9 +32,11 @@
 */
 
 #include <stdio.h>
+#include <math.h>
 
 #include <topography.h>
 #include <propagation.h>
+#include <propagation-simd.h>
 #include <wireless-phy.h>
 
 class PacketStamp;
@@ -43,6 +45,11 @@ Propagation::command(int argc, const char*const* argv)
 {
   TclObject *obj;  
 
+  if (argc == 2 && strcasecmp(argv[1], "rx-streams") == 0)
+    {
+      streams_.init(rng());
+      return TCL_OK;
+    }
   if(argc == 3) 
     {
       if( (obj = TclObject::lookup(argv[2])) == 0) 
@@ -57,11 +64,186 @@ Propagation::command(int argc, const char*const* argv)
 	  topo = (Topography*) obj;
 	  return TCL_OK;
 	}
+      if (strcasecmp(argv[1], "rx-streams") == 0)
+	{
+	  streams_.init((RNG*) obj);
+	  return TCL_OK;
+	}
     }
   return TclObject::command(argc,argv);
 }
  
 
+RxStreams::~RxStreams()
+{
+	clear();
+}
+
+void
+RxStreams::clear()
+{
+	for (int i = 0; i < (int)streams_.size(); i++)
+		delete streams_[i].rng_;
+	streams_.clear();
+}
+
+void
+RxStreams::init(RNG *parent)
+{
+	clear();
+	parent_ = parent;
+	// split off the first stream now, so that later use of the parent
+	// does not move it
+	rng(0);
+}
+
+RNG *
+RxStreams::rng(int i)
+{
+	while ((int)streams_.size() <= i) {
+		Stream s;
+		if (streams_.empty())
+			s.rng_ = RNG::substream(*parent_, RXSTREAM_BITS);
+		else
+			s.rng_ = RNG::substream(*streams_.back().rng_,
+					       RXSTREAM_BITS);
+		s.parity_ = 0;
+		s.next_ = 0;
+		streams_.push_back(s);
+	}
+	return streams_[i].rng_;
+}
+
+// Same polar method as RNG::normal()
+double
+RxStreams::normal(int i, double avg, double std)
+{
+	RNG *r = rng(i);
+	Stream &s = streams_[i];
+	double sam1, sam2, rad;
+
+	if (std == 0)
+		return avg;
+	if (s.parity_) {
+		s.parity_ = 0;
+		return (s.next_ * std + avg);
+	}
+	do {
+		sam1 = 2 * r->uniform() - 1;
+		sam2 = 2 * r->uniform() - 1;
+	} while ((rad = sam1 * sam1 + sam2 * sam2) >= 1);
+	rad = sqrt((-2 * log(rad)) / rad);
+	s.next_ = sam2 * rad;
+	s.parity_ = 1;
+	return (sam1 * rad * std + avg);
+}
+
+// Same method (Marsaglia and Tsang) as GammaRandomVariable::value()
+double
+RxStreams::gamma(int i, double alpha, double beta)
+{
+	RNG *r = rng(i);
+	double x, v, u;
+
+	if (alpha < 1) {
+		u = r->uniform(1.0);
+		return gamma(i, 1.0 + alpha, beta) * pow(u, 1.0 / alpha);
+	}
+	double d = alpha - 1.0 / 3.0;
+	double c = (1.0 / 3.0) / sqrt(d);
+	while (1) {
+		do {
+			x = normal(i, 0.0, 1.0);
+			v = 1.0 + c * x;
+		} while (v <= 0);
+		v = v * v * v;
+		u = r->uniform(1.0);
+		if (u < 1 - 0.0331 * x * x * x * x)
+			break;
+		if (log(u) < 0.5 * x * x + d * (1 - v + log(v)))
+			break;
+	}
+	return beta * d * v;
+}
+
+
+void
+PrBatch::clear()
+{
+	prop_ = 0;
+	ifp_.clear();
+	ant_.clear();
+	id_.clear();
+	x_.clear(); y_.clear(); z_.clear();
+	ax_.clear(); ay_.clear(); az_.clear();
+}
+
+int
+PrBatch::add(WirelessPhy *ifp)
+{
+	MobileNode *mn = (MobileNode*) ifp->node();
+	Antenna *ant = ifp->getAntenna();
+	double x, y, z;
+
+	if (size() == 0) {
+		prop_ = ifp->getPropagation();
+		L_ = ifp->getL();
+		lambda_ = ifp->getLambda();
+	} else if (ifp->getPropagation() != prop_ || ifp->getL() != L_ ||
+		   ifp->getLambda() != lambda_)
+		return 0;
+
+	mn->getLoc(&x, &y, &z);
+	ifp_.push_back(ifp);
+	ant_.push_back(ant);
+	id_.push_back(mn->nodeid());
+	x_.push_back(x);
+	y_.push_back(y);
+	z_.push_back(z);
+	ax_.push_back(ant->getX());
+	ay_.push_back(ant->getY());
+	az_.push_back(ant->getZ());
+	return 1;
+}
+
+/*
+ * Position of every receiver relative to the transmitter at (Xt, Yt,
+ * Zt), counting the antenna height of the receiver only if antz is set
+ * (TwoRayGround does not).  Also sizes the arrays the models fill in.
+ */
+void
+PrBatch::offsets(double Xt, double Yt, double Zt, int antz)
+{
+	int i = 0, n = size();
+
+	dx_.resize(n); dy_.resize(n); dz_.resize(n);
+	d_.resize(n);
+	gt_.resize(n); gr_.resize(n);
+	pr_.resize(n);
+	if (n == 0)
+		return;
+#ifdef PR_SIMD
+	pr_vec xt = pr_set1(Xt), yt = pr_set1(Yt), zt = pr_set1(Zt);
+	for (; i + PR_LANES <= n; i += PR_LANES) {
+		pr_store(&dx_[i], pr_sub(pr_add(pr_load(&x_[i]),
+						pr_load(&ax_[i])), xt));
+		pr_store(&dy_[i], pr_sub(pr_add(pr_load(&y_[i]),
+						pr_load(&ay_[i])), yt));
+		if (antz)
+			pr_store(&dz_[i], pr_sub(pr_add(pr_load(&z_[i]),
+							pr_load(&az_[i])), zt));
+		else
+			pr_store(&dz_[i], pr_sub(pr_load(&z_[i]), zt));
+	}
+#endif
+	for (; i < n; i++) {
+		dx_[i] = (x_[i] + ax_[i]) - Xt;
+		dy_[i] = (y_[i] + ay_[i]) - Yt;
+		dz_[i] = (antz ? z_[i] + az_[i] : z_[i]) - Zt;
+	}
+}
+
+
 /* As new network-intefaces are added, add a default method here */
 
 double
@@ -84,6 +266,75 @@ Propagation::Pr(PacketStamp *, PacketStamp *, WirelessPhy *)
 	return 0; // Make msvc happy
 }
 
+/*
+ * Models without a batch version work out one receiver after the other.
+ */
+void
+Propagation::Pr(PacketStamp *t, PrBatch &b)
+{
+	PacketStamp s;
+
+	b.pr_.resize(b.size());
+	for (int i = 0; i < b.size(); i++) {
+		s.stamp((MobileNode*) b.ifp_[i]->node(), b.ant_[i], 0,
+			b.lambda_);
+		b.pr_[i] = Pr(t, &s, b.ifp_[i]);
+	}
+}
+
+void
+Propagation::gains(PacketStamp *t, PrBatch &b)
+{
+	Antenna *ant = t->getAntenna();
+
+	for (int i = 0; i < b.size(); i++) {
+		b.gt_[i] = ant->getTxGain(b.dx_[i], b.dy_[i], b.dz_[i],
+					  b.lambda_);
+		b.gr_[i] = b.ant_[i]->getRxGain(b.dx_[i], b.dy_[i], b.dz_[i],
+						b.lambda_);
+	}
+}
+
+void
+Propagation::distances(int n, const double *dx, const double *dy,
+		       const double *dz, double *d)
+{
+	int i = 0;
+
+#ifdef PR_SIMD
+	for (; i + PR_LANES <= n; i += PR_LANES) {
+		pr_vec x = pr_load(dx + i), y = pr_load(dy + i);
+		pr_vec z = pr_load(dz + i);
+		pr_store(d + i, pr_sqrt(pr_add(pr_add(pr_mul(x, x),
+						      pr_mul(y, y)),
+					       pr_mul(z, z))));
+	}
+#endif
+	for (; i < n; i++)
+		d[i] = sqrt(dx[i] * dx[i] + dy[i] * dy[i] + dz[i] * dz[i]);
+}
+
+void
+Propagation::Friis(int n, double Pt, const double *Gt, const double *Gr,
+		   double lambda, double L, const double *d, double *Pr)
+{
+	int i = 0;
+
+#ifdef PR_SIMD
+	pr_vec pt = pr_set1(Pt), lam = pr_set1(lambda), l = pr_set1(L);
+	pr_vec fourpi = pr_set1(4 * PI), zero = pr_set1(0.0);
+	for (; i + PR_LANES <= n; i += PR_LANES) {
+		pr_vec dv = pr_load(d + i);
+		pr_vec M = pr_div(lam, pr_mul(fourpi, dv));
+		pr_vec p = pr_mul(pr_mul(pt, pr_load(Gt + i)), pr_load(Gr + i));
+		p = pr_div(pr_mul(p, pr_mul(M, M)), l);
+		pr_store(Pr + i, pr_select(pr_eq(dv, zero), pt, p));
+	}
+#endif
+	for (; i < n; i++)
+		Pr[i] = Friis(Pt, Gt[i], Gr[i], lambda, L, d[i]);
+}
+
 double
 Propagation::getDist(double , double , double , double , double , double , double , double )
 {
@@ -157,6 +408,28 @@ double FreeSpace::Pr(PacketStamp *t, PacketStamp *r, WirelessPhy *ifp)
 	return Pr;
 }
 
+void FreeSpace::Pr(PacketStamp *t, PrBatch &b)
+{
+	double Xt, Yt, Zt;		// location of transmitter
+	int n = b.size();
+
+	t->getNode()->getLoc(&Xt, &Yt, &Zt);
+	Xt += t->getAntenna()->getX();
+	Yt += t->getAntenna()->getY();
+	Zt += t->getAntenna()->getZ();
+
+	b.offsets(Xt, Yt, Zt, 1);
+	if (n == 0)
+		return;
+	gains(t, b);
+	distances(n, &b.dx_[0], &b.dy_[0], &b.dz_[0], &b.d_[0]);
+	Friis(n, t->getTxPr(), &b.gt_[0], &b.gr_[0], b.lambda_, b.L_,
+	      &b.d_[0], &b.pr_[0]);
+	for (int i = 0; i < n; i++)
+		printf("%lf: d: %lf, Pr: %e\n", Scheduler::instance().clock(),
+		       b.d_[i], b.pr_[i]);
+}
+
 double
 FreeSpace::getDist(double Pr, double Pt, double Gt, double Gr, double , double , double L, double lambda)
 {
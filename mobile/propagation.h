@@ -44,13 +44,79 @@
 #define PI		3.1415926535897
 
 
+#include <vector>
 #include <topography.h>
 #include <phy.h>
 #include <wireless-phy.h>
 #include <packet-stamp.h>
+#include <rng.h>
 
 class PacketStamp;
 class WirelessPhy;
+class Propagation;
+
+/*
+ * Per-receiver random streams.  Receiver i draws from its own piece of
+ * the current substream of a parent generator (2^RXSTREAM_BITS values
+ * each), so the values a receiver sees do not depend on the order in
+ * which the receptions of a transmission are worked out.  normal() and
+ * gamma() keep their own state per receiver: RNG::normal() caches its
+ * second value in a static shared by all generators.
+ */
+#define RXSTREAM_BITS	50
+
+class RxStreams {
+public:
+	RxStreams() : parent_(0) {}
+	~RxStreams();
+	void init(RNG *parent);
+	inline int enabled() const { return (parent_ != 0); }
+
+	RNG *rng(int i);
+	double normal(int i, double avg, double std);
+	double gamma(int i, double alpha, double beta);
+private:
+	struct Stream {
+		RNG *rng_;
+		int parity_;
+		double next_;
+	};
+	void clear();
+
+	RNG *parent_;
+	std::vector<Stream> streams_;
+};
+/*
+ * The receivers of one transmission, for the batch Pr() below.  All of
+ * them use the same propagation model, system loss and wavelength.
+ * Positions are kept as structure of arrays so that the models can
+ * work on several receivers at once.
+ */
+class PrBatch {
+public:
+	PrBatch() : prop_(0), L_(0), lambda_(0) {}
+	void clear();
+	int add(WirelessPhy *ifp);	// 0 if ifp does not fit in
+	inline int size() const { return (int)ifp_.size(); }
+	void offsets(double Xt, double Yt, double Zt, int antz);
+
+	Propagation *prop_;
+	double L_;			// system loss
+	double lambda_;			// wavelength
+
+	std::vector<WirelessPhy*> ifp_;
+	std::vector<Antenna*> ant_;
+	std::vector<int> id_;		// receiving node
+	std::vector<double> x_, y_, z_;	// receiving node
+	std::vector<double> ax_, ay_, az_; // its antenna, relative to the node
+
+	// filled in by the models
+	std::vector<double> dx_, dy_, dz_;	// receiver - transmitter
+	std::vector<double> d_;		// distance
+	std::vector<double> gt_, gr_;	// antenna gains
+	std::vector<double> pr_;	// received power
+};
+
 /*======================================================================
    Progpagation Models
 
@@ -74,6 +140,8 @@ public:
   // type
   virtual double Pr(PacketStamp *tx, PacketStamp *rx, Phy *);
   virtual double Pr(PacketStamp *tx, PacketStamp *rx, WirelessPhy *);
+  // the same for all receivers in b, into b.pr_
+  virtual void Pr(PacketStamp *tx, PrBatch &b);
   virtual int command(int argc, const char*const* argv);
 
   // get interference distance
@@ -82,7 +150,7 @@ public:
 
 
   // Friis free space equation, likely to be used by other propagation models.
-  double Friis(double Pt, double Gt, double Gr, double lambda, double L, double d);
+  static double Friis(double Pt, double Gt, double Gr, double lambda, double L, double d);
   	// Pt -- transmitted signal power
   	// Gt -- transmitter antenna gain
   	// Gr -- receiver antenna gain
@@ -91,9 +159,21 @@ public:
   	// d -- distance between transmitter and receiver
   	// return -- received signal power
 
+  // Friis() and the distance for n receivers at once
+  static void Friis(int n, double Pt, const double *Gt, const double *Gr,
+		    double lambda, double L, const double *d, double *Pr);
+  static void distances(int n, const double *dx, const double *dy,
+			const double *dz, double *d);
+  // antenna gains along b.dx_, b.dy_, b.dz_ as in FreeSpace::Pr()
+  static void gains(PacketStamp *tx, PrBatch &b);
+
 protected:
+  // generator the per-receiver streams are split from ("rx-streams")
+  virtual RNG *rng() { return RNG::defaultrng(); }
+
   char *name;
   Topography *topo;
+  RxStreams streams_;
 };
 
 
@@ -102,6 +182,7 @@ class FreeSpace : public Propagation {
 public:
 //	FreeSpace();
 	virtual double Pr(PacketStamp *tx, PacketStamp *rx, WirelessPhy *ifp);
+	virtual void Pr(PacketStamp *tx, PrBatch &b);
 	virtual double getDist(double Pr, double Pt, double Gt, double Gr,
 			       double ht, double hr, double L, double lambda);
 };
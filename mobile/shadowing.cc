@@ -133,7 +133,12 @@ double Shadowing::Pr(PacketStamp *t, PacketStamp *r, WirelessPhy *ifp)
    
 	// get power loss by adding a log-normal random variable (shadowing)
 	// the power loss is relative to that at reference distance dist0_
-	double powerLoss_db = avg_db + ranVar->normal(0.0, std_db_);
+	double powerLoss_db = avg_db;
+	if (streams_.enabled())
+		powerLoss_db += streams_.normal(r->getNode()->nodeid(),
+						0.0, std_db_);
+	else
+		powerLoss_db += ranVar->normal(0.0, std_db_);
 
 	// calculate the receiving power at dist
 	double Pr = Pr0 * pow(10.0, powerLoss_db/10.0);
@@ -142,6 +147,46 @@ double Shadowing::Pr(PacketStamp *t, PacketStamp *r, WirelessPhy *ifp)
 }
 
 
+/*
+ * Batch version of Pr(): the power at the reference distance for
+ * several receivers at once, then the path loss and the shadowing one
+ * receiver after the other (log10() and pow() have no packed form).
+ */
+void Shadowing::Pr(PacketStamp *t, PrBatch &b)
+{
+	double Xt, Yt, Zt;		// loc of transmitter
+	int i, n = b.size();
+
+	t->getNode()->getLoc(&Xt, &Yt, &Zt);
+	Xt += t->getAntenna()->getX();
+	Yt += t->getAntenna()->getY();
+	Zt += t->getAntenna()->getZ();
+
+	b.offsets(Xt, Yt, Zt, 1);
+	if (n == 0)
+		return;
+	gains(t, b);
+	distances(n, &b.dx_[0], &b.dy_[0], &b.dz_[0], &b.d_[0]);
+	pr0_.assign(n, dist0_);
+	Friis(n, t->getTxPr(), &b.gt_[0], &b.gr_[0], b.lambda_, b.L_,
+	      &pr0_[0], &pr0_[0]);
+
+	for (i = 0; i < n; i++) {
+		double avg_db;
+		if (b.d_[i] > dist0_)
+			avg_db = -10.0 * pathlossExp_ * log10(b.d_[i]/dist0_);
+		else
+			avg_db = 0.0;
+		double powerLoss_db = avg_db;
+		if (streams_.enabled())
+			powerLoss_db += streams_.normal(b.id_[i], 0.0, std_db_);
+		else
+			powerLoss_db += ranVar->normal(0.0, std_db_);
+		b.pr_[i] = pr0_[i] * pow(10.0, powerLoss_db/10.0);
+	}
+}
+
+
 int Shadowing::command(int argc, const char* const* argv)
 {
 	if (argc == 4) {
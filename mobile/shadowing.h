@@ -66,17 +66,22 @@ public:
 	Shadowing();
 	~Shadowing();
 	virtual double Pr(PacketStamp *tx, PacketStamp *rx, WirelessPhy *ifp);
+	virtual void Pr(PacketStamp *tx, PrBatch &b);
 	virtual double getDist(double Pr, double Pt, double Gt, double Gr,
 			       double hr, double ht, double L, double lambda);
 	virtual int command(int argc, const char*const* argv);
 
 protected:
+	virtual RNG *rng() { return ranVar; }
+
 	RNG *ranVar;	// random number generator for normal distribution
 	
 	double pathlossExp_;	// path-loss exponent
 	double std_db_;		// shadowing deviation (dB),
 	double dist0_;	// close-in reference distance
 	int seed_;	// seed for random number generator
+
+	std::vector<double> pr0_;	// per receiver, for the batch Pr()
 };
 
 #endif
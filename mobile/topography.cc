@@ -124,7 +124,15 @@ Topography::load_demfile(const char *fname)
 void 
 Topography::updateNodesList(class MobileNode* mn, double oldX)
 {
-	channel_->updateNodesList(mn, oldX);
+	if (channel_ != 0)
+		channel_->updateNodesList(mn, oldX);
+}
+
+void
+Topography::catchUp(class MobileNode* mn)
+{
+	if (channel_ != 0)
+		channel_->catchUp(mn);
 }
 
 
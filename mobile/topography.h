@@ -42,10 +42,12 @@
 class Topography : public TclObject {
 
 public:
-	Topography() { maxX = maxY = grid_resolution = 0.0; grid = 0; }
+	Topography() { maxX = maxY = grid_resolution = 0.0; grid = 0;
+		       channel_ = 0; }
 
 	/* List-keeper */
 	void updateNodesList(class MobileNode *mn, double oldX);
+	void catchUp(class MobileNode *mn);
 	
 	double	lowerX() { return 0.0; }
 	double	upperX() { return maxX * grid_resolution; }
@@ -42,6 +42,7 @@
 #include <propagation.h>
 #include <wireless-phy.h>
 #include <tworayground.h>
+#include <propagation-simd.h>
 
 static class TwoRayGroundClass: public TclClass {
 public:
@@ -171,3 +172,72 @@ double TwoRayGround::getDist(double Pr, double Pt, double Gt, double Gr, double
        /* Get quartic root */
        return sqrt(sqrt(Pt * Gt * Gr * (hr * hr * ht * ht) / Pr));
 }
+
+/*
+ * Batch version of Pr(): the positions and the cross-over distances
+ * are worked out one receiver after the other, as above, the powers
+ * for several receivers at once.
+ */
+void
+TwoRayGround::Pr(PacketStamp *t, PrBatch &b)
+{
+  double tX, tY, tZ;		// location of transmitter
+  double ht;			// height of xmit antenna
+  double Pt = t->getTxPr();
+  double L = b.L_, lambda = b.lambda_;
+  int i, n = b.size();
+
+  t->getNode()->getLoc(&tX, &tY, &tZ);
+  tX += t->getAntenna()->getX();
+  tY += t->getAntenna()->getY();
+  ht = tZ + t->getAntenna()->getZ();
+
+  b.offsets(tX, tY, tZ, 0);
+  if (n == 0)
+    return;
+  hr_.resize(n);
+  xover_.resize(n);
+  for (i = 0; i < n; i++) {
+    if (b.dz_[i] != 0) {
+      printf("%s: TwoRayGround propagation model assume flat ground\n",
+	     __FILE__);
+    }
+    hr_[i] = b.z_[i] + b.az_[i];
+    if (hr_[i] != last_hr || ht != last_ht) {
+      crossover_dist = (4 * PI * ht * hr_[i]) / lambda;
+      last_hr = hr_[i]; last_ht = ht;
+    }
+    xover_[i] = crossover_dist;
+    b.gt_[i] = t->getAntenna()->getTxGain(b.dx_[i], b.dy_[i], b.dz_[i],
+					  t->getLambda());
+    b.gr_[i] = b.ant_[i]->getRxGain(-b.dx_[i], -b.dy_[i], -b.dz_[i],
+				    lambda);
+  }
+  distances(n, &b.dx_[0], &b.dy_[0], &b.dz_[0], &b.d_[0]);
+
+  i = 0;
+#ifdef PR_SIMD
+  pr_vec pt = pr_set1(Pt), lam = pr_set1(lambda), l = pr_set1(L);
+  pr_vec htv = pr_set1(ht), fourpi = pr_set1(4 * PI), zero = pr_set1(0.0);
+  for (; i + PR_LANES <= n; i += PR_LANES) {
+    pr_vec d = pr_load(&b.d_[i]), hr = pr_load(&hr_[i]);
+    pr_vec g = pr_mul(pr_mul(pt, pr_load(&b.gt_[i])), pr_load(&b.gr_[i]));
+    // Friis
+    pr_vec M = pr_div(lam, pr_mul(fourpi, d));
+    pr_vec friis = pr_select(pr_eq(d, zero), pt,
+			     pr_div(pr_mul(g, pr_mul(M, M)), l));
+    // TwoRay
+    pr_vec h = pr_mul(pr_mul(pr_mul(hr, hr), htv), htv);
+    pr_vec d4 = pr_mul(pr_mul(pr_mul(d, d), d), d);
+    pr_vec tworay = pr_div(pr_mul(g, h), pr_mul(d4, l));
+    pr_store(&b.pr_[i], pr_select(pr_le(d, pr_load(&xover_[i])),
+				  friis, tworay));
+  }
+#endif
+  for (; i < n; i++) {
+    if (b.d_[i] <= xover_[i])
+      b.pr_[i] = Friis(Pt, b.gt_[i], b.gr_[i], lambda, L, b.d_[i]);
+    else
+      b.pr_[i] = TwoRay(Pt, b.gt_[i], b.gr_[i], ht, hr_[i], L, b.d_[i]);
+  }
+}
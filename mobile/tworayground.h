@@ -44,6 +44,7 @@ class TwoRayGround : public Propagation {
 public:
   TwoRayGround();
   virtual double Pr(PacketStamp *tx, PacketStamp *rx, WirelessPhy *ifp);
+  virtual void Pr(PacketStamp *tx, PrBatch &b);
   virtual double getDist(double Pr, double Pt, double Gt, double Gr,
 			 double hr, double ht, double L, double lambda);
 
@@ -51,6 +52,7 @@ protected:
   double TwoRay(double Pt, double Gt, double Gr, double ht, double hr, double L, double d);
   double last_hr, last_ht;
   double crossover_dist;
+  std::vector<double> hr_, xover_;	// per receiver, for the batch Pr()
 };
 
 
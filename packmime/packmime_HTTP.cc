@@ -100,6 +100,8 @@ PackMimeHTTP::~PackMimeHTTP()
 		fprintf (stderr, "in pool: %d  active: %d\n", 
 			 (int) serverAppPool_.size(), 
 			 (int) serverAppActive_.size());
+		tcpPool_.stats(tcl);
+		fprintf (stderr, "TCP agents: %s\n", tcl.result());
 	}
 	
 	// delete timer
@@ -143,11 +145,8 @@ PackMimeHTTP::~PackMimeHTTP()
 
 	// delete agents in the pool
 	FullTcpAgent* tcp;
-	while (!tcpPool_.empty()) {
-		tcp = tcpPool_.front();
+	while ((tcp = tcpPool_.drain()) != NULL)
 		tcl.evalf ("delete %s", tcp->name());
-		tcpPool_.pop();
-	}
 	
 	// delete RNGs and Random Variables
 	cleanup();
@@ -161,33 +160,39 @@ PackMimeHTTP::~PackMimeHTTP()
  		fclose(samplesfp_);
 }
 
-FullTcpAgent* PackMimeHTTP::picktcp()
+FullTcpAgent* PackMimeHTTP::picktcp(int& reused)
+/*
+ * The oldest agent of the pool, which keeps its OTcl setup (reused = 1),
+ * or a new one (reused = 0)
+ */
 {
 	FullTcpAgent* a;
 	Tcl& tcl = Tcl::instance();
 
-	if (tcpPool_.empty()) {
-		tcl.evalf ("%s alloc-tcp %s", name(), tcptype_);
-		a = (FullTcpAgent*) lookup_obj (tcl.result());
-		if (a == NULL) {
-			fprintf (stderr, "Failed to allocate a TCP agent\n");
-			abort();
-		}
-		if (debug_ > 1) {
-			fprintf (stderr, 
-				 "\tflow %d created new TCPAgent %s\n",
-				 total_connections_, a->name());
-		}
-	} else {
-		a = tcpPool_.front(); 	// grab top of the queue
-		tcpPool_.pop();         // remove top from queue
-
+	a = tcpPool_.get(now());
+	if (a != NULL) {
+		reused = 1;
 		if (debug_ > 1) {
 			fprintf (stderr, "\tflow %d got TCPAgent %s", 
 				 total_connections_, a->name());
 			fprintf (stderr, " from pool (%d in pool)\n",
-				 (int) tcpPool_.size());
+				 tcpPool_.idle());
 		}
+		return a;
+	}
+
+	tcl.evalf ("%s alloc-tcp %s", name(), tcptype_);
+	a = (FullTcpAgent*) lookup_obj (tcl.result());
+	if (a == NULL) {
+		fprintf (stderr, "Failed to allocate a TCP agent\n");
+		abort();
+	}
+	tcpPool_.created();
+	reused = 0;
+	if (debug_ > 1) {
+		fprintf (stderr, 
+			 "\tflow %d created new TCPAgent %s\n",
+			 total_connections_, a->name());
 	}
 
 	return a;
@@ -284,12 +289,12 @@ void PackMimeHTTP::recycle(FullTcpAgent* agent)
 	agent->reset();
 
 	// add to the inactive agent pool
-	tcpPool_.push (agent);
+	tcpPool_.put (agent, now());
 
 	if (debug_ > 2) {
 		fprintf (stderr, "\tTCPAgent %s moved to pool ", 
 			 agent->name());
-		fprintf (stderr, "(%d in pool)\n", (int) tcpPool_.size());
+		fprintf (stderr, "(%d in pool)\n", tcpPool_.idle());
 	}
 }
 
@@ -462,8 +467,9 @@ void PackMimeHTTP::setup_connection()
 	}
 
 	// pick tcp agent for client and server
-	FullTcpAgent* ctcp = picktcp();
-	FullTcpAgent* stcp = picktcp();
+	int creused, sreused;
+	FullTcpAgent* ctcp = picktcp(creused);
+	FullTcpAgent* stcp = picktcp(sreused);
 
 	// rotate through nodes assigning connections
 	current_node_++;
@@ -476,16 +482,31 @@ void PackMimeHTTP::setup_connection()
 	tcl.evalf ("%s attach %s", client_[current_node_]->name(), 
 		   ctcp->name());
 
-	// set TCP options
-	tcl.evalf ("%s setup-tcp %s %d", name(), stcp->name(), 
-		   total_connections_);
-	tcl.evalf ("%s setup-tcp %s %d", name(), ctcp->name(),
-		   total_connections_);
+	// set TCP options; a reused agent already has its done proc
+	if (sreused)
+		stcp->flowid() = total_connections_;
+	else
+		tcl.evalf ("%s setup-tcp %s %d", name(), stcp->name(), 
+			   total_connections_);
+	if (creused)
+		ctcp->flowid() = total_connections_;
+	else
+		tcl.evalf ("%s setup-tcp %s %d", name(), ctcp->name(),
+			   total_connections_);
 
 	// setup connection between client and server
-	tcl.evalf ("set ns [Simulator instance]");
-	tcl.evalf ("$ns connect %s %s", ctcp->name(), stcp->name());
-	tcl.evalf ("%s listen", stcp->name());
+	if (creused && sreused && pool_fast_connect()) {
+		// what "$ns connect" does for a pair of Full-TCP agents
+		ctcp->daddr() = stcp->addr();
+		ctcp->dport() = stcp->port();
+		stcp->daddr() = ctcp->addr();
+		stcp->dport() = ctcp->port();
+		((Agent*) stcp)->listen();
+	} else {
+		tcl.evalf ("set ns [Simulator instance]");
+		tcl.evalf ("$ns connect %s %s", ctcp->name(), stcp->name());
+		tcl.evalf ("%s listen", stcp->name());
+	}
 
 	// create PackMimeHTTPApps
 	PackMimeHTTPClientApp* client_app = pickClientApp();
@@ -788,6 +809,10 @@ int PackMimeHTTP::command(int argc, const char*const* argv) {
 			tcl.resultf("%d", cur_pairs_);
 			return (TCL_OK);
 		}
+		else if (strcmp (argv[1], "pool-stats") == 0) {
+			tcpPool_.stats(Tcl::instance());
+			return (TCL_OK);
+		}
 		else if (!strcmp (argv[1], "no-pm-persistent-reqsz")) {
 			use_pm_persist_reqsz_ = false;
 			return (TCL_OK);
@@ -47,6 +47,7 @@
 #include "timer-handler.h"
 #include "app.h"
 #include "node.h"
+#include "agent-pool.h"
 #include "packmime_ranvar.h"
 #include <string>
 #include <stack>
@@ -226,7 +227,7 @@ class PackMimeHTTP : public TclObject {
 	void cleanup();
 	void recycle (FullTcpAgent*);
 
-	FullTcpAgent* picktcp();
+	FullTcpAgent* picktcp(int& reused);
 	PackMimeHTTPServerApp* pickServerApp();
 	PackMimeHTTPClientApp* pickClientApp();	
 
@@ -305,7 +306,7 @@ class PackMimeHTTP : public TclObject {
 	}
 
 	// Agent and App Pools	
-	std::queue<FullTcpAgent*> tcpPool_;
+	AgentPool<FullTcpAgent> tcpPool_;	// see agent-pool.h
 	std::queue<PackMimeHTTPClientApp*> clientAppPool_;
 	std::queue<PackMimeHTTPServerApp*> serverAppPool_;
 
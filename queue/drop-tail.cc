@@ -68,6 +68,7 @@ DropTail::command(int argc, const char*const* argv)
 				return (TCL_ERROR);
 			else {
 				pq_ = q_;
+				ring_ = dynamic_cast<PacketRing*>(q_) != 0;
 				return (TCL_OK);
 			}
 		}
@@ -85,8 +86,9 @@ void DropTail::enque(Packet* p)
 	}
 
 	int qlimBytes = qlim_ * mean_pktsize_;
-	if ((!qib_ && (q_->length() + 1) >= qlim_) ||
-  	(qib_ && (q_->byteLength() + hdr_cmn::access(p)->size()) >= qlimBytes)){
+	// fluid_pkts_ and fluid_bytes_ are 0 unless a FluidModel shares q_
+	if ((!qib_ && (q_->length() + fluid_pkts_ + 1) >= qlim_) ||
+  	(qib_ && (q_->byteLength() + fluid_bytes_ + hdr_cmn::access(p)->size()) >= qlimBytes)){
 		// if the queue would overflow if we added this packet...
 		if (drop_front_) { /* remove from head of queue */
 			q_->enque(p);
@@ -43,13 +43,17 @@
 class DropTail : public Queue {
   public:
 	DropTail() { 
-		q_ = new PacketQueue; 
-		pq_ = q_;
 		bind_bool("drop_front_", &drop_front_);
 		bind_bool("summarystats_", &summarystats);
 		bind_bool("queue_in_bytes_", &qib_);  // boolean: q in bytes?
 		bind("mean_pktsize_", &mean_pktsize_);
+		bind_bool("ring_", &ring_);	// PacketRing rather than list?
 		//		_RENAMED("drop-front_", "drop_front_");
+		if (ring_)
+			q_ = new PacketRing(qlim_ + 1);
+		else
+			q_ = new PacketQueue;
+		pq_ = q_;
 	}
 	~DropTail() {
 		delete q_;
@@ -67,6 +71,7 @@ class DropTail : public Queue {
 	void print_summarystats();
 	int qib_;       	/* bool: queue measured in bytes? */
 	int mean_pktsize_;	/* configured mean packet size in bytes */
+	int ring_;		/* q_ is a PacketRing */
 };
 
 #endif
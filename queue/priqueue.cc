@@ -153,6 +153,16 @@ PriQueue::filter(nsaddr_t id)
 	Packet *pp = 0;
 	struct hdr_cmn *ch;
 
+	if (ring_) {
+		/* a PacketRing does not link its packets */
+		for (int i = 0; (p = q_->lookup(i)) != 0; i++) {
+			if (HDR_CMN(p)->next_hop() == id) {
+				q_->remove(p);
+				break;
+			}
+		}
+		return p;
+	}
 	for(p = q_->head(); p; p = p->next_) {
 		ch = HDR_CMN(p);
 		if(ch->next_hop() == id)
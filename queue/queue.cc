@@ -34,8 +34,10 @@ static const char rcsid[] =
 #endif
 
 #include "queue.h"
+#include "delay.h"
 #include <math.h>
 #include <stdio.h>
+#include <typeinfo>
 
 void PacketQueue::remove(Packet* target)
 {
@@ -76,6 +78,63 @@ void PacketQueue::remove(Packet* pkt, Packet *prev) //XXX: screwy
 	return;
 }
 
+static class PacketRingClass : public TclClass {
+public:
+	PacketRingClass() : TclClass("PacketQueue/Ring") {}
+	TclObject* create(int, const char*const*) {
+		return (new PacketRing);
+	}
+} class_packet_ring;
+
+PacketRing::PacketRing(int capacity) : first_(0)
+{
+	int n = 16;
+	while (n < capacity)
+		n *= 2;
+	slots_ = new Packet*[n];
+	mask_ = n - 1;
+}
+
+void PacketRing::grow()
+{
+	int n = 2 * (mask_ + 1);
+	Packet** slots = new Packet*[n];
+	for (int i = 0; i < len_; i++)
+		slots[i] = slots_[(first_ + i) & mask_];
+	delete [] slots_;
+	slots_ = slots;
+	mask_ = n - 1;
+	first_ = 0;
+}
+
+void PacketRing::remove(Packet* target)
+{
+	int i, j;
+
+	/* mostly the packet just enqueued: look from the tail */
+	for (i = len_ - 1; i >= 0; i--)
+		if (slots_[(first_ + i) & mask_] == target)
+			break;
+	if (i < 0) {
+		fprintf(stderr, "PacketRing:: remove() couldn't find target\n");
+		abort();
+	}
+	if (i < len_ / 2) {
+		for (j = i; j > 0; j--)
+			slots_[(first_ + j) & mask_] =
+				slots_[(first_ + j - 1) & mask_];
+		first_ = (first_ + 1) & mask_;
+	} else {
+		for (j = i; j < len_ - 1; j++)
+			slots_[(first_ + j) & mask_] =
+				slots_[(first_ + j + 1) & mask_];
+	}
+	--len_;
+	bytes_ -= hdr_cmn::access(target)->size();
+	head_ = len_ ? slots_[first_] : 0;
+	tail_ = len_ ? slots_[(first_ + len_ - 1) & mask_] : 0;
+}
+
 void QueueHandler::handle(Event*)
 {
 	queue_.resume();
@@ -85,7 +144,8 @@ Queue::~Queue() {
 }
 
 Queue::Queue() : Connector(), blocked_(0), unblock_on_resume_(1), qh_(*this),
-		 pq_(0), 
+		 pq_(0), fastlink_(0),
+		 fluid_(0), fluid_pkts_(0), fluid_bytes_(0), fluid_in_(0),
 		 last_change_(0), /* temporarily NULL */
 		 old_util_(0), period_begin_(0), cur_util_(0), buf_slot_(0),
 		 util_buf_(NULL)
@@ -109,9 +169,45 @@ Queue::Queue() : Connector(), blocked_(0), unblock_on_resume_(1), qh_(*this),
 	}
 }
 
+int Queue::command(int argc, const char*const* argv)
+{
+	if (argc == 2) {
+		/*
+		 * Called once the topology is set up (Simulator
+		 * fast-links): note whether target_ is a plain LinkDelay,
+		 * which transmit() may then call directly.
+		 */
+		if (strcmp(argv[1], "fast-path") == 0) {
+			fastlink_ = 0;
+			if (target_ != 0 && typeid(*target_) == typeid(LinkDelay))
+				fastlink_ = (LinkDelay*)target_;
+			Tcl::instance().resultf("%d", fastlink_ != 0);
+			return (TCL_OK);
+		}
+	}
+	return (Connector::command(argc, argv));
+}
+
+/*
+ * Hand p to the link.  Most of the time target_ is the LinkDelay of a
+ * SimpleLink, whose recv() is then called without going through the
+ * vtable; anything spliced in since "fast-path" (a deque trace, a
+ * monitor, an error model) changes target_ and so turns the shortcut
+ * off again.
+ */
+inline void Queue::transmit(Packet* p)
+{
+	if (target_ == fastlink_)
+		fastlink_->LinkDelay::recv(p, &qh_);
+	else
+		target_->recv(p, &qh_);
+}
+
 void Queue::recv(Packet* p, Handler*)
 {
 	double now = Scheduler::instance().clock();
+	if (fluid_)
+		fluid_in_ += hdr_cmn::access(p)->size();
 	enque(p);
 	if (!blocked_) {
 		/*
@@ -125,7 +221,7 @@ void Queue::recv(Packet* p, Handler*)
 			utilUpdate(last_change_, now, blocked_);
 			last_change_ = now;
 			blocked_ = 1;
-			target_->recv(p, &qh_);
+			transmit(p);
 		}
 	}
 }
@@ -208,7 +304,7 @@ void Queue::resume()
 	double now = Scheduler::instance().clock();
 	Packet* p = deque();
 	if (p != 0) {
-		target_->recv(p, &qh_);
+		transmit(p);
 	} else {
 		if (unblock_on_resume_) {
 			utilUpdate(last_change_, now, blocked_);
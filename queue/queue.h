@@ -64,7 +64,7 @@ public:
 		bytes_ -= hdr_cmn::access(p)->size();
 		return p;
 	}
-	Packet* lookup(int n) {
+	virtual Packet* lookup(int n) {
 		for (Packet* p = head_; p != 0; p = p->next_) {
 			if (--n < 0)
 				return (p);
@@ -74,7 +74,7 @@ public:
 	/* remove a specific packet, which must be in the queue */
 	virtual void remove(Packet*);
 	/* Remove a packet, located after a given packet. Either could be 0. */
-	void remove(Packet *, Packet *);
+	virtual void remove(Packet *, Packet *);
         Packet* head() { return head_; }
 	Packet* tail() { return tail_; }
 	// MONARCH EXTNS
@@ -104,7 +104,78 @@ private:
 	Packet *iter;
 };
 
+#ifdef __GNUC__
+#define PQ_PREFETCH(addr)	__builtin_prefetch(addr)
+#else
+#define PQ_PREFETCH(addr)
+#endif
+
+/*
+ * A PacketQueue kept in an array of slots used as a ring, whose size is
+ * a power of two: lookup() is O(1), a dequeue prefetches the header of
+ * the next packet, and remove() scans the array rather than the packets
+ * and shifts the shorter side.  The packets are not linked through
+ * next_ (nor is the iterator kept), so walk the queue with lookup().
+ * The ring doubles when it is full.
+ */
+class PacketRing : public PacketQueue {
+public:
+	PacketRing(int capacity = 0);
+	~PacketRing() { delete [] slots_; }
+	Packet* enque(Packet* p) {
+		if (len_ > mask_)
+			grow();
+		Packet* pt = tail_;
+		slots_[(first_ + len_) & mask_] = p;
+		if (!pt)
+			head_ = p;
+		tail_ = p;
+		++len_;
+		bytes_ += hdr_cmn::access(p)->size();
+		return pt;
+	}
+	Packet* deque() {
+		if (len_ == 0)
+			return 0;
+		Packet* p = slots_[first_];
+		first_ = (first_ + 1) & mask_;
+		if (--len_ == 0)
+			head_ = tail_ = 0;
+		else {
+			head_ = slots_[first_];
+			PQ_PREFETCH(hdr_cmn::access(head_));
+		}
+		bytes_ -= hdr_cmn::access(p)->size();
+		return p;
+	}
+	Packet* lookup(int n) {
+		return (n >= 0 && n < len_ ? slots_[(first_ + n) & mask_] : 0);
+	}
+	void enqueHead(Packet* p) {
+		if (len_ > mask_)
+			grow();
+		first_ = (first_ - 1) & mask_;
+		slots_[first_] = p;
+		head_ = p;
+		if (!tail_)
+			tail_ = p;
+		++len_;
+		bytes_ += hdr_cmn::access(p)->size();
+	}
+	void remove(Packet*);
+	void remove(Packet* p, Packet*) {
+		if (p)
+			remove(p);
+	}
+protected:
+	void grow();
+	Packet** slots_;
+	int mask_;		// slots - 1
+	int first_;		// slot of head_
+};
+
 class Queue;
+class LinkDelay;
 
 class QueueHandler : public Handler {
 public:
@@ -137,10 +208,28 @@ public:
 	/* max utilization over recent time period.
 	   Returns the maximum of recent measurements stored in util_buf_*/
 	double peak_utilization(void);
+	/*
+	 * Background traffic of a FluidModel (asim/fluid.h) sharing this
+	 * queue.  Its backlog counts against the limit and the average
+	 * queue of the disciplines that look (DropTail, RED); the model
+	 * reads the bytes of the packets that arrived since it last looked.
+	 */
+	void fluid(int pkts, int bytes) {
+		fluid_ = 1;
+		fluid_pkts_ = pkts;
+		fluid_bytes_ = bytes;
+	}
+	double fluid_arrivals() {
+		double b = fluid_in_;
+		fluid_in_ = 0;
+		return (b);
+	}
 	virtual ~Queue();
 protected:
 	Queue();
 	void reset();
+	int command(int argc, const char*const* argv);
+	void transmit(Packet* p);
 	int qlim_;		/* maximum allowed pkts in queue */
 	int blocked_;		/* blocked now? */
 	int unblock_on_resume_;	/* unblock q on idle? */
@@ -148,6 +237,12 @@ protected:
 	PacketQueue *pq_;	/* pointer to actual packet queue 
 				 * (maintained by the individual disciplines
 				 * like DropTail and RED). */
+	LinkDelay* fastlink_;	/* target_, if "fast-path" found it to be
+				 * a plain LinkDelay */
+	int fluid_;		/* a FluidModel shares this queue */
+	int fluid_pkts_;	/* its backlog, packets */
+	int fluid_bytes_;	/*  and bytes */
+	double fluid_in_;	/* bytes arrived since fluid_arrivals() */
 	double true_ave_;	/* true long-term average queue size */
 	double total_time_;	/* total time average queue size compute for */
 
@@ -146,9 +146,13 @@ REDQueue::REDQueue(const char * trace) : link_(NULL), de_drop_(NULL), EDTrace(NU
 	bind("prob1_", &edv_.v_prob1);		    // dropping probability
 	bind("curq_", &curq_);			    // current queue size
 	bind("cur_max_p_", &edv_.cur_max_p);        // current max_p
+	bind_bool("ring_", &ring_);		    // PacketRing as q_?
 	
 
-	q_ = new PacketQueue();			    // underlying queue
+	if (ring_)
+		q_ = new PacketRing(qlim_ + 1);	    // underlying queue
+	else
+		q_ = new PacketQueue();
 	pq_ = q_;
 	//reset();
 #ifdef notdef
@@ -645,13 +649,17 @@ void REDQueue::enque(Packet* pkt)
 			m = int(ptc * (now - idletime_));
 		} else
                 	m = int(edp_.ptc * (now - idletime_));
+		if (fluid_pkts_ > 0)
+			m = 0;	// the link was busy with FluidModel traffic
 	}
 
 	/*
 	 * Run the estimator with either 1 new packet arrival, or with
 	 * the scaled version above [scaled by m due to idle time]
 	 */
-	edv_.v_ave = estimator(qib_ ? q_->byteLength() : q_->length(), m + 1, edv_.v_ave, edp_.q_w);
+	edv_.v_ave = estimator(qib_ ? q_->byteLength() + fluid_bytes_ :
+			       q_->length() + fluid_pkts_,
+			       m + 1, edv_.v_ave, edp_.q_w);
 	//printf("v_ave: %6.4f (%13.12f) q: %d)\n", 
 	//	double(edv_.v_ave), double(edv_.v_ave), q_->length());
 	if (summarystats_) {
@@ -679,7 +687,8 @@ void REDQueue::enque(Packet* pkt)
 
 	register double qavg = edv_.v_ave;
 	int droptype = DTYPE_NONE;
-	int qlen = qib_ ? q_->byteLength() : q_->length();
+	int qlen = qib_ ? q_->byteLength() + fluid_bytes_ :
+			  q_->length() + fluid_pkts_;
 	int qlim = qib_ ? (qlim_ * edp_.mean_pktsize) : qlim_;
 
 	curq_ = qlen;	// helps to trace queue during arrival, if enabled
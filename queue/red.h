@@ -189,6 +189,7 @@ class REDQueue : public Queue {
 	 */
 	int drop_tail_;		/* drop-tail */
 	int drop_front_;	/* drop-from-front */
+	int ring_;		/* q_ is a PacketRing */
 	int drop_rand_;		/* drop-tail, or drop random? */
 	int ns1_compat_;	/* for ns-1 compatibility, bypass a */
 				/*   small bugfix */
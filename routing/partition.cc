@@ -0,0 +1,656 @@
+/* -*-	Mode:C++; c-basic-offset:8; tab-width:8; indent-tabs-mode:t -*- */
+/*
+ * Copyright (c) 1991-1994 Regents of the University of California.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor of the Laboratory may be used
+ *    to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * The partition has to serve two masters: the fewer links between LPs
+ * the less work crosses them, but it is the least delay of those links,
+ * the lookahead, that bounds how far the LPs may run ahead of each
+ * other.  run() settles the lookahead first: links shorter than some
+ * delay are contracted, and the delay is raised (by bisection over the
+ * distinct link delays) as long as no resulting component is too big
+ * for a part or holds nodes pinned to different parts.  The components
+ * are then split into parts with few links between them by a multilevel
+ * scheme in the style of METIS: the component graph is coarsened by
+ * heavy edge matching, the coarsest graph is split by graph growing,
+ * and the split is refined by greedy boundary moves on every level on
+ * the way back.  Everything is deterministic.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "partition.h"
+
+/*
+ * An undirected graph in compressed adjacency form: the neighbours of v
+ * are adj[xadj[v] .. xadj[v + 1]), ew[] the links each arc stands for.
+ */
+struct PartGraph {
+	int n;
+	int* xadj;
+	int* adj;
+	int* ew;
+	int* vw;		/* nodes each vertex stands for */
+	int* pin;		/* part the vertex must be in, or -1 */
+	int* cmap;		/* vertex of the coarser graph */
+	PartGraph* coarser;
+
+	PartGraph(int nv) : n(nv), xadj(new int[nv + 1]), adj(0), ew(0),
+		vw(new int[nv]), pin(new int[nv]), cmap(0), coarser(0) {}
+	~PartGraph() {
+		delete [] xadj;
+		delete [] adj;
+		delete [] ew;
+		delete [] vw;
+		delete [] pin;
+		delete [] cmap;
+		delete coarser;
+	}
+	void arcs(int na, const int* from, const int* to, const int* w);
+};
+
+/*
+ * Set up the adjacency from na arcs (both directions of every edge),
+ * summing the weights of parallel arcs.
+ */
+void PartGraph::arcs(int na, const int* from, const int* to, const int* w)
+{
+	int v, i;
+
+	for (v = 0; v <= n; v++)
+		xadj[v] = 0;
+	for (i = 0; i < na; i++)
+		xadj[from[i] + 1]++;
+	for (v = 0; v < n; v++)
+		xadj[v + 1] += xadj[v];
+	adj = new int[na];
+	ew = new int[na];
+	int* fill = new int[n];
+	for (v = 0; v < n; v++)
+		fill[v] = xadj[v];
+	for (i = 0; i < na; i++) {
+		adj[fill[from[i]]] = to[i];
+		ew[fill[from[i]]++] = w[i];
+	}
+	/* merge parallel arcs, in place */
+	int* at = fill;
+	for (v = 0; v < n; v++)
+		at[v] = -1;
+	int k = 0;
+	for (v = 0; v < n; v++) {
+		int first = k, end = xadj[v + 1];
+		for (i = xadj[v]; i < end; i++) {
+			int u = adj[i];
+			if (at[u] >= first) {
+				ew[at[u]] += ew[i];
+				continue;
+			}
+			at[u] = k;
+			adj[k] = u;
+			ew[k++] = ew[i];
+		}
+		xadj[v] = first;
+	}
+	xadj[n] = k;
+	delete [] fill;
+}
+
+static unsigned int
+part_random(unsigned int& seed)
+{
+	seed = seed * 1103515245 + 12345;
+	return ((seed >> 16) & 0x7fff);
+}
+
+/*
+ * Match every vertex with the unmatched neighbour it shares the most
+ * links with, visiting vertices in random order, and return the graph
+ * of the pairs, or 0 if that would hardly be smaller.
+ */
+static PartGraph*
+part_coarsen(PartGraph* g, int maxvw, unsigned int& seed)
+{
+	int n = g->n, v, i;
+	int* order = new int[n];
+	int* match = new int[n];
+
+	for (v = 0; v < n; v++) {
+		order[v] = v;
+		match[v] = -1;
+	}
+	for (v = n - 1; v > 0; v--) {
+		i = (int)(((part_random(seed) << 15) | part_random(seed)) %
+			  (unsigned int)(v + 1));
+		int t = order[v];
+		order[v] = order[i];
+		order[i] = t;
+	}
+	for (int j = 0; j < n; j++) {
+		v = order[j];
+		if (match[v] >= 0)
+			continue;
+		int best = v, bestw = 0;
+		for (i = g->xadj[v]; i < g->xadj[v + 1]; i++) {
+			int u = g->adj[i];
+			if (match[u] >= 0 || g->ew[i] <= bestw ||
+			    g->vw[v] + g->vw[u] > maxvw ||
+			    (g->pin[v] >= 0 && g->pin[u] >= 0 &&
+			     g->pin[v] != g->pin[u]))
+				continue;
+			best = u;
+			bestw = g->ew[i];
+		}
+		match[v] = best;
+		match[best] = v;
+	}
+	delete [] order;
+
+	g->cmap = new int[n];
+	int nc = 0;
+	for (v = 0; v < n; v++)
+		g->cmap[v] = -1;
+	for (v = 0; v < n; v++) {
+		if (g->cmap[v] >= 0)
+			continue;
+		g->cmap[v] = g->cmap[match[v]] = nc++;
+	}
+	if (nc > n - n / 10) {
+		delete [] match;
+		delete [] g->cmap;
+		g->cmap = 0;
+		return (0);
+	}
+
+	PartGraph* c = new PartGraph(nc);
+	for (v = 0; v < nc; v++) {
+		c->vw[v] = 0;
+		c->pin[v] = -1;
+	}
+	int na = 0;
+	for (v = 0; v < n; v++) {
+		int cv = g->cmap[v];
+		c->vw[cv] += g->vw[v];
+		if (g->pin[v] >= 0)
+			c->pin[cv] = g->pin[v];
+		for (i = g->xadj[v]; i < g->xadj[v + 1]; i++)
+			if (g->cmap[g->adj[i]] != cv)
+				na++;
+	}
+	int* from = new int[na];
+	int* to = new int[na];
+	int* w = new int[na];
+	na = 0;
+	for (v = 0; v < n; v++) {
+		int cv = g->cmap[v];
+		for (i = g->xadj[v]; i < g->xadj[v + 1]; i++) {
+			int cu = g->cmap[g->adj[i]];
+			if (cu == cv)
+				continue;
+			from[na] = cv;
+			to[na] = cu;
+			w[na++] = g->ew[i];
+		}
+	}
+	c->arcs(na, from, to, w);
+	delete [] from;
+	delete [] to;
+	delete [] w;
+	delete [] match;
+	g->coarser = c;
+	return (c);
+}
+
+/*
+ * Split g by growing the parts one after the other in breadth first
+ * order, each vertex going to the part it has most links to among
+ * those not yet at their share of the nodes.
+ */
+static void
+part_initial(PartGraph* g, int nparts, int total, int* part, int* pw)
+{
+	int n = g->n, v, i, p;
+	int share = (total + nparts - 1) / nparts;
+	int* conn = new int[nparts];
+	int* queue = new int[n];
+	char* seen = new char[n];
+	int head = 0, tail = 0;
+
+	for (p = 0; p < nparts; p++)
+		pw[p] = conn[p] = 0;
+	memset(seen, 0, n);
+	/* pinned vertices first, the others breadth first from them */
+	for (v = 0; v < n; v++) {
+		part[v] = g->pin[v];
+		if (part[v] >= 0) {
+			pw[part[v]] += g->vw[v];
+			queue[tail++] = v;
+			seen[v] = 1;
+		}
+	}
+	for (int start = 0; start < n || head < tail; ) {
+		if (head == tail) {
+			while (seen[start])
+				start++;
+			queue[tail++] = start;
+			seen[start] = 1;
+		}
+		v = queue[head++];
+		for (i = g->xadj[v]; i < g->xadj[v + 1]; i++) {
+			int u = g->adj[i];
+			if (!seen[u]) {
+				seen[u] = 1;
+				queue[tail++] = u;
+			}
+		}
+		if (tail == n)
+			start = n;
+		if (part[v] >= 0)
+			continue;
+		for (i = g->xadj[v]; i < g->xadj[v + 1]; i++)
+			if (part[g->adj[i]] >= 0)
+				conn[part[g->adj[i]]] += g->ew[i];
+		int best = -1, lightest = 0;
+		for (p = 0; p < nparts; p++) {
+			if (pw[p] < pw[lightest])
+				lightest = p;
+			if (conn[p] > 0 && pw[p] + g->vw[v] <= share &&
+			    (best < 0 || conn[p] > conn[best]))
+				best = p;
+			conn[p] = 0;
+		}
+		part[v] = best >= 0 ? best : lightest;
+		pw[part[v]] += g->vw[v];
+	}
+	delete [] conn;
+	delete [] queue;
+	delete [] seen;
+}
+
+/*
+ * Move vertices on the boundary to the neighbouring part they have most
+ * links to, as long as that cuts fewer links (or as many, but evens out
+ * the parts) and keeps the parts within cap; a part above cap sheds
+ * vertices even at a loss.
+ */
+static void
+part_refine(PartGraph* g, int nparts, int cap, int* part, int* pw)
+{
+	int n = g->n, v, i, p;
+	int* conn = new int[nparts];
+	int* touched = new int[nparts];
+
+	for (p = 0; p < nparts; p++)
+		conn[p] = 0;
+	for (int pass = 0; pass < 8; pass++) {
+		int moves = 0;
+		for (v = 0; v < n; v++) {
+			if (g->pin[v] >= 0)
+				continue;
+			int from = part[v], nt = 0;
+			for (i = g->xadj[v]; i < g->xadj[v + 1]; i++) {
+				p = part[g->adj[i]];
+				if (conn[p] == 0)
+					touched[nt++] = p;
+				conn[p] += g->ew[i];
+			}
+			int over = pw[from] > cap;
+			int best = -1, bestgain = 0;
+			for (int t = 0; t < nt; t++) {
+				p = touched[t];
+				if (p == from || pw[p] + g->vw[v] > cap)
+					continue;
+				int gain = conn[p] - conn[from];
+				if (best < 0 || gain > bestgain ||
+				    (gain == bestgain && pw[p] < pw[best])) {
+					best = p;
+					bestgain = gain;
+				}
+			}
+			for (int t = 0; t < nt; t++)
+				conn[touched[t]] = 0;
+			if (best < 0 && over) {
+				for (p = 0; p < nparts; p++)
+					if (best < 0 || pw[p] < pw[best])
+						best = p;
+				if (pw[best] + g->vw[v] > cap)
+					best = -1;
+			}
+			if (best < 0)
+				continue;
+			if (!over && (bestgain < 0 || (bestgain == 0 &&
+			    pw[best] + g->vw[v] >= pw[from])))
+				continue;
+			part[v] = best;
+			pw[from] -= g->vw[v];
+			pw[best] += g->vw[v];
+			moves++;
+		}
+		if (moves == 0)
+			break;
+	}
+	delete [] conn;
+	delete [] touched;
+}
+
+/*
+ * Partition g and everything coarser than it into nparts parts,
+ * leaving the result in part[].
+ */
+static void
+part_multilevel(PartGraph* g, int nparts, int total, int cap,
+		unsigned int& seed, int* part, int* pw)
+{
+	PartGraph* c = 0;
+	if (g->n > 20 * nparts) {
+		int maxvw = cap / 4 > 0 ? cap / 4 : 1;
+		c = part_coarsen(g, maxvw, seed);
+	}
+	if (c == 0) {
+		part_initial(g, nparts, total, part, pw);
+	} else {
+		int* cpart = new int[c->n];
+		part_multilevel(c, nparts, total, cap, seed, cpart, pw);
+		for (int v = 0; v < g->n; v++)
+			part[v] = cpart[g->cmap[v]];
+		delete [] cpart;
+	}
+	part_refine(g, nparts, cap, part, pw);
+}
+
+TopoPartition::TopoPartition()
+	: n_(0), maxn_(0), links_(0), nlinks_(0), maxlinks_(0), pin_(0),
+	  part_(0), nparts_(0), cut_(0), lookahead_(-1)
+{
+}
+
+TopoPartition::~TopoPartition()
+{
+	delete [] links_;
+	delete [] pin_;
+	delete [] part_;
+}
+
+void TopoPartition::reset(int nodes)
+{
+	nlinks_ = 0;
+	n_ = 0;
+	delete [] part_;
+	part_ = 0;
+	nparts_ = cut_ = 0;
+	lookahead_ = -1;
+	grow(nodes);
+}
+
+void TopoPartition::grow(int n)
+{
+	if (n > maxn_) {
+		int m = maxn_ ? maxn_ : 64;
+		while (m < n)
+			m *= 2;
+		int* np = new int[m];
+		if (n_ > 0)
+			memcpy(np, pin_, n_ * sizeof(int));
+		delete [] pin_;
+		pin_ = np;
+		maxn_ = m;
+	}
+	for (; n_ < n; n_++)
+		pin_[n_] = -1;
+}
+
+void TopoPartition::link(int src, int dst, double delay)
+{
+	grow((src > dst ? src : dst) + 1);
+	if (nlinks_ == maxlinks_) {
+		maxlinks_ = maxlinks_ ? 2 * maxlinks_ : 256;
+		Link* nl = new Link[maxlinks_];
+		if (nlinks_ > 0)
+			memcpy(nl, links_, nlinks_ * sizeof(Link));
+		delete [] links_;
+		links_ = nl;
+	}
+	links_[nlinks_].src = src;
+	links_[nlinks_].dst = dst;
+	links_[nlinks_].delay = delay;
+	nlinks_++;
+}
+
+void TopoPartition::pin(int node, int part)
+{
+	grow(node + 1);
+	pin_[node] = part;
+}
+
+static int
+comp_find(int* up, int v)
+{
+	while (up[v] != v)
+		v = up[v] = up[up[v]];
+	return (v);
+}
+
+/*
+ * Merge the nodes joined by links shorter than delay into components,
+ * numbered in comp[], and return how many there are, or -1 if a
+ * component would hold more than cap nodes or nodes pinned to
+ * different parts, or there would be fewer than nparts.
+ */
+int TopoPartition::contract(double delay, int* comp, int nparts, int cap)
+{
+	int v, i;
+	for (v = 0; v < n_; v++)
+		comp[v] = v;
+	for (i = 0; i < nlinks_; i++) {
+		if (links_[i].delay >= delay)
+			continue;
+		int a = comp_find(comp, links_[i].src);
+		int b = comp_find(comp, links_[i].dst);
+		if (a != b)
+			comp[a > b ? a : b] = a < b ? a : b;
+	}
+	int* size = new int[n_];
+	int* pin = new int[n_];
+	int ncomps = 0, ok = 1;
+	for (v = 0; v < n_; v++) {
+		size[v] = 0;
+		pin[v] = -1;
+	}
+	for (v = 0; v < n_; v++) {
+		int r = comp_find(comp, v);
+		comp[v] = r;
+		if (++size[r] > cap)
+			ok = 0;
+		if (pin_[v] >= 0) {
+			if (pin[r] >= 0 && pin[r] != pin_[v])
+				ok = 0;
+			pin[r] = pin_[v];
+		}
+	}
+	/* number the components in order of their least node */
+	for (v = 0; v < n_; v++)
+		if (comp[v] == v)
+			size[v] = ncomps++;
+	for (v = 0; v < n_; v++)
+		comp[v] = size[comp[v]];
+	delete [] size;
+	delete [] pin;
+	return (ok && ncomps >= nparts ? ncomps : -1);
+}
+
+/* The graph of the components and the links between them. */
+PartGraph* TopoPartition::graph(const int* comp, int ncomps)
+{
+	PartGraph* g = new PartGraph(ncomps);
+	int v, i;
+
+	for (v = 0; v < ncomps; v++) {
+		g->vw[v] = 0;
+		g->pin[v] = -1;
+	}
+	for (v = 0; v < n_; v++) {
+		g->vw[comp[v]]++;
+		if (pin_[v] >= 0)
+			g->pin[comp[v]] = pin_[v];
+	}
+	int* from = new int[2 * nlinks_];
+	int* to = new int[2 * nlinks_];
+	int* w = new int[2 * nlinks_];
+	int na = 0;
+	for (i = 0; i < nlinks_; i++) {
+		int a = comp[links_[i].src], b = comp[links_[i].dst];
+		if (a == b)
+			continue;
+		from[na] = a;
+		to[na] = b;
+		w[na++] = 1;
+		from[na] = b;
+		to[na] = a;
+		w[na++] = 1;
+	}
+	g->arcs(na, from, to, w);
+	delete [] from;
+	delete [] to;
+	delete [] w;
+	return (g);
+}
+
+static int
+delay_cmp(const void* a, const void* b)
+{
+	double x = *(const double*)a, y = *(const double*)b;
+	return (x < y ? -1 : x > y ? 1 : 0);
+}
+
+/*
+ * Split the nodes into nparts parts of at most (1 + imbalance) times
+ * their share of the nodes.  With lookahead > 0 links shorter than it
+ * are never cut, otherwise the lookahead is made as large as it can be.
+ * Returns -1 if the pins and the balance leave no way to do it.
+ */
+int TopoPartition::run(int nparts, double imbalance, double lookahead)
+{
+	int v, i;
+
+	delete [] part_;
+	part_ = 0;
+	nparts_ = cut_ = 0;
+	lookahead_ = -1;
+	if (nparts < 1 || n_ < nparts)
+		return (-1);
+	for (v = 0; v < n_; v++)
+		if (pin_[v] >= nparts)
+			return (-1);
+	int cap = (int)((1 + imbalance) * n_ / nparts);
+	if (cap * nparts < n_)
+		cap = (n_ + nparts - 1) / nparts;
+
+	int* comp = new int[n_];
+	int ncomps;
+	if (lookahead > 0) {
+		ncomps = contract(lookahead, comp, nparts, cap);
+	} else {
+		/* the largest link delay d such that cutting only links
+		   of d or more is feasible (the least delay always is) */
+		double* d = new double[nlinks_ + 1];
+		for (i = 0; i < nlinks_; i++)
+			d[i] = links_[i].delay;
+		qsort(d, nlinks_, sizeof(double), delay_cmp);
+		int nd = 0;
+		for (i = 0; i < nlinks_; i++)
+			if (nd == 0 || d[i] != d[nd - 1])
+				d[nd++] = d[i];
+		int lo = 0, hi = nd - 1;
+		while (lo < hi) {
+			int mid = (lo + hi + 1) / 2;
+			if (contract(d[mid], comp, nparts, cap) >= 0)
+				lo = mid;
+			else
+				hi = mid - 1;
+		}
+		ncomps = contract(nd > 0 ? d[lo] : 0, comp, nparts, cap);
+		delete [] d;
+	}
+	if (ncomps < 0) {
+		delete [] comp;
+		return (-1);
+	}
+
+	PartGraph* g = graph(comp, ncomps);
+	int* gpart = new int[ncomps];
+	int* pw = new int[nparts];
+	unsigned int seed = 1;
+	part_multilevel(g, nparts, n_, cap, seed, gpart, pw);
+
+	part_ = new int[n_];
+	for (v = 0; v < n_; v++)
+		part_[v] = gpart[comp[v]];
+	nparts_ = nparts;
+	for (i = 0; i < nlinks_; i++) {
+		if (part_[links_[i].src] == part_[links_[i].dst])
+			continue;
+		cut_++;
+		if (lookahead_ < 0 || links_[i].delay < lookahead_)
+			lookahead_ = links_[i].delay;
+	}
+	delete g;
+	delete [] gpart;
+	delete [] pw;
+	delete [] comp;
+	return (0);
+}
+
+int TopoPartition::size(int part) const
+{
+	int n = 0;
+	for (int v = 0; part_ != 0 && v < n_; v++)
+		if (part_[v] == part)
+			n++;
+	return (n);
+}
+
+/*
+ * One "n <node> <part>" line per node and one "c <src> <dst> <delay>"
+ * line per cut link, after a summary in comments.
+ */
+void TopoPartition::dump(FILE* f) const
+{
+	int v, i;
+
+	fprintf(f, "# %d nodes, %d links, %d parts, %d cut links, "
+		"lookahead %g\n", n_, nlinks_, nparts_, cut_, lookahead_);
+	for (int p = 0; p < nparts_; p++)
+		fprintf(f, "# part %d: %d nodes\n", p, size(p));
+	for (v = 0; part_ != 0 && v < n_; v++)
+		fprintf(f, "n %d %d\n", v, part_[v]);
+	for (i = 0; part_ != 0 && i < nlinks_; i++)
+		if (part_[links_[i].src] != part_[links_[i].dst])
+			fprintf(f, "c %d %d %g\n", links_[i].src,
+				links_[i].dst, links_[i].delay);
+}
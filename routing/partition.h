@@ -0,0 +1,85 @@
+/* -*-	Mode:C++; c-basic-offset:8; tab-width:8; indent-tabs-mode:t -*- */
+/*
+ * Copyright (c) 1991-1994 Regents of the University of California.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor of the Laboratory may be used
+ *    to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Multilevel partitioning of the node graph for the parallel scheduler
+ * (Scheduler/Parallel), driven by RouteLogic ("partition" and the
+ * "part-" commands).
+ */
+
+#ifndef ns_partition_h
+#define ns_partition_h
+
+#include <stdio.h>
+
+struct PartGraph;
+
+class TopoPartition {
+public:
+	TopoPartition();
+	~TopoPartition();
+	void reset(int nodes);
+	void link(int src, int dst, double delay);
+	void pin(int node, int part);
+	int run(int nparts, double imbalance, double lookahead);
+	int part(int node) const {
+		return (part_ != 0 && node >= 0 && node < n_ ?
+			part_[node] : -1);
+	}
+	int nparts() const { return (nparts_); }
+	int size(int part) const;
+	int cut() const { return (cut_); }
+	double lookahead() const { return (lookahead_); }
+	void dump(FILE* f) const;
+
+protected:
+	struct Link {
+		int src;
+		int dst;
+		double delay;
+	};
+
+	void grow(int n);
+	int contract(double delay, int* comp, int nparts, int cap);
+	PartGraph* graph(const int* comp, int ncomps);
+
+	int n_;			/* nodes */
+	int maxn_;
+	Link* links_;
+	int nlinks_;
+	int maxlinks_;
+	int* pin_;		/* part a node must be in, or -1 */
+	int* part_;		/* result of the last run(), 0 before */
+	int nparts_;
+	int cut_;		/* links between parts */
+	double lookahead_;	/* least delay of those links, -1 if none */
+};
+
+#endif
@@ -42,6 +42,11 @@ static const char rcsid[] =
 #include "config.h"
 #include "route.h"
 #include "address.h"
+#include "partition.h"
+#ifdef HAVE_LIBPTHREAD
+#include <pthread.h>
+#include <unistd.h>
+#endif
 
 class RouteLogicClass : public TclClass {
 public:
@@ -57,18 +62,32 @@ void RouteLogic::reset_all()
 	delete[] route_;
 	adj_ = 0; 
 	route_ = 0;
+	delete[] arcs_;
+	delete[] arc_head_;
+	arcs_ = 0;
+	arc_head_ = 0;
+	narcs_ = maxarcs_ = 0;
+	free_runs();
 	size_ = 0;
 }
 
 int RouteLogic::command(int argc, const char*const* argv)
 {
 	Tcl& tcl = Tcl::instance();
+	if (argc >= 2 && (strcmp(argv[1], "partition") == 0 ||
+			  strncmp(argv[1], "part-", 5) == 0))
+		return (part_command(argc, argv));
 	if (argc == 2) {
 		if (strcmp(argv[1], "compute") == 0) {
-			if (adj_ == 0)
+			if (adj_ == 0 && arc_head_ == 0)
 				return (TCL_OK);
 			compute_routes();
 			return (TCL_OK);
+		} else if (strcmp(argv[1], "lazy") == 0) {
+			if (adj_ == 0 && arc_head_ == 0)
+				return (TCL_OK);
+			lazy_routes();
+			return (TCL_OK);
 		} else if (strcmp(argv[1], "hier-compute") == 0) {
 			if (hadj_ == 0) {
 				return (TCL_OK);
@@ -196,13 +215,98 @@ int RouteLogic::command(int argc, const char*const* argv)
 	return (TclObject::command(argc, argv));
 }
 
+/*
+ * Split the node graph among the LPs of a parallel scheduler (see
+ * partition.cc).  The graph is handed over link by link, with delays:
+ *
+ *	$r part-reset <nodes>
+ *	$r part-link <src> <dst> <delay>
+ *	$r part-pin <node> <part>	;# node must go to part
+ *	$r partition <nparts>		;# returns the lookahead
+ *	$r part-of <node>
+ *	$r part-lookahead		;# least delay of a cut link, -1 if none
+ *	$r part-cut			;# number of cut links
+ *	$r part-count			;# parts of the last partition
+ *	$r part-size <part>		;# nodes in the part
+ *	$r part-export <file>
+ */
+int RouteLogic::part_command(int argc, const char*const* argv)
+{
+	Tcl& tcl = Tcl::instance();
+	if (part_ == 0)
+		part_ = new TopoPartition;
+	if (argc == 2) {
+		if (strcmp(argv[1], "part-lookahead") == 0) {
+			tcl.resultf("%g", part_->lookahead());
+			return (TCL_OK);
+		} else if (strcmp(argv[1], "part-cut") == 0) {
+			tcl.resultf("%d", part_->cut());
+			return (TCL_OK);
+		} else if (strcmp(argv[1], "part-count") == 0) {
+			tcl.resultf("%d", part_->nparts());
+			return (TCL_OK);
+		}
+	} else if (argc == 3) {
+		if (strcmp(argv[1], "part-reset") == 0) {
+			part_->reset(atoi(argv[2]));
+			return (TCL_OK);
+		} else if (strcmp(argv[1], "partition") == 0) {
+			if (part_->run(atoi(argv[2]), part_imbalance_,
+				       part_lookahead_) < 0) {
+				tcl.resultf("cannot split the topology into "
+					    "%s parts (pins, balance or "
+					    "part_lookahead_?)", argv[2]);
+				return (TCL_ERROR);
+			}
+			tcl.resultf("%g", part_->lookahead());
+			return (TCL_OK);
+		} else if (strcmp(argv[1], "part-of") == 0) {
+			tcl.resultf("%d", part_->part(atoi(argv[2])));
+			return (TCL_OK);
+		} else if (strcmp(argv[1], "part-size") == 0) {
+			tcl.resultf("%d", part_->size(atoi(argv[2])));
+			return (TCL_OK);
+		} else if (strcmp(argv[1], "part-export") == 0) {
+			FILE* f = fopen(argv[2], "w");
+			if (f == 0) {
+				tcl.resultf("cannot open %s", argv[2]);
+				return (TCL_ERROR);
+			}
+			part_->dump(f);
+			fclose(f);
+			return (TCL_OK);
+		}
+	} else if (argc == 4) {
+		if (strcmp(argv[1], "part-pin") == 0) {
+			int node = atoi(argv[2]), p = atoi(argv[3]);
+			if (node < 0 || p < 0) {
+				tcl.result("negative node or part number");
+				return (TCL_ERROR);
+			}
+			part_->pin(node, p);
+			return (TCL_OK);
+		}
+	} else if (argc == 5) {
+		if (strcmp(argv[1], "part-link") == 0) {
+			int src = atoi(argv[2]), dst = atoi(argv[3]);
+			if (src < 0 || dst < 0) {
+				tcl.result("negative node number");
+				return (TCL_ERROR);
+			}
+			part_->link(src, dst, atof(argv[4]));
+			return (TCL_OK);
+		}
+	}
+	return (TclObject::command(argc, argv));
+}
+
 // xxx: using references as in this result is bogus---use pointers!
 int RouteLogic::lookup_flat(char* asrc, char* adst, int& result) {
 	Tcl& tcl = Tcl::instance();
 	int src = atoi(asrc) + 1;
 	int dst = atoi(adst) + 1;
 
-	if (route_ == 0) {
+	if (route_ == 0 && runs_ == 0) {
 		// routes are computed only after the simulator is running
 		// ($ns run).
 		tcl.result("routes not yet computed");
@@ -212,7 +316,7 @@ int RouteLogic::lookup_flat(char* asrc, char* adst, int& result) {
 		tcl.result("node out of range");
 		return (TCL_ERROR);
 	}
-	result = route_[INDEX(src, dst, size_)].next_hop - 1;
+	result = next_hop(src, dst) - 1;
 	return TCL_OK;
 }
 
@@ -221,7 +325,7 @@ int RouteLogic::lookup_flat(char* asrc, char* adst, int& result) {
 int RouteLogic::lookup_flat(int sid, int did) {
 	int src = sid+1;
 	int dst = did+1;
-	if (route_ == 0) {
+	if (route_ == 0 && runs_ == 0) {
 		// routes are computed only after the simulator is running
 		// ($ns run).
 		printf("routes not yet computed\n");
@@ -231,7 +335,7 @@ int RouteLogic::lookup_flat(int sid, int did) {
 		printf("node out of range\n");
 		return (-2);
 	}
-	return route_[INDEX(src, dst, size_)].next_hop - 1;
+	return next_hop(src, dst) - 1;
 }
 
 // xxx: using references as in this result is bogus---use pointers!
@@ -309,6 +413,21 @@ RouteLogic::RouteLogic()
 	size_ = 0;
 	adj_ = 0;
 	route_ = 0;
+	sparse_ = 0;
+	compress_ = 0;
+	threads_ = 1;
+	arcs_ = 0;
+	narcs_ = maxarcs_ = 0;
+	arc_head_ = 0;
+	runs_ = 0;
+	nruns_ = 0;
+	runsize_ = 0;
+	bind_bool("sparse_", &sparse_);
+	bind_bool("compress_", &compress_);
+	bind("threads_", &threads_);
+	part_ = 0;
+	bind("part_imbalance_", &part_imbalance_);
+	bind_time("part_lookahead_", &part_lookahead_);
 	/* additions for hierarchical routing extension */
 	C_ = 0;
 	D_ = 0;
@@ -325,6 +444,10 @@ RouteLogic::~RouteLogic()
 {
 	delete[] adj_;
 	delete[] route_;
+	delete[] arcs_;
+	delete[] arc_head_;
+	free_runs();
+	delete part_;
 
 	for (int i = 0; i < (Cmax_ * D_); i++) {
 		for (int j = 0; j < (Cmax_ + D_) * (cluster_size_[i]+1); j++) {
@@ -388,12 +511,22 @@ void RouteLogic::check(int n)
 
 void RouteLogic::insert(int src, int dst, double cost)
 {
+	if (sparse()) {
+		arc(src, dst, 1)->cost = cost;
+		return;
+	}
 	check(src);
 	check(dst);
 	adj_[INDEX(src, dst, size_)].cost = cost;
 }
 void RouteLogic::insert(int src, int dst, double cost, void* entry_)
 {
+	if (sparse()) {
+		route_arc* a = arc(src, dst, 1);
+		a->cost = cost;
+		a->entry = entry_;
+		return;
+	}
 	check(src);
 	check(dst);
 	adj_[INDEX(src, dst, size_)].cost = cost;
@@ -404,79 +537,400 @@ void RouteLogic::reset(int src, int dst)
 {
 	assert(src < size_);
 	assert(dst < size_);
+	if (sparse()) {
+		route_arc* a = arc(src, dst, 0);
+		if (a != 0)
+			a->cost = INFINITY;
+		return;
+	}
 	adj_[INDEX(src, dst, size_)].cost = INFINITY;
 }
 
+struct RouteHeapItem {
+	double d;
+	int v;
+	inline int operator<(const RouteHeapItem& o) const {
+		return (d < o.d || (d == o.d && v < o.v));
+	}
+};
+
+/* what one thread needs to route from a source */
+struct RouteScratch {
+	RouteScratch(int n, int maxheap, int rows) : nheap(0) {
+		hopcnt = new double[n];
+		parent = new int[n];
+		heap = new RouteHeapItem[maxheap > 0 ? maxheap : 1];
+		row = rows ? new route_entry[n] : 0;
+	}
+	~RouteScratch() {
+		delete[] hopcnt;
+		delete[] parent;
+		delete[] heap;
+		delete[] row;
+	}
+	void push(double d, int v) {
+		int i = nheap++;
+		while (i > 0) {
+			int up = (i - 1) / 2;
+			if (!(d < heap[up].d || (d == heap[up].d && v < heap[up].v)))
+				break;
+			heap[i] = heap[up];
+			i = up;
+		}
+		heap[i].d = d;
+		heap[i].v = v;
+	}
+	RouteHeapItem pop() {
+		RouteHeapItem top = heap[0];
+		RouteHeapItem last = heap[--nheap];
+		int i = 0;
+		for (;;) {
+			int c = 2 * i + 1;
+			if (c >= nheap)
+				break;
+			if (c + 1 < nheap && heap[c + 1] < heap[c])
+				c++;
+			if (!(heap[c] < last))
+				break;
+			heap[i] = heap[c];
+			i = c;
+		}
+		heap[i] = last;
+		return (top);
+	}
+
+	double* hopcnt;
+	int* parent;
+	RouteHeapItem* heap;
+	int nheap;
+	route_entry* row;	/* with compress_ */
+};
+
+/* every step'th source starting at first + 1 */
+struct RouteStripe {
+	RouteLogic* rl;
+	int first;
+	int step;
+};
+
+/*
+ * Sparse adjacency: the same node numbering and growth of size_ as
+ * check(), but a list of links per node instead of a row of adj_.
+ */
+void RouteLogic::sparse_check(int n)
+{
+	if (n < size_)
+		return;
+
+	int* old = arc_head_;
+	int m = size_;
+	if (m == 0)
+		m = 16;
+	while (m <= n)
+		m <<= 1;
+	arc_head_ = new int[m];
+	for (int i = 0; i < m; ++i)
+		arc_head_[i] = i < size_ ? old[i] : -1;
+	size_ = m;
+	delete[] old;
+}
+
+/* the link from src to dst, added (at INFINITY) if create is set */
+route_arc* RouteLogic::arc(int src, int dst, int create)
+{
+	int a;
+	if (src < size_)
+		for (a = arc_head_[src]; a >= 0; a = arcs_[a].next)
+			if (arcs_[a].dst == dst)
+				return (&arcs_[a]);
+	if (!create)
+		return (0);
+
+	sparse_check(src);
+	sparse_check(dst);
+	if (narcs_ == maxarcs_) {
+		route_arc* old = arcs_;
+		maxarcs_ = maxarcs_ ? 2 * maxarcs_ : 64;
+		arcs_ = new route_arc[maxarcs_];
+		if (narcs_ > 0)
+			memcpy(arcs_, old, narcs_ * sizeof(route_arc));
+		delete[] old;
+	}
+	a = narcs_++;
+	arcs_[a].dst = dst;
+	arcs_[a].cost = INFINITY;
+	arcs_[a].entry = 0;
+	arcs_[a].next = arc_head_[src];
+	arc_head_[src] = a;
+	return (&arcs_[a]);
+}
+
+void RouteLogic::free_runs()
+{
+	for (int i = 0; i < runsize_; ++i)
+		delete[] runs_[i];
+	delete[] runs_;
+	delete[] nruns_;
+	runs_ = 0;
+	nruns_ = 0;
+	runsize_ = 0;
+}
+
+/* next hop (numbered from 1, 0 if none) from src to dst */
+int RouteLogic::next_hop(int src, int dst)
+{
+	if (runs_ == 0)
+		return (route_[INDEX(src, dst, size_)].next_hop);
+	if (src >= runsize_ || dst >= runsize_)
+		return (0);
+	if (runs_[src] == 0) {
+		RouteScratch sc(size_, arc_head_ ? narcs_ + size_ : 0, 1);
+		compute_source(src, sc);
+	}
+	route_run* r = runs_[src];
+	int lo = 0, hi = nruns_[src] - 1;
+	while (lo < hi) {
+		int mid = (lo + hi + 1) / 2;
+		if (r[mid].dst <= dst)
+			lo = mid;
+		else
+			hi = mid - 1;
+	}
+	return (r[lo].next_hop);
+}
+
+void* RouteLogic::compute_stripe(void* arg)
+{
+	RouteStripe* s = (RouteStripe*)arg;
+	RouteLogic* rl = s->rl;
+	RouteScratch sc(rl->size_, rl->arc_head_ ? rl->narcs_ + rl->size_ : 0,
+			rl->runs_ != 0);
+	for (int k = 1 + s->first; k < rl->size_; k += s->step)
+		rl->compute_source(k, sc);
+	return (0);
+}
+
 void RouteLogic::compute_routes()
 {
 	int n = size_;
-	int* parent = new int[n];
-	double* hopcnt = new double[n];
-#define ADJ(i, j) adj_[INDEX(i, j, size_)].cost
-#define ADJ_ENTRY(i, j) adj_[INDEX(i, j, size_)].entry
-#define ROUTE(i, j) route_[INDEX(i, j, size_)].next_hop
-#define ROUTE_ENTRY(i, j) route_[INDEX(i, j, size_)].entry
 	delete[] route_;
-	route_ = new route_entry[n * n];
-	memset((char *)route_, 0, n * n * sizeof(route_[0]));
+	route_ = 0;
+	free_runs();
+	if (compress_) {
+		runs_ = new route_run*[n];
+		nruns_ = new int[n];
+		runsize_ = n;
+		if (n > 0) {
+			runs_[0] = new route_run[1];
+			memset((char *)runs_[0], 0, sizeof(route_run));
+			nruns_[0] = 1;
+		}
+	} else {
+		route_ = new route_entry[n * n];
+		memset((char *)route_, 0, n * n * sizeof(route_[0]));
+	}
 
-	/* do for all the sources */
-	int k;
-	for (k = 1; k < n; ++k) {
-		int v;
-		for (v = 0; v < n; v++)
-			parent[v] = v;
+	/*
+	 * The sources are independent: each writes only its own row, so
+	 * they can be shared out among threads.
+	 */
+	int nthreads = 1;
+#ifdef HAVE_LIBPTHREAD
+	nthreads = threads_;
+	if (nthreads <= 0)
+		nthreads = sysconf(_SC_NPROCESSORS_ONLN);
+	if (nthreads > n - 1)
+		nthreads = n - 1;
+	if (nthreads < 1)
+		nthreads = 1;
+#endif
+	RouteStripe* stripes = new RouteStripe[nthreads];
+	for (int t = 0; t < nthreads; ++t) {
+		stripes[t].rl = this;
+		stripes[t].first = t;
+		stripes[t].step = nthreads;
+	}
+#ifdef HAVE_LIBPTHREAD
+	pthread_t* tids = new pthread_t[nthreads];
+	int* started = new int[nthreads];
+	for (int t = 1; t < nthreads; ++t)
+		started[t] = pthread_create(&tids[t], 0, compute_stripe,
+					    &stripes[t]) == 0;
+	compute_stripe(&stripes[0]);
+	for (int t = 1; t < nthreads; ++t) {
+		if (started[t])
+			pthread_join(tids[t], 0);
+		else
+			compute_stripe(&stripes[t]);
+	}
+	delete[] started;
+	delete[] tids;
+#else
+	compute_stripe(&stripes[0]);
+#endif
+	delete[] stripes;
+}
+
+/*
+ * Forget the routes, to compute those of each source when it is first
+ * looked up.  The routes are kept as runs, whatever compress_ says.
+ */
+void RouteLogic::lazy_routes()
+{
+	int n = size_;
+	delete[] route_;
+	route_ = 0;
+	free_runs();
+	runs_ = new route_run*[n];
+	nruns_ = new int[n];
+	runsize_ = n;
+	memset((char *)runs_, 0, n * sizeof(runs_[0]));
+}
+
+/*
+ * Routes from source k.  Whichever way the adjacency is kept, the next
+ * hops are the ones the original matrix version picked.
+ */
+void RouteLogic::compute_source(int k, RouteScratch& sc)
+{
+	int n = size_;
+	route_entry* row;
+	if (runs_ != 0) {
+		row = sc.row;
+		memset((char *)row, 0, n * sizeof(row[0]));
+	} else
+		row = &route_[INDEX(k, 0, n)];
+
+	if (arc_head_ != 0)
+		sparse_source(k, sc, row);
+	else
+		dense_source(k, sc, row);
+	/*
+	 * The route to yourself is yourself.
+	 */
+	row[k].next_hop = k;
+	row[k].entry = 0; // This should not matter
+
+	if (runs_ == 0)
+		return;
+	int v, nr = 1;
+	for (v = 1; v < n; ++v)
+		if (row[v].next_hop != row[v - 1].next_hop ||
+		    row[v].entry != row[v - 1].entry)
+			nr++;
+	route_run* r = new route_run[nr];
+	nr = 0;
+	for (v = 0; v < n; ++v)
+		if (v == 0 || row[v].next_hop != row[v - 1].next_hop ||
+		    row[v].entry != row[v - 1].entry) {
+			r[nr].dst = v;
+			r[nr].next_hop = row[v].next_hop;
+			r[nr].entry = row[v].entry;
+			nr++;
+		}
+	runs_[k] = r;
+	nruns_[k] = nr;
+}
+
+void RouteLogic::dense_source(int k, RouteScratch& sc, route_entry* row)
+{
+	int n = size_;
+	int* parent = sc.parent;
+	double* hopcnt = sc.hopcnt;
+#define ADJ(i, j) adj_[INDEX(i, j, size_)].cost
+#define ADJ_ENTRY(i, j) adj_[INDEX(i, j, size_)].entry
+	int v;
+	for (v = 0; v < n; v++)
+		parent[v] = v;
 	
-		/* set the route for all neighbours first */
-		for (v = 1; v < n; ++v) {
-			if (parent[v] != k) {
-				hopcnt[v] = ADJ(k, v);
-				if (hopcnt[v] != INFINITY) {
-					ROUTE(k, v) = v;
-					ROUTE_ENTRY(k, v) = ADJ_ENTRY(k, v);
-				}
+	/* set the route for all neighbours first */
+	for (v = 1; v < n; ++v) {
+		if (parent[v] != k) {
+			hopcnt[v] = ADJ(k, v);
+			if (hopcnt[v] != INFINITY) {
+				row[v].next_hop = v;
+				row[v].entry = ADJ_ENTRY(k, v);
 			}
 		}
-		for (v = 1; v < n; ++v) {
-			/*
-			 * w is the node that is the nearest to the subtree
-			 * that has been routed
-			 */
-			int o = 0;
-			/* XXX */
-			hopcnt[0] = INFINITY;
-			int w;
-			for (w = 1; w < n; w++)
-				if (parent[w] != k && hopcnt[w] < hopcnt[o])
-					o = w;
-			parent[o] = k;
-			/*
-			 * update distance counts for the nodes that are
-			 * adjacent to o
-			 */
-			if (o == 0)
-				continue;
-			for (w = 1; w < n; w++) {
-				if (parent[w] != k &&
-				    hopcnt[o] + ADJ(o, w) < hopcnt[w]) {
-					ROUTE(k, w) = ROUTE(k, o);
-					ROUTE_ENTRY(k, w) = 
-					    ROUTE_ENTRY(k, o);
-					hopcnt[w] = hopcnt[o] + ADJ(o, w);
-				}
+	}
+	for (v = 1; v < n; ++v) {
+		/*
+		 * w is the node that is the nearest to the subtree
+		 * that has been routed
+		 */
+		int o = 0;
+		/* XXX */
+		hopcnt[0] = INFINITY;
+		int w;
+		for (w = 1; w < n; w++)
+			if (parent[w] != k && hopcnt[w] < hopcnt[o])
+				o = w;
+		parent[o] = k;
+		/*
+		 * update distance counts for the nodes that are
+		 * adjacent to o
+		 */
+		if (o == 0)
+			continue;
+		for (w = 1; w < n; w++) {
+			if (parent[w] != k &&
+			    hopcnt[o] + ADJ(o, w) < hopcnt[w]) {
+				row[w] = row[o];
+				hopcnt[w] = hopcnt[o] + ADJ(o, w);
 			}
 		}
 	}
-	/*
-	 * The route to yourself is yourself.
-	 */
-	for (k = 1; k < n; ++k) {
-		ROUTE(k, k) = k;
-		ROUTE_ENTRY(k, k) = 0; // This should not matter
+#undef ADJ
+#undef ADJ_ENTRY
+}
+
+/*
+ * dense_source() with a heap.  The heap hands out nodes in the order
+ * the matrix scan picks them (least cost, then lowest number) and the
+ * updates are the same comparisons, so ties fall the same way.  Links
+ * of cost INFINITY or more are down here as there.
+ */
+void RouteLogic::sparse_source(int k, RouteScratch& sc, route_entry* row)
+{
+	int n = size_;
+	int* done = sc.parent;
+	double* hopcnt = sc.hopcnt;
+	int v, a;
+	for (v = 0; v < n; v++) {
+		hopcnt[v] = INFINITY;
+		done[v] = 0;
 	}
+	done[k] = 1;
+	sc.nheap = 0;
 
-	delete[] hopcnt;
-	delete[] parent;
+	for (a = arc_head_[k]; a >= 0; a = arcs_[a].next) {
+		v = arcs_[a].dst;
+		if (v == k)
+			continue;
+		hopcnt[v] = arcs_[a].cost;
+		if (hopcnt[v] != INFINITY) {
+			row[v].next_hop = v;
+			row[v].entry = arcs_[a].entry;
+		}
+		if (hopcnt[v] < INFINITY)
+			sc.push(hopcnt[v], v);
+	}
+	while (sc.nheap > 0) {
+		RouteHeapItem it = sc.pop();
+		int o = it.v;
+		if (done[o] || it.d != hopcnt[o])
+			continue;	// stale
+		done[o] = 1;
+		for (a = arc_head_[o]; a >= 0; a = arcs_[a].next) {
+			int w = arcs_[a].dst;
+			if (!done[w] && hopcnt[o] + arcs_[a].cost < hopcnt[w]) {
+				row[w] = row[o];
+				hopcnt[w] = hopcnt[o] + arcs_[a].cost;
+				if (hopcnt[w] < INFINITY)
+					sc.push(hopcnt[w], w);
+			}
+		}
+	}
 }
 
 /* hierarchical routing support */
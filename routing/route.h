@@ -65,6 +65,27 @@ public:
 	void* entry;
 };
 
+/* a link in the adjacency lists used instead of adj_ when sparse_ is set */
+struct route_arc {
+	int dst;
+	double cost;
+	void* entry;
+	int next;		/* next link from the same node, -1 at the end */
+};
+
+/*
+ * With compress_ set, the routes of a source are kept as runs of
+ * consecutive destinations that share a next hop.
+ */
+struct route_run {
+	int dst;		/* first destination of the run */
+	int next_hop;
+	void* entry;
+};
+
+struct RouteScratch;
+class TopoPartition;
+
 class RouteLogic : public TclObject {
 public:
 	RouteLogic();
@@ -92,6 +113,40 @@ protected:
 	int size_,
 		maxnode_;
 
+	/**** Large topologies ****/
+
+	inline int sparse() const {
+		return (arc_head_ != 0 || (adj_ == 0 && sparse_));
+	}
+	int next_hop(int src, int dst);
+	void sparse_check(int n);
+	route_arc* arc(int src, int dst, int create);
+	void free_runs();
+	void lazy_routes();
+	void compute_source(int k, RouteScratch&);
+	void dense_source(int k, RouteScratch&, route_entry* row);
+	void sparse_source(int k, RouteScratch&, route_entry* row);
+	static void* compute_stripe(void*);
+
+	int sparse_;		/* adjacency lists instead of adj_ */
+	int compress_;		/* routes as runs instead of route_ */
+	int threads_;		/* sources computed in parallel */
+	route_arc *arcs_;
+	int narcs_, maxarcs_;
+	int *arc_head_;		/* first link from each node */
+	route_run **runs_;	/* runs of each source (0 until needed
+				   with lazy_routes()) */
+	int *nruns_;
+	int runsize_;		/* sources in runs_ */
+
+	/**** Partitioning for Scheduler/Parallel ****/
+
+	int part_command(int argc, const char*const* argv);
+
+	TopoPartition *part_;	/* 0 until the first "part-" command */
+	double part_imbalance_;	/* parts may exceed their share by this */
+	double part_lookahead_;	/* least delay of a cut link, 0 = largest */
+
 	/**** Hierarchical routing support ****/
 
 	void hier_check(int index);
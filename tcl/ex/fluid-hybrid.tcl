@@ -0,0 +1,133 @@
+#
+# fluid-hybrid.tcl -- a few packet-level TCP flows across a dumbbell
+# loaded by many long-lived background TCP flows, with the background
+# simulated as packets or as fluid (see asim/fluid.h).
+#
+# Usage:
+#   ns fluid-hybrid.tcl packet|fluid ?nbg? ?queue? ?seconds?
+#	nbg background flows (default 200) over a 10Mb bottleneck whose
+#	queue is DropTail (default) or RED; 4 foreground flows
+#   ns fluid-hybrid.tcl compare ?nbg? ?queue? ?seconds?
+#	run both (each in a fresh ns process) and print a table
+#
+# "compare" shows how close the fluid background brings the foreground
+# throughput and the bottleneck loss to the packet-level run, and what
+# it saves in packets and run time.
+#
+
+proc run { nbg qtype } {
+	# the "at" below runs at global level
+	global ns tcp ack0 qmon nfg secs warm mode cls t0
+	set ns [new Simulator]
+	Agent/TCP set window_ 64
+	Agent/TCP set packetSize_ 1000
+
+	set r1 [$ns node]
+	set r2 [$ns node]
+	$ns duplex-link $r1 $r2 10Mb 20ms $qtype
+	$ns queue-limit $r1 $r2 100
+
+	# foreground: 4 flows on their own access links
+	set nfg 4
+	for { set i 0 } { $i < $nfg } { incr i } {
+		set s [$ns node]
+		set d [$ns node]
+		$ns duplex-link $s $r1 100Mb [expr 2 + 3 * $i]ms DropTail
+		$ns duplex-link $r2 $d 100Mb 2ms DropTail
+		set tcp($i) [$ns create-connection TCP/Sack1 $s TCPSink/Sack1 $d $i]
+		set ftp [$tcp($i) attach-app FTP]
+		$ns at [expr 0.1 * $i] "$ftp start"
+	}
+
+	# background: nbg flows between one pair of hosts
+	set bs [$ns node]
+	set bd [$ns node]
+	$ns duplex-link $bs $r1 1000Mb 5ms DropTail
+	$ns duplex-link $r2 $bd 1000Mb 5ms DropTail
+	if { $mode == "fluid" } {
+		set cls [$ns background-tcp $bs $bd $nbg 1000]
+	} else {
+		for { set i 0 } { $i < $nbg } { incr i } {
+			set btcp [$ns create-connection TCP/Reno $bs TCPSink \
+			    $bd [expr 1000 + $i]]
+			set ftp [$btcp attach-app FTP]
+			$ns at [expr 0.01 * $i] "$ftp start"
+		}
+	}
+
+	# measure the second half of the run
+	set warm [expr $secs / 2.0]
+	set qmon [$ns monitor-queue $r1 $r2 ""]
+	$ns at $warm "$qmon reset"
+	for { set i 0 } { $i < $nfg } { incr i } {
+		$ns at $warm "set ack0($i) \[$tcp($i) set ack_\]"
+	}
+
+	$ns at $secs {
+		set fg 0
+		for { set i 0 } { $i < $nfg } { incr i } {
+			set fg [expr $fg + [$tcp($i) set ack_] - $ack0($i)]
+		}
+		set span [expr $secs - $warm]
+		set arr [$qmon set parrivals_]
+		set loss 0
+		if { $arr > 0 } {
+			set loss [expr double([$qmon set pdrops_]) / $arr]
+		}
+		set res [list \
+		    fg-mbps [expr $fg * 8000.0 / $span / 1e6] \
+		    bottleneck-pkts [$qmon set pdepartures_] \
+		    loss $loss \
+		    seconds [expr ([clock clicks -milliseconds] - $t0) / 1000.0]]
+		if { $mode == "fluid" } {
+			set fm [$ns fluid-model]
+			lappend res bg-mbps [expr [$fm rate $cls] * 8 / 1e6]
+		}
+		puts $res
+		exit 0
+	}
+	set t0 [clock clicks -milliseconds]
+	$ns run
+}
+
+proc usage {} {
+	global argv0
+	puts stderr "usage: ns $argv0 packet|fluid|compare ?nbg? ?queue? ?seconds?"
+	exit 1
+}
+
+if { $argc < 1 } {
+	usage
+}
+set mode [lindex $argv 0]
+set nbg 200
+set qtype DropTail
+set secs 60
+if { $argc > 1 } { set nbg [lindex $argv 1] }
+if { $argc > 2 } { set qtype [lindex $argv 2] }
+if { $argc > 3 } { set secs [lindex $argv 3] }
+
+switch -- $mode {
+	packet -
+	fluid {
+		run $nbg $qtype
+	}
+	compare {
+		puts [format "%-10s %10s %16s %10s %10s" \
+		    background fg-mbps bottleneck-pkts loss seconds]
+		foreach m { packet fluid } {
+			if [catch { exec [info nameofexecutable] [info script] \
+			    $m $nbg $qtype $secs } res] {
+				puts [format "%-10s (failed: %s)" $m $res]
+				continue
+			}
+			array set r $res
+			puts [format "%-10s %10.3f %16d %10.4f %10.2f" $m \
+			    $r(fg-mbps) $r(bottleneck-pkts) $r(loss) \
+			    $r(seconds)]
+		}
+	}
+	default {
+		usage
+	}
+}
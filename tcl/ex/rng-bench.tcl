@@ -0,0 +1,66 @@
+#
+# rng-bench.tcl -- per-call and block throughput of the random number
+# streams (see tools/rng.h and tools/rng-bench.cc).
+#
+# Usage:
+#   ns rng-bench.tcl all ?count?
+#	draw <count> (default 50000000) numbers each way, print a table,
+#	and check that blocks give the numbers one at a time would
+#   ns rng-bench.tcl run call|buffered next|exponential|block <count>
+#   ns rng-bench.tcl check <count> ?seed?
+#
+# "call" streams generate one number per call, as before blocks;
+# "buffered" streams generate RNG_BLOCK at a time (the default).
+#
+
+proc run { kind how count } {
+	set bench [new RNGBench]
+	set rng [new RNG]
+	if { $kind == "call" } {
+		$rng block 0
+	}
+	return [$bench run $rng $how $count]
+}
+
+proc usage {} {
+	global argv0
+	puts stderr "usage: ns $argv0 all ?count?"
+	puts stderr "       ns $argv0 run call|buffered next|exponential|block <count>"
+	puts stderr "       ns $argv0 check <count> ?seed?"
+	exit 1
+}
+
+if { $argc < 1 } {
+	usage
+}
+switch -- [lindex $argv 0] {
+	all {
+		set count 50000000
+		if { $argc > 1 } { set count [lindex $argv 1] }
+		puts [format "%-10s %-12s %12s %10s %8s" \
+		    stream draw values/s seconds ns]
+		foreach t { {call next} {buffered next} {buffered block} \
+		    {call exponential} {buffered exponential} } {
+			array set r [run [lindex $t 0] [lindex $t 1] $count]
+			puts [format "%-10s %-12s %12.0f %10.3f %8.2f" \
+			    [lindex $t 0] [lindex $t 1] $r(rate) $r(seconds) \
+			    $r(ns)]
+		}
+		set bench [new RNGBench]
+		array set r [$bench check [expr $count / 10]]
+		puts "check: $r(values) values, $r(mismatches) mismatches"
+	}
+	run {
+		if { $argc != 4 } { usage }
+		puts [eval run [lrange $argv 1 end]]
+	}
+	check {
+		if { $argc < 2 } { usage }
+		set bench [new RNGBench]
+		puts [eval $bench $argv]
+	}
+	default {
+		usage
+	}
+}
+exit 0
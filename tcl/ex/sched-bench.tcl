@@ -0,0 +1,101 @@
+#
+# sched-bench.tcl -- compare the event schedulers on recorded or
+# synthetic event streams (see common/sched-log.h and sched-bench.cc).
+#
+# To record the event stream of an existing simulation, add
+#	$ns record-scheduler sched.log
+# right after [new Simulator] and run it as usual.
+#
+# Usage:
+#   ns sched-bench.tcl all ?n? ?ops?
+#	generate the exp, bimodal and tcp hold workloads with <n> pending
+#	events and <ops> dequeues, and compare every scheduler on them
+#   ns sched-bench.tcl compare <log> ?scheduler ...?
+#	replay <log> against each scheduler (each in a fresh ns process,
+#	so that peak memory is per scheduler) and print a table
+#   ns sched-bench.tcl generate <model> <log> <n> <ops> ?seed?
+#   ns sched-bench.tcl replay <scheduler> <log>
+#
+# Scheduler parameters can be varied from the command line of "compare"
+# and "replay", e.g. "Calendar:adjust_new_width_interval_=0".
+#
+
+set schedulers { List Heap Calendar Splay Map Ladder }
+
+proc new-scheduler { spec } {
+	set args [split $spec ":"]
+	set type [lindex $args 0]
+	foreach a [lrange $args 1 end] {
+		set kv [split $a "="]
+		Scheduler/$type set [lindex $kv 0] [lindex $kv 1]
+	}
+	return [new Scheduler/$type]
+}
+
+proc replay { spec log } {
+	set bench [new SchedulerBench]
+	puts [$bench replay [new-scheduler $spec] $log]
+}
+
+proc compare { log specs } {
+	puts "\n$log:"
+	puts [format "%-32s %12s %10s %10s %10s %5s" \
+	    scheduler events/s seconds cancel-ns peak-kb bad]
+	foreach spec $specs {
+		if [catch { exec [info nameofexecutable] [info script] \
+		    replay $spec $log } res] {
+			puts [format "%-32s (failed: %s)" $spec $res]
+			continue
+		}
+		array set r $res
+		puts [format "%-32s %12.0f %10.3f %10.1f %10d %5d" $spec \
+		    $r(rate) $r(seconds) $r(cancel-ns) $r(peak-kb) \
+		    $r(mismatches)]
+	}
+}
+
+proc usage {} {
+	global argv0
+	puts stderr "usage: ns $argv0 all ?n? ?ops?"
+	puts stderr "       ns $argv0 compare <log> ?scheduler ...?"
+	puts stderr "       ns $argv0 generate <model> <log> <n> <ops> ?seed?"
+	puts stderr "       ns $argv0 replay <scheduler> <log>"
+	exit 1
+}
+
+if { $argc < 1 } {
+	usage
+}
+switch -- [lindex $argv 0] {
+	all {
+		set n 10000
+		set ops 1000000
+		if { $argc > 1 } { set n [lindex $argv 1] }
+		if { $argc > 2 } { set ops [lindex $argv 2] }
+		set bench [new SchedulerBench]
+		foreach model { exp bimodal tcp } {
+			set log sched-$model.log
+			$bench generate $model $log $n $ops
+			compare $log $schedulers
+		}
+	}
+	compare {
+		if { $argc < 2 } { usage }
+		set specs [lrange $argv 2 end]
+		if { $specs == "" } { set specs $schedulers }
+		compare [lindex $argv 1] $specs
+	}
+	generate {
+		if { $argc < 5 } { usage }
+		set bench [new SchedulerBench]
+		eval $bench $argv
+	}
+	replay {
+		if { $argc != 3 } { usage }
+		replay [lindex $argv 1] [lindex $argv 2]
+	}
+	default {
+		usage
+	}
+}
+exit 0
@@ -0,0 +1,90 @@
+#
+# scoreboard-bench.tcl -- compare the SACK scoreboards on recorded or
+# synthetic ACK streams (see tcp/scoreboard-log.h and scoreboard-bench.cc).
+#
+# To record the scoreboard calls of a Fack or Sack1 sender in an
+# existing simulation, add
+#	$tcp record-scoreboard scoreboard.log
+# right after the agent is created and run it as usual.
+#
+# Usage:
+#   ns scoreboard-bench.tcl all ?acks?
+#	generate workloads for windows of 1000 to 50000 packets and
+#	compare every scoreboard on them
+#   ns scoreboard-bench.tcl compare <log> ?kind ...?
+#	replay <log> against each kind of scoreboard (each in a fresh ns
+#	process, so that peak memory is per scoreboard) and print a table
+#   ns scoreboard-bench.tcl generate <log> <window> <loss> <acks> ?seed?
+#   ns scoreboard-bench.tcl replay <kind> <log>
+#
+# Only array and bitmap must replay without mismatches; the rq kinds
+# answer by their own rules.
+#
+
+set kinds { array bitmap rq rq-index }
+
+proc replay { kind log } {
+	set bench [new ScoreBoardBench]
+	puts [$bench replay $kind $log]
+}
+
+proc compare { log kinds } {
+	puts "\n$log:"
+	puts [format "%-12s %12s %10s %10s %10s %6s" \
+	    scoreboard calls/s seconds ack-ns peak-kb bad]
+	foreach kind $kinds {
+		if [catch { exec [info nameofexecutable] [info script] \
+		    replay $kind $log } res] {
+			puts [format "%-12s (failed: %s)" $kind $res]
+			continue
+		}
+		array set r $res
+		puts [format "%-12s %12.0f %10.3f %10.1f %10d %6d" $kind \
+		    $r(rate) $r(seconds) $r(ack-ns) $r(peak-kb) \
+		    $r(mismatches)]
+	}
+}
+
+proc usage {} {
+	global argv0
+	puts stderr "usage: ns $argv0 all ?acks?"
+	puts stderr "       ns $argv0 compare <log> ?kind ...?"
+	puts stderr "       ns $argv0 generate <log> <window> <loss> <acks> ?seed?"
+	puts stderr "       ns $argv0 replay <kind> <log>"
+	exit 1
+}
+
+if { $argc < 1 } {
+	usage
+}
+switch -- [lindex $argv 0] {
+	all {
+		set acks 20000
+		if { $argc > 1 } { set acks [lindex $argv 1] }
+		set bench [new ScoreBoardBench]
+		foreach window { 1000 10000 50000 } {
+			set log scoreboard-$window.log
+			$bench generate $log $window 0.01 $acks
+			compare $log $kinds
+		}
+	}
+	compare {
+		if { $argc < 2 } { usage }
+		set ks [lrange $argv 2 end]
+		if { $ks == "" } { set ks $kinds }
+		compare [lindex $argv 1] $ks
+	}
+	generate {
+		if { $argc < 5 } { usage }
+		set bench [new ScoreBoardBench]
+		eval $bench $argv
+	}
+	replay {
+		if { $argc != 3 } { usage }
+		replay [lindex $argv 1] [lindex $argv 2]
+	}
+	default {
+		usage
+	}
+}
+exit 0
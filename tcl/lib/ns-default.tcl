@@ -45,6 +45,7 @@
 # Debojyoti added this
 Simulator set useasim_ 1
 Asim set debug_ false
+FluidModel set step_ 0.01
 
 set MAXSEQ 1073741824
 # Increased Floating Point Precision
@@ -70,6 +71,8 @@ Scheduler/RealTime set maxslop_ 0.010; # max allowed slop b4 error (sec)
 
 Scheduler/Calendar set adjust_new_width_interval_ 10;	# the interval (in unit of resize times) we recalculate bin width. 0 means disable dynamic adjustment
 Scheduler/Calendar set min_bin_width_ 1e-18;		# the lower bound for the bin_width
+Scheduler/Ladder set bucket_threshold_ 50;	# buckets larger than this are split into a new rung
+Scheduler/Parallel set threads_ 1;		# threads running the LPs (needs pthreads)
 
 #
 # Queues and associated
@@ -99,6 +102,7 @@ Queue/DropTail set drop_front_ false
 Queue/DropTail set summarystats_ false
 Queue/DropTail set queue_in_bytes_ false
 Queue/DropTail set mean_pktsize_ 500
+Queue/DropTail set ring_ false;	# packets in an array ring (PacketQueue/Ring)
 
 Queue/DropTail/PriQueue set Prefer_Routing_Protocols    1
 
@@ -144,6 +148,7 @@ Queue/RED set gentle_ true
 Queue/RED set drop_tail_ true
 Queue/RED set drop_front_ false
 Queue/RED set drop_rand_ false
+Queue/RED set ring_ false
 Queue/RED set doubleq_ false
 Queue/RED set ns1_compat_ false
 Queue/RED set dqthresh_ 50
@@ -358,6 +363,8 @@ DelayLink set debug_ false
 DelayLink set avoidReordering_ false ;	# Added 3/27/2003.
 					# Set to true to avoid reordering when
 					#   changing link bandwidth or delay.
+# Set to true to schedule only the head of the packets in transit
+DelayLink set inflightRing_ false
 DynamicLink set status_ 1
 DynamicLink set debug_ false
 
@@ -617,6 +624,17 @@ Simulator set TaggedTrace_ OFF
 # this can be set to use custom Routing Agents implemented within dynamic libraries
 Simulator set rtAgentFunction_ ""
 
+# static routes: adjacency lists instead of an N x N matrix, next hops
+# kept as runs of destinations, and how many threads compute them
+# (0 = one per processor)
+RouteLogic set sparse_ 0
+RouteLogic set compress_ 0
+RouteLogic set threads_ 1
+# auto-partition: parts may exceed their share of the nodes by 5%; links
+# shorter than part_lookahead_ are never cut (0: as long as possible)
+RouteLogic set part_imbalance_ 0.05
+RouteLogic set part_lookahead_ 0
+
 SessionHelper set rc_ 0                      ;# just to eliminate warnings
 SessionHelper set debug_ false
 
@@ -657,8 +675,17 @@ GAFPartner set debug_ false
 
 Mac set debug_ false
 ARPTable set debug_ false
+# find the receivers of a transmission with a grid instead of the
+# X-sorted node list (same receivers, much faster with many nodes)
+Channel/WirelessChannel set neighbor_grid_ 0
+# work out the receive power at all candidates when a packet is sent,
+# and only copy it to the interfaces that can sense it
+Channel/WirelessChannel set batch_pr_ 0
 ARPTable set avoidReordering_ false ; #not used
 God set debug_ false
+# keep the hop counts up to date link by link rather than recomputing
+# them all (see God::UpdateHops)
+God set incremental_ 0
 
 Mac/Tdma set slot_packet_len_	1500
 Mac/Tdma set max_node_num_	64
@@ -1029,6 +1056,8 @@ Agent/TCP set nam_tracevar_ false
 
 Agent/TCP/Fack set ss-div4_ false
 Agent/TCP/Fack set rampdown_ false
+Agent/TCP/Fack set sb_bitmap_ false ;	# bit vector scoreboard, for large windows
+Agent/TCP/Sack1 set sb_index_ false ;	# indexed scoreboard, for many holes
 
 Agent/TCP/Reno/XCP set timestamps_ true
 Agent/TCP/FullTcp/Newreno/XCP set timestamps_ true
@@ -1230,6 +1259,7 @@ if [TclObject is-class Agent/TCP/FullTcp] {
         Agent/TCP/FullTcp set ecn_syn_ false; # Make SYN/ACK packet ECN-Capable?
         Agent/TCP/FullTcp set ecn_syn_wait_ 0; # Wait after marked SYN/ACK? 
         Agent/TCP/FullTcp set debug_ false;  # Added Sept. 16, 2007.
+	Agent/TCP/FullTcp set rq_index_ false; # index the reassembly queue?
 
 	Agent/TCP/FullTcp/Newreno set recov_maxburst_ 2; # max burst dur recov
 
@@ -1382,6 +1412,10 @@ Agent/LDP set trace_ldp_ 0
 
 # Default to NOT nix-vector routing
 Simulator set nix-routing 0
+# nor lazy flat routing
+Simulator set lazy-routing 0
+# nor links that skip the virtual call between queue, delay and TTL checker
+Simulator set fast-links 0
 #Node/NixNode set id_ 0
 
 #Routing Module variable setting
@@ -0,0 +1,72 @@
+#
+# ns-fluid.tcl
+#
+# Long-lived background TCP flows as fluid (see asim/fluid.h).
+#
+#	$ns background-tcp $src $dst ?nflows? ?size?
+#
+# adds nflows bulk TCP flows of size-byte packets from node src to
+# node dst.  They make no packets: "$ns run" hands them to a
+# FluidModel, which solves for their windows along the route that
+# unicast routing gives and loads the queue and link of every hop with
+# their backlog, so that the packet-level flows sharing those links
+# see the queueing delay and the losses.  Windows are capped at
+# "Agent/TCP set window_".  Calls before "$ns run" only.
+#
+#	[$ns fluid-model] rate|window|rtt <class>
+#	[$ns fluid-model] link-stats <queue>
+#	[$ns fluid-model] stats
+#
+# read the model back, <class> being what background-tcp returned.
+#
+
+Simulator instproc background-tcp { src dst {nflows 1} {size 1000} } {
+	$self instvar fluidflows_
+	lappend fluidflows_ [list $src $dst $nflows $size]
+	return [expr [llength $fluidflows_] - 1]
+}
+
+Simulator instproc fluid-model {} {
+	$self instvar fluid_
+	if ![info exists fluid_] {
+		set fluid_ [new FluidModel]
+	}
+	return $fluid_
+}
+
+Simulator instproc fluid-link { l } {
+	set fm [$self fluid-model]
+	set q [$l queue]
+	$fm link $q [$l link]
+	if [$q info class Queue/RED] {
+		# the parameters as the queue's reset left them
+		$fm red $q [$q set thresh_] [$q set maxthresh_] \
+		    [expr 1.0 / [$q set linterm_]] \
+		    [expr [$q set gentle_] ? 1 : 0] \
+		    [$q set q_weight_]
+	}
+}
+
+Simulator instproc fluid-configure {} {
+	$self instvar fluidflows_ link_
+	set r [$self get-routelogic]
+	set fm [$self fluid-model]
+	set wmax [Agent/TCP set window_]
+	foreach f $fluidflows_ {
+		set s [[lindex $f 0] id]
+		set d [[lindex $f 1] id]
+		set hops ""
+		while { $s != $d } {
+			set nh [$r lookup $s $d]
+			if { $nh < 0 || ![info exists link_($s:$nh)] } {
+				error "background-tcp: no route from $s to $d"
+			}
+			set l $link_($s:$nh)
+			$self fluid-link $l
+			lappend hops [$l queue] [$l link]
+			set s $nh
+		}
+		eval $fm flow [lindex $f 2] [lindex $f 3] $wmax $hops
+	}
+	$fm start
+}
@@ -225,6 +225,7 @@ source ../packmime/packmime.tcl
 }
 
 source ns-qsnode.tcl
+source ns-fluid.tcl
 
 # Obsolete modules
 #source ns-wireless-mip.tcl
@@ -277,6 +278,37 @@ Simulator instproc use-scheduler type {
 	$scheduler_ now
 }
 
+#
+# Run on a scheduler of the given type while logging every insert,
+# cancel and dequeue to file (see common/sched-log.h); the log can be
+# replayed against other schedulers with tcl/ex/sched-bench.tcl.
+# Like use-scheduler, this must come before anything is scheduled.
+#
+Simulator instproc record-scheduler { file { type Calendar } } {
+	$self instvar scheduler_
+	$self use-scheduler $type
+	set target $scheduler_
+	set scheduler_ [new Scheduler/Record]
+	$scheduler_ target $target
+	$scheduler_ open $file
+}
+
+#
+# Load a node-movement scenario (setdest output, or its binary form from
+# indep-utils/cmu-scen-gen/scen2bin.tcl) natively rather than sourcing
+# it: see mobile/mobility-scen.h.  Like the sourced file, this moves the
+# nodes of the global node_ array, so call it once they are created.
+#
+Simulator instproc load-mobility { file } {
+	global node_
+	set scen [new MobilityScenario]
+	foreach i [array names node_] {
+		$scen node $i $node_($i)
+	}
+	$scen load $file
+	return $scen
+}
+
 Simulator instproc delay_parse { spec } {
 	return [time_parse $spec]
 }
@@ -911,6 +943,44 @@ Simulator instproc cancel args {
 	return [eval $scheduler_ cancel $args]
 }
 
+#
+# Schedule many calls at once: <calls> is a list of
+# {<time> <object> <method> ?<arg> ...?}, and the file given to
+# at-file has one such list per line.  See common/at-batch.h.
+#
+Simulator instproc at-batch { calls } {
+	$self instvar scheduler_
+	return [$scheduler_ at-batch $calls]
+}
+
+Simulator instproc at-file { file } {
+	$self instvar scheduler_
+	return [$scheduler_ at-file $file]
+}
+
+#
+# Whether "$obj $method" reaches the C++ command() of obj, that is,
+# neither obj nor its classes define method in OTcl, so that a batched
+# call may skip the interpreter.
+#
+Scheduler instproc at-native { obj method } {
+	$self instvar native_
+	if [llength [$obj info commands $method]] {
+		return 0
+	}
+	set c [$obj info class]
+	if ![info exists native_($c,$method)] {
+		set native_($c,$method) 1
+		foreach k [concat $c [$c info heritage]] {
+			if [llength [$k info instcommands $method]] {
+				set native_($c,$method) 0
+				break
+			}
+		}
+	}
+	return $native_($c,$method)
+}
+
 Simulator instproc after {ival args} {
         eval $self at [expr [$self now] + $ival] $args
 }
@@ -970,7 +1040,7 @@ Simulator instproc run {} {
 	$self check-node-num
 	$self rtmodel-configure			;# in case there are any
 	[$self get-routelogic] configure
-	$self instvar scheduler_ Node_ link_ started_ 
+	$self instvar scheduler_ Node_ link_ started_ fluidflows_
 	
 	set started_ 1
 	
@@ -994,16 +1064,208 @@ Simulator instproc run {} {
 		set q [$link_($qn) queue]
 		$q reset
 	}
+	if [Simulator set fast-links] {
+		$self fast-links
+	}
+	if [info exists fluidflows_] {
+		$self fluid-configure
+	}
+
+	if { [$scheduler_ info class] == "Scheduler/Parallel" } {
+		$self parallel-configure
+	}
 
 	# Do all nam-related initialization here
 	$self init-nam
 
+	# Now that every object is in place, shrink the packet format
+	# if auto-packet-headers asked for it
+	$self prune-packet-headers
+
 	# NIXVECTOR xxx?
 	# global simstart
 	# set simstart [clock seconds]
 	return [$scheduler_ run]
 }
 
+#
+# Set up the direct hand-offs within every link (see Link fast-path);
+# "run" does this if "Simulator set fast-links 1", but links created
+# or rewired while the simulation runs need another call.
+#
+Simulator instproc fast-links {} {
+	$self instvar link_
+	set n 0
+	foreach l [array names link_] {
+		incr n [$link_($l) fast-path]
+	}
+	return $n
+}
+
+#
+# Profile the calls from OTcl into C++ command() procedures.  A method
+# an object does not define in OTcl lands in "TclObject unknown", which
+# passes it on to command(); "profile-commands on" wraps that to count
+# the calls to every class and subcommand and add up their time
+# (inclusive, in microseconds, Tcl overhead and all).
+#	$ns profile-commands on|off|reset
+#	$ns profile-commands report ?n?
+# prints the n (default 20) most called ones, whose strcmp() chains
+# are worth a CommandTable (see common/cmd-table.h) or whose calls are
+# worth moving into C++ altogether.
+#
+Simulator instproc profile-commands { op {n 20} } {
+	global cmdprof_body_ cmdprof_calls_ cmdprof_usec_
+	switch -- $op {
+	on {
+		if [info exists cmdprof_body_] {
+			return
+		}
+		set cmdprof_body_ [TclObject info instbody unknown]
+		TclObject instproc unknown args {
+			global cmdprof_body_ cmdprof_calls_ cmdprof_usec_
+			set t0 [clock clicks -microseconds]
+			set code [catch { eval $cmdprof_body_ } ret]
+			set dt [expr [clock clicks -microseconds] - $t0]
+			set key "[$self info class] [lindex $args 0]"
+			if [info exists cmdprof_calls_($key)] {
+				incr cmdprof_calls_($key)
+				set cmdprof_usec_($key) \
+				    [expr $cmdprof_usec_($key) + $dt]
+			} else {
+				set cmdprof_calls_($key) 1
+				set cmdprof_usec_($key) $dt
+			}
+			if { $code == 1 } {
+				global errorInfo errorCode
+				return -code error -errorinfo $errorInfo \
+				    -errorcode $errorCode $ret
+			}
+			return $ret
+		}
+	}
+	off {
+		if [info exists cmdprof_body_] {
+			TclObject instproc unknown args $cmdprof_body_
+			unset cmdprof_body_
+		}
+	}
+	reset {
+		catch { unset cmdprof_calls_ }
+		catch { unset cmdprof_usec_ }
+	}
+	report {
+		set l {}
+		foreach key [array names cmdprof_calls_] {
+			lappend l [list $key $cmdprof_calls_($key) \
+			    $cmdprof_usec_($key)]
+		}
+		puts [format "%-40s %10s %12s %9s" command calls usec \
+		    usec/call]
+		foreach e [lrange [lsort -integer -decreasing -index 1 $l] \
+		    0 [expr $n - 1]] {
+			set calls [lindex $e 1]
+			puts [format "%-40s %10d %12d %9.2f" [lindex $e 0] \
+			    $calls [lindex $e 2] \
+			    [expr double([lindex $e 2]) / $calls]]
+		}
+	}
+	default {
+		error "usage: \$ns profile-commands on|off|reset|report ?n?"
+	}
+	}
+}
+
+#
+# Scheduler/Parallel: run the nodes in $nodes, their agents and the
+# links that leave them in logical process $lp.  Nodes left out are in
+# LP 0, unless auto-partition places them.
+#
+Simulator instproc partition { nodes lp } {
+	$self instvar partition_
+	foreach node $nodes {
+		set partition_([$node id]) $lp
+	}
+}
+
+#
+# Split the topology into $nparts LPs with few links between them and
+# as long a lookahead as possible (see RouteLogic set part_imbalance_
+# and part_lookahead_).  Nodes already placed with "partition" stay
+# where they are.  Returns the lookahead, or -1 if no link is cut.
+#
+Simulator instproc auto-partition { nparts } {
+	$self instvar partition_ Node_ link_
+	set r [$self get-routelogic]
+	$r part-reset [Node set nn_]
+	foreach ln [array names link_] {
+		set L [split $ln :]
+		if [catch { $link_($ln) delay } delay] {
+			set delay 0
+		}
+		$r part-link [lindex $L 0] [lindex $L 1] $delay
+	}
+	foreach id [array names partition_] {
+		$r part-pin $id $partition_($id)
+	}
+	set lookahead [$r partition $nparts]
+	foreach id [array names Node_] {
+		set partition_($id) [$r part-of $id]
+	}
+	return $lookahead
+}
+
+# lookahead, cut links and nodes per LP of the last auto-partition
+Simulator instproc partition-stats {} {
+	set r [$self get-routelogic]
+	set sizes {}
+	for { set p 0 } { $p < [$r part-count] } { incr p } {
+		lappend sizes [$r part-size $p]
+	}
+	return [list lookahead [$r part-lookahead] cut [$r part-cut] \
+	    sizes $sizes]
+}
+
+Simulator instproc export-partition { file } {
+	[$self get-routelogic] part-export $file
+}
+
+#
+# Hand the partition to the scheduler and cut the links between LPs;
+# the least delay of a cut link bounds how far the LPs run apart.
+#
+Simulator instproc parallel-configure {} {
+	$self instvar scheduler_ partition_ Node_ link_
+	set nlps 1
+	foreach id [array names partition_] {
+		if { $partition_($id) >= $nlps } {
+			set nlps [expr $partition_($id) + 1]
+		}
+	}
+	$scheduler_ lps $nlps
+	foreach id [array names Node_] {
+		if ![info exists partition_($id)] {
+			set partition_($id) 0
+		}
+		set node $Node_($id)
+		$scheduler_ assign $partition_($id) $node
+		foreach agent [$node set agents_] {
+			$scheduler_ assign $partition_($id) $agent
+		}
+	}
+	foreach l [array names link_] {
+		set link $link_($l)
+		set from $partition_([[$link src] id])
+		set to $partition_([[$link dst] id])
+		foreach obj [list [$link head] [$link queue] [$link link]] {
+			$scheduler_ assign $from $obj
+		}
+		if { $from != $to } {
+			$scheduler_ cut [$link link] $to
+		}
+	}
+}
+
 # johnh xxx?
 Simulator instproc log-simstart { } {
         # GFR Modification to log actual start
@@ -1359,6 +1621,14 @@ Simulator instproc trace-all file {
 	set traceAllFile_ $file
 }
 
+#
+# Write the traces attached to $file from now on in binary form; the
+# trace-decode tool turns the file back into text.
+#
+Simulator instproc binary-trace file {
+	return [new BinaryTrace $file]
+}
+
 Simulator instproc get-nam-traceall {} {
 	$self instvar namtraceAllFile_
 	if [info exists namtraceAllFile_] {
@@ -162,6 +162,16 @@ Link instproc install-error {em} {
 	$link_ target $em
 }
 
+#
+# Let the objects of this link hand packets straight to their usual
+# successors, skipping a virtual call per hop (see Queue::transmit).
+# Returns the number of hops shortened; a trace or monitor attached
+# later switches the shortcut off for the hop it is spliced into.
+#
+Link instproc fast-path {} {
+	return 0
+}
+
 Class SimpleLink -superclass Link
 
 SimpleLink instproc init { src dst bw delay q {lltype "DelayLink"} } {
@@ -237,6 +247,11 @@ SimpleLink instproc enable-mcast {src dst} {
 
 # Debo
 
+SimpleLink instproc fast-path {} {
+	$self instvar queue_ link_
+	return [expr [$queue_ fast-path] + [$link_ fast-path]]
+}
+
 SimpleLink instproc bw {} { 
 	$self instvar link_
 	$link_ set bandwidth_ 
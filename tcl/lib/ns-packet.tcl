@@ -61,11 +61,26 @@
 #   ... 
 #   set ns [new Simulator]
 #
+# Alternatively, ns can work out the headers itself:
+#
+#   auto-packet-headers
+#   add-packet-header Foo	;# optional, headers it cannot know about
+#   set ns [new Simulator]
+#
+# The packet format is then recomputed when the simulation starts, from
+# the classes of the agents, queues, MACs, etc. that exist at that time
+# (see the uses_ table below), so packets carry only those headers.
+# Every other header is mapped onto one shared block that is cleared on
+# allocation; in builds with assertions enabled, a packet that wrote
+# into that block aborts the simulation when it is freed.
+#
 # IMPORTANT: You MUST never remove common header from your simulation. 
 # As you can see, this is also enforced by these header manipulation procs.
 #
 
 PacketHeaderManager set hdrlen_ 0
+PacketHeaderManager set hdrguard_ 0
+PacketHeaderManager set auto_ 0
 
 # XXX Common header should ALWAYS be present
 PacketHeaderManager set tab_(Common) 1
@@ -73,9 +88,16 @@ PacketHeaderManager set tab_(Common) 1
 proc add-packet-header args {
 	foreach cl $args {
 		PacketHeaderManager set tab_(PacketHeader/$cl) 1
+		if [PacketHeaderManager set auto_] {
+			PacketHeaderManager set keep_(PacketHeader/$cl) 1
+		}
 	}
 }
 
+proc auto-packet-headers {} {
+	PacketHeaderManager set auto_ 1
+}
+
 proc add-all-packet-headers {} {
 	PacketHeaderManager instvar tab_
 	foreach cl [PacketHeader info subclass] {
@@ -186,6 +208,8 @@ foreach prot $allhdrs {
 }
 
 proc PktHdr_offset { hdrName {field ""} } {
+	# whoever asked may keep the offset, so the format must not change
+	PacketHeaderManager set pinned_ $hdrName
 	set offset [$hdrName offset]
 	if { $field != "" } {
 		# This requires that fields inside the packet header must
@@ -197,10 +221,91 @@ proc PktHdr_offset { hdrName {field ""} } {
 	return $offset
 }
 
+#
+# Headers used by the objects of each class, for auto-packet-headers.
+# A class uses the entry of its nearest listed ancestor; Common, Flags
+# and IP are always present.  "*" means the headers are unknown, and
+# keeps the full packet format, as does an object whose class has no
+# listed ancestor at all.
+#
+foreach {cl hdrs} {
+	Simulator		{}
+	Scheduler		{}
+	PacketHeaderManager	{}
+	RNG			{}
+	RandomVariable		{}
+	RouteLogic		{}
+	AllocAddr		{}
+	Node			{}
+	RtModule		{}
+	Classifier		{}
+	Classifier/Mac		Mac
+	Classifier/Multicast/BST UMP
+	Queue			{}
+	PacketQueue/Semantic	TCP
+	DelayLink		{}
+	TTLChecker		{}
+	Trace			{}
+	QueueMonitor		{}
+	SnoopQueue		{}
+	Integrator		{}
+	Samples			{}
+	Application/Traffic	{}
+	Application/FTP		{}
+	Application/Telnet	{}
+	FluidModel		{}
+	Agent			*
+	Agent/Null		{}
+	Agent/LossMonitor	RTP
+	Agent/UDP		RTP
+	Agent/RTP		RTP
+	Agent/RTCP		RTP
+	Agent/MessagePassing	RTP
+	Agent/Message		Message
+	Agent/Ping		Ping
+	Agent/TCP		{TCP QS}
+	Agent/TCPSink		{TCP QS}
+	Agent/TCP/Asym		{TCP QS TCPA}
+	Agent/TCP/Reno/Asym	{TCP QS TCPA}
+	Agent/TCP/Newreno/Asym	{TCP QS TCPA}
+	Agent/TCPSink/Asym	{TCP QS TCPA}
+	Agent/TCP/Reno/XCP	{TCP QS XCP}
+	Agent/TCP/FullTcp/Newreno/XCP {TCP QS XCP}
+	Agent/TCPSink/XCPSink	{TCP QS XCP}
+	Agent/TFRC		{TFRC TFRC_ACK}
+	Agent/TFRCSink		{TFRC TFRC_ACK}
+	Agent/SCTP		SCTP
+	Agent/rtProto/DV	rtProtoDV
+	Agent/LDP		LDP
+	Agent/AODV		AODV
+	Agent/AOMDV		AOMDV
+	Agent/TORA		{TORA IMEP}
+	Agent/Encapsulator	Encap
+	Agent/Decapsulator	Encap
+	Queue/XCP		XCP
+	Queue/DropTail/XCPQ	XCP
+	ErrorModel		Mac
+	SRMErrorModel		{Mac SRM}
+	ErrorModel/Trace/Mroute	{Mac mcastCtrl}
+	Classifier/Addr/MPLS	MPLS
+	LL			{LL Mac ARP}
+	LL/LLSnoop		{LL Mac ARP Snoop}
+	ARPTable		ARP
+	Mac			*
+	Mac/802_3		Mac
+	Mac/802_11		Mac
+	Mac/802_11Ext		Mac
+	Mac/Simple		Mac
+	Mac/SMAC		{Mac Smac}
+	Mac/802_15_4		{Mac LRWPAN}
+} {
+	PacketHeaderManager set uses_($cl) $hdrs
+}
+
 Simulator instproc create_packetformat { } {
 	PacketHeaderManager instvar tab_
 	set pm [new PacketHeaderManager]
-	foreach cl [PacketHeader info subclass] {
+	foreach cl [$pm layout-order [PacketHeader info subclass]] {
 		if [info exists tab_($cl)] {
 			set off [$pm allochdr $cl]
 			$cl offset $off
@@ -209,9 +314,133 @@ Simulator instproc create_packetformat { } {
 	$self set packetManager_ $pm
 }
 
+# In auto mode, lay out the headers every format has first, so that
+# their offsets survive pruning.
+PacketHeaderManager instproc layout-order hdrs {
+	if ![PacketHeaderManager set auto_] {
+		return $hdrs
+	}
+	set first {PacketHeader/Common PacketHeader/Flags PacketHeader/IP}
+	foreach cl $hdrs {
+		if { [lsearch -exact $first $cl] < 0 } {
+			lappend first $cl
+		}
+	}
+	return $first
+}
+
+# Headers used by the objects that exist now, or "" if some object's
+# headers are unknown (its class is left in unknown_).
+PacketHeaderManager instproc headers-in-use {} {
+	PacketHeaderManager instvar uses_ keep_
+	foreach h {Common Flags IP} {
+		set used(PacketHeader/$h) 1
+	}
+	foreach cl [array names keep_] {
+		set used($cl) 1
+	}
+	if [Simulator set nix-routing] {
+		set used(PacketHeader/NV) 1
+	}
+	set todo [SplitObject info subclass]
+	while { $todo != "" } {
+		set cl [lindex $todo 0]
+		set todo [lrange $todo 1 end]
+		if [info exists seen($cl)] {
+			continue
+		}
+		set seen($cl) 1
+		eval lappend todo [$cl info subclass]
+		if { [$cl info instances] == "" } {
+			continue
+		}
+		set hdrs *
+		foreach c [concat $cl [$cl info heritage]] {
+			if [info exists uses_($c)] {
+				set hdrs $uses_($c)
+				break
+			}
+		}
+		if { $hdrs == "*" } {
+			$self set unknown_ $cl
+			return ""
+		}
+		foreach h $hdrs {
+			set used(PacketHeader/$h) 1
+		}
+	}
+	return [array names used]
+}
+
+# Lay out <hdrs> again from offset 0, and map every other header onto
+# one cleared block at the end (Packet::hdrguard_).
+PacketHeaderManager instproc relayout hdrs {
+	$self instvar hdrlen_ hdrguard_
+	set hdrlen_ 0
+	set pruned ""
+	foreach cl [$self layout-order [PacketHeader info subclass]] {
+		if { [lsearch -exact $hdrs $cl] >= 0 } {
+			$cl offset [$self allochdr $cl]
+		} else {
+			lappend pruned $cl
+		}
+	}
+	set guard $hdrlen_
+	set size 0
+	foreach cl $pruned {
+		$cl offset $guard
+		if { [$cl set hdrlen_] > $size } {
+			set size [$cl set hdrlen_]
+		}
+	}
+	if { $size > 0 } {
+		$self allochdr-size $size
+		set hdrguard_ $guard
+	} else {
+		set hdrguard_ 0
+	}
+}
+
+# Called by "$ns run": shrink the packet format to the headers in use.
+Simulator instproc prune-packet-headers {} {
+	$self instvar packetManager_ pruned_
+	if { ![PacketHeaderManager set auto_] || [info exists pruned_] } {
+		return
+	}
+	set pruned_ 1
+	if { [PacketHeaderManager info vars pinned_] != "" } {
+		warn "auto-packet-headers: offset of\
+		    [PacketHeaderManager set pinned_] was taken by the\
+		    script, keeping all packet headers"
+		return
+	}
+	array set pool [$packetManager_ pool-stats]
+	if { $pool(live) > 0 } {
+		warn "auto-packet-headers: $pool(live) packets already\
+		    allocated, keeping all packet headers"
+		return
+	}
+	set hdrs [$packetManager_ headers-in-use]
+	if { $hdrs == "" } {
+		warn "auto-packet-headers: no header list for\
+		    [$packetManager_ set unknown_], keeping all packet headers"
+		return
+	}
+	$packetManager_ relayout $hdrs
+}
+
+# Packet allocator counters, e.g. "hdrlen 176 allocs 12345 live 17
+# peak 230 slabs 1 packets 1489" (see common/packet.h)
+Simulator instproc packet-pool-stats {} {
+	$self instvar packetManager_
+	return [$packetManager_ pool-stats]
+}
+
 PacketHeaderManager instproc allochdr cl {
-	set size [$cl set hdrlen_]
+	return [$self allochdr-size [$cl set hdrlen_]]
+}
 
+PacketHeaderManager instproc allochdr-size size {
 	$self instvar hdrlen_
 	set NS_ALIGN 8
 	# round up to nearest NS_ALIGN bytes
@@ -314,6 +314,14 @@ Simulator instproc compute-routes {} {
 	}
 }
 
+#
+# Compute the routes of a node only when it first has a packet for a
+# destination, instead of all of them before the simulation starts.
+#
+Simulator instproc set-lazy-routing {} {
+	Simulator set lazy-routing 1
+}
+
 Simulator instproc compute-flat-routes {} {
 	$self instvar Node_ link_
 	#
@@ -343,6 +351,19 @@ Simulator instproc compute-flat-routes {} {
 	#puts " and starting route-compute at \
 	#	time: [clock format [clock seconds] -format %X]"
 
+	if [Simulator set lazy-routing] {
+		# routes are computed and installed by the classifiers
+		# on their first miss
+		$r lazy
+		foreach i [array names Node_] {
+			set m [$Node_($i) get-module Base]
+			if { $m != "" } {
+				[$m set classifier_] lazy-node $i
+			}
+		}
+		$self lazy-flat-classifiers [Node set nn_]
+		return
+	}
 	$r compute
 
 	#puts "completed route-compute"
@@ -791,6 +791,10 @@ HandoffManager set handoff_randomization_ false
 SatRouteObject set metric_delay_ true
 SatRouteObject set data_driven_computation_ false
 SatRouteObject set wiredRouting_ false
+# the satellite routing code reads the N x N tables directly
+SatRouteObject set sparse_ 0
+SatRouteObject set compress_ 0
+SatRouteObject set threads_ 1
 Mac/Sat set trace_drops_ true
 Mac/Sat set trace_collisions_ true
 Mac/Sat/UnslottedAloha set mean_backoff_ 1s; # mean backoff time upon collision
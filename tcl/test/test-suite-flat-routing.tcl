@@ -0,0 +1,220 @@
+#
+# This test suite checks that the variants of flat route computation
+# give the routes of the default one.
+#
+# To run all tests:  test-all-flat-routing
+#
+# To run individual tests:
+# ns test-suite-flat-routing.tcl lazy_updown
+# ns test-suite-flat-routing.tcl random_routes
+# ...
+#
+# Each test writes what it compared, and whether it agreed, to
+# temp.rands.
+#
+
+Class TestSuite
+
+TestSuite instproc init {} {
+	$self instvar out_
+	set out_ [open temp.rands w]
+}
+
+TestSuite instproc report { what ok } {
+	$self instvar out_
+	if $ok {
+		puts $out_ "$what: agree"
+	} else {
+		puts $out_ "$what: DIFFER"
+	}
+}
+
+TestSuite instproc finish {} {
+	$self instvar out_
+	close $out_
+	exit 0
+}
+
+proc usage {} {
+	global argv0
+	puts stderr "usage: ns $argv0 <tests> \[QUIET\]"
+	puts stderr "Valid tests are:\t[get-subclasses TestSuite Test/]"
+	exit 1
+}
+
+proc isProc? {cls prc} {
+	if [catch "Object info subclass $cls/$prc" r] {
+		global argv0
+		puts stderr "$argv0: no such $cls: $prc"
+		usage
+	}
+}
+
+proc get-subclasses {cls pfx} {
+	set ret ""
+	set l [string length $pfx]
+
+	set c $cls
+	while {[llength $c] > 0} {
+		set t [lindex $c 0]
+		set c [lrange $c 1 end]
+		if [string match ${pfx}* $t] {
+			lappend ret [string range $t $l end]
+		}
+		eval lappend c [$t info subclass]
+	}
+	set ret
+}
+
+#
+# Lazy routing across a pair that becomes unreachable and then
+# reachable again, against eager routing.
+#
+#		n0 ---------- n1
+#		  \          /
+#		   \        /
+#		    -- n2 --
+#
+# n0 sends CBR to n1.  At 1s n0-n1 goes down (n0 routes over n2), at 2s
+# n2-n1 too (n1 is unreachable), and at 3s n0-n1 comes back up.  Both
+# routings run in a child ns each, which prints how many packets n1 has
+# received every half second; the counts must be the same.
+#
+Class Test/lazy_updown -superclass TestSuite
+
+Test/lazy_updown proc child { routing } {
+	set ns [new Simulator]
+	if { $routing == "lazy" } {
+		$ns set-lazy-routing
+	}
+	$ns rtproto Session
+	for { set i 0 } { $i < 3 } { incr i } {
+		set n($i) [$ns node]
+	}
+	$ns duplex-link $n(0) $n(1) 1Mb 10ms DropTail
+	$ns duplex-link $n(0) $n(2) 1Mb 10ms DropTail
+	$ns duplex-link $n(2) $n(1) 1Mb 10ms DropTail
+
+	set udp [new Agent/UDP]
+	$ns attach-agent $n(0) $udp
+	set sink [new Agent/LossMonitor]
+	$ns attach-agent $n(1) $sink
+	$ns connect $udp $sink
+	set cbr [new Application/Traffic/CBR]
+	$cbr set packetSize_ 500
+	$cbr set interval_ 0.01
+	$cbr attach-agent $udp
+
+	$ns at 0.1 "$cbr start"
+	$ns rtmodel-at 1.0 down $n(0) $n(1)
+	$ns rtmodel-at 2.0 down $n(2) $n(1)
+	$ns rtmodel-at 3.0 up $n(0) $n(1)
+	for { set t 0.5 } { $t < 5 } { set t [expr $t + 0.5] } {
+		$ns at $t "puts \"$t \[$sink set npkts_\]\""
+	}
+	$ns at 5.0 "exit 0"
+	$ns run
+}
+
+Test/lazy_updown instproc run {} {
+	foreach r { eager lazy } {
+		set rx($r) [exec [info nameofexecutable] [info script] \
+		    lazy_updown child $r 2>@ stderr]
+	}
+	foreach e [split $rx(eager) \n] l [split $rx(lazy) \n] {
+		$self report "packets received by [lindex $e 0]s" \
+		    [string equal $e $l]
+	}
+	$self finish
+}
+
+#
+# The routes of RouteLogic with sparse_, compress_ and threads_, against
+# the dense computation, on a random topology of 80 nodes with ties,
+# zero-cost links and links that are down, some leaving nodes
+# unreachable.
+#
+Class Test/random_routes -superclass TestSuite
+
+Test/random_routes instproc routes { n links sparse compress threads } {
+	set r [new RouteLogic]
+	$r set sparse_ $sparse
+	$r set compress_ $compress
+	$r set threads_ $threads
+	foreach l $links {
+		eval $r $l
+	}
+	$r compute
+	set res ""
+	for { set i 0 } { $i < $n } { incr i } {
+		for { set j 0 } { $j < $n } { incr j } {
+			if { $i != $j } {
+				lappend res [$r cmd lookup $i $j]
+			}
+		}
+	}
+	delete $r
+	return $res
+}
+
+Test/random_routes instproc run {} {
+	set n 80
+	set rng [new RNG]
+	$rng seed 7
+	# a random tree, so that every node is known, then more links
+	set links ""
+	for { set i 1 } { $i < $n } { incr i } {
+		set j [$rng integer $i]
+		set c [lindex { 0 1 1 1 2 3 } [$rng integer 6]]
+		lappend links "insert $i $j $c" "insert $j $i $c"
+	}
+	for { set k 0 } { $k < 2 * $n } { incr k } {
+		set i [$rng integer $n]
+		set j [$rng integer $n]
+		if { $i == $j } {
+			continue
+		}
+		set c [lindex { 0 1 1 1 2 3 } [$rng integer 6]]
+		lappend links "insert $i $j $c"
+		if { [$rng integer 8] == 0 } {
+			lappend links "reset $i $j"
+		}
+	}
+	for { set k 0 } { $k < $n / 10 } { incr k } {
+		set i [expr 1 + [$rng integer [expr $n - 1]]]
+		lappend links "reset $i [$rng integer $i]"
+	}
+
+	set dense [$self routes $n $links 0 0 1]
+	foreach v { {1 0 1} {0 1 1} {1 1 1} {0 0 4} {1 0 4} {1 1 4} } {
+		set rt [eval $self routes $n [list $links] $v]
+		$self report "routes with sparse_ compress_ threads_ $v" \
+		    [string equal $dense $rt]
+	}
+	$self finish
+}
+
+TestSuite proc runTest {} {
+	global argc argv
+
+	switch $argc {
+		1 -
+		2 {
+			set test [lindex $argv 0]
+			isProc? Test $test
+		}
+		3 {
+			# a run of the test in a child ns
+			set test [lindex $argv 0]
+			isProc? Test $test
+			Test/$test child [lindex $argv 2]
+		}
+		default {
+			usage
+		}
+	}
+	set t [new Test/$test]
+	$t run
+}
+
+TestSuite runTest
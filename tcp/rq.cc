@@ -47,6 +47,7 @@
  *
  */
 
+#include <limits.h>
 #include "rq.h"
 
 ReassemblyQueue::seginfo* ReassemblyQueue::freelist_ = NULL;
@@ -77,6 +78,8 @@ ReassemblyQueue::fremove(seginfo* p)
 {
 	if (hint_ == p)
 		hint_ = NULL;
+	if (indexed_)
+		tremove(p);
 
 	if (p->prev_)
 		p->prev_->next_ = p->next_;
@@ -143,6 +146,197 @@ ReassemblyQueue::cnts(seginfo *p, int& blkcnt, int& bytecnt)
 	return;
 }
 
+/*
+ * the index: a treap over the FIFO, in FIFO (sequence) order, max-heap
+ * ordered on random priorities; nblks_ and nbytes_ count the blocks
+ * and bytes of each subtree
+ */
+
+void
+ReassemblyQueue::index(int on)
+{
+	seginfo *p;
+
+	root_ = NULL;
+	indexed_ = on;
+	if (on) {
+		for (p = head_; p != NULL; p = p->next_)
+			tinsert(p, p->prev_);
+	}
+}
+
+void
+ReassemblyQueue::tpull(seginfo* n)
+{
+	n->nblks_ = 1;
+	n->nbytes_ = n->endseq_ - n->startseq_;
+	if (n->left_) {
+		n->nblks_ += n->left_->nblks_;
+		n->nbytes_ += n->left_->nbytes_;
+	}
+	if (n->right_) {
+		n->nblks_ += n->right_->nblks_;
+		n->nbytes_ += n->right_->nbytes_;
+	}
+}
+
+void
+ReassemblyQueue::tfix(seginfo* n)
+{
+	if (!indexed_)
+		return;
+	for (; n != NULL; n = n->up_)
+		tpull(n);
+}
+
+void
+ReassemblyQueue::trotate(seginfo* n)
+{
+	seginfo* u = n->up_;
+	seginfo* g = u->up_;
+
+	if (u->left_ == n) {
+		u->left_ = n->right_;
+		if (n->right_)
+			n->right_->up_ = u;
+		n->right_ = u;
+	} else {
+		u->right_ = n->left_;
+		if (n->left_)
+			n->left_->up_ = u;
+		n->left_ = u;
+	}
+	u->up_ = n;
+	n->up_ = g;
+	if (g == NULL)
+		root_ = n;
+	else if (g->left_ == u)
+		g->left_ = n;
+	else
+		g->right_ = n;
+	tpull(u);
+	tpull(n);
+}
+
+void
+ReassemblyQueue::tinsert(seginfo* n, seginfo* p)
+{
+	seginfo* u;
+
+	seed_ ^= seed_ << 13;
+	seed_ ^= seed_ >> 17;
+	seed_ ^= seed_ << 5;
+	n->prio_ = seed_;
+	n->left_ = n->right_ = NULL;
+	tpull(n);
+
+	// as a leaf at n's place in order: the leftmost spot of the
+	// tree or of p's right subtree, or p's right child
+	if (root_ == NULL) {
+		n->up_ = NULL;
+		root_ = n;
+		return;
+	}
+	if (p == NULL || p->right_ != NULL) {
+		u = (p == NULL) ? root_ : p->right_;
+		while (u->left_)
+			u = u->left_;
+		u->left_ = n;
+	} else {
+		u = p;
+		u->right_ = n;
+	}
+	n->up_ = u;
+	tfix(u);
+	while (n->up_ != NULL && n->up_->prio_ < n->prio_)
+		trotate(n);
+}
+
+void
+ReassemblyQueue::tremove(seginfo* n)
+{
+	seginfo* c;
+
+	// rotate n down to a leaf, then cut it off
+	while (n->left_ || n->right_) {
+		if (n->left_ == NULL)
+			c = n->right_;
+		else if (n->right_ == NULL)
+			c = n->left_;
+		else
+			c = (n->left_->prio_ > n->right_->prio_) ?
+				n->left_ : n->right_;
+		trotate(c);
+	}
+	if (n->up_ == NULL)
+		root_ = NULL;
+	else if (n->up_->left_ == n)
+		n->up_->left_ = NULL;
+	else
+		n->up_->right_ = NULL;
+	tfix(n->up_);
+}
+
+/*
+ * As the blocks don't overlap, both their start and end seqs increase
+ * along the FIFO, so the index can be searched on either.
+ */
+
+ReassemblyQueue::seginfo*
+ReassemblyQueue::tfind_start(TcpSeq seq)
+{
+	seginfo *p = root_, *r = NULL;
+
+	while (p) {
+		if (p->startseq_ >= seq) {
+			r = p;
+			p = p->left_;
+		} else
+			p = p->right_;
+	}
+	return (r);
+}
+
+ReassemblyQueue::seginfo*
+ReassemblyQueue::tfind_end(TcpSeq seq)
+{
+	seginfo *p = root_, *r = NULL;
+
+	while (p) {
+		if (p->endseq_ > seq) {
+			r = p;
+			p = p->left_;
+		} else
+			p = p->right_;
+	}
+	return (r);
+}
+
+/*
+ * cnts() in O(log n): everything less what precedes p
+ */
+void
+ReassemblyQueue::tcnts(seginfo *p, int& blkcnt, int& bytecnt)
+{
+	int blks = 0;
+	int bytes = 0;
+	seginfo* u;
+
+	if (p->left_) {
+		blks = p->left_->nblks_;
+		bytes = p->left_->nbytes_;
+	}
+	for (; (u = p->up_) != NULL; p = u) {
+		if (u->right_ != p)
+			continue;
+		blks += 1 + (u->left_ ? u->left_->nblks_ : 0);
+		bytes += (u->endseq_ - u->startseq_) +
+			(u->left_ ? u->left_->nbytes_ : 0);
+	}
+	blkcnt = root_->nblks_ - blks;
+	bytecnt = root_->nbytes_ - bytes;
+}
+
 
 /*
  * clear out reassembly queue and stack
@@ -152,7 +346,7 @@ void
 ReassemblyQueue::clear()
 {
 	// clear stack and end of queue
-	tail_ = top_ = bottom_ = hint_ = NULL;
+	tail_ = top_ = bottom_ = hint_ = root_ = NULL;
 
 	seginfo *p = head_;
 	while (head_) {
@@ -191,6 +385,7 @@ ReassemblyQueue::clearto(TcpSeq seq)
 	if (p && p->startseq_ <= seq && p->endseq_ > seq) {
 		total_ -= (seq - p->startseq_);
 		p->startseq_ = seq;
+		tfix(p);
 		flag |= p->pflags_;
 	}
 	return flag;
@@ -328,6 +523,8 @@ ReassemblyQueue::add(TcpSeq start, TcpSeq end, TcpFlag tiflags, RqFlag rqflags)
 		head_->pflags_ = tiflags;
 		head_->rqflags_ = rqflags;
 		head_->cnt_ = initcnt;
+		if (indexed_)
+			tinsert(head_, NULL);
 
 		total_ = (end - start);
 
@@ -369,13 +566,19 @@ again2:
 		// search for segments before and after
 		// the new one; could be overlapped
 		//
-		q = head_;
-		while (q && q->startseq_ < end)
-			q = q->next_;
+		if (indexed_) {
+			q = tfind_start(end);
+			p = tfind_end(start);
+			p = p ? p->prev_ : tail_;
+		} else {
+			q = head_;
+			while (q && q->startseq_ < end)
+				q = q->next_;
 
-		p = tail_;
-		while (p && p->endseq_ > start)
-			p = p->prev_;
+			p = tail_;
+			while (p && p->endseq_ > start)
+				p = p->prev_;
+		}
 
 #ifdef notdef
 printf("Thinking of merging (s:%d, e:%d), p:%p (%d,%d), q:%p (%d,%d) into: \n",
@@ -438,6 +641,7 @@ start, end, p, q,
 			if (start < p->startseq_) {
 				total_ += (p->startseq_ - start);
 				p->startseq_ = start;
+				tfix(p);
 			}
 			start = p->endseq_;
 			needmerge = TRUE;
@@ -457,6 +661,7 @@ start, end, p, q,
 			if (end > q->endseq_) {
 				total_ += (end - q->endseq_);
 				q->endseq_ = end;
+				tfix(q);
 			}
 			end = q->startseq_;
 			needmerge = TRUE;
@@ -512,6 +717,9 @@ endfast:
 		else
 			tail_ = n;
 
+		if (indexed_)
+			tinsert(n, p);
+
 
 		//
 		// If there is an adjacency condition,
@@ -567,6 +775,7 @@ dumplist();
 		sremove(q);
 		fremove(q);
 		p->endseq_ = q->endseq_;
+		tfix(p);
 		p->cnt_ += (n->cnt_ + q->cnt_);
 		flags = (p->pflags_ |= n->pflags_);
 		ReassemblyQueue::deleteseginfo(n);
@@ -577,6 +786,7 @@ dumplist();
 		sremove(n);
 		fremove(n);
 		p->endseq_ = n->endseq_;
+		tfix(p);
 		flags = (p->pflags_ |= n->pflags_);
 		p->cnt_ += n->cnt_;
 		ReassemblyQueue::deleteseginfo(n);
@@ -586,6 +796,7 @@ dumplist();
 		sremove(n);
 		fremove(n);
 		q->startseq_ = n->startseq_;
+		tfix(q);
 		flags = (q->pflags_ |= n->pflags_);
 		q->cnt_ += n->cnt_;
 		ReassemblyQueue::deleteseginfo(n);
@@ -618,6 +829,22 @@ ReassemblyQueue::nexthole(TcpSeq seq, int& nxtcnt, int& nxtbytes)
 	hint_ = head_;
 
 	seginfo* p;
+	if (indexed_) {
+		// the first block ending at or after seq
+		if (seq == INT_MIN)
+			p = head_;
+		else
+			p = tfind_end(seq - 1);
+		if (p == NULL)
+			return (-1);
+		if (p->startseq_ > seq) {
+			tcnts(p, nxtcnt, nxtbytes);
+			return (seq);
+		}
+		if (p->next_)
+			tcnts(p->next_, nxtcnt, nxtbytes);
+		return (p->endseq_);
+	}
 	for (p = hint_; p; p = p->next_) {
 		// seq# is prior to SACK region
 		// so seq# is a legit hole
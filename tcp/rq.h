@@ -83,6 +83,17 @@ typedef int	RqFlag;		// meta data (owned by ReassemblyQueue)
  * overhead in generating SACK blocks good for HSTCP; see scoreboard-rq
  */ 
 
+/*
+ * With index(TRUE), the FIFO is also indexed by a treap (a randomized
+ * balanced search tree) in sequence order, whose nodes carry the block
+ * and byte counts of their subtrees.  add() then finds the blocks around
+ * a new segment, and nexthole() the block of a sequence number and the
+ * counts above it, in O(log n) instead of walking the FIFO, which for a
+ * receiver (or SACK sender) with thousands of holes makes every segment
+ * cost O(n).  The FIFO and LIFO are kept exactly as without the index,
+ * so add(), nexthole() and gensack() give the same results either way.
+ */
+
 class ReassemblyQueue {
 	struct seginfo {
 		seginfo* next_;	// next on FIFO list
@@ -95,11 +106,18 @@ class ReassemblyQueue {
 		TcpFlag	pflags_;	// flags derived from tcp hdr
 		RqFlag	rqflags_;	// book-keeping flags
 		int	cnt_;		// refs to this block
+
+		seginfo* left_;		// index (treap) links
+		seginfo* right_;
+		seginfo* up_;
+		unsigned prio_;		// treap priority (heap ordered)
+		int	nblks_;		// blocks in this subtree
+		int	nbytes_;	// bytes in this subtree
 	};
 
 public:
 	ReassemblyQueue(TcpSeq& rcvnxt) :
-		head_(NULL), tail_(NULL), top_(NULL), bottom_(NULL), hint_(NULL), total_(0), rcv_nxt_(rcvnxt) { };
+		head_(NULL), tail_(NULL), top_(NULL), bottom_(NULL), hint_(NULL), total_(0), root_(NULL), indexed_(FALSE), seed_(1), rcv_nxt_(rcvnxt) { };
 	int empty() { return (head_ == NULL); }
 	int add(TcpSeq sseq, TcpSeq eseq, TcpFlag pflags, RqFlag rqflags = 0);
 	int maxseq() { return (tail_ ? (tail_->endseq_) : -1); }
@@ -117,6 +135,8 @@ public:
 	    return (clearto(rcv_nxt_));
 	}
 	void dumplist();	// for debugging
+	void index(int);	// keep (or drop) the index
+	int indexed() { return (indexed_); }
 
 	// cache of allocated seginfo blocks
 	static seginfo* newseginfo();
@@ -132,6 +152,9 @@ protected:
 	seginfo* bottom_;	// bottom of stack
 	seginfo* hint_;	// hint for nexthole() function
 	int total_;	// # bytes in Reassembly Queue
+	seginfo* root_;		// root of the index, if indexed_
+	int indexed_;
+	unsigned seed_;		// treap priorities (xorshift)
 
 	// rcv_nxt_ is a reference to an externally allocated TcpSeq
 	// (aka integer)that will be updated with the highest in-sequence sequence
@@ -145,6 +168,16 @@ protected:
 	void sremove(seginfo*); // remove from LIFO
 	void push(seginfo*); // add to LIFO
 	void cnts(seginfo *, int&, int&); // byte/blk counts
+
+	// the index
+	void tinsert(seginfo* n, seginfo* p);	// insert n after p (or first)
+	void tremove(seginfo*);
+	void tfix(seginfo*);	// after a change of seqs, redo the counts
+	void tpull(seginfo*);	// counts of one node from its children
+	void trotate(seginfo*);	// move a node above its parent
+	seginfo* tfind_start(TcpSeq);	// first blk starting at/after seq
+	seginfo* tfind_end(TcpSeq);	// first blk ending after seq
+	void tcnts(seginfo *, int&, int&); // cnts(), from the index
 };
 
 #endif
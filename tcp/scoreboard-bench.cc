@@ -0,0 +1,376 @@
+/* -*-	Mode:C++; c-basic-offset:8; tab-width:8; indent-tabs-mode:t -*- */
+/*
+ * Copyright (c) 1994 Regents of the University of California.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor of the Laboratory may be used
+ *    to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+
+/*
+ * ScoreBoardBench: compare SACK scoreboard implementations on the same
+ * stream of ACKs.
+ *
+ *	$bench generate <file> <window> <loss> <acks> ?seed?
+ *		write a synthetic ScoreBoardLog of <acks> ACKs for a
+ *		sender keeping <window> packets in flight, each first
+ *		transmission lost with probability <loss>
+ *	$bench replay <kind> <file>
+ *		replay a ScoreBoardLog (recorded with record-scoreboard
+ *		or generated above) against a new scoreboard of <kind>,
+ *		returning a list of {name value} statistics
+ *
+ * Kinds are array (ScoreBoard, as Agent/TCP/Fack uses), bitmap
+ * (ScoreBoardBV), rq and rq-index (ScoreBoardRQ, as Agent/TCP/Sack1
+ * uses, without and with its index).  Each result is checked against
+ * the log.  The rq kinds answer GetNextRetran() and UpdateScoreBoard()
+ * by their own rules and do not implement CheckSndNxt(), which they
+ * skip, so only array and bitmap replays should show no mismatches.
+ * tcl/ex/scoreboard-bench.tcl drives this for all kinds.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <deque>
+#include <map>
+#include <vector>
+
+#include "config.h"
+#ifndef WIN32
+#include <sys/time.h>
+#endif
+#ifdef HAVE_GETRUSAGE
+#include <sys/resource.h>
+#endif
+#include <time.h>
+
+#include "scoreboard-log.h"
+#include "scoreboard-bv.h"
+#include "scoreboard-rq.h"
+#include "rng.h"
+
+class ScoreBoardBench : public TclObject {
+public:
+	ScoreBoardBench() {}
+	int command(int argc, const char*const* argv);
+protected:
+	int generate(const char* file, int window, double loss, int nacks,
+		     long seed);
+	int load(const char* file);
+	void replay(ScoreBoard* sb, int sndnxt);
+
+	// the decoded log: one entry per call ...
+	vector<char> op_;
+	vector<int> arg_;		// its first argument in args_
+	// ... its arguments and results, and the SACK blocks of each
+	// UpdateScoreBoard() and CheckSndNxt(), indexed by args_[arg_]
+	vector<int> args_;
+	vector<hdr_tcp> sack_;
+};
+
+static class ScoreBoardBenchClass : public TclClass {
+public:
+	ScoreBoardBenchClass() : TclClass("ScoreBoardBench") {}
+	TclObject* create(int /* argc */, const char*const* /* argv */) {
+		return (new ScoreBoardBench);
+	}
+} class_scoreboard_bench;
+
+static double
+bench_now()
+{
+#ifdef CLOCK_MONOTONIC
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (ts.tv_sec + 1e-9 * ts.tv_nsec);
+#else
+	timeval tv;
+	gettimeofday(&tv, 0);
+	return (tv.tv_sec + 1e-6 * tv.tv_usec);
+#endif
+}
+
+/* peak resident set size in KB, or 0 if we cannot tell */
+static long
+bench_maxrss()
+{
+#ifdef HAVE_GETRUSAGE
+	struct rusage ru;
+	getrusage(RUSAGE_SELF, &ru);
+	return (ru.ru_maxrss);
+#else
+	return (0);
+#endif
+}
+
+/*
+ * Generate a log by recording the calls a SACK sender makes on
+ * ScoreBoard, the reference.  The path is a FIFO of <window> packets;
+ * the receiver acks every packet that arrives, with up to NSA SACK
+ * blocks (the one holding the packet first, then the highest ones).
+ * For each ACK the sender updates the scoreboard, checks its
+ * retransmissions, asks for the next unacked packet, and then fills
+ * the path, retransmitting whatever GetNextRetran() offers before
+ * sending new data.  Retransmissions are never lost.
+ */
+int
+ScoreBoardBench::generate(const char* file, int window, double loss,
+			  int nacks, long seed)
+{
+	ScoreBoard* sb;
+	deque<int> path;		// seqno << 1 | retransmitted
+	map<int, int> ooo;		// receiver's blocks, left -> right
+	map<int, int>::iterator p, q;
+	map<int, int>::reverse_iterator b;
+	hdr_tcp tcph;
+	RNG rng(seed);
+	int seqno = 0, ack = -1;	// next new packet, cumulative ack
+	int s, left, right, i;
+
+	sb = ScoreBoardRecord::open(new ScoreBoard(new ScoreBoardNode[1024],
+						   1024), file);
+	if (sb == 0)
+		return (-1);
+	memset(&tcph, 0, sizeof(tcph));
+
+	for (i = 0; i < nacks; ) {
+		// fill the path
+		while ((int)path.size() < window) {
+			if ((s = sb->GetNextRetran()) >= 0) {
+				sb->MarkRetran(s, seqno);
+				path.push_back(s << 1 | 1);
+			} else
+				path.push_back(seqno++ << 1);
+		}
+		// the next packet to arrive
+		s = path.front();
+		path.pop_front();
+		if (!(s & 1) && rng.uniform_double() < loss)
+			continue;
+		s >>= 1;
+
+		// the receiver
+		left = s;
+		right = s + 1;
+		if (s == ack + 1) {
+			ack = s;
+			p = ooo.begin();
+			if (p != ooo.end() && p->first == ack + 1) {
+				ack = p->second - 1;
+				ooo.erase(p);
+			}
+		} else if (s > ack) {
+			q = ooo.upper_bound(s);
+			if (q != ooo.begin()) {
+				p = q;
+				--p;
+				if (p->second == s) {
+					left = p->first;
+					ooo.erase(p);
+				}
+			}
+			if (q != ooo.end() && q->first == s + 1) {
+				right = q->second;
+				ooo.erase(q);
+			}
+			ooo[left] = right;
+		}
+		tcph.sa_length() = 0;
+		if (s > ack) {
+			tcph.sa_left(0) = left;
+			tcph.sa_right(0) = right;
+			tcph.sa_length() = 1;
+		}
+		for (b = ooo.rbegin(); b != ooo.rend() &&
+		     tcph.sa_length() < NSA; ++b) {
+			if (b->first == left && s > ack)
+				continue;
+			tcph.sa_left(tcph.sa_length()) = b->first;
+			tcph.sa_right(tcph.sa_length()) = b->second;
+			++tcph.sa_length();
+		}
+
+		// the sender
+		sb->UpdateScoreBoard(ack, &tcph);
+		sb->CheckSndNxt(&tcph);
+		sb->GetNextUnacked(ack + 1);
+		++i;
+	}
+	delete sb;
+	return (0);
+}
+
+int
+ScoreBoardBench::load(const char* file)
+{
+	ScoreBoardLog log;
+	int args[SCBLOG_MAXARGS];
+	int op, n, r, i, nsack;
+	hdr_tcp tcph;
+
+	op_.clear();
+	arg_.clear();
+	args_.clear();
+	sack_.clear();
+	if (log.open(file, 0) < 0)
+		return (-1);
+	memset(&tcph, 0, sizeof(tcph));
+	while ((r = log.get(op, n, args)) == 1) {
+		op_.push_back((char)op);
+		arg_.push_back(args_.size());
+		if (op == SCBLOG_UPDATE || op == SCBLOG_SNDNXT) {
+			// <last_ack> <nsack> <left right>... <result>...
+			i = (op == SCBLOG_UPDATE);
+			nsack = (i < n) ? args[i] : -1;
+			if (nsack < 0 || nsack > NSA ||
+			    n != i + 1 + 2 * nsack + 1 + i) {
+				r = -1;
+				break;
+			}
+			tcph.sa_length() = nsack;
+			for (int k = 0; k < nsack; ++k) {
+				tcph.sa_left(k) = args[i + 1 + 2 * k];
+				tcph.sa_right(k) = args[i + 2 + 2 * k];
+			}
+			args_.push_back(sack_.size());
+			sack_.push_back(tcph);
+			if (op == SCBLOG_UPDATE)
+				args_.push_back(args[0]);
+			args_.push_back(args[n - 1 - i]);
+			if (op == SCBLOG_UPDATE)
+				args_.push_back(args[n - 1]);
+		} else {
+			for (i = 0; i < n; ++i)
+				args_.push_back(args[i]);
+		}
+	}
+	log.close();
+	return (r);
+}
+
+void
+ScoreBoardBench::replay(ScoreBoard* sb, int sndnxt)
+{
+	Tcl& tcl = Tcl::instance();
+	int ncalls = op_.size(), nacks = 0, mismatch = 0;
+	double t0, t1;
+	const int* a;
+	int i, r;
+
+	long rss = bench_maxrss();
+	t0 = bench_now();
+	for (i = 0; i < ncalls; ++i) {
+		a = &args_[arg_[i]];
+		switch (op_[i]) {
+		case SCBLOG_UPDATE:
+			// <sack> <last_ack> <result> <changed>
+			r = sb->UpdateScoreBoard(a[1], &sack_[a[0]]);
+			if (r != a[2] || sb->IsChanged() != a[3])
+				++mismatch;
+			++nacks;
+			break;
+		case SCBLOG_SNDNXT:
+			// <sack> <result>
+			if (sndnxt && sb->CheckSndNxt(&sack_[a[0]]) != a[1])
+				++mismatch;
+			break;
+		case SCBLOG_NEXTRETRAN:
+			if (sb->GetNextRetran() != a[0])
+				++mismatch;
+			break;
+		case SCBLOG_NEXTUNACKED:
+			if (sb->GetNextUnacked(a[0]) != a[1])
+				++mismatch;
+			break;
+		case SCBLOG_MARK:
+			sb->MarkRetran(a[0], a[1]);
+			break;
+		case SCBLOG_MARK1:
+			sb->MarkRetran(a[0]);
+			break;
+		case SCBLOG_CLEAR:
+			sb->ClearScoreBoard();
+			break;
+		}
+	}
+	t1 = bench_now();
+	rss = bench_maxrss() - rss;
+
+	double elapsed = t1 - t0;
+	if (elapsed <= 0)
+		elapsed = 1e-9;
+	tcl.resultf("calls %d acks %d seconds %.6f rate %.0f ack-ns %.1f "
+		    "peak-kb %ld mismatches %d",
+		    ncalls, nacks, elapsed, ncalls / elapsed,
+		    nacks ? 1e9 * elapsed / nacks : 0.0, rss, mismatch);
+}
+
+int
+ScoreBoardBench::command(int argc, const char*const* argv)
+{
+	Tcl& tcl = Tcl::instance();
+	if (argc == 4) {
+		if (strcmp(argv[1], "replay") == 0) {
+			ScoreBoard* sb;
+			int sndnxt = 1;
+			if (strcmp(argv[2], "array") == 0)
+				sb = new ScoreBoard(new ScoreBoardNode[1024],
+						    1024);
+			else if (strcmp(argv[2], "bitmap") == 0)
+				sb = new ScoreBoardBV();
+			else if (strcmp(argv[2], "rq") == 0 ||
+				 strcmp(argv[2], "rq-index") == 0) {
+				sb = new ScoreBoardRQ(
+				    strcmp(argv[2], "rq-index") == 0);
+				sndnxt = 0;
+			} else {
+				tcl.resultf("%s: unknown scoreboard %s",
+					    name(), argv[2]);
+				return (TCL_ERROR);
+			}
+			if (load(argv[3]) != 0) {
+				delete sb;
+				tcl.resultf("%s: cannot read scoreboard log %s",
+					    name(), argv[3]);
+				return (TCL_ERROR);
+			}
+			replay(sb, sndnxt);
+			delete sb;
+			return (TCL_OK);
+		}
+	} else if (argc == 6 || argc == 7) {
+		if (strcmp(argv[1], "generate") == 0) {
+			long seed = (argc == 7) ? atol(argv[6]) : 1;
+			if (generate(argv[2], atoi(argv[3]), atof(argv[4]),
+				     atoi(argv[5]), seed) < 0) {
+				tcl.resultf("%s: cannot write %s", name(), argv[2]);
+				return (TCL_ERROR);
+			}
+			return (TCL_OK);
+		}
+	}
+	return (TclObject::command(argc, argv));
+}
@@ -0,0 +1,420 @@
+/* -*-	Mode:C++; c-basic-offset:8; tab-width:8; indent-tabs-mode:t -*- */
+/*
+ * Copyright (c) 1994 Regents of the University of California.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor of the Laboratory may be used
+ *    to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "scoreboard-bv.h"
+
+#define SBBV_INITWORDS	64	/* 2048 packets */
+
+static inline int
+sb_ctz(unsigned int x)
+{
+#ifdef __GNUC__
+	return (__builtin_ctz(x));
+#else
+	int n = 0;
+	while ((x & 1) == 0) {
+		x >>= 1;
+		++n;
+	}
+	return (n);
+#endif
+}
+
+static inline int
+sb_popcount(unsigned int x)
+{
+#ifdef __GNUC__
+	return (__builtin_popcount(x));
+#else
+	x = x - ((x >> 1) & 0x55555555);
+	x = (x & 0x33333333) + ((x >> 2) & 0x33333333);
+	return ((((x + (x >> 4)) & 0x0f0f0f0f) * 0x01010101) >> 24);
+#endif
+}
+
+/* bits [lo, hi) of a word, 0 <= lo < hi <= 32 */
+static inline unsigned int
+sb_mask(int lo, int hi)
+{
+	unsigned int m = (hi == 32) ? ~0u : ((1u << hi) - 1);
+	return (m & ~((1u << lo) - 1));
+}
+
+ScoreBoardBV::ScoreBoardBV() : ScoreBoard(NULL, 0), base_(0),
+	nwords_(SBBV_INITWORDS), nsacked_(0), nretran_(0)
+{
+	int nsum = (nwords_ + 31) >> 5;
+
+	sacked_ = new sbword[nwords_];
+	retran_ = new sbword[nwords_];
+	done_ = new sbword[nsum];
+	anyretran_ = new sbword[nsum];
+	snd_nxt_ = new int[nwords_ << 5];
+	memset(sacked_, 0, nwords_ * sizeof(sbword));
+	memset(retran_, 0, nwords_ * sizeof(sbword));
+	memset(done_, 0, nsum * sizeof(sbword));
+	memset(anyretran_, 0, nsum * sizeof(sbword));
+}
+
+ScoreBoardBV::~ScoreBoardBV()
+{
+	delete [] sacked_;
+	delete [] retran_;
+	delete [] done_;
+	delete [] anyretran_;
+	delete [] snd_nxt_;
+}
+
+/*
+ * Start over with the single packet seq.  Only packets in the
+ * scoreboard have bits set, so with length_ 0 all bits are clear.
+ */
+void ScoreBoardBV::restart(int seq)
+{
+	base_ = first_ = seq;
+	length_ = 1;
+	snd_nxt_[0] = 0;
+	nsacked_ = nretran_ = 0;
+}
+
+/*
+ * Make room for packets below seq: slide the live words down to the
+ * start of the vectors, and double them until at least half is free
+ * afterwards, so that sliding costs O(1) per packet.
+ */
+void ScoreBoardBV::reserve(int seq)
+{
+	if (seq - base_ <= (nwords_ << 5))
+		return;
+
+	int shift = (first_ - base_) >> 5;
+	int used = (first_ + length_ - base_ + 31) >> 5;
+	int need = ((seq - base_ + 31) >> 5) - shift;
+	int n = nwords_;
+	while (n < 2 * need)
+		n *= 2;
+
+	sbword* sacked = new sbword[n];
+	sbword* retran = new sbword[n];
+	int* snd_nxt = new int[n << 5];
+	memset(sacked, 0, n * sizeof(sbword));
+	memset(retran, 0, n * sizeof(sbword));
+	memcpy(sacked, sacked_ + shift, (used - shift) * sizeof(sbword));
+	memcpy(retran, retran_ + shift, (used - shift) * sizeof(sbword));
+	memcpy(snd_nxt, snd_nxt_ + (shift << 5),
+	       ((used - shift) << 5) * sizeof(int));
+	delete [] sacked_;
+	delete [] retran_;
+	delete [] snd_nxt_;
+	sacked_ = sacked;
+	retran_ = retran;
+	snd_nxt_ = snd_nxt;
+
+	if (n != nwords_) {
+		delete [] done_;
+		delete [] anyretran_;
+		done_ = new sbword[(n + 31) >> 5];
+		anyretran_ = new sbword[(n + 31) >> 5];
+	}
+	memset(done_, 0, ((n + 31) >> 5) * sizeof(sbword));
+	memset(anyretran_, 0, ((n + 31) >> 5) * sizeof(sbword));
+	nwords_ = n;
+	base_ += shift << 5;
+	summarize(first_, first_ + length_);
+}
+
+int ScoreBoardBV::setbits(sbword* v, int from, int to)
+{
+	int i = from - base_, j = to - base_, n = 0;
+	int w, lo, hi;
+	sbword m;
+
+	for (w = i >> 5; w << 5 < j; ++w) {
+		lo = (w << 5) < i ? i - (w << 5) : 0;
+		hi = (w << 5) + 32 > j ? j - (w << 5) : 32;
+		m = sb_mask(lo, hi);
+		n += sb_popcount(m & ~v[w]);
+		v[w] |= m;
+	}
+	return (n);
+}
+
+int ScoreBoardBV::clearbits(sbword* v, int from, int to)
+{
+	int i = from - base_, j = to - base_, n = 0;
+	int w, lo, hi;
+	sbword m;
+
+	for (w = i >> 5; w << 5 < j; ++w) {
+		lo = (w << 5) < i ? i - (w << 5) : 0;
+		hi = (w << 5) + 32 > j ? j - (w << 5) : 32;
+		m = sb_mask(lo, hi);
+		n += sb_popcount(m & v[w]);
+		v[w] &= ~m;
+	}
+	return (n);
+}
+
+void ScoreBoardBV::summarize(int from, int to)
+{
+	int w, last = (to - base_ + 31) >> 5;
+	sbword b;
+
+	for (w = (from - base_) >> 5; w < last; ++w) {
+		b = 1u << (w & 31);
+		if ((sacked_[w] | retran_[w]) == ~0u)
+			done_[w >> 5] |= b;
+		else
+			done_[w >> 5] &= ~b;
+		if (retran_[w] != 0)
+			anyretran_[w >> 5] |= b;
+		else
+			anyretran_[w >> 5] &= ~b;
+	}
+}
+
+/*
+ * The first packet in [from, to) that is neither SACKed nor
+ * retransmitted, or -1: look in the word of from, then skip done
+ * words through the summary.
+ */
+int ScoreBoardBV::nextfree(int from, int to)
+{
+	int i = from - base_, j = to - base_;
+	int w = i >> 5;
+	sbword m, s;
+
+	m = ~(sacked_[w] | retran_[w]) & ~((1u << (i & 31)) - 1);
+	while (m == 0) {
+		for (++w; w << 5 < j; w = ((w >> 5) + 1) << 5) {
+			s = ~done_[w >> 5] & ~((1u << (w & 31)) - 1);
+			if (s != 0) {
+				w = ((w >> 5) << 5) + sb_ctz(s);
+				break;
+			}
+		}
+		if (w << 5 >= j)
+			return (-1);
+		m = ~(sacked_[w] | retran_[w]);
+	}
+	i = (w << 5) + sb_ctz(m);
+	return (i < j ? base_ + i : -1);
+}
+
+/* the first retransmitted packet in [from, to), or -1 */
+int ScoreBoardBV::nextretran(int from, int to)
+{
+	int i = from - base_, j = to - base_;
+	int w = i >> 5;
+	sbword m, s;
+
+	m = retran_[w] & ~((1u << (i & 31)) - 1);
+	while (m == 0) {
+		for (++w; w << 5 < j; w = ((w >> 5) + 1) << 5) {
+			s = anyretran_[w >> 5] & ~((1u << (w & 31)) - 1);
+			if (s != 0) {
+				w = ((w >> 5) << 5) + sb_ctz(s);
+				break;
+			}
+		}
+		if (w << 5 >= j)
+			return (-1);
+		m = retran_[w];
+	}
+	i = (w << 5) + sb_ctz(m);
+	return (i < j ? base_ + i : -1);
+}
+
+/* last_ack = TCP last ack; see ScoreBoard::UpdateScoreBoard() */
+int ScoreBoardBV::UpdateScoreBoard (int last_ack, hdr_tcp* tcph)
+{
+	int sack_index, sack_left, sack_right;
+	int retran_decr = 0;
+	int from, to, n;
+
+	changed_ = 0;
+
+	//  Advance the left edge of the block.
+	if (length_ && first_ <= last_ack) {
+		to = last_ack + 1;
+		if (to > first_ + length_)
+			to = first_ + length_;
+		nsacked_ -= clearbits(sacked_, first_, to);
+		n = clearbits(retran_, first_, to);
+		nretran_ -= n;
+		retran_decr += n;
+		summarize(first_, to);
+		changed_ += to - first_;
+		length_ -= to - first_;
+		first_ = to;
+	}
+
+	//  If there is no scoreboard, create one.
+	if (length_ == 0 && tcph->sa_length()) {
+		restart(last_ack + 1);
+		changed_++;
+	}
+
+	for (sack_index=0; sack_index < tcph->sa_length(); sack_index++) {
+		sack_left = tcph->sa_left(sack_index);
+		sack_right = tcph->sa_right(sack_index);
+
+		//  Create new entries off the right side.
+		if (sack_right > first_ + length_) {
+			reserve(sack_right);
+			memset(snd_nxt_ + (first_ + length_ - base_), 0,
+			       (sack_right - (first_ + length_)) * sizeof(int));
+			changed_ += sack_right - (first_ + length_);
+			length_ = sack_right - first_;
+		}
+
+		from = (sack_left > first_) ? sack_left : first_;
+		to = (sack_right < first_ + length_) ?
+			sack_right : first_ + length_;
+		if (from < to) {
+			n = setbits(sacked_, from, to);
+			nsacked_ += n;
+			changed_ += n;
+			n = clearbits(retran_, from, to);
+			nretran_ -= n;
+			retran_decr += n;
+			summarize(from, to);
+		}
+	}
+	return (retran_decr);
+}
+
+int ScoreBoardBV::CheckSndNxt (hdr_tcp* tcph)
+{
+	int sack_index, sack_right, i, to;
+	int force_timeout = 0;
+
+	if (length_ == 0)
+		return (0);
+	for (sack_index=0; sack_index < tcph->sa_length(); sack_index++) {
+		sack_right = tcph->sa_right(sack_index);
+		to = (sack_right < first_ + length_) ?
+			sack_right : first_ + length_;
+		if (to <= first_)
+			continue;
+		for (i = nextretran(first_, to); i >= 0;
+		     i = (i + 1 < to) ? nextretran(i + 1, to) : -1) {
+			if (snd_nxt_[i - base_] < sack_right) {
+				// the packet was lost again
+				clearbits(retran_, i, i + 1);
+				nretran_--;
+				snd_nxt_[i - base_] = 0;
+				summarize(i, i + 1);
+				force_timeout = 1;
+			}
+		}
+	}
+	return (force_timeout);
+}
+
+void ScoreBoardBV::ClearScoreBoard()
+{
+	if (length_) {
+		clearbits(sacked_, first_, first_ + length_);
+		clearbits(retran_, first_, first_ + length_);
+		summarize(first_, first_ + length_);
+	}
+	length_ = 0;
+	nsacked_ = nretran_ = 0;
+}
+
+int ScoreBoardBV::GetNextRetran()
+{
+	if (length_ == 0)
+		return (-1);
+	return (nextfree(first_, first_ + length_));
+}
+
+int ScoreBoardBV::GetNextUnacked (int seqno)
+{
+	int i, j, w;
+	sbword m;
+
+	if (!length_ || seqno < first_ || seqno >= first_ + length_)
+		return (-1);
+	i = seqno - base_;
+	j = first_ + length_ - base_;
+	w = i >> 5;
+	m = ~sacked_[w] & ~((1u << (i & 31)) - 1);
+	while (m == 0) {
+		if (++w << 5 >= j)
+			return (-1);
+		m = ~sacked_[w];
+	}
+	i = (w << 5) + sb_ctz(m);
+	return (i < j ? base_ + i : -1);
+}
+
+void ScoreBoardBV::MarkRetran (int retran_seqno, int snd_nxt)
+{
+	if (length_ == 0 || retran_seqno < first_ ||
+	    retran_seqno >= first_ + length_)
+		return;	// recreated (cleared) with the scoreboard anyway
+	nretran_ += setbits(retran_, retran_seqno, retran_seqno + 1);
+	snd_nxt_[retran_seqno - base_] = snd_nxt;
+	summarize(retran_seqno, retran_seqno + 1);
+}
+
+void ScoreBoardBV::MarkRetran (int retran_seqno)
+{
+	if (length_ == 0 || retran_seqno < first_ ||
+	    retran_seqno >= first_ + length_)
+		return;
+	nretran_ += setbits(retran_, retran_seqno, retran_seqno + 1);
+	summarize(retran_seqno, retran_seqno + 1);
+}
+
+void ScoreBoardBV::Dump()
+{
+	int i, b;
+
+	printf("SB len: %d  ", length_);
+	for (i = first_; i < first_ + length_; i++) {
+		b = i - base_;
+		printf("seq: %d  [ ", i);
+		if (sacked_[b >> 5] & (1u << (b & 31)))
+			printf("S");
+		if (retran_[b >> 5] & (1u << (b & 31)))
+			printf("R");
+		printf(" ]");
+	}
+	printf("\n");
+}
@@ -0,0 +1,92 @@
+/* -*-	Mode:C++; c-basic-offset:8; tab-width:8; indent-tabs-mode:t -*- */
+/*
+ * Copyright (c) 1994 Regents of the University of California.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor of the Laboratory may be used
+ *    to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+/*
+ * ScoreBoardBV: the ScoreBoard (scoreboard.h) as bit vectors.
+ *
+ * ScoreBoard keeps a node per packet in a ring and walks the ring from
+ * first_ on every UpdateScoreBoard(), GetNextRetran() and CheckSndNxt(),
+ * so with windows of tens of thousands of packets every ACK costs
+ * O(cwnd).  ScoreBoardBV keeps a bit per packet for "SACKed" and one
+ * for "retransmitted", with two summaries of a bit per 32-packet word:
+ * all packets of the word done (SACKed or retransmitted), and some
+ * packet of it retransmitted.  A SACK block costs O(length/32), and
+ * GetNextRetran() and CheckSndNxt() skip 1024 packets per summary bit.
+ * The counts of SACKed and retransmitted packets, for pipe estimates,
+ * are kept as bits change.  Every call gives the result ScoreBoard
+ * gives.
+ */
+
+#ifndef ns_scoreboard_bv_h
+#define ns_scoreboard_bv_h
+
+#include "scoreboard.h"
+
+class ScoreBoardBV : public ScoreBoard {
+public:
+	ScoreBoardBV();
+	virtual ~ScoreBoardBV();
+	virtual int IsEmpty () {return (length_ == 0);}
+	virtual void ClearScoreBoard ();
+	virtual int GetNextRetran ();
+	virtual void Dump();
+	virtual void MarkRetran (int retran_seqno);
+	virtual void MarkRetran (int retran_seqno, int snd_nxt);
+	virtual int UpdateScoreBoard (int last_ack_, hdr_tcp*);
+	virtual int CheckSndNxt (hdr_tcp*);
+	virtual int GetNextUnacked (int seqno);
+	// packets in the scoreboard SACKed, and retransmitted but not SACKed
+	inline int Sacked() { return (nsacked_); }
+	inline int Retransmitted() { return (nretran_); }
+
+protected:
+	typedef unsigned int sbword;
+
+	void restart(int seq);		// just seq, first_ = seq
+	void reserve(int seq);		// make room for packets below seq
+	int setbits(sbword* v, int from, int to);	// # bits newly set
+	int clearbits(sbword* v, int from, int to);	// # bits cleared
+	void summarize(int from, int to);	// redo summaries of [from, to)
+	int nextfree(int from, int to);	// neither SACKed nor rexmitted
+	int nextretran(int from, int to);	// retransmitted
+
+	int base_;		// packet of bit 0 (first_ >= base_)
+	int nwords_;		// words in each vector
+	sbword* sacked_;
+	sbword* retran_;
+	sbword* done_;		// summary: word of sacked_|retran_ all set
+	sbword* anyretran_;	// summary: word of retran_ not 0
+	int* snd_nxt_;		// per packet: snd_nxt at retransmission
+	int nsacked_;
+	int nretran_;
+};
+
+#endif
@@ -0,0 +1,201 @@
+/* -*-	Mode:C++; c-basic-offset:8; tab-width:8; indent-tabs-mode:t -*- */
+/*
+ * Copyright (c) 1994 Regents of the University of California.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor of the Laboratory may be used
+ *    to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "scoreboard-log.h"
+
+int
+ScoreBoardLog::open(const char* file, int writing)
+{
+	char magic[sizeof(SCBLOG_MAGIC) + 1];
+
+	close();
+	fp_ = fopen(file, writing ? "w" : "r");
+	if (fp_ == 0)
+		return (-1);
+	if (writing) {
+		fprintf(fp_, "%s\n", SCBLOG_MAGIC);
+		return (0);
+	}
+	if (fgets(magic, sizeof(magic), fp_) == 0 ||
+	    strncmp(magic, SCBLOG_MAGIC, sizeof(SCBLOG_MAGIC) - 1) != 0) {
+		close();
+		return (-1);
+	}
+	return (0);
+}
+
+void
+ScoreBoardLog::close()
+{
+	if (fp_ != 0) {
+		fclose(fp_);
+		fp_ = 0;
+	}
+}
+
+void
+ScoreBoardLog::put(int op, int n, const int* args)
+{
+	putc(op, fp_);
+	for (int i = 0; i < n; ++i)
+		fprintf(fp_, " %d", args[i]);
+	putc('\n', fp_);
+}
+
+/*
+ * Read the next call into op and args[0..n-1].  Returns 1 for a call,
+ * 0 at the end of the log, -1 for a malformed line.
+ */
+int
+ScoreBoardLog::get(int& op, int& n, int* args)
+{
+	char line[32 * SCBLOG_MAXARGS], *p, *q;
+	long v;
+
+	if (fgets(line, sizeof(line), fp_) == 0)
+		return (0);
+	op = line[0];
+	n = 0;
+	for (p = line + 1;; p = q) {
+		v = strtol(p, &q, 10);
+		if (q == p)
+			break;
+		if (n == SCBLOG_MAXARGS)
+			return (-1);
+		args[n++] = (int)v;
+	}
+	return ((op != 0 && strchr("UCRNMmZ", op) != 0) ? 1 : -1);
+}
+
+ScoreBoardRecord*
+ScoreBoardRecord::open(ScoreBoard* target, const char* file)
+{
+	ScoreBoardRecord* r = new ScoreBoardRecord(target);
+
+	if (r->log_.open(file, 1) < 0) {
+		r->target_ = 0;
+		delete r;
+		return (0);
+	}
+	return (r);
+}
+
+/* append <nsack> <left right>... to args, returning the count */
+int
+ScoreBoardRecord::sacks(int* args, hdr_tcp* tcph)
+{
+	int n = 0;
+
+	args[n++] = tcph->sa_length();
+	for (int i = 0; i < tcph->sa_length(); ++i) {
+		args[n++] = tcph->sa_left(i);
+		args[n++] = tcph->sa_right(i);
+	}
+	return (n);
+}
+
+void
+ScoreBoardRecord::ClearScoreBoard()
+{
+	target_->ClearScoreBoard();
+	log_.put(SCBLOG_CLEAR, 0, 0);
+}
+
+int
+ScoreBoardRecord::GetNextRetran()
+{
+	int r = target_->GetNextRetran();
+
+	log_.put(SCBLOG_NEXTRETRAN, 1, &r);
+	return (r);
+}
+
+void
+ScoreBoardRecord::MarkRetran(int retran_seqno)
+{
+	target_->MarkRetran(retran_seqno);
+	log_.put(SCBLOG_MARK1, 1, &retran_seqno);
+}
+
+void
+ScoreBoardRecord::MarkRetran(int retran_seqno, int snd_nxt)
+{
+	int args[2];
+
+	target_->MarkRetran(retran_seqno, snd_nxt);
+	args[0] = retran_seqno;
+	args[1] = snd_nxt;
+	log_.put(SCBLOG_MARK, 2, args);
+}
+
+int
+ScoreBoardRecord::UpdateScoreBoard(int last_ack, hdr_tcp* tcph)
+{
+	int args[SCBLOG_MAXARGS];
+	int n, r;
+
+	r = target_->UpdateScoreBoard(last_ack, tcph);
+	changed_ = target_->IsChanged();
+	args[0] = last_ack;
+	n = 1 + sacks(args + 1, tcph);
+	args[n++] = r;
+	args[n++] = changed_;
+	log_.put(SCBLOG_UPDATE, n, args);
+	return (r);
+}
+
+int
+ScoreBoardRecord::CheckSndNxt(hdr_tcp* tcph)
+{
+	int args[SCBLOG_MAXARGS];
+	int n, r;
+
+	r = target_->CheckSndNxt(tcph);
+	n = sacks(args, tcph);
+	args[n++] = r;
+	log_.put(SCBLOG_SNDNXT, n, args);
+	return (r);
+}
+
+int
+ScoreBoardRecord::GetNextUnacked(int seqno)
+{
+	int args[2];
+
+	args[0] = seqno;
+	args[1] = target_->GetNextUnacked(seqno);
+	log_.put(SCBLOG_NEXTUNACKED, 2, args);
+	return (args[1]);
+}
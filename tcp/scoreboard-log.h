@@ -0,0 +1,108 @@
+/* -*-	Mode:C++; c-basic-offset:8; tab-width:8; indent-tabs-mode:t -*- */
+/*
+ * Copyright (c) 1994 Regents of the University of California.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor of the Laboratory may be used
+ *    to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+
+/*
+ * Scoreboard call logs.
+ *
+ * A ScoreBoardLog is a text record of the calls a TCP sender makes on
+ * its SACK scoreboard, with the results they returned.  The
+ * "record-scoreboard <file>" command of Agent/TCP/Fack and
+ * Agent/TCP/Sack1 puts a ScoreBoardRecord in front of the agent's
+ * scoreboard, which writes such a log while the simulation runs;
+ * ScoreBoardBench (scoreboard-bench.cc) replays logs, or synthetic
+ * ones of its own making, against each scoreboard implementation.
+ *
+ * After the magic line SCBLOG_MAGIC, one call per line:
+ *
+ *	U <last_ack> <nsack> <left right>... <result> <changed>
+ *	C <nsack> <left right>... <result>		CheckSndNxt
+ *	R <result>					GetNextRetran
+ *	N <seqno> <result>				GetNextUnacked
+ *	M <seqno> <snd_nxt>				MarkRetran
+ *	m <seqno>					MarkRetran
+ *	Z						ClearScoreBoard
+ */
+
+#ifndef ns_scoreboard_log_h
+#define ns_scoreboard_log_h
+
+#include <stdio.h>
+#include "scoreboard.h"
+
+#define SCBLOG_MAGIC		"NSSCB1"
+#define SCBLOG_UPDATE		'U'
+#define SCBLOG_SNDNXT		'C'
+#define SCBLOG_NEXTRETRAN	'R'
+#define SCBLOG_NEXTUNACKED	'N'
+#define SCBLOG_MARK		'M'
+#define SCBLOG_MARK1		'm'
+#define SCBLOG_CLEAR		'Z'
+#define SCBLOG_MAXARGS		(2 * (NSA + 1) + 4)
+
+class ScoreBoardLog {
+public:
+	ScoreBoardLog() : fp_(0) {}
+	~ScoreBoardLog() { close(); }
+	int open(const char* file, int writing);
+	void close();
+	int is_open() const { return (fp_ != 0); }
+	void put(int op, int n, const int* args);
+	int get(int& op, int& n, int* args);
+protected:
+	FILE* fp_;
+};
+
+class ScoreBoardRecord : public ScoreBoard {
+public:
+	// target, or 0 if file cannot be written; target_ is then not ours
+	static ScoreBoardRecord* open(ScoreBoard* target, const char* file);
+	virtual ~ScoreBoardRecord() { delete target_; }
+	virtual int IsEmpty () { return (target_->IsEmpty()); }
+	virtual void ClearScoreBoard ();
+	virtual int GetNextRetran ();
+	virtual void Dump() { target_->Dump(); }
+	virtual void MarkRetran (int retran_seqno);
+	virtual void MarkRetran (int retran_seqno, int snd_nxt);
+	virtual int UpdateScoreBoard (int last_ack_, hdr_tcp*);
+	virtual int CheckUpdate() { return (target_->CheckUpdate()); }
+	virtual int CheckSndNxt (hdr_tcp*);
+	virtual int GetNextUnacked (int seqno);
+protected:
+	ScoreBoardRecord(ScoreBoard* target) : ScoreBoard(NULL, 0),
+		target_(target) {}
+	int sacks(int* args, hdr_tcp* tcph);
+
+	ScoreBoard* target_;	// the scoreboard doing the real work
+	ScoreBoardLog log_;
+};
+
+#endif
@@ -39,7 +39,9 @@
 
 class ScoreBoardRQ : public ScoreBoard {
 public:
-	ScoreBoardRQ(): ScoreBoard(NULL, 0), h_seqno_(-1),sack_min(-1), rq_(sack_min){};
+	ScoreBoardRQ(int index = FALSE): ScoreBoard(NULL, 0), h_seqno_(-1),sack_min(-1), rq_(sack_min){
+		rq_.index(index);	// see rq.h: for many holes
+	};
 	virtual ~ScoreBoardRQ(){delete[] SBN;}
 	virtual int IsEmpty ();
 	virtual void ClearScoreBoard () {rq_.clear(); h_seqno_ = -1;}; 
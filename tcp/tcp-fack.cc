@@ -30,6 +30,8 @@ static const char rcsid[] =
 #include "tcp.h"
 #include "flags.h"
 #include "scoreboard.h"
+#include "scoreboard-bv.h"
+#include "scoreboard-log.h"
 #include "random.h"
 #include "tcp-fack.h"
 #include "template.h"
@@ -45,15 +47,35 @@ public:
 
 FackTcpAgent::FackTcpAgent() : 	timeout_(FALSE), wintrim_(0),
 	wintrimmult_(.5), rampdown_(0), fack_(-1), retran_data_(0),
-	ss_div4_(0)		// What about fastrecov_ and scb_
+	ss_div4_(0), sb_bitmap_(0)	// What about fastrecov_ and scb_
 {
 	bind_bool("ss-div4_", &ss_div4_);
 	bind_bool("rampdown_", &rampdown_);
-	scb_ = new ScoreBoard(new ScoreBoardNode[SBSIZE],SBSIZE);
+	bind_bool("sb_bitmap_", &sb_bitmap_);
+	/* the bit vector scoreboard is for windows of many packets */
+	if (sb_bitmap_)
+		scb_ = new ScoreBoardBV();
+	else
+		scb_ = new ScoreBoard(new ScoreBoardNode[SBSIZE],SBSIZE);
 }
 
 FackTcpAgent::~FackTcpAgent(){
-	delete [] scb_;
+	delete scb_;
+}
+
+int FackTcpAgent::command(int argc, const char*const* argv)
+{
+	if (argc == 3 && strcmp(argv[1], "record-scoreboard") == 0) {
+		ScoreBoardRecord* r = ScoreBoardRecord::open(scb_, argv[2]);
+		if (r == 0) {
+			Tcl::instance().resultf("%s: cannot write %s",
+						name(), argv[2]);
+			return (TCL_ERROR);
+		}
+		scb_ = r;
+		return (TCL_OK);
+	}
+	return (TcpAgent::command(argc, argv));
 }
 
 int FackTcpAgent::window() 
@@ -57,6 +57,7 @@ class FackTcpAgent : public TcpAgent {
 	void reset();
 	virtual void send_much(int force, int reason, int maxburst = 0);
 	virtual void recv_newack_helper(Packet* pkt);
+	int command(int argc, const char*const* argv);
  protected:
 	u_char timeout_;	/* flag: sent pkt from timeout; */
 	u_char fastrecov_;	/* flag: in fast recovery */
@@ -66,6 +67,7 @@ class FackTcpAgent : public TcpAgent {
 	int fack_;
 	int retran_data_;
 	int ss_div4_;
+	int sb_bitmap_;		/* ScoreBoardBV instead of ScoreBoard */
 
 	ScoreBoard* scb_;
 	static const int SBSIZE=1024;
@@ -195,6 +195,7 @@ FullTcpAgent::delay_bind_init_all()
         delay_bind_init_one("ecn_syn_wait_");
         delay_bind_init_one("debug_");
         delay_bind_init_one("spa_thresh_");
+        delay_bind_init_one("rq_index_");
 
 	TcpAgent::delay_bind_init_all();
        
@@ -225,6 +226,7 @@ FullTcpAgent::delay_bind_dispatch(const char *varName, const char *localName, Tc
         if (delay_bind_bool(varName, localName, "ecn_syn_", &ecn_syn_, tracer)) return TCL_OK;
         if (delay_bind(varName, localName, "ecn_syn_wait_", &ecn_syn_wait_, tracer)) return TCL_OK;
         if (delay_bind_bool(varName, localName, "debug_", &debug_, tracer)) return TCL_OK;
+        if (delay_bind_bool(varName, localName, "rq_index_", &rq_index_, tracer)) return TCL_OK;
 
         return TcpAgent::delay_bind_dispatch(varName, localName, tracer);
 }
@@ -727,6 +729,8 @@ FullTcpAgent::reass(Packet* pkt)
 		abort();
 	}
 
+	if (rq_.indexed() != rq_index_)
+		rq_.index(rq_index_);
 	flags = rq_.add(start, end, tiflags, 0);
 
 	//present:
@@ -3001,6 +3005,8 @@ SackFullTcpAgent::process_sack(hdr_tcp* tcph)
 		return;
 	}	
 
+	if (sq_.indexed() != rq_index_)
+		sq_.index(rq_index_);
 	int slen = tcph->sa_length(), i;
 	for (i = 0; i < slen; ++i) {
 		/* Added check for FIN   -M. Weigle 5/21/02 */
@@ -116,7 +116,7 @@ public:
         	last_send_time_(-1.0), infinite_send_(FALSE), irs_(-1),
         	delack_timer_(this), flags_(0),
         	state_(TCPS_CLOSED), recent_ce_(FALSE),
-        	last_state_(TCPS_CLOSED), rq_(rcv_nxt_), last_ack_sent_(-1) { }
+        	last_state_(TCPS_CLOSED), rq_(rcv_nxt_), rq_index_(0), last_ack_sent_(-1) { }
 
 	~FullTcpAgent() { cancel_timers(); rq_.clear(); }
 	virtual void recv(Packet *pkt, Handler*);
@@ -126,6 +126,7 @@ public:
 	void advance_bytes(int);	// unique to full-tcp
         virtual void sendmsg(int nbytes, const char *flags = 0);
         virtual int& size() { return maxseg_; } //FullTcp uses maxseg_ for size_
+	inline int& maxseg() { return maxseg_; }	// segsize_
 	virtual int command(int argc, const char*const* argv);
        	virtual void reset();       		// reset to a known point
 protected:
@@ -232,6 +233,7 @@ protected:
 	int last_state_; /* FSM state at last pkt recv */
 	int rcv_nxt_;       /* next sequence number expected */
 	ReassemblyQueue rq_;    /* TCP reassembly queue */
+	int rq_index_;      /* index rq_ (and sq_) for many holes (see rq.h) */
 	/*
 	* the following are part of a tcpcb in "real" RFC1323 TCP
 	*/
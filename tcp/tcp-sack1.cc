@@ -40,6 +40,7 @@
 #include "flags.h"
 #include "scoreboard.h"
 #include "scoreboard-rq.h"
+#include "scoreboard-log.h"
 #include "random.h"
 
 #define TRUE    1
@@ -60,6 +61,7 @@ class Sack1TcpAgent : public TcpAgent {
 	virtual void partial_ack_action();
 	void plot();
 	virtual void send_much(int force, int reason, int maxburst);
+	int command(int argc, const char*const* argv);
  protected:
 	u_char timeout_;	/* boolean: sent pkt from timeout? */
 	u_char fastrecov_;	/* boolean: doing fast recovery? */
@@ -69,6 +71,7 @@ class Sack1TcpAgent : public TcpAgent {
 	int next_pkt_;		/* Next packet to transmit during Fast */
 				/*  Retransmit as a result of a partial ack. */
 	int firstpartial_;	/* First of a series of partial acks. */
+	int sb_index_;		/* index the scoreboard for many holes */
 	ScoreBoard* scb_;
 	static const int SBSIZE=64; /* Initial scoreboard size */
 };
@@ -81,20 +84,36 @@ public:
 	}
 } class_sack;
 
-Sack1TcpAgent::Sack1TcpAgent() : fastrecov_(FALSE), pipe_(-1), next_pkt_(0), firstpartial_(0)
+Sack1TcpAgent::Sack1TcpAgent() : fastrecov_(FALSE), pipe_(-1), next_pkt_(0), firstpartial_(0), sb_index_(0)
 {
 	bind_bool("partial_ack_", &partial_ack_);
+	bind_bool("sb_index_", &sb_index_);
 	/* Use the Reassembly Queue based scoreboard as
 	 * ScoreBoard is O(cwnd) which is bad for HSTCP
 	 * scb_ = new ScoreBoard(new ScoreBoardNode[SBSIZE],SBSIZE);
 	 */
-	scb_ = new ScoreBoardRQ();
+	scb_ = new ScoreBoardRQ(sb_index_);
 }
 
 Sack1TcpAgent::~Sack1TcpAgent(){
 	delete scb_;
 }
 
+int Sack1TcpAgent::command(int argc, const char*const* argv)
+{
+	if (argc == 3 && strcmp(argv[1], "record-scoreboard") == 0) {
+		ScoreBoardRecord* r = ScoreBoardRecord::open(scb_, argv[2]);
+		if (r == 0) {
+			Tcl::instance().resultf("%s: cannot write %s",
+						name(), argv[2]);
+			return (TCL_ERROR);
+		}
+		scb_ = r;
+		return (TCL_OK);
+	}
+	return (TcpAgent::command(argc, argv));
+}
+
 void Sack1TcpAgent::reset ()
 {
 	scb_->ClearScoreBoard();
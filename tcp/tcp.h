@@ -186,6 +186,8 @@ public:
 	/* These two functions aid Tmix one-way TCP agents */
 	int is_closed() {return closed_;} 
 	void clr_closed() {closed_ = 0;}
+	/* max window (window_), for agents reused by traffic generators */
+	inline double& wnd() { return wnd_; }
 protected:
 	virtual int window();
 	virtual double windowd();
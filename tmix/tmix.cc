@@ -151,6 +151,8 @@ Tmix::~Tmix()
 			 get_total(), get_active());
 		fprintf (stderr, "(apps in pool: %d  active: %d)\n", 
 			 (int) appPool_.size(), (int) appActive_.size());
+		tcpPool_.stats(tcl);
+		fprintf (stderr, "TCP agents: %s\n", tcl.result());
 	}
 	
 	/* cancel timer */
@@ -179,11 +181,8 @@ Tmix::~Tmix()
 
 	/* delete agents in the pool */
 	TmixAgent* tcp;
-	while (!tcpPool_.empty()) {
-		tcp = tcpPool_.front();
+	while ((tcp = tcpPool_.drain()) != NULL)
 		tcl.evalf ("delete %s", tcp->name());
- 		tcpPool_.pop();
-	}
 
 	/* delete connections */
 	for (list<ConnVector*>::iterator i = connections_.begin();
@@ -205,22 +204,18 @@ TmixAgent* Tmix::picktcp()
 {
 	TmixAgent* a;
 
-	if (! tcpPool_.empty()) {
-		/* check to see if oldest agent has been in for 1 second */
-		a = tcpPool_.front();
-		if (a->inPoolFor1s(now())) {
-			tcpPool_.pop();    /* remove top from queue */
-
-			if (debug_ >= 6) {
-				fprintf (stderr, "\tflow %lu got TCPAgent %s", 
-					 total_connections_, a->name());
-				fprintf (stderr, " from pool (%.3f s in pool, %d in pool)\n", a->getTimeInPool(now()), (int) tcpPool_.size());
-			}
-			return a;
-		}
-		else if (debug_ >= 6) {
-			fprintf (stderr, "\t head of queue, only %.3f s in pool\n", a->getTimeInPool(now()));
+	/* reuse the oldest agent if it has been in the pool 
+	   for more than 1 second */
+	a = tcpPool_.get(now(), 1.0);
+	if (a != NULL) {
+		a->setReused(1);
+		if (debug_ >= 6) {
+			fprintf (stderr, "\tflow %lu got TCPAgent %s", 
+				 total_connections_, a->name());
+			fprintf (stderr, " from pool (%d in pool)\n", 
+				 tcpPool_.idle());
 		}
+		return a;
 	}
 
 	/* Need to create new Agent - 
@@ -230,10 +225,11 @@ TmixAgent* Tmix::picktcp()
 		fprintf (stderr, "Failed to allocate a TCP agent\n");
 		abort();
 	}
+	tcpPool_.created();
 	if (debug_ >= 6) {
 		fprintf (stderr, 
 			 "\tflow %lu created new TCPAgent %s (%d in pool)\n",
-			 total_connections_, a->name(), (int) tcpPool_.size());
+			 total_connections_, a->name(), tcpPool_.idle());
 	}
 	return a;
 }
@@ -359,16 +355,13 @@ void Tmix::recycle(TmixAgent* agent)
 	/* reinitialize agent */
 	agent->reset();
 
-	/* set the time agent entered the pool */
-	agent->setPoolTime(now());
-
 	/* add to the inactive agent pool */
-	tcpPool_.push (agent);
+	tcpPool_.put (agent, now());
 
 	if (debug_ >= 6) {
 		fprintf (stderr, "\tTCPAgent %s moved to pool ", 
 			 agent->name());
-		fprintf (stderr, "(%d in pool)\n", (int) tcpPool_.size());
+		fprintf (stderr, "(%d in pool)\n", tcpPool_.idle());
 	}
 }
 
@@ -1099,6 +1092,10 @@ int Tmix::command(int argc, const char*const* argv) {
 			stop();
 			return (TCL_OK);
 		}
+		else if (strcmp (argv[1], "pool-stats") == 0) {
+			tcpPool_.stats(Tcl::instance());
+			return (TCL_OK);
+		}
 		else if (strcmp (argv[1], "active-connections") == 0) {
 			if (outfp_) {
 				fprintf (outfp_, "%lu ", get_active());
@@ -50,6 +50,7 @@
 #include "timer-handler.h"
 #include "app.h"
 #include "node.h"
+#include "agent-pool.h"
 #include <string>
 #include <stack>
 #include <queue>
@@ -411,7 +412,7 @@ protected:
 	}
 
 	/* Agent and App Pools */
-	queue<TmixAgent*> tcpPool_;
+	AgentPool<TmixAgent> tcpPool_;	/* see agent-pool.h */
 	queue<TmixApp*> appPool_;
 
 	/* string = tcpAgent's name */
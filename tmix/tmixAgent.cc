@@ -83,6 +83,13 @@ void TmixOneWayAgent::attachApp(Application* app) {
 }
 
 void TmixOneWayAgent::configureTcp(Tmix* tmixInstance, int window, int mss) {
+  if (reused) {
+    // the sink keeps its configure-sink settings
+    agent->flowid() = tmixInstance->get_total();
+    dynamic_cast<TcpAgent*>(agent)->wnd() = window;
+    agent->size() = mss;
+    return;
+  }
   Tcl& tcl = Tcl::instance();
 
   tcl.evalf ("%s configure-source %s %d %d %d", tmixInstance->name(), 
@@ -101,6 +108,21 @@ void TmixOneWayAgent::reset() {
 }
 
 void TmixOneWayAgent::connect(TmixAgent * peer) {
+  Agent* peer_sink = (dynamic_cast<TmixOneWayAgent*>(peer))->getSink();
+
+  if (reused && peer->isReused() && pool_fast_connect()) {
+    // what the two "$ns connect"s below do
+    Agent* peer_agent = peer->getAgent();
+    agent->daddr() = peer_sink->addr();
+    agent->dport() = peer_sink->port();
+    peer_sink->daddr() = agent->addr();
+    peer_sink->dport() = agent->port();
+    peer_agent->daddr() = sink->addr();
+    peer_agent->dport() = sink->port();
+    sink->daddr() = peer_agent->addr();
+    sink->dport() = peer_agent->port();
+    return;
+  }
   Tcl& tcl = Tcl::instance();
 	
   tcl.evalf ("set ns [Simulator instance]");
@@ -135,6 +157,14 @@ void TmixFullAgent::attachToNode(Node * node) {
 }
 	
 void TmixFullAgent::configureTcp(Tmix* tmixInstance, int window, int mss) {
+  if (reused) {
+    // the done proc is still in place; what setup-tcp sets
+    FullTcpAgent* tcp = dynamic_cast<FullTcpAgent*>(agent);
+    tcp->flowid() = tmixInstance->get_total();
+    tcp->wnd() = window;
+    tcp->maxseg() = mss;
+    return;
+  }
   Tcl& tcl = Tcl::instance();
 		
   // note that for fulltcp init_mss == acc_mss
@@ -143,6 +173,14 @@ void TmixFullAgent::configureTcp(Tmix* tmixInstance, int window, int mss) {
 }
 
 void TmixFullAgent::connect(TmixAgent * peer) {
+  if (reused && peer->isReused() && pool_fast_connect()) {
+    // what "$ns connect" does
+    agent->daddr() = peer->addr();
+    agent->dport() = peer->port();
+    peer->getAgent()->daddr() = addr();
+    peer->getAgent()->dport() = port();
+    return;
+  }
   Tcl& tcl = Tcl::instance();
 	
   tcl.evalf ("set ns [Simulator instance]");
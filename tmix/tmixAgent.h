@@ -50,7 +50,7 @@
 class Tmix;
 class TmixAgent : public TclObject {
 public:
-  TmixAgent(Tmix * t) : TclObject(), agent(NULL), tmix(t) {}
+  TmixAgent(Tmix * t) : TclObject(), agent(NULL), reused(0), tmix(t) {}
   inline const char* name() { return agent->name(); }
   inline void sendmsg(int bytes) { agent->sendmsg(bytes); agent->clr_closed(); }
   inline nsaddr_t& port() { return agent->port(); }
@@ -58,9 +58,8 @@ public:
   inline Agent* getAgent() { return agent; }
   inline int getType() { return type; }
   inline int is_closed() { return agent->is_closed(); }
-  inline double getTimeInPool(double now) {return (now - time_entered_pool);}
-  inline bool inPoolFor1s(double now) {return (now-time_entered_pool > 1);}
-  inline void setPoolTime (double now) {time_entered_pool = now;}
+  inline int isReused() { return reused; }
+  inline void setReused(int r) { reused = r; }
   virtual void attachApp(Application* app);
   virtual inline Agent* getSink() { return NULL; }
 	
@@ -81,9 +80,10 @@ public:
 protected:
   Agent* agent;
   int type;
-  double time_entered_pool;    /* time agent entered pool - to ensure agents
-				  aren't re-used until they've been in pool
-				  for at least 1 second */
+  int reused;                  /* taken from the pool: already set up by
+				  OTcl, so configureTcp() and (unless
+				  useasim_) connect() need not go through
+				  OTcl */
   Tmix * tmix;
 };
 
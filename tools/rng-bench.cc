@@ -0,0 +1,227 @@
+/* -*-	Mode:C++; c-basic-offset:8; tab-width:8; indent-tabs-mode:t -*- */
+/*
+ * Copyright (c) 1994 Regents of the University of California.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor of the Laboratory may be used
+ *    to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+
+/*
+ * RNGBench: per-call and block throughput of the MRG32k3a streams
+ * (see RNG::set_block() and RNG::rand_u01_block() in tools/rng.h).
+ *
+ *	$bench run <rng> next|exponential|block <count>
+ *		draw <count> numbers from <rng> by next_double() (what
+ *		every uniform() comes down to), by exponential(), or
+ *		RNG_BLOCK * 4 at a time by rand_u01_block(), returning a
+ *		list of {name value} statistics
+ *	$bench check <count> ?seed?
+ *		draw <count> numbers, with the antithetic and increased
+ *		precision switches, state jumps and blocks of random
+ *		sizes mixed in, from a stream that generates them one at
+ *		a time and from one that buffers them, and return the
+ *		number of mismatches
+ *
+ * "$rng block 0" makes <rng> generate one number per call, as before
+ * there were blocks.  tcl/ex/rng-bench.tcl drives this.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "config.h"
+#ifndef WIN32
+#include <sys/time.h>
+#endif
+#include <time.h>
+
+#include "rng.h"
+
+#ifndef OLD_RNG
+
+#define BENCH_BLOCK	(RNG_BLOCK * 4)
+
+class RNGBench : public TclObject {
+public:
+	RNGBench() {}
+	int command(int argc, const char*const* argv);
+protected:
+	void run(RNG* rng, const char* how, long count);
+	void check(long count, long seed);
+};
+
+static class RNGBenchClass : public TclClass {
+public:
+	RNGBenchClass() : TclClass("RNGBench") {}
+	TclObject* create(int /* argc */, const char*const* /* argv */) {
+		return (new RNGBench);
+	}
+} class_rng_bench;
+
+static double
+bench_now()
+{
+#ifdef CLOCK_MONOTONIC
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (ts.tv_sec + 1e-9 * ts.tv_nsec);
+#else
+	timeval tv;
+	gettimeofday(&tv, 0);
+	return (tv.tv_sec + 1e-6 * tv.tv_usec);
+#endif
+}
+
+void
+RNGBench::run(RNG* rng, const char* how, long count)
+{
+	Tcl& tcl = Tcl::instance();
+	double u[BENCH_BLOCK];
+	double sum = 0, t0, t1;
+	long i;
+	int j;
+
+	t0 = bench_now();
+	if (strcmp(how, "block") == 0) {
+		for (i = 0; i < count; i += BENCH_BLOCK) {
+			rng->rand_u01_block(u, BENCH_BLOCK);
+			for (j = 0; j < BENCH_BLOCK; ++j)
+				sum += u[j];
+		}
+		count = i;
+	} else if (strcmp(how, "exponential") == 0) {
+		for (i = 0; i < count; ++i)
+			sum += rng->exponential();
+	} else {
+		for (i = 0; i < count; ++i)
+			sum += rng->next_double();
+	}
+	t1 = bench_now();
+
+	double elapsed = t1 - t0;
+	if (elapsed <= 0)
+		elapsed = 1e-9;
+	// the sum keeps the loops honest, and tells whether two runs
+	// drew the same numbers
+	tcl.resultf("values %ld seconds %.6f rate %.0f ns %.2f sum %.6f",
+		    count, elapsed, count / elapsed, 1e9 * elapsed / count,
+		    sum);
+}
+
+void
+RNGBench::check(long count, long seed)
+{
+	Tcl& tcl = Tcl::instance();
+	// copies, which leave the streams of the package alone
+	RNG& a = *RNG::substream(*RNG::defaultrng(), 0);
+	RNG& b = *RNG::substream(a, 0);
+	RNG& pick = *RNG::substream(a, 0);
+	double u[BENCH_BLOCK];
+	unsigned long sa[6], sb[6];
+	long i, mismatch = 0;
+	int j, n;
+
+	for (j = 0; j < 6; ++j)
+		sa[j] = seed + j;
+	a.set_seed(sa);
+	b.set_seed(sa);
+	sa[0] += 6;
+	pick.set_seed(sa);
+	a.set_block(0);
+	for (i = 0; i < count; ) {
+		int op = pick.uniform(100);
+		if (op < 80) {
+			if (a.next_double() != b.next_double())
+				++mismatch;
+			++i;
+		} else if (op < 90) {
+			n = pick.uniform(BENCH_BLOCK);
+			b.rand_u01_block(u, n);
+			for (j = 0; j < n; ++j)
+				if (a.next_double() != u[j])
+					++mismatch;
+			i += n;
+		} else if (op < 93) {
+			a.get_state(sa);
+			b.get_state(sb);
+			for (j = 0; j < 6; ++j)
+				if (sa[j] != sb[j])
+					++mismatch;
+		} else if (op < 95) {
+			bool f = pick.uniform(2);
+			a.set_antithetic(f);
+			b.set_antithetic(f);
+		} else if (op < 97) {
+			bool f = pick.uniform(4) == 0;
+			a.increased_precis(f);
+			b.increased_precis(f);
+		} else if (op < 98) {
+			n = pick.uniform(100);
+			a.advance_state(0, n);
+			b.advance_state(0, n);
+		} else if (op < 99) {
+			a.reset_next_substream();
+			b.reset_next_substream();
+		} else {
+			b.set_block(pick.uniform(RNG_BLOCK + 1));
+		}
+	}
+	tcl.resultf("values %ld mismatches %ld", i, mismatch);
+	delete &a;
+	delete &b;
+	delete &pick;
+}
+
+int
+RNGBench::command(int argc, const char*const* argv)
+{
+	Tcl& tcl = Tcl::instance();
+	if (argc == 3 || argc == 4) {
+		if (strcmp(argv[1], "check") == 0) {
+			long seed = (argc == 4) ? atol(argv[3]) : 12345;
+			if (seed <= 0 || seed > MAXINT) {
+				tcl.resultf("%s: bad seed %s", name(), argv[3]);
+				return (TCL_ERROR);
+			}
+			check(atol(argv[2]), seed);
+			return (TCL_OK);
+		}
+	} else if (argc == 5) {
+		if (strcmp(argv[1], "run") == 0) {
+			RNG* rng = (RNG*)TclObject::lookup(argv[2]);
+			if (rng == 0) {
+				tcl.resultf("%s: no RNG %s", name(), argv[2]);
+				return (TCL_ERROR);
+			}
+			run(rng, argv[3], atol(argv[4]));
+			return (TCL_OK);
+		}
+	}
+	return (TclObject::command(argc, argv));
+}
+
+#endif /* !OLD_RNG */
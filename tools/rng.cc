@@ -67,6 +67,11 @@ static const char rcsid[] =
 #include <stdio.h>
 #ifndef OLD_RNG
 #include <string.h>
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RNG_SSE2
+#include <emmintrin.h>
+#endif
 #endif /* !OLD_RNG */
 #include "rng.h"
 
@@ -188,7 +193,7 @@ public:
 
 /* default RNG */
 
-RNG* RNG::default_ = NULL;
+NS_THREAD_LOCAL RNG* RNG::default_ = NULL;
 
 double
 RNG::normal(double avg, double std)
@@ -233,6 +238,12 @@ RNG::command(int argc, const char*const* argv)
 			tcl.resultf("%6e", uniform(d));
 			return (TCL_OK);
 		}
+		if (strcmp(argv[1], "block") == 0) {
+#ifndef OLD_RNG
+			set_block(atoi(argv[2]));
+#endif /* !OLD_RNG */
+			return (TCL_OK);
+		}
 		if (strcmp(argv[1], "seed") == 0) {
 			int s = atoi(argv[2]);
 			// NEEDSWORK: should be a way to set seed to PRDEF_SEED_SOURCE
@@ -722,6 +733,115 @@ namespace
 		} 
 		return 0; 
 	} 
+
+	//-------------------------------------------------------------------- 
+	// One step of both components from state C; returns the number 
+	// before the antithetic flip.  This is the recurrence of U01(). 
+	// 
+	inline double Step (double C[6]) 
+	{ 
+		long k; 
+		double p1, p2; 
+		p1 = a12 * C[1] - a13n * C[0]; 
+		k = static_cast<long> (p1 / m1); 
+		p1 -= k * m1; 
+		if (p1 < 0.0) p1 += m1; 
+		C[0] = C[1]; C[1] = C[2]; C[2] = p1; 
+		p2 = a21 * C[5] - a23n * C[3]; 
+		k = static_cast<long> (p2 / m2); 
+		p2 -= k * m2; 
+		if (p2 < 0.0) p2 += m2; 
+		C[3] = C[4]; C[4] = C[5]; C[5] = p2; 
+		return ((p1 > p2) ? (p1 - p2) * norm : (p1 - p2 + m1) * norm); 
+	} 
+
+	//-------------------------------------------------------------------- 
+	// p MOD m for integral |p| < 2^53, by the reciprocal of m.  The 
+	// quotient may be one off where p/m is within rounding of an 
+	// integer, which the two corrections take care of, so this is 
+	// exactly what Step() gets by dividing. 
+	// 
+	inline double ModM (double p, double m, double minv) 
+	{ 
+		p -= static_cast<double> (static_cast<long> (p * minv)) * m; 
+		if (p < 0.0) 
+			p += m; 
+		else if (p >= m) 
+			p -= m; 
+		return p; 
+	} 
+
+	//-------------------------------------------------------------------- 
+	// Fill u[0..n-1] with the next n numbers from state C, as n calls 
+	// of Step() would.  The first component gives two numbers per 
+	// step, x(n) = a12 x(n-2) - a13n x(n-3) and x(n+1) = a12 x(n-1) - 
+	// a13n x(n-2) both depending on the state alone, so they go in the 
+	// two lanes of an SSE2 register; the second, y(n) = a21 y(n-1) - 
+	// a23n y(n-3), is a chain and stays scalar.  Every lane does the 
+	// same IEEE operations as the scalar code, so the numbers are the 
+	// same bit for bit. 
+	// 
+#ifdef RNG_SSE2
+	inline __m128d ModM2 (__m128d p, __m128d m, __m128d minv) 
+	{ 
+		__m128d k = _mm_cvtepi32_pd (_mm_cvttpd_epi32 ( 
+			_mm_mul_pd (p, minv))); 
+		p = _mm_sub_pd (p, _mm_mul_pd (k, m)); 
+		p = _mm_add_pd (p, _mm_and_pd ( 
+			_mm_cmplt_pd (p, _mm_setzero_pd ()), m)); 
+		p = _mm_sub_pd (p, _mm_and_pd (_mm_cmpge_pd (p, m), m)); 
+		return p; 
+	} 
+#endif 
+
+	void StepBlock (double C[6], double* u, int n) 
+	{ 
+		const double m2inv = 1.0 / m2; 
+		double y0 = C[3], y1 = C[4], y2 = C[5], p2, q2; 
+		int i = 0; 
+#ifdef RNG_SSE2
+		const __m128d A12 = _mm_set1_pd (a12), A13N = _mm_set1_pd (a13n); 
+		const __m128d M1 = _mm_set1_pd (m1); 
+		const __m128d M1INV = _mm_set1_pd (1.0 / m1); 
+		const __m128d NORM = _mm_set1_pd (norm), ZERO = _mm_setzero_pd (); 
+		__m128d x01 = _mm_loadu_pd (&C[0]);	// x(n-3), x(n-2) 
+		__m128d x12 = _mm_loadu_pd (&C[1]);	// x(n-2), x(n-1) 
+		__m128d p, d; 
+		for (; i + 1 < n; i += 2) { 
+			p = ModM2 (_mm_sub_pd (_mm_mul_pd (A12, x12), 
+					       _mm_mul_pd (A13N, x01)), M1, M1INV); 
+			p2 = ModM (a21 * y2 - a23n * y0, m2, m2inv); 
+			q2 = ModM (a21 * p2 - a23n * y1, m2, m2inv); 
+			y0 = y2; y1 = p2; y2 = q2; 
+			x01 = _mm_shuffle_pd (x12, p, 1); 
+			x12 = p; 
+			d = _mm_sub_pd (p, _mm_set_pd (q2, p2)); 
+			d = _mm_add_pd (d, _mm_and_pd (_mm_cmple_pd (d, ZERO), M1)); 
+			_mm_storeu_pd (&u[i], _mm_mul_pd (d, NORM)); 
+		} 
+		_mm_storeu_pd (&C[0], x01); 
+		_mm_store_sd (&C[2], _mm_unpackhi_pd (x12, x12)); 
+#else 
+		const double m1inv = 1.0 / m1; 
+		double x0 = C[0], x1 = C[1], x2 = C[2], p1, q1, d; 
+		for (; i + 1 < n; i += 2) { 
+			p1 = ModM (a12 * x1 - a13n * x0, m1, m1inv); 
+			q1 = ModM (a12 * x2 - a13n * x1, m1, m1inv); 
+			p2 = ModM (a21 * y2 - a23n * y0, m2, m2inv); 
+			q2 = ModM (a21 * p2 - a23n * y1, m2, m2inv); 
+			x0 = x2; x1 = p1; x2 = q1; 
+			y0 = y2; y1 = p2; y2 = q2; 
+			d = p1 - p2; 
+			u[i] = ((d > 0.0) ? d : d + m1) * norm; 
+			d = q1 - q2; 
+			u[i + 1] = ((d > 0.0) ? d : d + m1) * norm; 
+		} 
+		C[0] = x0; C[1] = x1; C[2] = x2; 
+#endif 
+		C[3] = y0; C[4] = y1; C[5] = y2; 
+		if (i < n) 
+			u[i] = Step (C); 
+	} 
 } // end of anonymous namespace 
 
 //------------------------------------------------------------------------- 
@@ -729,25 +849,54 @@ namespace
 // 
 double RNG::U01 () 
 { 
-	long k; 
-	double p1, p2, u; 
-	/* Component 1 */ 
-	p1 = a12 * Cg_[1] - a13n * Cg_[0]; 
-	k = static_cast<long> (p1 / m1); 
-	p1 -= k * m1; 
-	if (p1 < 0.0) p1 += m1; 
-	Cg_[0] = Cg_[1]; Cg_[1] = Cg_[2]; Cg_[2] = p1; 
-	/* Component 2 */ 
-	p2 = a21 * Cg_[5] - a23n * Cg_[3]; 
-	k = static_cast<long> (p2 / m2); 
-	p2 -= k * m2; 
-	if (p2 < 0.0) p2 += m2; 
-	Cg_[3] = Cg_[4]; Cg_[4] = Cg_[5]; Cg_[5] = p2; 
-	/* Combination */ 
-	u = ((p1 > p2) ? (p1 - p2) * norm : (p1 - p2 + m1) * norm); 
+	double u; 
+	if (pos_ < nbuf_) 
+		u = buf_[pos_++]; 
+	else if (nblock_ > 0) 
+		u = refill (); 
+	else 
+		u = Step (Cg_); 
 	return (anti_ == false) ? u : (1 - u); 
 } 
 
+//------------------------------------------------------------------------- 
+// Generate the next block of numbers from Cg_ (saved in Sg_, so 
+// that state() can find where the stream is) and hand out the first. 
+// 
+double RNG::refill () 
+{ 
+	for (int i = 0; i < 6; ++i) 
+		Sg_[i] = Cg_[i]; 
+	StepBlock (Cg_, buf_, nblock_); 
+	nbuf_ = nblock_; 
+	pos_ = 1; 
+	return buf_[0]; 
+} 
+
+//------------------------------------------------------------------------- 
+// The state as of the last number handed out: Cg_, or pos_ steps on 
+// from the start of the current block. 
+// 
+void RNG::state (double s[6]) const 
+{ 
+	int i; 
+	if (nbuf_ == 0) { 
+		for (i = 0; i < 6; ++i) 
+			s[i] = Cg_[i]; 
+		return; 
+	} 
+	for (i = 0; i < 6; ++i) 
+		s[i] = Sg_[i]; 
+	for (i = 0; i < pos_; ++i) 
+		Step (s); 
+} 
+
+void RNG::sync () 
+{ 
+	state (Cg_); 
+	nbuf_ = pos_ = 0; 
+} 
+
 //------------------------------------------------------------------------- 
 // Generate the next random number with extended (53 bits) precision. 
 // 
@@ -781,10 +930,37 @@ double RNG::U01d ()
  */
 RNG::RNG (long seed) 
 {
+	nblock_ = RNG_BLOCK;
+	nbuf_ = pos_ = 0;
 	set_seed (seed);
 	init();
 }
 
+/*
+ * A new generator that starts 2^e values past the start of the current
+ * substream of <from>.  Unlike the constructors this does not take the
+ * next stream of the package, so it leaves the streams of the
+ * generators created after it alone.
+ */
+RNG* RNG::substream (const RNG& from, long e)
+{
+	return (new RNG (from, e, 0));
+}
+
+RNG::RNG (const RNG& from, long e, int)
+{
+	anti_ = from.anti_;
+	inc_prec_ = from.inc_prec_;
+	name_[0] = 0;
+	nblock_ = from.nblock_;
+	nbuf_ = pos_ = 0;
+	for (int i = 0; i < 6; ++i)
+		Cg_[i] = from.Bg_[i];
+	advance_state (e, 0);
+	for (int i = 0; i < 6; ++i)
+		Bg_[i] = Ig_[i] = Cg_[i];
+}
+
 void RNG::init()
 {
 	anti_ = false; 
@@ -801,6 +977,7 @@ void RNG::init()
 	for (int i = 0; i < 6; ++i) { 
 		Bg_[i] = Cg_[i] = Ig_[i] = next_seed_[i]; 
 	} 
+	nbuf_ = pos_ = 0; 
 	MatVecModM (A1p127, next_seed_, next_seed_, m1); 
 	MatVecModM (A2p127, &next_seed_[3], &next_seed_[3], m2); 
 }
@@ -831,11 +1008,6 @@ long RNG::next()
 {
 	return (rand_int(0, MAXINT));
 }
-
-double RNG::next_double()
-{
-	return (rand_u01());
-}
 /* End of backward compatibility functions */
 
 // The default seed of the package; will be the seed of the first 
@@ -858,6 +1030,7 @@ RNG::RNG (const char *s)
 	else 
 		strcpy (name_, s);
 
+	nblock_ = RNG_BLOCK;
 	init();
 }
 
@@ -869,6 +1042,7 @@ void RNG::reset_start_stream ()
 { 
 	for (int i = 0; i < 6; ++i) 
 		Cg_[i] = Bg_[i] = Ig_[i]; 
+	nbuf_ = pos_ = 0; 
 } 
 
 //------------------------------------------------------------------------- 
@@ -878,6 +1052,7 @@ void RNG::reset_start_substream ()
 { 
 	for (int i = 0; i < 6; ++i) 
 		Cg_[i] = Bg_[i]; 
+	nbuf_ = pos_ = 0; 
 } 
 
 //------------------------------------------------------------------------- 
@@ -889,6 +1064,7 @@ void RNG::reset_next_substream ()
 	MatVecModM(A2p76, &Bg_[3], &Bg_[3], m2); 
 	for (int i = 0; i < 6; ++i) 
 		Cg_[i] = Bg_[i]; 
+	nbuf_ = pos_ = 0; 
 } 
 
 //------------------------------------------------------------------------- 
@@ -907,6 +1083,7 @@ void RNG::set_seed (const unsigned long seed[6])
 		abort();
 	for (int i = 0; i < 6; ++i) 
 		Cg_[i] = Bg_[i] = Ig_[i] = seed[i]; 
+	nbuf_ = pos_ = 0; 
 } 
 
 //------------------------------------------------------------------------- 
@@ -918,6 +1095,7 @@ void RNG::set_seed (const unsigned long seed[6])
 void RNG::advance_state (long e, long c) 
 { 
 	double B1[3][3], C1[3][3], B2[3][3], C2[3][3]; 
+	sync (); 
 	if (e > 0) { 
 		MatTwoPowModM (A1p0, B1, m1, e); 
 		MatTwoPowModM (A2p0, B2, m2, e); 
@@ -943,25 +1121,31 @@ void RNG::advance_state (long e, long c)
 //------------------------------------------------------------------------- 
 void RNG::get_state (unsigned long seed[6]) const 
 { 
+	double C[6]; 
+	state (C); 
 	for (int i = 0; i < 6; ++i) 
-		seed[i] = static_cast<unsigned long> (Cg_[i]); 
+		seed[i] = static_cast<unsigned long> (C[i]); 
 } 
 
 //------------------------------------------------------------------------- 
 void RNG::write_state () const 
 { 
+	double C[6]; 
+	state (C); 
 	printf ("The current state of the Rngstream %s:\n", name_);
 	printf (" Cg_ = { ");
 	for(int i=0;i<5;i++) { 
-		printf ("%lu, ", (unsigned long) Cg_[i]);
+		printf ("%lu, ", (unsigned long) C[i]);
 	} 
-	printf ("%lu }\n\n", (unsigned long) Cg_[5]);
+	printf ("%lu }\n\n", (unsigned long) C[5]);
 } 
 
 //------------------------------------------------------------------------- 
 void RNG::write_state_full () const 
 { 
 	int i; 
+	double C[6]; 
+	state (C); 
 	printf ("The RNG %s:\n", name_);
 	printf (" anti_ = %s", (anti_ ? "true" : "false")); 
 	printf (" inc_prec_ = %s\n", (inc_prec_ ? "true" : "false")); 
@@ -980,9 +1164,9 @@ void RNG::write_state_full () const
 
 	printf (" Cg_ = { ");
 	for (i = 0; i < 5; i++) { 
-		printf ("%lu, ", (unsigned long) Cg_[i]);
+		printf ("%lu, ", (unsigned long) C[i]);
 	} 
-	printf ("%lu }\n\n", (unsigned long) Cg_[5]);
+	printf ("%lu }\n\n", (unsigned long) C[5]);
 } 
 
 //------------------------------------------------------------------------- 
@@ -1008,6 +1192,37 @@ double RNG::rand_u01 ()
 		return U01(); 
 } 
 
+//------------------------------------------------------------------------- 
+// Generate the next n random numbers: what is left of the block, then 
+// straight into u. 
+// 
+void RNG::rand_u01_block (double* u, int n) 
+{ 
+	int i = 0; 
+	if (inc_prec_) { 
+		for (; i < n; ++i) 
+			u[i] = U01d (); 
+		return; 
+	} 
+	while (i < n && pos_ < nbuf_) 
+		u[i++] = buf_[pos_++]; 
+	if (i < n) { 
+		// the block, if any, is used up, so Cg_ is current 
+		StepBlock (Cg_, &u[i], n - i); 
+		nbuf_ = pos_ = 0; 
+	} 
+	if (anti_) 
+		for (i = 0; i < n; ++i) 
+			u[i] = 1 - u[i]; 
+} 
+
+//------------------------------------------------------------------------- 
+void RNG::set_block (int n) 
+{ 
+	sync (); 
+	nblock_ = (n < 0) ? 0 : (n > RNG_BLOCK) ? RNG_BLOCK : n; 
+} 
+
 //------------------------------------------------------------------------- 
 // Generate the next random integer. 
 // 
@@ -70,12 +70,16 @@
 
 #ifndef stand_alone
 #include "config.h"
+#else
+#define NS_THREAD_LOCAL
 #endif   /* stand_alone */
 
 #ifndef MAXINT
 #define	MAXINT	2147483647	// XX [for now]
 #endif
 
+#define RNG_BLOCK	64	/* values generated at once, see set_block() */
+
 #ifdef OLD_RNG
 /*
  * RNGImplementation is internal---do not use it, use RNG.
@@ -112,14 +116,26 @@ public:
 #else
 	RNG(const char* name = "");
 	RNG(long seed);
+	static RNG* substream(const RNG& from, long e);
 	void init();
 	long seed();
 	void set_seed (long seed);
 	long next();
-	double next_double();
+	inline double next_double() {
+		// straight from the block refill() generated, if any
+		if (pos_ < nbuf_ && !inc_prec_)
+			return (anti_ ? 1 - buf_[pos_++] : buf_[pos_++]);
+		return (rand_u01());
+	}
 #endif /* OLD_RNG */
 
-	RNG(RNGSources source, int seed = 1) { set_seed(source, seed); };
+	RNG(RNGSources source, int seed = 1) {
+#ifndef OLD_RNG
+		nblock_ = RNG_BLOCK;
+		nbuf_ = pos_ = 0;
+#endif /* !OLD_RNG */
+		set_seed(source, seed);
+	};
 	void set_seed(RNGSources source, int seed = 1);
 	inline static RNG* defaultrng() { return (default_); }
 
@@ -233,6 +249,21 @@ public:
 	  Returns a (pseudo)random number from the discrete uniform distribution
 	  over the integers {i, i +1,...,j}. Makes one call to RandU01.
 	*/
+
+	void rand_u01_block (double* u, int n); 
+	/*
+	  Fills u[0..n-1] with the next n numbers rand_u01() would return,
+	  generating them a block at a time.
+	*/
+
+	void set_block (int n); 
+	/*
+	  Sets how many numbers (at most RNG_BLOCK, the default) the stream
+	  generates at once and hands out from a buffer.  0 generates them one
+	  at a time.  The numbers are the same either way, and get_state()
+	  and advance_state() see the stream as of the last number handed
+	  out.
+	*/
 #endif /* !OLD_RNG */
 
 #ifndef stand_alone
@@ -351,8 +382,32 @@ protected:   // need to be public?
 	  The backbone uniform random number generator with increased 
 	  precision. 
 	*/	
+
+	double buf_[RNG_BLOCK], Sg_[6]; 
+	int nbuf_, pos_, nblock_; 
+	/*
+	  The block of numbers generated from state Sg_ (which leaves the
+	  stream in Cg_), of which the first pos_ of nbuf_ are handed out,
+	  and the size of the next block.
+	*/
+
+	RNG (const RNG& from, long e, int); 
+	/*
+	  See substream(); the third argument keeps this apart from
+	  RNG(RNGSources, int), which RNGSources would make ambiguous.
+	*/
+
+	double refill (); 
+	void state (double s[6]) const; 
+	void sync (); 
+	/*
+	  Generate the next block and return its first number; return the
+	  state as of the last number handed out; and make that Cg_,
+	  dropping the rest of the block.
+	*/
 #endif /* OLD_RNG */
-	static RNG* default_;
+	friend class ParallelScheduler;	// keeps a default_ per LP
+	static NS_THREAD_LOCAL RNG* default_;
 }; 
 
 /*
@@ -31,6 +31,7 @@
  */
 
 #include "basetrace.h"
+#include "bintrace.h"
 #include "tcp.h"
 
 class BaseTraceClass : public TclClass {
@@ -51,20 +52,72 @@ public:
 
 
 BaseTrace::BaseTrace() 
-  : channel_(0), namChan_(0), tagged_(0) 
+  : channel_(0), namChan_(0), tagged_(0), bin_(0), nbin_(0),
+    keeptext_(0)
 {
   wrk_ = new char[1026];
   nwrk_ = new char[256];
+  twrk_ = new char[1026];
+  twrk_[0] = 0;
 }
 
 BaseTrace::~BaseTrace()
 {
   delete wrk_;
   delete nwrk_;
+  delete [] twrk_;
 }
 
+void BaseTrace::bufferf(int offset, const char* fmt, ...)
+{
+	va_list ap;
+
+	va_start(ap, fmt);
+	if (bin_ != 0) {
+		if (offset == 0)
+			bline_.clear();
+		wrk_[0] = 0;
+		bin_->encode(bline_, fmt, ap);
+		if (keeptext_ != 0 && *keeptext_) {
+			/* offset is in bline_ here; append to the text */
+			va_end(ap);
+			va_start(ap, fmt);
+			vsprintf(offset ? twrk_ + strlen(twrk_) : twrk_,
+				 fmt, ap);
+		}
+	} else
+		vsprintf(wrk_ + offset, fmt, ap);
+	va_end(ap);
+}
+
+void BaseTrace::nbufferf(int offset, const char* fmt, ...)
+{
+	va_list ap;
+
+	va_start(ap, fmt);
+	if (nbin_ != 0) {
+		if (offset == 0)
+			nbline_.clear();
+		nwrk_[0] = 0;
+		nbin_->encode(nbline_, fmt, ap);
+	} else
+		vsprintf(nwrk_ + offset, fmt, ap);
+	va_end(ap);
+}
+
+/*
+ * On a binary trace, buffer() holds text only if something wrote it
+ * after the last bufferf(); otherwise the line is the one bufferf()
+ * built.
+ */
 void BaseTrace::dump()
 {
+	if (bin_ != 0 && wrk_[0] == 0) {
+		if (!bline_.empty())
+			bin_->write(bline_);
+		return;
+	}
+
 	int n = strlen(wrk_);
 	if ((n > 0) && (channel_ != 0)) {
 		/*
@@ -90,6 +143,12 @@ void BaseTrace::dump()
 
 void BaseTrace::namdump()
 {
+	if (nbin_ != 0 && nwrk_[0] == 0) {
+		if (!nbline_.empty())
+			nbin_->write(nbline_);
+		return;
+	}
+
 	int n = 0;
 
 	/* Otherwise nwrk_ isn't initialized */
@@ -119,8 +178,8 @@ int BaseTrace::command(int argc, const char*const* argv)
 	Tcl& tcl = Tcl::instance();
 	if (argc == 2) {
 		if (strcmp(argv[1], "detach") == 0) {
-			channel_ = 0;
-			namChan_ = 0;
+			channel(0);
+			namchannel(0);
 			return (TCL_OK);
 		}
 		if (strcmp(argv[1], "flush") == 0) {
@@ -138,8 +197,8 @@ int BaseTrace::command(int argc, const char*const* argv)
 		if (strcmp(argv[1], "attach") == 0) {
 			int mode;
 			const char* id = argv[2];
-			channel_ = Tcl_GetChannel(tcl.interp(), (char*)id,
-						  &mode);
+			channel(Tcl_GetChannel(tcl.interp(), (char*)id,
+					       &mode));
 			if (channel_ == 0) {
 				tcl.resultf("trace: can't attach %s for writing", id);
 				return (TCL_ERROR);
@@ -149,8 +208,8 @@ int BaseTrace::command(int argc, const char*const* argv)
 		if (strcmp(argv[1], "namattach") == 0) {
 			int mode;
 			const char* id = argv[2];
-			namChan_ = Tcl_GetChannel(tcl.interp(), (char*)id,
-						  &mode);
+			namchannel(Tcl_GetChannel(tcl.interp(), (char*)id,
+						  &mode));
 			if (namChan_ == 0) {
 				tcl.resultf("trace: can't attach %s for writing", id);
 				return (TCL_ERROR);
@@ -178,3 +237,329 @@ void EventTrace::trace()
 }
 
 
+
+
+BinaryLine::BinaryLine() : len_(3), max_(256)
+{
+	buf_ = new char[max_];
+}
+
+BinaryLine::~BinaryLine()
+{
+	delete [] buf_;
+}
+
+/* room for n more bytes at the end of the line */
+char* BinaryLine::reserve(int n)
+{
+	if (len_ + n > max_) {
+		while (len_ + n > max_)
+			max_ *= 2;
+		char* b = new char[max_];
+		memcpy(b, buf_, len_);
+		delete [] buf_;
+		buf_ = b;
+	}
+	char* p = buf_ + len_;
+	len_ += n;
+	return (p);
+}
+
+static inline void
+put16(BinaryLine& l, int v)
+{
+	u_int16_t x = v;
+	memcpy(l.reserve(2), &x, 2);
+}
+
+static inline void
+put32(BinaryLine& l, u_int32_t x)
+{
+	memcpy(l.reserve(4), &x, 4);
+}
+
+
+/* strings longer than this are always given in place */
+#define BT_MAXINTERN	64
+/* and so are all new ones once the table has this many */
+#define BT_MAXSTRINGS	65536
+
+static class BinaryTraceClass : public TclClass {
+public:
+	BinaryTraceClass() : TclClass("BinaryTrace") {}
+	TclObject* create(int argc, const char*const* argv) {
+		if (argc < 5)
+			return (0);
+		BinaryTrace* b = new BinaryTrace;
+		if (b->attach(argv[4]) != TCL_OK) {
+			delete b;
+			return (0);
+		}
+		return (b);
+	}
+} class_binary_trace;
+
+BinaryTrace* BinaryTrace::all_;
+
+BinaryTrace::BinaryTrace() :
+	channel_(0), formats_(0), maxformats_(0), nformats_(0),
+	nfmtids_(0),
+	strings_(0), maxstrings_(0), nstrings_(0), next_(0)
+{
+}
+
+BinaryTrace::~BinaryTrace()
+{
+	if (channel_ != 0) {
+		Tcl_DeleteCloseHandler(channel_, closed, (ClientData)this);
+		closed((ClientData)this);
+	}
+	for (int i = 0; i < maxformats_; i++)
+		delete [] formats_[i].sig_;
+	delete [] formats_;
+	for (int i = 0; i < maxstrings_; i++)
+		delete [] strings_[i].s_;
+	delete [] strings_;
+}
+
+BinaryTrace* BinaryTrace::lookup(Tcl_Channel ch)
+{
+	BinaryTrace* b;
+	for (b = all_; b != 0 && ch != 0; b = b->next_)
+		if (b->channel_ == ch)
+			return (b);
+	return (0);
+}
+
+/*
+ * The channel is going away: forget it, so that a channel opened later
+ * at the same address is not taken for a binary one.
+ */
+void BinaryTrace::closed(ClientData cd)
+{
+	BinaryTrace* b = (BinaryTrace*)cd;
+	BinaryTrace** pp;
+	for (pp = &all_; *pp != 0; pp = &(*pp)->next_)
+		if (*pp == b) {
+			*pp = b->next_;
+			break;
+		}
+	b->channel_ = 0;
+}
+
+int BinaryTrace::attach(const char* id)
+{
+	Tcl& tcl = Tcl::instance();
+	int mode;
+	Tcl_Channel ch = Tcl_GetChannel(tcl.interp(), (char*)id, &mode);
+	if (ch == 0 || (mode & TCL_WRITABLE) == 0) {
+		tcl.resultf("trace: can't attach %s for writing", id);
+		return (TCL_ERROR);
+	}
+	if (lookup(ch) != 0) {
+		tcl.resultf("trace: %s is already a binary trace", id);
+		return (TCL_ERROR);
+	}
+	if (Tcl_SetChannelOption(tcl.interp(), ch, "-translation",
+				 "binary") != TCL_OK)
+		return (TCL_ERROR);
+	Tcl_SetChannelBufferSize(ch, 1 << 20);
+	Tcl_CreateCloseHandler(ch, closed, (ClientData)this);
+	channel_ = ch;
+	next_ = all_;
+	all_ = this;
+
+	char magic[9];
+	int32_t order = BT_ORDER;
+	magic[0] = BT_MAGIC;
+	memcpy(magic + 1, "NSBT", 4);
+	memcpy(magic + 5, &order, 4);
+	(void)Tcl_Write(channel_, magic, sizeof(magic));
+	return (TCL_OK);
+}
+
+void BinaryTrace::define(int tag, const char* s, int n)
+{
+	char hdr[3];
+	u_int16_t x = n;
+	hdr[0] = tag;
+	memcpy(hdr + 1, &x, 2);
+	(void)Tcl_Write(channel_, hdr, 3);
+	(void)Tcl_Write(channel_, (char*)s, n);
+}
+
+/*
+ * Find fmt in the format table, defining it on first use.
+ */
+BinaryTrace::Format* BinaryTrace::format(const char* fmt)
+{
+	if (2 * (nformats_ + 1) > maxformats_) {
+		Format* old = formats_;
+		int n = maxformats_;
+		maxformats_ = maxformats_ ? 2 * maxformats_ : 64;
+		formats_ = new Format[maxformats_];
+		memset(formats_, 0, maxformats_ * sizeof(Format));
+		for (int i = 0; i < n; i++) {
+			if (old[i].fmt_ == 0)
+				continue;
+			int h = ((size_t)old[i].fmt_ >> 3) & (maxformats_ - 1);
+			while (formats_[h].fmt_ != 0)
+				h = (h + 1) & (maxformats_ - 1);
+			formats_[h] = old[i];
+		}
+		delete [] old;
+	}
+	int h = ((size_t)fmt >> 3) & (maxformats_ - 1);
+	while (formats_[h].fmt_ != 0) {
+		if (formats_[h].fmt_ == fmt)
+			return (&formats_[h]);
+		h = (h + 1) & (maxformats_ - 1);
+	}
+
+	Format* f = &formats_[h];
+	char sig[128];
+	int len = strlen(fmt);
+	f->fmt_ = fmt;
+	f->sig_ = 0;
+	f->id_ = -1;
+	if (len < BT_TEXT && bintrace_signature(fmt, sig, sizeof(sig)) >= 0) {
+		f->id_ = nfmtids_++;
+		f->sig_ = new char[strlen(sig) + 1];
+		strcpy(f->sig_, sig);
+		define(BT_FORMAT, fmt, len);
+	}
+	nformats_++;
+	return (f);
+}
+
+/*
+ * Append a string argument, by its id in the string table if it is short
+ * enough to go there.
+ */
+void BinaryTrace::string(BinaryLine& l, const char* s)
+{
+	if (s == 0) {
+		put32(l, BT_NULL);
+		return;
+	}
+	int n = strlen(s);
+	if (n <= BT_MAXINTERN) {
+		unsigned int hash = 2166136261U;
+		for (int i = 0; i < n; i++)
+			hash = (hash ^ (unsigned char)s[i]) * 16777619U;
+		if (2 * (nstrings_ + 1) > maxstrings_ &&
+		    nstrings_ < BT_MAXSTRINGS) {
+			String* old = strings_;
+			int m = maxstrings_;
+			maxstrings_ = maxstrings_ ? 2 * maxstrings_ : 256;
+			strings_ = new String[maxstrings_];
+			memset(strings_, 0, maxstrings_ * sizeof(String));
+			for (int i = 0; i < m; i++) {
+				if (old[i].s_ == 0)
+					continue;
+				int h = old[i].hash_ & (maxstrings_ - 1);
+				while (strings_[h].s_ != 0)
+					h = (h + 1) & (maxstrings_ - 1);
+				strings_[h] = old[i];
+			}
+			delete [] old;
+		}
+		int h = hash & (maxstrings_ - 1);
+		while (strings_[h].s_ != 0) {
+			if (strings_[h].hash_ == hash &&
+			    strings_[h].len_ == n &&
+			    memcmp(strings_[h].s_, s, n) == 0) {
+				put32(l, strings_[h].id_);
+				return;
+			}
+			h = (h + 1) & (maxstrings_ - 1);
+		}
+		if (nstrings_ < BT_MAXSTRINGS) {
+			String* e = &strings_[h];
+			e->s_ = new char[n + 1];
+			memcpy(e->s_, s, n + 1);
+			e->len_ = n;
+			e->hash_ = hash;
+			e->id_ = nstrings_++;
+			define(BT_STRING, s, n);
+			put32(l, e->id_);
+			return;
+		}
+	}
+	if (n > 0xffff)
+		n = 0xffff;
+	put32(l, BT_INLINE);
+	put16(l, n);
+	memcpy(l.reserve(n), s, n);
+}
+
+/*
+ * Append what sprintf(fmt, ...) would have printed, as fmt's id and
+ * the arguments.
+ */
+void BinaryTrace::encode(BinaryLine& l, const char* fmt, va_list ap)
+{
+	Format* f = format(fmt);
+	if (f->sig_ == 0) {
+		char text[2048];
+		int n = vsnprintf(text, sizeof(text), fmt, ap);
+		if (n < 0)
+			n = 0;
+		if (n > (int)sizeof(text) - 1)
+			n = sizeof(text) - 1;
+		put16(l, BT_TEXT);
+		put16(l, n);
+		memcpy(l.reserve(n), text, n);
+		return;
+	}
+	put16(l, f->id_);
+	for (const char* k = f->sig_; *k != 0; k++) {
+		switch (*k) {
+		case BT_INT: {
+			int v = va_arg(ap, int);
+			memcpy(l.reserve(4), &v, 4);
+			break;
+		}
+		case BT_LONG: {
+			int64_t v = va_arg(ap, long);
+			memcpy(l.reserve(8), &v, 8);
+			break;
+		}
+		case BT_LLONG: {
+			int64_t v = va_arg(ap, int64_t);
+			memcpy(l.reserve(8), &v, 8);
+			break;
+		}
+		case BT_DOUBLE: {
+			double v = va_arg(ap, double);
+			memcpy(l.reserve(8), &v, 8);
+			break;
+		}
+		case BT_PTR: {
+			int64_t v = (size_t)va_arg(ap, void*);
+			memcpy(l.reserve(8), &v, 8);
+			break;
+		}
+		case BT_STR:
+			string(l, va_arg(ap, const char*));
+			break;
+		}
+	}
+}
+
+/* write a line built by encode() */
+void BinaryTrace::write(BinaryLine& l)
+{
+	int n = l.len_ - 3;
+	if (channel_ == 0)
+		return;
+	if (n > 0xffff) {
+		fprintf(stderr, "BinaryTrace: %d-byte line dropped\n", n);
+		return;
+	}
+	u_int16_t x = n;
+	l.buf_[0] = BT_LINE;
+	memcpy(l.buf_ + 1, &x, 2);
+	(void)Tcl_Write(channel_, l.buf_, l.len_);
+}
+
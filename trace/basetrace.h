@@ -34,8 +34,68 @@
 #define ns_basetrace_h
 
 #include <math.h> //floor
+#include <stdarg.h>
 #include "tcp.h"
 
+/*
+ * A trace line in the binary form of bintrace.h, as it is being built.
+ */
+struct BinaryLine {
+	BinaryLine();
+	~BinaryLine();
+	inline void clear() { len_ = 3; }	// leave room for the header
+	inline int empty() { return len_ == 3; }
+	char* reserve(int n);
+
+	char* buf_;
+	int len_;
+	int max_;
+};
+
+/*
+ * Writes the binary form of a trace channel: "$ns binary-trace $file"
+ * creates one for $file, and every BaseTrace attached to $file then
+ * hands it format strings and arguments instead of formatted text (see
+ * bintrace.h).
+ */
+class BinaryTrace : public TclObject {
+public:
+	BinaryTrace();
+	~BinaryTrace();
+	static BinaryTrace* lookup(Tcl_Channel);
+	int attach(const char* id);
+
+	void encode(BinaryLine&, const char* fmt, va_list);
+	void write(BinaryLine&);
+protected:
+	struct Format {
+		const char* fmt_;	// by address, as literals don't move
+		int id_;
+		char* sig_;		// 0 if formatted at run time
+	};
+	struct String {
+		char* s_;
+		int len_;
+		unsigned int hash_;
+		int id_;
+	};
+	Format* format(const char* fmt);
+	void string(BinaryLine&, const char* s);
+	void define(int tag, const char* s, int n);
+	static void closed(ClientData);
+
+	Tcl_Channel channel_;
+	Format* formats_;		// open hash tables
+	int maxformats_;
+	int nformats_;
+	int nfmtids_;			// formats defined in the file
+	String* strings_;
+	int maxstrings_;
+	int nstrings_;
+	BinaryTrace* next_;
+	static BinaryTrace* all_;
+};
+
 class BaseTrace : public TclObject {
 public:
 	BaseTrace();
@@ -46,11 +106,40 @@ public:
 	inline char* buffer() { return wrk_ ; }
 	inline char *nbuffer() {return nwrk_; }
 
+	/*
+	 * sprintf() fmt into buffer() at offset, 0 to start a new line,
+	 * or else buffer_length() to append; on a binary trace only the
+	 * format and its arguments are kept.
+	 */
+	void bufferf(int offset, const char* fmt, ...);
+	void nbufferf(int offset, const char* fmt, ...);
+	inline int buffer_length() {
+		return (bin_ ? bline_.len_ - 3 : strlen(wrk_));
+	}
+	inline int nbuffer_length() {
+		return (nbin_ ? nbline_.len_ - 3 : strlen(nwrk_));
+	}
+
+	/*
+	 * The text of the line in buffer(), even on a binary trace, as
+	 * long as *when was set while bufferf() built it.
+	 */
+	inline void keeptext(const int* when) { keeptext_ = when; }
+	inline char* text() {
+		return (bin_ != 0 && wrk_[0] == 0 ? twrk_ : wrk_);
+	}
+
 	inline Tcl_Channel channel() { return channel_; }
-	inline void channel(Tcl_Channel ch) {channel_ = ch; }
+	inline void channel(Tcl_Channel ch) {
+		channel_ = ch;
+		bin_ = BinaryTrace::lookup(ch);
+	}
 
 	inline Tcl_Channel namchannel() { return namChan_; }
-	inline void namchannel(Tcl_Channel namch) {namChan_ = namch; }
+	inline void namchannel(Tcl_Channel namch) {
+		namChan_ = namch;
+		nbin_ = BinaryTrace::lookup(namch);
+	}
 
 	void flush(Tcl_Channel channel) { Tcl_Flush(channel); }
 
@@ -78,6 +167,12 @@ protected:
 	char *wrk_;
 	char *nwrk_;
 	bool tagged_;
+	BinaryTrace* bin_;	// binary writers of the channels, if any
+	BinaryTrace* nbin_;
+	BinaryLine bline_;	// the lines they are building
+	BinaryLine nbline_;
+	const int* keeptext_;	// format binary lines into twrk_ too if set
+	char *twrk_;
 };
 
 class EventTrace : public BaseTrace {
@@ -0,0 +1,175 @@
+/* -*-	Mode:C++; c-basic-offset:8; tab-width:8; indent-tabs-mode:t -*- */
+/*
+ * Copyright (c) 1997 Regents of the University of California.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor of the Laboratory may be used
+ *    to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+
+/*
+ * bintrace.h
+ *
+ * The binary form of ns trace files, shared by BinaryTrace (basetrace.cc)
+ * and the trace-decode tool.
+ *
+ * A binary trace does not hold formatted text.  Each sprintf() that
+ * would have built part of a trace line is recorded as the id of its
+ * format string followed by its raw arguments, and trace-decode runs the
+ * same formats through the same printf to get the text back.  Strings
+ * passed for %s (packet types, trace levels, addresses, ...) go into a
+ * string table as they are first seen, so a record refers to each by
+ * index.  Formats and strings are numbered from 0 in the order they
+ * are defined.
+ *
+ * The file is a sequence of
+ *
+ *	BT_MAGIC	"NSBT" int32 BT_ORDER
+ *	BT_FORMAT	u16 length, text		defines the next format
+ *	BT_STRING	u16 length, text		defines the next string
+ *	BT_LINE		u16 length, fragments		one trace line
+ *
+ * in host byte order, where a fragment is a u16 format id and then its
+ * arguments, 4 bytes for an int, 8 for a long, long long, double or
+ * pointer, and a u32 string id for a string.  The string id BT_NULL
+ * stands for a null pointer, and BT_INLINE for a string given in place
+ * as u16 length and text.  The format id BT_TEXT introduces text that
+ * was formatted at run time (u16 length, text), for formats the binary
+ * form cannot carry.
+ *
+ * Anything else, starting with a printable character, is a text line
+ * copied as is: lines from writers that still sprintf() into the trace
+ * buffer, and anything the script puts on the channel itself.
+ */
+
+#ifndef ns_bintrace_h
+#define ns_bintrace_h
+
+#include <ctype.h>
+#include <string.h>
+
+#define BT_MAGIC	1
+#define BT_FORMAT	2
+#define BT_STRING	3
+#define BT_LINE		4
+
+#define BT_ORDER	0x01020304
+
+#define BT_TEXT		0xffff
+#define BT_NULL		0xffffffff
+#define BT_INLINE	0xfffffffe
+
+/* argument kinds */
+#define BT_INT		'i'
+#define BT_LONG		'l'
+#define BT_LLONG	'q'
+#define BT_DOUBLE	'd'
+#define BT_STR		's'
+#define BT_PTR		'p'
+
+/*
+ * Store in sig the kinds of the arguments fmt consumes, in order, and
+ * return how many there are, or -1 if fmt has a conversion the binary
+ * form does not carry (%n, %Lf, %zu, positional arguments, ...).
+ */
+static inline int
+bintrace_signature(const char* fmt, char* sig, int max)
+{
+	int n = 0;
+
+	for (const char* p = fmt; *p != 0; p++) {
+		if (*p != '%')
+			continue;
+		if (*++p == '%')
+			continue;
+		while (*p != 0 && strchr("-+ #0'", *p) != 0)
+			p++;
+		if (*p == '*') {
+			if (n >= max - 1)
+				return (-1);
+			sig[n++] = BT_INT;
+			p++;
+		} else
+			while (isdigit((unsigned char)*p))
+				p++;
+		if (*p == '.') {
+			p++;
+			if (*p == '*') {
+				if (n >= max - 1)
+					return (-1);
+				sig[n++] = BT_INT;
+				p++;
+			} else
+				while (isdigit((unsigned char)*p))
+					p++;
+		}
+		int longs = 0;
+		if (*p == 'h') {
+			if (*++p == 'h')
+				p++;
+		} else if (*p == 'l') {
+			longs = 1;
+			if (*++p == 'l') {
+				longs = 2;
+				p++;
+			}
+		}
+		char kind;
+		switch (*p) {
+		case 'd': case 'i': case 'o': case 'u': case 'x': case 'X':
+			kind = longs == 0 ? BT_INT :
+				longs == 1 ? BT_LONG : BT_LLONG;
+			break;
+		case 'c':
+			if (longs)
+				return (-1);
+			kind = BT_INT;
+			break;
+		case 'e': case 'E': case 'f': case 'F':
+		case 'g': case 'G': case 'a': case 'A':
+			if (longs > 1)
+				return (-1);
+			kind = BT_DOUBLE;
+			break;
+		case 's':
+			if (longs)
+				return (-1);
+			kind = BT_STR;
+			break;
+		case 'p':
+			kind = BT_PTR;
+			break;
+		default:
+			return (-1);
+		}
+		if (n >= max - 1)
+			return (-1);
+		sig[n++] = kind;
+	}
+	sig[n] = 0;
+	return (n);
+}
+
+#endif /* ns_bintrace_h */
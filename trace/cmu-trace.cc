@@ -202,7 +202,7 @@ CMUTrace::format_mac_common(Packet *p, const char *why, int offset)
 		if (op == SEND) op = '+';
 		if (op == FWRD) op = 'h';
 
-		sprintf(pt_->buffer() + offset,
+		pt_->bufferf(offset,
 			"%c "TIME_FORMAT" -s %d -d %d -p %s -k %3s -i %d "
 			"-N:loc {%.2f %.2f %.2f} -N:en %f ",
 			
@@ -216,7 +216,7 @@ CMUTrace::format_mac_common(Packet *p, const char *why, int offset)
 			x, y, z,			// location
 			energy);				// energy
 
-		offset = strlen(pt_->buffer());
+		offset = pt_->buffer_length();
 		if (strcmp (mactype, "Mac/SMAC") == 0) {
 			format_smac(p, offset);
 		} else {
@@ -235,7 +235,7 @@ CMUTrace::format_mac_common(Packet *p, const char *why, int offset)
 
 	        // basic trace infomation + basic exenstion
 
-	    sprintf(pt_->buffer() + offset,
+	    pt_->bufferf(offset,
 		   "%c -t %.9f -Hs %d -Hd %d -Ni %d -Nx %.2f -Ny %.2f -Nz %.2f -Ne %f -Nl %3s -Nw %s ",
 		    op,                       // event type
 		    Scheduler::instance().clock(),  // time
@@ -251,7 +251,7 @@ CMUTrace::format_mac_common(Packet *p, const char *why, int offset)
 
 	    // mac layer extension
 
-	    offset = strlen(pt_->buffer());
+	    offset = pt_->buffer_length();
 	    if (strcmp(mactype, "Mac/SMAC") == 0) {
 		    format_smac(p, offset);
 	    } else {
@@ -265,7 +265,7 @@ CMUTrace::format_mac_common(Packet *p, const char *why, int offset)
         x = 0.0, y = 0.0, z = 0.0;
         node_->getLoc(&x, &y, &z);
 #endif
-	sprintf(pt_->buffer() + offset,
+	pt_->bufferf(offset,
 #ifdef LOG_POSITION
 		"%c %.9f %d (%6.2f %6.2f) %3s %4s %d %s %d ",
 #else
@@ -318,11 +318,11 @@ CMUTrace::format_mac_common(Packet *p, const char *why, int offset)
 		 packet_info.name(ch->ptype())),
 		ch->size());
 	
-	offset = strlen(pt_->buffer());
+	offset = pt_->buffer_length();
 
 	if(tracetype == TR_PHY) {
 		format_phy(p, offset);
-		offset = strlen(pt_->buffer());
+		offset = pt_->buffer_length();
 		return;
 	}
 
@@ -332,13 +332,13 @@ CMUTrace::format_mac_common(Packet *p, const char *why, int offset)
 		format_mac(p, offset);
         }
 	
-	offset = strlen(pt_->buffer());
+	offset = pt_->buffer_length();
 
 	if (thisnode) {
 		if (thisnode->energy_model()) {
 			// log detailed energy consumption
 			// total energy and breakdown in idle, sleep, transmit and receive modes
-			sprintf(pt_->buffer() + offset,
+			pt_->bufferf(offset,
 				"[energy %f ei %.3f es %.3f et %.3f er %.3f] ",
 				thisnode->energy_model()->energy(),
 				thisnode->energy_model()->ei(),
@@ -352,7 +352,7 @@ CMUTrace::format_mac_common(Packet *p, const char *why, int offset)
 void
 CMUTrace::format_phy(Packet *, int offset)
 {
-	sprintf(pt_->buffer() + offset, " ");
+	pt_->bufferf(offset, " ");
 }
 
 
@@ -372,7 +372,7 @@ CMUTrace::format_mac(Packet *p, int offset)
 	} 
 	
 	if (pt_->tagged()) {
-		sprintf(pt_->buffer() + offset,
+		pt_->bufferf(offset,
 			"-M:dur %x -M:s %x -M:d %x -M:t %x ",
 			mh->dh_duration,		// MAC: duration
 			
@@ -385,7 +385,7 @@ CMUTrace::format_mac(Packet *p, int offset)
 
 			print_ether_type ? GET_ETHER_TYPE(mh->dh_body) : 0);	// MAC: type
 	} else if (newtrace_) {
-		sprintf(pt_->buffer() + offset, 
+		pt_->bufferf(offset, 
 			"-Ma %x -Md %x -Ms %x -Mt %x ",
 			mh->dh_duration,
 			
@@ -398,7 +398,7 @@ CMUTrace::format_mac(Packet *p, int offset)
 
 			print_ether_type ? GET_ETHER_TYPE(mh->dh_body) : 0);
 	} else {
-		sprintf(pt_->buffer() + offset,
+		pt_->bufferf(offset,
 			" [%x %x %x %x] ",
 			//*((u_int16_t*) &mh->dh_fc),
 			mh->dh_duration,
@@ -416,7 +416,7 @@ void
 CMUTrace::format_smac(Packet *p, int offset)
 {
 	struct hdr_smac *sh = HDR_SMAC(p);
-	sprintf(pt_->buffer() + offset,
+	pt_->bufferf(offset,
 		" [%.2f %d %d] ",
 		sh->duration,
 		sh->dstAddr,
@@ -436,7 +436,7 @@ CMUTrace::format_ip(Packet *p, int offset)
 	int dst = Address::instance().get_nodeaddr(ih->daddr());
 
 	if (pt_->tagged()) {
-		sprintf(pt_->buffer() + offset,
+		pt_->bufferf(offset,
 			"-IP:s %d -IP:sp %d -IP:d %d -IP:dp %d -p %s -e %d "
 			"-c %d -i %d -IP:ttl %d ",
 			src,                           // packet src
@@ -450,7 +450,7 @@ CMUTrace::format_ip(Packet *p, int offset)
 			ih->ttl_                       // ttl
 			);
 	} else if (newtrace_) {
-	    sprintf(pt_->buffer() + offset,
+	    pt_->bufferf(offset,
 		    "-Is %d.%d -Id %d.%d -It %s -Il %d -If %d -Ii %d -Iv %d ",
 		    src,                           // packet src
 		    ih->sport(),                   // src port
@@ -462,7 +462,7 @@ CMUTrace::format_ip(Packet *p, int offset)
 		    ch->uid(),                      // unique id
 		    ih->ttl_);                      // ttl
 	} else {
-	    sprintf(pt_->buffer() + offset, "------- [%d:%d %d:%d %d %d] ",
+	    pt_->bufferf(offset, "------- [%d:%d %d:%d %d %d] ",
 		src, ih->sport(),
 		dst, ih->dport(),
 		ih->ttl_, (ch->next_hop_ < 0) ? 0 : ch->next_hop_);
@@ -477,7 +477,7 @@ CMUTrace::format_arp(Packet *p, int offset)
 	struct hdr_arp *ah = HDR_ARP(p);
 
 	if (pt_->tagged()) {
-	    sprintf(pt_->buffer() + offset,
+	    pt_->bufferf(offset,
 		    "-arp:op %s -arp:ms %d -arp:s %d -arp:md %d -arp:d %d ",
 		    ah->arp_op == ARPOP_REQUEST ?  "REQUEST" : "REPLY",
 		    ah->arp_sha,
@@ -485,7 +485,7 @@ CMUTrace::format_arp(Packet *p, int offset)
 		    ah->arp_tha,
 		    ah->arp_tpa);
 	} else if (newtrace_) {
-	    sprintf(pt_->buffer() + offset,
+	    pt_->bufferf(offset,
 		    "-P arp -Po %s -Pms %d -Ps %d -Pmd %d -Pd %d ",
 		    ah->arp_op == ARPOP_REQUEST ?  "REQUEST" : "REPLY",
 		    ah->arp_sha,
@@ -494,7 +494,7 @@ CMUTrace::format_arp(Packet *p, int offset)
 		    ah->arp_tpa);
 	} else {
 
-	    sprintf(pt_->buffer() + offset,
+	    pt_->bufferf(offset,
 		"------- [%s %d/%d %d/%d]",
 		ah->arp_op == ARPOP_REQUEST ?  "REQUEST" : "REPLY",
 		ah->arp_sha,
@@ -519,7 +519,7 @@ CMUTrace::format_dsr(Packet *p, int offset)
 	}
 
 	if (pt_->tagged()) {
-	    sprintf(pt_->buffer() + offset,
+	    pt_->bufferf(offset,
 		    "-dsr:h %d -dsr:q %d -dsr:s %d -dsr:p %d -dsr:n %d "
 		    "-dsr:l %d -dsr:e {%d %d} -dsr:w %d -dsr:m %d -dsr:c %d "
 		    "-dsr:b {%d %d} ",
@@ -538,7 +538,7 @@ CMUTrace::format_dsr(Packet *p, int offset)
 		    srh->down_links()[last_err_index].to_addr);
 	    return;
 	} else if (newtrace_) {
-	    sprintf(pt_->buffer() + offset, 
+	    pt_->bufferf(offset, 
 		"-P dsr -Ph %d -Pq %d -Ps %d -Pp %d -Pn %d -Pl %d -Pe %d->%d -Pw %d -Pm %d -Pc %d -Pb %d->%d ",
 		    srh->num_addrs(),                   // how many nodes travered
 
@@ -560,7 +560,7 @@ CMUTrace::format_dsr(Packet *p, int offset)
 
 	   return;
 	}
-	sprintf(pt_->buffer() + offset, 
+	pt_->bufferf(offset, 
 		"%d [%d %d] [%d %d %d %d->%d] [%d %d %d %d->%d]",
 		srh->num_addrs(),
 
@@ -593,14 +593,14 @@ CMUTrace::format_tcp(Packet *p, int offset)
 	struct hdr_tcp *th = HDR_TCP(p);
 	
 	if (pt_->tagged()) {
-	    sprintf(pt_->buffer() + offset,
+	    pt_->bufferf(offset,
 		    "-tcp:s %d -tcp:a %d -tcp:f %d -tcp:o %d ",
 		    th->seqno_,
 		    th->ackno_,
 		    ch->num_forwards(),
 		    ch->opt_num_forwards());
 	} else if (newtrace_) {
-	    sprintf(pt_->buffer() + offset,
+	    pt_->bufferf(offset,
 		"-Pn tcp -Ps %d -Pa %d -Pf %d -Po %d ",
 		th->seqno_,
 		th->ackno_,
@@ -608,7 +608,7 @@ CMUTrace::format_tcp(Packet *p, int offset)
 		ch->opt_num_forwards());
 
 	} else {
-	    sprintf(pt_->buffer() + offset,
+	    pt_->bufferf(offset,
 		"[%d %d] %d %d",
 		th->seqno_,
 		th->ackno_,
@@ -664,7 +664,7 @@ CMUTrace::format_sctp(Packet* p,int offset)
 		}
     
 		if( newtrace_ ) {
-			sprintf(pt_->buffer() + offset,
+			pt_->bufferf(offset,
 				"-Pn sctp -Pnc %d -Pct %c "
 				"-Ptsn %d -Psid %d -Pssn %d "
 				"-Pf %d -Po %d ",
@@ -677,7 +677,7 @@ CMUTrace::format_sctp(Packet* p,int offset)
 				ch->opt_num_forwards());
 		}
 		else {
-			sprintf(pt_->buffer() + offset,
+			pt_->bufferf(offset,
 				"[%d %c %d %d %d] %d %d",
 				sh->NumChunks(),
 				cChunkType,
@@ -710,19 +710,19 @@ CMUTrace::format_rtp(Packet *p, int offset)
         }
 
 	if (pt_->tagged()) {
-		sprintf(pt_->buffer() + offset,
+		pt_->bufferf(offset,
 			"-cbr:s %d -cbr:f %d -cbr:o %d ",
 			rh->seqno_,
 			ch->num_forwards(),
 			ch->opt_num_forwards());
 	} else if (newtrace_) {
-		sprintf(pt_->buffer() + offset,
+		pt_->bufferf(offset,
 			"-Pn cbr -Pi %d -Pf %d -Po %d ",
 			rh->seqno_,
 			ch->num_forwards(),
 			ch->opt_num_forwards());
 	} else {
-		sprintf(pt_->buffer() + offset,
+		pt_->bufferf(offset,
 			"[%d] %d %d",
 			rh->seqno_,
 			ch->num_forwards(),
@@ -738,21 +738,21 @@ CMUTrace::format_imep(Packet *p, int offset)
 #define U_INT16_T(x)    *((u_int16_t*) &(x))
 
 	if (pt_->tagged()) {
-	    sprintf(pt_->buffer() + offset,
+	    pt_->bufferf(offset,
 		    "-imep:a %c -imep:h %c -imep:o %c -imep:l %04x ",
 		    (im->imep_block_flags & BLOCK_FLAG_ACK) ? 'A' : '-',
                     (im->imep_block_flags & BLOCK_FLAG_HELLO) ? 'H' : '-',
                     (im->imep_block_flags & BLOCK_FLAG_OBJECT) ? 'O' : '-',
                     U_INT16_T(im->imep_length));
 	} else if (newtrace_) {
-	    sprintf(pt_->buffer() + offset,
+	    pt_->bufferf(offset,
                 "-P imep -Pa %c -Ph %c -Po %c -Pl 0x%04x ] ",
                 (im->imep_block_flags & BLOCK_FLAG_ACK) ? 'A' : '-',
                 (im->imep_block_flags & BLOCK_FLAG_HELLO) ? 'H' : '-',
                 (im->imep_block_flags & BLOCK_FLAG_OBJECT) ? 'O' : '-',
                 U_INT16_T(im->imep_length));
 	} else {
-            sprintf(pt_->buffer() + offset,
+            pt_->bufferf(offset,
                 "[%c %c %c 0x%04x] ",
                 (im->imep_block_flags & BLOCK_FLAG_ACK) ? 'A' : '-',
                 (im->imep_block_flags & BLOCK_FLAG_HELLO) ? 'H' : '-',
@@ -776,17 +776,17 @@ CMUTrace::format_tora(Packet *p, int offset)
         case TORATYPE_QRY:
 
 		if (pt_->tagged()) {
-		    sprintf(pt_->buffer() + offset,
+		    pt_->bufferf(offset,
 			    "-tora:t %x -tora:d %d -tora:c QUERY",
 			    qh->tq_type, qh->tq_dst);
 		} else if (newtrace_) {
-		    sprintf(pt_->buffer() + offset,
+		    pt_->bufferf(offset,
 			"-P tora -Pt 0x%x -Pd %d -Pc QUERY ",
                         qh->tq_type, qh->tq_dst);
 			
                 } else {
 
-                    sprintf(pt_->buffer() + offset, "[0x%x %d] (QUERY)",
+                    pt_->bufferf(offset, "[0x%x %d] (QUERY)",
                         qh->tq_type, qh->tq_dst);
 		}
                 break;
@@ -794,7 +794,7 @@ CMUTrace::format_tora(Packet *p, int offset)
         case TORATYPE_UPD:
 
 		if (pt_->tagged()) {
-		    sprintf(pt_->buffer() + offset,
+		    pt_->bufferf(offset,
 			    "-tora:t %x -tora:d %d -tora:a %f -tora:o %d "
 			    "-tora:r %d -tora:e %d -tora:i %d -tora:c UPDATE",
 			    uh->tu_type,
@@ -805,7 +805,7 @@ CMUTrace::format_tora(Packet *p, int offset)
                             uh->tu_delta,
                             uh->tu_id);
 		} else if (newtrace_) {
-		    sprintf(pt_->buffer() + offset,
+		    pt_->bufferf(offset,
                         "-P tora -Pt 0x%x -Pd %d (%f %d %d %d %d) -Pc UPDATE ",
                         uh->tu_type,
                         uh->tu_dst,
@@ -815,7 +815,7 @@ CMUTrace::format_tora(Packet *p, int offset)
                         uh->tu_delta,
                         uh->tu_id);
 		} else {
-                    sprintf(pt_->buffer() + offset,
+                    pt_->bufferf(offset,
                         "-Pt 0x%x -Pd %d -Pa %f -Po %d -Pr %d -Pe %d -Pi %d -Pc UPDATE ",
                         uh->tu_type,
                         uh->tu_dst,
@@ -829,7 +829,7 @@ CMUTrace::format_tora(Packet *p, int offset)
 
         case TORATYPE_CLR:
 		if (pt_->tagged()) {
-		    sprintf(pt_->buffer() + offset,
+		    pt_->bufferf(offset,
 			    "-tora:t %x -tora:d %d -tora:a %f -tora:o %d "
 			    "-tora:c CLEAR ",
 			    ch->tc_type,
@@ -837,14 +837,14 @@ CMUTrace::format_tora(Packet *p, int offset)
                             ch->tc_tau,
                             ch->tc_oid);
 		} else if (newtrace_) {
-		    sprintf(pt_->buffer() + offset, 
+		    pt_->bufferf(offset, 
 			"-P tora -Pt 0x%x -Pd %d -Pa %f -Po %d -Pc CLEAR ",
                         ch->tc_type,
                         ch->tc_dst,
                         ch->tc_tau,
                         ch->tc_oid);
 		} else {
-                    sprintf(pt_->buffer() + offset, "[0x%x %d %f %d] (CLEAR)",
+                    pt_->bufferf(offset, "[0x%x %d %f %d] (CLEAR)",
                         ch->tc_type,
                         ch->tc_dst,
                         ch->tc_tau,
@@ -866,7 +866,7 @@ CMUTrace::format_aodv(Packet *p, int offset)
         case AODVTYPE_RREQ:
 
 		if (pt_->tagged()) {
-		    sprintf(pt_->buffer() + offset,
+		    pt_->bufferf(offset,
 			    "-aodv:t %x -aodv:h %d -aodv:b %d -aodv:d %d "
 			    "-aodv:ds %d -aodv:s %d -aodv:ss %d "
 			    "-aodv:c REQUEST ",
@@ -879,7 +879,7 @@ CMUTrace::format_aodv(Packet *p, int offset)
                             rq->rq_src_seqno);
 		} else if (newtrace_) {
 
-		    sprintf(pt_->buffer() + offset,
+		    pt_->bufferf(offset,
 			"-P aodv -Pt 0x%x -Ph %d -Pb %d -Pd %d -Pds %d -Ps %d -Pss %d -Pc REQUEST ",
 			rq->rq_type,
                         rq->rq_hop_count,
@@ -892,7 +892,7 @@ CMUTrace::format_aodv(Packet *p, int offset)
 
 		} else {
 
-		    sprintf(pt_->buffer() + offset,
+		    pt_->bufferf(offset,
 			"[0x%x %d %d [%d %d] [%d %d]] (REQUEST)",
 			rq->rq_type,
                         rq->rq_hop_count,
@@ -909,7 +909,7 @@ CMUTrace::format_aodv(Packet *p, int offset)
 	case AODVTYPE_RERR:
 		
 		if (pt_->tagged()) {
-		    sprintf(pt_->buffer() + offset,
+		    pt_->bufferf(offset,
 			    "-aodv:t %x -aodv:h %d -aodv:d %d -adov:ds %d "
 			    "-aodv:l %f -aodv:c %s ",
 			    rp->rp_type,
@@ -922,7 +922,7 @@ CMUTrace::format_aodv(Packet *p, int offset)
 			     "HELLO"));
 		} else if (newtrace_) {
 			
-			sprintf(pt_->buffer() + offset,
+			pt_->bufferf(offset,
 			    "-P aodv -Pt 0x%x -Ph %d -Pd %d -Pds %d -Pl %f -Pc %s ",
 				rp->rp_type,
 				rp->rp_hop_count,
@@ -934,7 +934,7 @@ CMUTrace::format_aodv(Packet *p, int offset)
 				 "HELLO"));
 	        } else {
 			
-			sprintf(pt_->buffer() + offset,
+			pt_->bufferf(offset,
 				"[0x%x %d [%d %d] %f] (%s)",
 				rp->rp_type,
 				rp->rp_hop_count,
@@ -972,7 +972,7 @@ CMUTrace::format_aomdv(Packet *p, int offset)
 		case AOMDVTYPE_RREQ:
 			
 			if (pt_->tagged()) {
-				sprintf(pt_->buffer() + offset,
+				pt_->bufferf(offset,
 						  "-aomdv:t %x -aomdv:h %d -aomdv:b %d -aomdv:d %d "
 						  "-aomdv:ds %d -aomdv:s %d -aomdv:ss %d "
 						  "-aomdv:c REQUEST ",
@@ -985,7 +985,7 @@ CMUTrace::format_aomdv(Packet *p, int offset)
 						  rq->rq_src_seqno);
 			} else if (newtrace_) {
 				
-				sprintf(pt_->buffer() + offset,
+				pt_->bufferf(offset,
 						  "-P aomdv -Pt 0x%x -Ph %d -Pb %d -Pd %d -Pds %d -Ps %d -Pss %d -Pc REQUEST ",
 						  rq->rq_type,
 						  rq->rq_hop_count,
@@ -998,7 +998,7 @@ CMUTrace::format_aomdv(Packet *p, int offset)
 				
 			} else {
 				
-				sprintf(pt_->buffer() + offset,
+				pt_->bufferf(offset,
 						  "[0x%x %d %d [%d %d] [%d %d]] (REQUEST)",
 						  rq->rq_type,
 						  rq->rq_hop_count,
@@ -1015,7 +1015,7 @@ CMUTrace::format_aomdv(Packet *p, int offset)
 		case AOMDVTYPE_RERR:
 			
 			if (pt_->tagged()) {
-				sprintf(pt_->buffer() + offset,
+				pt_->bufferf(offset,
 						  "-aomdv:t %x -aomdv:h %d -aomdv:d %d -admov:ds %d "
 						  "-aomdv:l %f -aomdv:c %s ",
 						  rp->rp_type,
@@ -1028,7 +1028,7 @@ CMUTrace::format_aomdv(Packet *p, int offset)
 							"HELLO"));
 			} else if (newtrace_) {
 				
-				sprintf(pt_->buffer() + offset,
+				pt_->bufferf(offset,
 						  "-P aomdv -Pt 0x%x -Ph %d -Pd %d -Pds %d -Pl %f -Pc %s ",
 						  rp->rp_type,
 						  rp->rp_hop_count,
@@ -1039,7 +1039,7 @@ CMUTrace::format_aomdv(Packet *p, int offset)
 						  (rp->rp_type == AOMDVTYPE_RERR ? "ERROR" :
 							"HELLO"));
 	        } else {
-				  sprintf(pt_->buffer() + offset,
+				  pt_->bufferf(offset,
 							 "[0x%x %d [%d %d] %f] (%s) [%d %d]",
 							 rp->rp_type,
 							 rp->rp_hop_count,
@@ -1084,11 +1084,11 @@ CMUTrace::format_mdart(Packet *p, int offset)
 			bitset<ADDR_SIZE> tempSetDstAdd_ (rhHello->dstAdd_);
 			string tempDstAdd_ = tempSetDstAdd_.to_string();
 			if (pt_->tagged()) {
-				sprintf(pt_->buffer() + offset, "-mdart:t %x -mdart:dAdd %d -mdart:sAdd %d -mdart:sId %d", rhHello->type_, rhHello->dstAdd_, rhHello->srcAdd_, rhHello->srcId_);
+				pt_->bufferf(offset, "-mdart:t %x -mdart:dAdd %d -mdart:sAdd %d -mdart:sId %d", rhHello->type_, rhHello->dstAdd_, rhHello->srcAdd_, rhHello->srcId_);
 			} else if (newtrace_) {
-				sprintf(pt_->buffer() + offset, "-type HELLO -srcId %d -srcAdd %s dstAdd %s -seqNum %d", rhHello->srcId_, tempSrcAdd_.c_str(), tempDstAdd_.c_str(),  rhHello->seqNum_);
+				pt_->bufferf(offset, "-type HELLO -srcId %d -srcAdd %s dstAdd %s -seqNum %d", rhHello->srcId_, tempSrcAdd_.c_str(), tempDstAdd_.c_str(),  rhHello->seqNum_);
 			} else {
-				sprintf(pt_->buffer() + offset, "[0x%x [%d %d] [%d]]", rhHello->type_, rhHello->dstAdd_, rhHello->srcAdd_, rhHello->srcId_);
+				pt_->bufferf(offset, "[0x%x [%d %d] [%d]]", rhHello->type_, rhHello->dstAdd_, rhHello->srcAdd_, rhHello->srcId_);
 			}
 			break;
 		}
@@ -1101,11 +1101,11 @@ CMUTrace::format_mdart(Packet *p, int offset)
 			bitset<ADDR_SIZE> tempSetDstAdd_ (rhDarq->dstAdd_);
 			string tempDstAdd_ = tempSetDstAdd_.to_string();
 			if (pt_->tagged()) {
-				sprintf(pt_->buffer() + offset, "-mdart:t %x -mdart:dstAdd %d -mdart:srcAdd %d -mdart:dstId %d -mdart:srcId %d -mdart:forAdd %d -mdart:forId %d -mdart:rId %d -mdart:pId %u -mdart:c DARQ", rhDarq->type_, rhDarq->dstAdd_, rhDarq->srcAdd_, rhDarq->dstId_, rhDarq->srcId_, rhDarq->forAdd_, rhDarq->forId_, rhDarq->reqId_, rhDarq->seqNum_);//, rhDarq->reqpktId_);
+				pt_->bufferf(offset, "-mdart:t %x -mdart:dstAdd %d -mdart:srcAdd %d -mdart:dstId %d -mdart:srcId %d -mdart:forAdd %d -mdart:forId %d -mdart:rId %d -mdart:pId %u -mdart:c DARQ", rhDarq->type_, rhDarq->dstAdd_, rhDarq->srcAdd_, rhDarq->dstId_, rhDarq->srcId_, rhDarq->forAdd_, rhDarq->forId_, rhDarq->reqId_, rhDarq->seqNum_);//, rhDarq->reqpktId_);
 			} else if (newtrace_) {
-				sprintf(pt_->buffer() + offset, "-type DARQ -srcId %d -srcAdd %s -forId %d -forAdd %s -dstId %d dstAdd %s -reqId %d -seqNum %d", rhDarq->srcId_, tempSrcAdd_.c_str(), rhDarq->forId_, tempForAdd_.c_str(), rhDarq->dstId_, tempDstAdd_.c_str(), rhDarq->reqId_, rhDarq->seqNum_);
+				pt_->bufferf(offset, "-type DARQ -srcId %d -srcAdd %s -forId %d -forAdd %s -dstId %d dstAdd %s -reqId %d -seqNum %d", rhDarq->srcId_, tempSrcAdd_.c_str(), rhDarq->forId_, tempForAdd_.c_str(), rhDarq->dstId_, tempDstAdd_.c_str(), rhDarq->reqId_, rhDarq->seqNum_);
 			} else {
-				sprintf(pt_->buffer() + offset, "[0x%x [%d %d] [%d %d] [%d %d] [%d] %u] (DARQ)", rhDarq->type_, rhDarq->dstAdd_, rhDarq->srcAdd_, rhDarq->dstId_, rhDarq->srcId_, rhDarq->forAdd_, rhDarq->forId_, rhDarq->reqId_, rhDarq->seqNum_);//, rhDarq->reqpktId_);
+				pt_->bufferf(offset, "[0x%x [%d %d] [%d %d] [%d %d] [%d] %u] (DARQ)", rhDarq->type_, rhDarq->dstAdd_, rhDarq->srcAdd_, rhDarq->dstId_, rhDarq->srcId_, rhDarq->forAdd_, rhDarq->forId_, rhDarq->reqId_, rhDarq->seqNum_);//, rhDarq->reqpktId_);
 			}
 			break;
 		}
@@ -1120,11 +1120,11 @@ CMUTrace::format_mdart(Packet *p, int offset)
 			bitset<ADDR_SIZE> tempSetReqAdd_ (rhDarp->reqAdd_);
 			string tempReqAdd_ = tempSetReqAdd_.to_string();
 			if (pt_->tagged()) {
-				sprintf(pt_->buffer() + offset, "-mdart:t %x -mdart:dAdd %d -mdart:sAdd %d -mdart:dId %d -mdart:sId %d -mdart:fAdd %d -mdart:fId %d -mdart:rAdd %d -mdart:rId %d -mdart:pAId %d mdart:c DARP", rhDarp->type_, rhDarp->dstAdd_, rhDarp->srcAdd_, rhDarp->dstId_, rhDarp->srcId_, rhDarp->forAdd_, rhDarp->forId_, rhDarp->reqAdd_, rhDarp->reqId_, rhDarp->seqNum_);//, rhDarp->reqpktId_);
+				pt_->bufferf(offset, "-mdart:t %x -mdart:dAdd %d -mdart:sAdd %d -mdart:dId %d -mdart:sId %d -mdart:fAdd %d -mdart:fId %d -mdart:rAdd %d -mdart:rId %d -mdart:pAId %d mdart:c DARP", rhDarp->type_, rhDarp->dstAdd_, rhDarp->srcAdd_, rhDarp->dstId_, rhDarp->srcId_, rhDarp->forAdd_, rhDarp->forId_, rhDarp->reqAdd_, rhDarp->reqId_, rhDarp->seqNum_);//, rhDarp->reqpktId_);
 			} else if (newtrace_) {
-				sprintf(pt_->buffer() + offset, "-type DARP -srcId %d -srcAdd %s -forId %d -forAdd %s -dstId %d dstAdd %s -reqId %d -reqAdd %s -seqNum %d", rhDarp->srcId_, tempSrcAdd_.c_str(), rhDarp->forId_, tempForAdd_.c_str(), rhDarp->dstId_, tempDstAdd_.c_str(), rhDarp->reqId_, tempReqAdd_.c_str(), rhDarp->seqNum_);
+				pt_->bufferf(offset, "-type DARP -srcId %d -srcAdd %s -forId %d -forAdd %s -dstId %d dstAdd %s -reqId %d -reqAdd %s -seqNum %d", rhDarp->srcId_, tempSrcAdd_.c_str(), rhDarp->forId_, tempForAdd_.c_str(), rhDarp->dstId_, tempDstAdd_.c_str(), rhDarp->reqId_, tempReqAdd_.c_str(), rhDarp->seqNum_);
 			} else {
-				sprintf(pt_->buffer() + offset, "[0x%x [%d %d] [%d %d] [%d %d] [%d %d] %u] (DARP)", rhDarp->type_, rhDarp->dstAdd_, rhDarp->srcAdd_, rhDarp->dstId_, rhDarp->srcId_, rhDarp->forAdd_, rhDarp->forId_, rhDarp->reqAdd_, rhDarp->reqId_, rhDarp->seqNum_);//, rhDarp->reqpktId_);
+				pt_->bufferf(offset, "[0x%x [%d %d] [%d %d] [%d %d] [%d %d] %u] (DARP)", rhDarp->type_, rhDarp->dstAdd_, rhDarp->srcAdd_, rhDarp->dstId_, rhDarp->srcId_, rhDarp->forAdd_, rhDarp->forId_, rhDarp->reqAdd_, rhDarp->reqId_, rhDarp->seqNum_);//, rhDarp->reqpktId_);
 			}
 			break;
 		}
@@ -1137,11 +1137,11 @@ CMUTrace::format_mdart(Packet *p, int offset)
 			bitset<ADDR_SIZE> tempSetDstAdd_ (rhDaup->dstAdd_);
 			string tempDstAdd_ = tempSetDstAdd_.to_string();
 			if (pt_->tagged()) {
-				sprintf(pt_->buffer() + offset, "-mdart:t %x -mdart:dAdd %d -mdart:sAdd %d -mdart:dId %d -mdart:sId %d -mdart:fAdd %d -mdart:fId %d -mdart:pAId %u -mdart:c DAUP", rhDaup->type_, rhDaup->dstAdd_, rhDaup->srcAdd_, rhDaup->dstId_, rhDaup->srcId_, rhDaup->forAdd_, rhDaup->forId_, rhDaup->seqNum_);
+				pt_->bufferf(offset, "-mdart:t %x -mdart:dAdd %d -mdart:sAdd %d -mdart:dId %d -mdart:sId %d -mdart:fAdd %d -mdart:fId %d -mdart:pAId %u -mdart:c DAUP", rhDaup->type_, rhDaup->dstAdd_, rhDaup->srcAdd_, rhDaup->dstId_, rhDaup->srcId_, rhDaup->forAdd_, rhDaup->forId_, rhDaup->seqNum_);
 			} else if (newtrace_) {
-				sprintf(pt_->buffer() + offset, "-type DAUP -srcId %d -srcAdd %s -forId %d -forAdd %s -dstId %d dstAdd %s -seqNum %d", rhDaup->srcId_, tempSrcAdd_.c_str(), rhDaup->forId_, tempForAdd_.c_str(), rhDaup->dstId_, tempDstAdd_.c_str(), rhDaup->seqNum_);
+				pt_->bufferf(offset, "-type DAUP -srcId %d -srcAdd %s -forId %d -forAdd %s -dstId %d dstAdd %s -seqNum %d", rhDaup->srcId_, tempSrcAdd_.c_str(), rhDaup->forId_, tempForAdd_.c_str(), rhDaup->dstId_, tempDstAdd_.c_str(), rhDaup->seqNum_);
 			} else {
-				sprintf(pt_->buffer() + offset, "[0x%x [%d %d] [%d %d] [%d %d] %u] (DAUP)", rhDaup->type_, rhDaup->dstAdd_, rhDaup->srcAdd_, rhDaup->dstId_, rhDaup->srcId_, rhDaup->forAdd_, rhDaup->forId_, rhDaup->seqNum_);
+				pt_->bufferf(offset, "[0x%x [%d %d] [%d %d] [%d %d] %u] (DAUP)", rhDaup->type_, rhDaup->dstAdd_, rhDaup->srcAdd_, rhDaup->dstId_, rhDaup->srcId_, rhDaup->forAdd_, rhDaup->forId_, rhDaup->seqNum_);
 			}
 			break;
 		}
@@ -1152,11 +1152,11 @@ CMUTrace::format_mdart(Packet *p, int offset)
 			bitset<ADDR_SIZE> tempSetDstAdd_ (rhDarq->dstAdd_);
 			string tempDstAdd_ = tempSetDstAdd_.to_string();
 			if (pt_->tagged()) {
-				sprintf(pt_->buffer() + offset, "-mdart:t %x -mdart:dAdd %d -mdart:sAdd %d -mdart:dId %d -mdart:sId %d -mdart:fAdd %d -mdart:fId %d -mdart:pAId %u -mdart:c DAUP", rhDaup->type_, rhDaup->dstAdd_, rhDaup->srcAdd_, rhDaup->dstId_, rhDaup->srcId_, rhDaup->forAdd_, rhDaup->forId_, rhDaup->seqNum_);
+				pt_->bufferf(offset, "-mdart:t %x -mdart:dAdd %d -mdart:sAdd %d -mdart:dId %d -mdart:sId %d -mdart:fAdd %d -mdart:fId %d -mdart:pAId %u -mdart:c DAUP", rhDaup->type_, rhDaup->dstAdd_, rhDaup->srcAdd_, rhDaup->dstId_, rhDaup->srcId_, rhDaup->forAdd_, rhDaup->forId_, rhDaup->seqNum_);
 			} else if (newtrace_) {
-				sprintf(pt_->buffer() + offset, "-type DABR -srcId %d -srcAdd %s dstAdd %s", rhDarq->srcId_, tempSrcAdd_.c_str(), tempDstAdd_.c_str());
+				pt_->bufferf(offset, "-type DABR -srcId %d -srcAdd %s dstAdd %s", rhDarq->srcId_, tempSrcAdd_.c_str(), tempDstAdd_.c_str());
 			} else {
-				sprintf(pt_->buffer() + offset, "[0x%x [%d %d] [%d %d] [%d %d] %u] (DAUP)", rhDaup->type_, rhDaup->dstAdd_, rhDaup->srcAdd_, rhDaup->dstId_, rhDaup->srcId_, rhDaup->forAdd_, rhDaup->forId_, rhDaup->seqNum_);
+				pt_->bufferf(offset, "[0x%x [%d %d] [%d %d] [%d %d] %u] (DAUP)", rhDaup->type_, rhDaup->dstAdd_, rhDaup->srcAdd_, rhDaup->dstId_, rhDaup->srcId_, rhDaup->forAdd_, rhDaup->forId_, rhDaup->seqNum_);
 			}
 			break;
 		}
@@ -1287,7 +1287,7 @@ CMUTrace::nam_format(Packet *p, int offset)
 	if (op == 's') op = 'h' ;
 	if (op == 'D') op = 'd' ;
 	if (op == 'h') {
-		sprintf(pt_->nbuffer(),
+		pt_->nbufferf(0,
 			"+ -t %.9f -s %d -d %d -p %s -e %d -c 2 -a %d -i %d -k %3s ",
 			Scheduler::instance().clock(),
 			src_,                           // this node
@@ -1298,9 +1298,9 @@ CMUTrace::nam_format(Packet *p, int offset)
 			ch->uid(),
 			tracename);
 
-		offset = strlen(pt_->nbuffer());
+		offset = pt_->nbuffer_length();
 		pt_->namdump();
-		sprintf(pt_->nbuffer() ,
+		pt_->nbufferf(0,
 			"- -t %.9f -s %d -d %d -p %s -e %d -c 2 -a %d -i %d -k %3s",
 			Scheduler::instance().clock(),
 			src_,                           // this node
@@ -1311,7 +1311,7 @@ CMUTrace::nam_format(Packet *p, int offset)
 			ch->uid(),
 			tracename);
 		
-		offset = strlen(pt_->nbuffer());
+		offset = pt_->nbuffer_length();
 		pt_->namdump();
 	}
 
@@ -1333,18 +1333,18 @@ CMUTrace::nam_format(Packet *p, int offset)
 	       exit(0);
 	   }
 	   if (nodeColor[src_] != energyLevel ) { //only dump it when node  
-	       sprintf(pt_->nbuffer() ,                    //color change
+	       pt_->nbufferf(0,                    //color change
 	          "n -t %.9f -s %d -S COLOR %s",
 	           Scheduler::instance().clock(),
 	           src_,                           // this node
 	           colors);
-               offset = strlen(pt_->nbuffer());
+               offset = pt_->nbuffer_length();
                pt_->namdump();
 	       nodeColor[src_] = energyLevel ;
 	    }   
         }
 
-	sprintf(pt_->nbuffer() ,
+	pt_->nbufferf(0,
 		"%c -t %.9f -s %d -d %d -p %s -e %d -c 2 -a %d -i %d -k %3s",
 		op,
 		Scheduler::instance().clock(),
@@ -1379,7 +1379,7 @@ if (Nam802_15_4::Nam_Status)
 		if (duration < 0.000000001)
 			duration = 0.000000001;
 		//</zheng: add>
-		sprintf(pt_->nbuffer() + strlen(pt_->nbuffer()),
+		pt_->nbufferf(pt_->nbuffer_length(),
 			" -R %.2f -D %.2f",
 			radius,
 			duration);
@@ -1387,7 +1387,7 @@ if (Nam802_15_4::Nam_Status)
 }
 //</zheng>
 
-	offset = strlen(pt_->nbuffer());
+	offset = pt_->nbuffer_length();
 	pt_->namdump();
 }
 
@@ -1403,7 +1403,7 @@ void CMUTrace::format(Packet* p, const char *why)
 
 	if (pt_->namchannel()) 
 		nam_format(p, offset);
-	offset = strlen(pt_->buffer());
+	offset = pt_->buffer_length();
 	switch(ch->ptype()) {
 	case PT_MAC:
 	case PT_SMAC:
@@ -1413,7 +1413,7 @@ void CMUTrace::format(Packet* p, const char *why)
 		break;
 	default:
 		format_ip(p, offset);
-		offset = strlen(pt_->buffer());
+		offset = pt_->buffer_length();
 		switch(ch->ptype()) {
 		case PT_AODV:
 			format_aodv(p, offset);
@@ -0,0 +1,366 @@
+/* -*-	Mode:C++; c-basic-offset:8; tab-width:8; indent-tabs-mode:t -*- */
+/*
+ * Copyright (c) 1997 Regents of the University of California.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the University nor of the Laboratory may be used
+ *    to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+
+/*
+ * trace-decode.cc
+ *
+ * Turn a binary ns trace (see bintrace.h) back into the text ns would
+ * have written: the old and new wireless formats, the wired format and
+ * nam traces alike, since every line is rebuilt by running the formats
+ * ns used through printf again.  It must run on a host with the byte
+ * order and printf of the one that wrote the trace.
+ *
+ * usage: trace-decode [binary-trace [text-trace]]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "config.h"
+#include "bintrace.h"
+
+/* a literal followed by at most one conversion */
+struct Segment {
+	char*	lit_;
+	int	litlen_;
+	char*	spec_;		// 0 if the format ends with the literal
+	char	kinds_[4];	// *, *, and the argument itself
+};
+
+struct Format {
+	std::vector<Segment> segs_;
+};
+
+static std::vector<Format*> formats;
+static std::vector<char*> strings;
+static const char* input = "<stdin>";
+
+static void
+die(const char* why)
+{
+	fprintf(stderr, "trace-decode: %s: %s\n", input, why);
+	exit(1);
+}
+
+static char*
+copy(const char* s, int n)
+{
+	char* c = new char[n + 1];
+	memcpy(c, s, n);
+	c[n] = 0;
+	return (c);
+}
+
+static Format*
+parse(const char* fmt)
+{
+	Format* f = new Format;
+	const char* lit = fmt;
+
+	for (const char* p = fmt; ; ) {
+		if (*p != 0 && *p != '%') {
+			p++;
+			continue;
+		}
+		if (*p == '%' && p[1] == '%') {
+			/* keep the literal, %% and all, for printf */
+			p += 2;
+			continue;
+		}
+		Segment s;
+		s.lit_ = copy(lit, p - lit);
+		s.litlen_ = p - lit;
+		s.spec_ = 0;
+		s.kinds_[0] = 0;
+		if (*p == 0) {
+			f->segs_.push_back(s);
+			break;
+		}
+		const char* q = p + 1;
+		while (*q != 0 && strchr("-+ #0'123456789.*hlLqjzt", *q) != 0)
+			q++;
+		if (*q == 0)
+			die("bad format");
+		q++;
+		s.spec_ = copy(p, q - p);
+		if (bintrace_signature(s.spec_, s.kinds_, sizeof(s.kinds_)) < 1)
+			die("bad format");
+		f->segs_.push_back(s);
+		lit = p = q;
+	}
+	return (f);
+}
+
+/* the line being rebuilt */
+static char* line;
+static int linemax;
+static int linelen;
+
+static void
+append(const char* s, int n)
+{
+	if (linelen + n + 1 > linemax) {
+		while (linelen + n + 1 > linemax)
+			linemax *= 2;
+		char* l = new char[linemax];
+		memcpy(l, line, linelen);
+		delete [] line;
+		line = l;
+	}
+	memcpy(line + linelen, s, n);
+	linelen += n;
+}
+
+/* printf one conversion with its arguments, as sprintf() would have */
+template <class T> static void
+emit(const char* spec, int nstars, const int* stars, T v)
+{
+	static char* buf;
+	static int max = 256;
+	int n;
+
+	if (buf == 0)
+		buf = new char[max];
+	for (;;) {
+		if (nstars == 0)
+			n = snprintf(buf, max, spec, v);
+		else if (nstars == 1)
+			n = snprintf(buf, max, spec, stars[0], v);
+		else
+			n = snprintf(buf, max, spec, stars[0], stars[1], v);
+		if (n < max)
+			break;
+		delete [] buf;
+		max = n + 1;
+		buf = new char[max];
+	}
+	if (n > 0)
+		append(buf, n);
+}
+
+/* payload reader */
+static const char* rdptr;
+static const char* rdend;
+
+static void
+take(void* v, int n)
+{
+	if (rdend - rdptr < n)
+		die("truncated record");
+	memcpy(v, rdptr, n);
+	rdptr += n;
+}
+
+static const char*
+string_arg(char* inl, int max)
+{
+	u_int32_t id;
+	take(&id, 4);
+	if (id == BT_NULL)
+		return (0);
+	if (id == BT_INLINE) {
+		u_int16_t n;
+		take(&n, 2);
+		if (n >= max)
+			die("inline string too long");
+		take(inl, n);
+		inl[n] = 0;
+		return (inl);
+	}
+	if (id >= strings.size())
+		die("undefined string");
+	return (strings[id]);
+}
+
+static void
+fragment()
+{
+	u_int16_t id;
+	take(&id, 2);
+
+	/* sprintf(buffer() + strlen(buffer()), ...) */
+	linelen = strlen(line);
+
+	if (id == BT_TEXT) {
+		u_int16_t n;
+		take(&n, 2);
+		if (rdend - rdptr < n)
+			die("truncated record");
+		append(rdptr, n);
+		rdptr += n;
+		line[linelen] = 0;
+		return;
+	}
+	if (id >= formats.size())
+		die("undefined format");
+
+	Format* f = formats[id];
+	for (size_t i = 0; i < f->segs_.size(); i++) {
+		Segment& s = f->segs_[i];
+		if (s.litlen_ > 0) {
+			/* literal text, in which %% stands for % */
+			if (strchr(s.lit_, '%') != 0) {
+				for (int k = 0; k < s.litlen_; k++) {
+					append(s.lit_ + k, 1);
+					if (s.lit_[k] == '%')
+						k++;
+				}
+			} else
+				append(s.lit_, s.litlen_);
+		}
+		if (s.spec_ == 0)
+			continue;
+
+		int stars[2], nstars = 0;
+		const char* k;
+		for (k = s.kinds_; k[1] != 0; k++)
+			take(&stars[nstars++], 4);
+		switch (*k) {
+		case BT_INT: {
+			int v;
+			take(&v, 4);
+			emit(s.spec_, nstars, stars, v);
+			break;
+		}
+		case BT_LONG: {
+			int64_t v;
+			take(&v, 8);
+			emit(s.spec_, nstars, stars, (long)v);
+			break;
+		}
+		case BT_LLONG: {
+			int64_t v;
+			take(&v, 8);
+			emit(s.spec_, nstars, stars, v);
+			break;
+		}
+		case BT_DOUBLE: {
+			double v;
+			take(&v, 8);
+			emit(s.spec_, nstars, stars, v);
+			break;
+		}
+		case BT_PTR: {
+			int64_t v;
+			take(&v, 8);
+			emit(s.spec_, nstars, stars, (void*)(size_t)v);
+			break;
+		}
+		case BT_STR: {
+			char inl[0x10000];
+			emit(s.spec_, nstars, stars, string_arg(inl, sizeof(inl)));
+			break;
+		}
+		}
+	}
+	line[linelen] = 0;
+}
+
+int
+main(int argc, char** argv)
+{
+	FILE* in = stdin;
+	FILE* out = stdout;
+
+	if (argc > 3) {
+		fprintf(stderr, "usage: trace-decode [binary-trace [text-trace]]\n");
+		exit(1);
+	}
+	if (argc > 1 && strcmp(argv[1], "-") != 0) {
+		input = argv[1];
+		if ((in = fopen(argv[1], "rb")) == 0) {
+			perror(argv[1]);
+			exit(1);
+		}
+	}
+	if (argc > 2 && (out = fopen(argv[2], "wb")) == 0) {
+		perror(argv[2]);
+		exit(1);
+	}
+
+	linemax = 4096;
+	line = new char[linemax];
+	char* rec = new char[0x10000];
+	int c;
+	while ((c = getc(in)) != EOF) {
+		u_int16_t n;
+		switch (c) {
+		case BT_MAGIC: {
+			char magic[8];
+			int32_t order;
+			if (fread(magic, 8, 1, in) != 1)
+				die("truncated header");
+			memcpy(&order, magic + 4, 4);
+			if (memcmp(magic, "NSBT", 4) != 0)
+				die("bad header");
+			if (order != BT_ORDER)
+				die("written on a host of another byte order");
+			break;
+		}
+		case BT_FORMAT:
+		case BT_STRING:
+		case BT_LINE:
+			if (fread(&n, 2, 1, in) != 1 ||
+			    (n > 0 && fread(rec, n, 1, in) != 1))
+				die("truncated record");
+			rec[n] = 0;
+			if (c == BT_FORMAT)
+				formats.push_back(parse(rec));
+			else if (c == BT_STRING)
+				strings.push_back(copy(rec, n));
+			else {
+				rdptr = rec;
+				rdend = rec + n;
+				line[0] = 0;
+				while (rdptr < rdend)
+					fragment();
+				fwrite(line, 1, strlen(line), out);
+				putc('\n', out);
+			}
+			break;
+		default:
+			/* a line of plain text */
+			do
+				putc(c, out);
+			while (c != '\n' && (c = getc(in)) != EOF);
+			break;
+		}
+	}
+	if (ferror(in))
+		die("read error");
+	if (fclose(out) != 0) {
+		perror("trace-decode");
+		exit(1);
+	}
+	return (0);
+}
@@ -67,6 +67,7 @@ Trace::Trace(int type)
 	bind("show_tcphdr_", &show_tcphdr_);
 	bind("show_sctphdr_", &show_sctphdr_);
 	pt_ = new BaseTrace;
+	pt_->keeptext(&callback_);
 }
 
 Trace::~Trace()
@@ -151,25 +152,25 @@ int Trace::command(int argc, const char*const* argv)
 
 void Trace::write_nam_trace(const char *s)
 {
-	sprintf(pt_->nbuffer(), "%s", s);
+	pt_->nbufferf(0, "%s", s);
 	pt_->namdump();
 }
 
 void Trace::annotate(const char* s)
 {
 	if (pt_->tagged()) {
-		sprintf(pt_->buffer(),
+		pt_->bufferf(0,
 			"v "TIME_FORMAT" -e {sim_annotation %g %s}",
 			Scheduler::instance().clock(), 
 			Scheduler::instance().clock(), s);
 	} else {
-		sprintf(pt_->buffer(),
+		pt_->bufferf(0,
 			"v "TIME_FORMAT" eval {set sim_annotation {%s}}", 
 			pt_->round(Scheduler::instance().clock()), s);
 	}
 	pt_->dump();
 	callback();
-	sprintf(pt_->nbuffer(), "v -t "TIME_FORMAT" -e sim_annotation %g %s", 
+	pt_->nbufferf(0, "v -t "TIME_FORMAT" -e sim_annotation %g %s", 
 		Scheduler::instance().clock(), 
 		Scheduler::instance().clock(), s);
 	pt_->namdump();
@@ -267,7 +268,7 @@ void Trace::format(int tt, int s, int d, Packet* p)
 	char *dst_portaddr = Address::instance().print_portaddr(iph->dport());
 
 	if (pt_->tagged()) {
-		sprintf(pt_->buffer(), 
+		pt_->bufferf(0, 
 			"%c "TIME_FORMAT" -s %d -d %d -p %s -e %d -c %d -i %d -a %d -x {%s.%s %s.%s %d %s %s}",
 			tt,
 			Scheduler::instance().clock(),
@@ -323,7 +324,7 @@ void Trace::format(int tt, int s, int d, Packet* p)
 			default:
 				assert (false);
 			}
-			sprintf(pt_->buffer(),
+			pt_->bufferf(0,
 				"%c "TIME_FORMAT" %d %d %s %d %s %d %s.%s %s.%s %d %d %d %d %d",
 				tt,
 				pt_->round(timestamp),
@@ -352,7 +353,7 @@ void Trace::format(int tt, int s, int d, Packet* p)
 				pt_->dump();
 		}
 	} else if (!show_tcphdr_) {
-		sprintf(pt_->buffer(), "%c "TIME_FORMAT" %d %d %s %d %s %d %s.%s %s.%s %d %d",
+		pt_->bufferf(0, "%c "TIME_FORMAT" %d %d %s %d %s %d %s.%s %s.%s %d %d",
 			tt,
 			pt_->round(Scheduler::instance().clock()),
 			s,
@@ -372,7 +373,7 @@ void Trace::format(int tt, int s, int d, Packet* p)
 			seqno,
 			th->uid() /* was p->uid_ */);
 	} else {
-		sprintf(pt_->buffer(), 
+		pt_->bufferf(0, 
 			"%c "TIME_FORMAT" %d %d %s %d %s %d %s.%s %s.%s %d %d %d 0x%x %d %d",
 			tt,
 			pt_->round(Scheduler::instance().clock()),
@@ -398,7 +399,7 @@ void Trace::format(int tt, int s, int d, Packet* p)
 			tcph->sa_length());
 	}
 	if (pt_->namchannel() != 0)
-		sprintf(pt_->nbuffer(), 
+		pt_->nbufferf(0, 
 			"%c -t "TIME_FORMAT" -s %d -d %d -p %s -e %d -c %d -i %d -a %d -x {%s.%s %s.%s %d %s %s}",
 			tt,
 			Scheduler::instance().clock(),
@@ -450,7 +451,7 @@ void Trace::trace(TracedVar* var)
 		return;
 
 	if (pt_->tagged()) {
-		sprintf(pt_->buffer(), "%c "TIME_FORMAT" -a %s -n %s -v %s",
+		pt_->bufferf(0, "%c "TIME_FORMAT" -a %s -n %s -v %s",
 			type_,
 			pt_->round(s.clock()),
 			var->owner()->name(),
@@ -458,7 +459,7 @@ void Trace::trace(TracedVar* var)
 			var->value(tmp, 256));
 	} else {
 		// format: use Mark's nam feature code without the '-' prefix
-		sprintf(pt_->buffer(), "%c t"TIME_FORMAT" a%s n%s v%s",
+		pt_->bufferf(0, "%c t"TIME_FORMAT" a%s n%s v%s",
 			type_,
 			pt_->round(s.clock()),
 			var->owner()->name(),
@@ -473,7 +474,7 @@ void Trace::callback()
 {
 	if (callback_) {
 		Tcl& tcl = Tcl::instance();
-		tcl.evalf("%s handle { %s }", name(), pt_->buffer());
+		tcl.evalf("%s handle { %s }", name(), pt_->text());
 	}
 }
 
@@ -550,7 +551,7 @@ DequeTrace::recv(Packet* p, Handler* h)
 #endif
 		
 		if (pt_->nbuffer() != 0) {
-			sprintf(pt_->nbuffer(), 
+			pt_->nbufferf(0, 
 				"%c -t "TIME_FORMAT" -s %d -d %d -p %s -e %d -c %d -i %d -a %d -x {%s.%s %s.%s %d %s %s}",
 				'h',
 				Scheduler::instance().clock(),
@@ -569,7 +570,7 @@ DequeTrace::recv(Packet* p, Handler* h)
 			pt_->namdump();
 		}
 		if (pt_->tagged() && pt_->buffer() != 0) {
-			sprintf(pt_->buffer(), 
+			pt_->bufferf(0, 
 				"%c "TIME_FORMAT" -s %d -d %d -p %s -e %d -c %d -i %d -a %d -x {%s.%s %s.%s %d %s %s}",
 				'h',
 				Scheduler::instance().clock(),
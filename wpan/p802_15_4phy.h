@@ -137,6 +137,9 @@ public:
 	void PLME_SET_request(PPIBAenum PIBAttribute,PHY_PIB *PIBAttributeValue);
 	UINT_8 measureLinkQ(Packet *p);
 	void recv(Packet *p, Handler *h);
+	// recv() works out the power again for sleeping nodes
+	int prescreen(Packet *, double *Pr) { *Pr = -1; return 1; }
+	int prescreen(PrBatch *) { return 0; }
 	Packet* rxPacket(void) {return rxPkt;}
 	void wakeupNode(int cause); // 2.31 change: for MAC to wake up the node
 	void putNodeToSleep(); // 2.31 change: for MAC to put the node to sleep